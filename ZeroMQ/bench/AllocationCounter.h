@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <openssl/crypto.h>
+
+/**
+ * @brief Counts heap allocations made through the global operator new and through
+ *        OpenSSL's allocator (BIGNUMs, BN_CTX frames, BN_bn2hex strings).
+ *
+ *        This header replaces the global operator new/delete, so include it from
+ *        exactly one translation unit per benchmark binary, and call install() first
+ *        thing in main: OpenSSL only accepts its hooks before its first allocation.
+ */
+namespace AllocationCounter {
+
+inline std::atomic<size_t> g_allocations{0};
+
+inline size_t count() { return g_allocations.load(std::memory_order_relaxed); }
+
+inline void* countedMalloc(size_t size, const char*, int) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size);
+}
+
+inline void* countedRealloc(void* ptr, size_t size, const char*, int) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::realloc(ptr, size);
+}
+
+inline void countedFree(void* ptr, const char*, int) {
+    std::free(ptr);
+}
+
+/**
+ * @return False if OpenSSL had already allocated; only operator new is counted then.
+ */
+inline bool install() {
+    return CRYPTO_set_mem_functions(countedMalloc, countedRealloc, countedFree) == 1;
+}
+
+/**
+ * @brief Allocations made since construction.
+ */
+class Scope {
+public:
+    Scope() : m_start(count()) {}
+    size_t allocations() const { return count() - m_start; }
+
+private:
+    size_t m_start;
+};
+
+} // namespace AllocationCounter
+
+void* operator new(std::size_t size) {
+    AllocationCounter::g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
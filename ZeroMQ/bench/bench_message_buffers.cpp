@@ -0,0 +1,76 @@
+// Steady-state cost of assembling and parsing one batch message: encode into a pooled
+// send buffer, copy into a pooled receive buffer (standing in for the transport) and
+// decode into reused BIGNUMs. Prints one CSV row per batch size and fails if a batch
+// that runs on the calling thread allocates at all.
+#include "AllocationCounter.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "AdditiveSecretSharing.h"
+#include "BufferPool.h"
+#include "ShareCodec.h"
+#include "ThreadPool.h"
+
+static void roundTrip(BufferPool &sendBuffers, BufferPool &recvBuffers,
+                      const std::vector<ShareType> &shares, std::vector<ShareType> &decoded) {
+    PooledBuffer msg = sendBuffers.acquire(encodedSharesSize(shares.size()));
+    msg.resize(encodeShares(shares, msg.data()));
+    PooledBuffer received = recvBuffers.acquire(msg.size());
+    std::memcpy(received.data(), msg.data(), msg.size());
+    received.resize(msg.size());
+    decodeShares(received.data(), received.size(), decoded);
+}
+
+int main() {
+    bool countsOpenSsl = AllocationCounter::install();
+    if (!countsOpenSsl) {
+        std::fprintf(stderr, "warning: OpenSSL allocations are not counted\n");
+    }
+
+    const SIZE_T rounds = 200;
+    const SIZE_T batchSizes[] = {1, 16, PARALLEL_GRAIN, 4096, 65536};
+    bool ok = true;
+    std::printf("batch,ns_per_batch,allocations_per_batch,inline\n");
+    for (SIZE_T count : batchSizes) {
+        std::vector<ShareType> shares(count);
+        for (auto &share : shares) {
+            share = AdditiveSecretSharing::newBigInt();
+            BN_rand_range(share, AdditiveSecretSharing::getPrime());
+        }
+        BufferPool sendBuffers, recvBuffers;
+        std::vector<ShareType> decoded;
+        // Warm-up touches the size classes and allocates the decoded BIGNUMs
+        roundTrip(sendBuffers, recvBuffers, shares, decoded);
+
+        AllocationCounter::Scope scope;
+        auto start = std::chrono::steady_clock::now();
+        for (SIZE_T r = 0; r < rounds; ++r) {
+            roundTrip(sendBuffers, recvBuffers, shares, decoded);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        double allocations = static_cast<double>(scope.allocations()) / rounds;
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count() / rounds;
+
+        // Larger batches are spread over ThreadPool::shared(), whose dispatch allocates a
+        // few task records per batch independent of its size
+        bool runsInline = count <= PARALLEL_GRAIN || ThreadPool::shared().size() == 0;
+        std::printf("%lu,%.0f,%.2f,%d\n", count, ns, allocations, runsInline ? 1 : 0);
+        if (runsInline && scope.allocations() != 0) ok = false;
+        for (SIZE_T k = 0; k < count; ++k) {
+            if (BN_cmp(shares[k], decoded[k]) != 0) {
+                std::fprintf(stderr, "batch %lu: share %lu did not round-trip\n", count, k);
+                ok = false;
+                break;
+            }
+        }
+
+        for (auto &share : shares) BN_free(share);
+        for (auto &share : decoded) BN_free(share);
+    }
+    if (!ok) {
+        std::fprintf(stderr, "FAILED: a batch message allocated in steady state\n");
+        return 1;
+    }
+    return 0;
+}
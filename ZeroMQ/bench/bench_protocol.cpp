@@ -0,0 +1,288 @@
+// End-to-end protocol benchmark. For every configuration it launches the n compute parties
+// and the dealer as separate processes, with the command lines run_parties.sh uses, then
+// collects the PHASE lines every party prints when it finishes (see src/PhaseStats.h).
+// One CSV row per phase goes to stdout or --output:
+//   wall_us   the dealer's wall time for the phase, i.e. the time the protocol spent in it
+//   messages  messages sent by all parties during the phase
+//   bytes     payload bytes sent by all parties during the phase, i.e. the bytes on the wire
+// plus a "total" row per run.
+//
+// Each --security mode and --batch size is passed to the parties as --security=<mode> and
+// --batch=<n>, so one build covers both protocols and every batch size; the security and
+// batch columns are taken from what the parties report. Each --binary is one protocol
+// build. Party output is kept under --log-dir.
+//
+// usage: bench_protocol [--binary PATH]... [--security LIST] [--batch LIST] [--parties LIST]
+//                       [--mode LIST] [--operation LIST] [--repeats N]
+//                       [--stagger-ms N] [--timeout SECONDS] [--log-dir DIR] [--output FILE]
+// LIST is comma-separated, e.g. --parties 3,5,9 --mode reqrep,dealerrouter --security malicious,semihonest
+//                                --batch 2,1024,65536
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+struct Options {
+    std::vector<std::string> binaries;
+    std::vector<std::string> securities = {"malicious"};
+    std::vector<int> batches = {2};
+    std::vector<int> parties = {3};
+    std::vector<std::string> modes = {"dealerrouter", "reqrep"};
+    std::vector<std::string> operations = {"add"};
+    int repeats = 1;
+    int staggerMs = 200;
+    int timeoutSeconds = 120;
+    std::string logDir = "bench_protocol_logs";
+    std::string output;
+};
+
+// One protocol run: a binary, a security mode, a batch size, a transport, an operation and a party count
+struct RunConfig {
+    std::string binary;
+    std::string security;
+    int batch;
+    std::string mode;
+    std::string operation;
+    int parties;
+    int repeat;
+};
+
+struct PhaseRow {
+    std::string name;
+    unsigned long wallUs = 0;
+    unsigned long messages = 0;
+    unsigned long bytes = 0;
+};
+
+struct RunResult {
+    std::string security;
+    std::string batch;
+    std::vector<PhaseRow> phases;
+};
+
+static std::vector<std::string> splitList(const std::string &list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+static Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+        std::string value = argv[++i];
+        if (arg == "--binary") {
+            options.binaries.push_back(value);
+        } else if (arg == "--security") {
+            options.securities = splitList(value);
+        } else if (arg == "--batch") {
+            options.batches.clear();
+            for (const auto &item : splitList(value)) options.batches.push_back(std::stoi(item));
+        } else if (arg == "--parties") {
+            options.parties.clear();
+            for (const auto &item : splitList(value)) options.parties.push_back(std::stoi(item));
+        } else if (arg == "--mode") {
+            options.modes = splitList(value);
+        } else if (arg == "--operation") {
+            options.operations = splitList(value);
+        } else if (arg == "--repeats") {
+            options.repeats = std::stoi(value);
+        } else if (arg == "--stagger-ms") {
+            options.staggerMs = std::stoi(value);
+        } else if (arg == "--timeout") {
+            options.timeoutSeconds = std::stoi(value);
+        } else if (arg == "--log-dir") {
+            options.logDir = value;
+        } else if (arg == "--output") {
+            options.output = value;
+        } else {
+            throw std::invalid_argument("Unknown option: " + arg);
+        }
+    }
+    if (options.binaries.empty()) options.binaries.push_back("./netiomp_test");
+    return options;
+}
+
+// Start one party with stdout and stderr going to logPath
+static pid_t spawnParty(const std::vector<std::string> &args, const std::string &logPath) {
+    pid_t pid = fork();
+    if (pid < 0) throw std::runtime_error("fork failed");
+    if (pid == 0) {
+        int fd = open(logPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        std::vector<char*> argv;
+        for (const auto &arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        std::perror("execv");
+        _exit(127);
+    }
+    return pid;
+}
+
+// Wait for every party; kills the rest once one fails or the timeout passes
+static bool waitForParties(std::vector<pid_t> pids, int timeoutSeconds, std::string &error) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSeconds);
+    bool ok = true;
+    while (!pids.empty()) {
+        for (auto it = pids.begin(); it != pids.end();) {
+            int status;
+            if (waitpid(*it, &status, WNOHANG) == *it) {
+                if (ok && !(WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+                    ok = false;
+                    error = "a party exited abnormally";
+                }
+                it = pids.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (pids.empty()) break;
+        if (ok && std::chrono::steady_clock::now() > deadline) {
+            ok = false;
+            error = "timed out after " + std::to_string(timeoutSeconds) + " s";
+        }
+        if (!ok) {
+            for (pid_t pid : pids) kill(pid, SIGKILL);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return ok;
+}
+
+static PhaseRow &phaseNamed(std::vector<PhaseRow> &phases, const std::string &name) {
+    for (auto &phase : phases) {
+        if (phase.name == name) return phase;
+    }
+    phases.push_back(PhaseRow{name});
+    return phases.back();
+}
+
+/**
+ * Adds up the PHASE,<party>,<security>,<batch>,<phase>,<wall_us>,<messages>,<bytes>
+ * lines of all parties: wall time from the dealer, traffic from everyone.
+ */
+static RunResult collectPhases(const std::vector<std::string> &logPaths, int dealerId) {
+    RunResult result;
+    for (const auto &path : logPaths) {
+        std::ifstream log(path);
+        std::string line;
+        while (std::getline(log, line)) {
+            if (line.rfind("PHASE,", 0) != 0) continue;
+            std::vector<std::string> fields = splitList(line);
+            if (fields.size() != 8) continue;
+            PhaseRow &phase = phaseNamed(result.phases, fields[4]);
+            if (std::stoi(fields[1]) == dealerId) {
+                result.security = fields[2];
+                result.batch = fields[3];
+                phase.wallUs = std::stoul(fields[5]);
+            }
+            phase.messages += std::stoul(fields[6]);
+            phase.bytes += std::stoul(fields[7]);
+        }
+    }
+    return result;
+}
+
+static bool runProtocol(const Options &options, const RunConfig &run, int runIndex, RunResult &result) {
+    int dealerId = run.parties + 1;
+    std::vector<pid_t> pids;
+    std::vector<std::string> logPaths;
+    // Compute parties first, then the dealer, as in run_parties.sh
+    for (int pid = 1; pid <= dealerId; ++pid) {
+        bool isDealer = pid == dealerId;
+        if (isDealer) std::this_thread::sleep_for(std::chrono::seconds(1));
+        std::string logPath = options.logDir + "/run" + std::to_string(runIndex) + "_party" + std::to_string(pid) + ".log";
+        std::vector<std::string> args = {run.binary, run.mode, std::to_string(pid), std::to_string(run.parties),
+                                         std::to_string(pid * 10), isDealer ? "1" : "0", run.operation,
+                                         "--security=" + run.security, "--batch=" + std::to_string(run.batch)};
+        pids.push_back(spawnParty(args, logPath));
+        logPaths.push_back(logPath);
+        if (!isDealer) std::this_thread::sleep_for(std::chrono::milliseconds(options.staggerMs));
+    }
+    std::string error;
+    if (!waitForParties(pids, options.timeoutSeconds, error)) {
+        std::cerr << "bench_protocol: run " << runIndex << " (" << run.binary << " " << run.security << " batch " << run.batch << " " << run.mode << " "
+                  << run.operation << " " << run.parties << " parties) " << error << "; see "
+                  << options.logDir << "\n";
+        return false;
+    }
+    result = collectPhases(logPaths, dealerId);
+    if (result.phases.empty()) {
+        std::cerr << "bench_protocol: run " << runIndex << " reported no phases; was the party built with ENABLE_PHASE_STATS?\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    std::filesystem::create_directories(options.logDir);
+    std::ofstream file;
+    if (!options.output.empty()) file.open(options.output);
+    std::ostream &out = options.output.empty() ? std::cout : file;
+
+    out << "security,batch,mode,operation,parties,repeat,phase,wall_us,messages,bytes\n";
+    int runIndex = 0;
+    int failures = 0;
+    for (const auto &binary : options.binaries) {
+        for (const auto &security : options.securities) {
+            for (int batch : options.batches) {
+                for (const auto &mode : options.modes) {
+                    for (const auto &operation : options.operations) {
+                        for (int parties : options.parties) {
+                            for (int repeat = 0; repeat < options.repeats; ++repeat) {
+                                RunConfig run{binary, security, batch, mode, operation, parties, repeat};
+                                RunResult result;
+                                if (!runProtocol(options, run, runIndex++, result)) {
+                                    ++failures;
+                                    continue;
+                                }
+                                PhaseRow total{"total"};
+                                for (const auto &phase : result.phases) {
+                                    total.wallUs += phase.wallUs;
+                                    total.messages += phase.messages;
+                                    total.bytes += phase.bytes;
+                                }
+                                result.phases.push_back(total);
+                                for (const auto &phase : result.phases) {
+                                    out << result.security << "," << result.batch << "," << mode << "," << operation << ","
+                                        << parties << "," << repeat << "," << phase.name << "," << phase.wallUs << ","
+                                        << phase.messages << "," << phase.bytes << "\n";
+                                }
+                                out.flush();
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
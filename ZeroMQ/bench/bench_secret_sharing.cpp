@@ -0,0 +1,215 @@
+// Microbenchmarks for AdditiveSecretSharing and the share codecs.
+//
+// Arguments are {parties, batch}: every benchmark iteration processes a batch of
+// secrets (or shares) for the given number of parties, and items/s counts secrets.
+// For JSON output that can be compared across commits:
+//   ./bench_secret_sharing --benchmark_format=json
+//   ./bench_secret_sharing --benchmark_out=bench_secret_sharing.json --benchmark_out_format=json
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include <openssl/crypto.h>
+#include "AdditiveSecretSharing.h"
+#include "ShareCodec.h"
+
+static const std::vector<int64_t> PARTY_COUNTS = {2, 4, 8, 16, 32, 64};
+static const std::vector<int64_t> BATCH_SIZES = {1, 64, 1024};
+
+static std::vector<ShareType> randomValues(SIZE_T count) {
+    std::vector<ShareType> values(count);
+    for (auto &value : values) {
+        value = AdditiveSecretSharing::newBigInt();
+        BN_rand_range(value, AdditiveSecretSharing::getPrime());
+    }
+    return values;
+}
+
+static void freeValues(std::vector<ShareType> &values) {
+    for (auto &value : values) BN_free(value);
+    values.clear();
+}
+
+static void setCounters(benchmark::State &state, SIZE_T batch) {
+    state.SetItemsProcessed(state.iterations() * batch);
+    state.counters["parties"] = static_cast<double>(state.range(0));
+    state.counters["batch"] = static_cast<double>(batch);
+}
+
+static void BM_GenerateShares(benchmark::State &state) {
+    int parties = static_cast<int>(state.range(0));
+    SIZE_T batch = state.range(1);
+    std::vector<ShareType> secrets = randomValues(batch);
+    std::vector<ShareType> shares;
+    for (auto _ : state) {
+        for (auto secret : secrets) {
+            AdditiveSecretSharing::generateShares(secret, parties, shares);
+            benchmark::DoNotOptimize(shares.data());
+            freeValues(shares);
+        }
+    }
+    setCounters(state, batch);
+    freeValues(secrets);
+}
+BENCHMARK(BM_GenerateShares)->ArgsProduct({PARTY_COUNTS, BATCH_SIZES});
+
+static void BM_GenerateMacShares(benchmark::State &state) {
+    PARTY_ID_T parties = static_cast<PARTY_ID_T>(state.range(0));
+    SIZE_T batch = state.range(1);
+    std::vector<ShareType> secrets = randomValues(batch);
+    std::vector<ShareType> macKey = randomValues(1);
+    std::vector<ShareType> shares;
+    for (auto _ : state) {
+        for (auto secret : secrets) {
+            AdditiveSecretSharing::generateMacShares(secret, macKey[0], parties, shares);
+            benchmark::DoNotOptimize(shares.data());
+            freeValues(shares);
+        }
+    }
+    setCounters(state, batch);
+    freeValues(secrets);
+    freeValues(macKey);
+}
+BENCHMARK(BM_GenerateMacShares)->ArgsProduct({PARTY_COUNTS, BATCH_SIZES});
+
+static void BM_ReconstructSecret(benchmark::State &state) {
+    SIZE_T parties = state.range(0);
+    SIZE_T batch = state.range(1);
+    std::vector<std::vector<ShareType>> shares(batch);
+    for (auto &secretShares : shares) secretShares = randomValues(parties);
+    ShareType result = AdditiveSecretSharing::newBigInt();
+    for (auto _ : state) {
+        for (const auto &secretShares : shares) {
+            AdditiveSecretSharing::reconstructSecret(secretShares, result);
+            benchmark::DoNotOptimize(result);
+        }
+    }
+    setCounters(state, batch);
+    for (auto &secretShares : shares) freeValues(secretShares);
+    BN_free(result);
+}
+BENCHMARK(BM_ReconstructSecret)->ArgsProduct({PARTY_COUNTS, BATCH_SIZES});
+
+// addShares(x, y, result): one local addition per secret, independent of the party count
+static void BM_AddSharesPair(benchmark::State &state) {
+    SIZE_T batch = state.range(1);
+    std::vector<ShareType> x = randomValues(batch);
+    std::vector<ShareType> y = randomValues(batch);
+    std::vector<ShareType> sums = randomValues(batch);
+    for (auto _ : state) {
+        for (SIZE_T k = 0; k < batch; ++k) {
+            AdditiveSecretSharing::addShares(x[k], y[k], sums[k]);
+        }
+        benchmark::DoNotOptimize(sums.data());
+    }
+    setCounters(state, batch);
+    freeValues(x);
+    freeValues(y);
+    freeValues(sums);
+}
+BENCHMARK(BM_AddSharesPair)->ArgsProduct({{2}, BATCH_SIZES});
+
+// addShares(vector, result): sums one share per party for every secret
+static void BM_AddSharesVector(benchmark::State &state) {
+    SIZE_T parties = state.range(0);
+    SIZE_T batch = state.range(1);
+    std::vector<std::vector<ShareType>> shares(batch);
+    for (auto &secretShares : shares) secretShares = randomValues(parties);
+    ShareType result = AdditiveSecretSharing::newBigInt();
+    for (auto _ : state) {
+        for (const auto &secretShares : shares) {
+            AdditiveSecretSharing::addShares(secretShares, result);
+            benchmark::DoNotOptimize(result);
+        }
+    }
+    setCounters(state, batch);
+    for (auto &secretShares : shares) freeValues(secretShares);
+    BN_free(result);
+}
+BENCHMARK(BM_AddSharesVector)->ArgsProduct({PARTY_COUNTS, BATCH_SIZES});
+
+// The local step of a Beaver multiplication, independent of the party count
+static void BM_MultiplyShares(benchmark::State &state) {
+    SIZE_T batch = state.range(1);
+    std::vector<ShareType> x = randomValues(batch);
+    std::vector<ShareType> y = randomValues(batch);
+    std::vector<ShareType> products = randomValues(batch);
+    std::vector<BeaverTriple> triples;
+    for (SIZE_T k = 0; k < batch; ++k) {
+        std::vector<ShareType> abc = randomValues(3);
+        triples.push_back({Share(abc[0]), Share(abc[1]), Share(abc[2])});
+    }
+    for (auto _ : state) {
+        for (SIZE_T k = 0; k < batch; ++k) {
+            AdditiveSecretSharing::multiplyShares(x[k], y[k], triples[k], products[k]);
+        }
+        benchmark::DoNotOptimize(products.data());
+    }
+    setCounters(state, batch);
+    freeValues(x);
+    freeValues(y);
+    freeValues(products);
+}
+BENCHMARK(BM_MultiplyShares)->ArgsProduct({{2}, BATCH_SIZES});
+
+// Serialization of one batch message. Party count does not matter; batch is the
+// number of shares per message. bytes/s is measured on the encoded size.
+static const std::vector<int64_t> MESSAGE_SIZES = {1, 64, 1024, 16384};
+
+static void BM_SerializeHexPerShare(benchmark::State &state) {
+    SIZE_T batch = state.range(1);
+    std::vector<ShareType> shares = randomValues(batch);
+    std::vector<ShareType> decoded = randomValues(batch);
+    SIZE_T bytes = 0;
+    for (auto _ : state) {
+        // The pre-codec format: one BN_bn2hex string per share, parsed with BN_hex2bn
+        bytes = 0;
+        for (SIZE_T k = 0; k < batch; ++k) {
+            char* hex = BN_bn2hex(shares[k]);
+            bytes += std::char_traits<char>::length(hex) + 1;
+            BN_hex2bn(&decoded[k], hex);
+            OPENSSL_free(hex);
+        }
+        benchmark::DoNotOptimize(decoded.data());
+    }
+    state.SetBytesProcessed(state.iterations() * bytes);
+    setCounters(state, batch);
+    freeValues(shares);
+    freeValues(decoded);
+}
+BENCHMARK(BM_SerializeHexPerShare)->ArgsProduct({{2}, MESSAGE_SIZES});
+
+static void BM_SerializeHex(benchmark::State &state) {
+    SIZE_T batch = state.range(1);
+    std::vector<ShareType> shares = randomValues(batch);
+    std::vector<ShareType> decoded;
+    std::vector<char> buffer(encodedSharesSize(batch));
+    for (auto _ : state) {
+        SIZE_T length = encodeShares(shares, buffer.data());
+        decodeShares(buffer.data(), length, decoded);
+        benchmark::DoNotOptimize(decoded.data());
+    }
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+    setCounters(state, batch);
+    freeValues(shares);
+    freeValues(decoded);
+}
+BENCHMARK(BM_SerializeHex)->ArgsProduct({{2}, MESSAGE_SIZES});
+
+static void BM_SerializeBinary(benchmark::State &state) {
+    SIZE_T batch = state.range(1);
+    std::vector<ShareType> shares = randomValues(batch);
+    std::vector<ShareType> decoded;
+    std::vector<char> buffer(encodedSharesBinarySize(batch));
+    for (auto _ : state) {
+        SIZE_T length = encodeSharesBinary(shares, buffer.data());
+        decodeSharesBinary(buffer.data(), length, decoded);
+        benchmark::DoNotOptimize(decoded.data());
+    }
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+    setCounters(state, batch);
+    freeValues(shares);
+    freeValues(decoded);
+}
+BENCHMARK(BM_SerializeBinary)->ArgsProduct({{2}, MESSAGE_SIZES});
+
+BENCHMARK_MAIN();
@@ -0,0 +1,239 @@
+// Transport benchmark for every NetIOMPFactory::Mode, all parties in this process on
+// loopback, one thread per party:
+//   latency    two parties ping-pong small messages; round-trip percentiles
+//   throughput party 1 streams payloads of 1 KB .. 64 MB to party 2, which acks the lot
+//   fanout     party 1 sendToAll()s 1 KB and waits for every ack, for growing party counts
+// Results go to stdout as CSV, one row per measurement.
+//
+// usage: bench_transport [--mode NAME]... [--max-payload BYTES] [--max-parties N]
+//                        [--rounds N] [--base-port PORT]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "NetIOMPFactory.h"
+
+using Clock = std::chrono::steady_clock;
+using Mode = NetIOMPFactory::Mode;
+
+struct Options {
+    std::vector<Mode> modes;
+    SIZE_T maxPayload = 64u << 20;
+    int maxParties = 32;
+    int rounds = 2000;
+    int basePort = 17000;
+};
+
+// Every test binds fresh ports so sockets of the previous one cannot interfere
+static int g_nextPort = 0;
+
+static std::vector<std::unique_ptr<INetIOMP>> makeMesh(Mode mode, int parties) {
+    std::map<PARTY_ID_T, std::pair<std::string, int>> partyInfo;
+    for (int pid = 1; pid <= parties; ++pid) {
+        partyInfo[static_cast<PARTY_ID_T>(pid)] = {"127.0.0.1", g_nextPort + pid - 1};
+    }
+    g_nextPort += parties + 1;
+    std::vector<std::unique_ptr<INetIOMP>> nets(parties + 1);
+    for (int pid = 1; pid <= parties; ++pid) {
+        nets[pid] = NetIOMPFactory::createNetIOMP(mode, static_cast<PARTY_ID_T>(pid), partyInfo, parties);
+        nets[pid]->init();
+    }
+    // Connections are set up in the background; give them a moment before timing anything
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    return nets;
+}
+
+// Next message for this endpoint. REQ/REP senders block until their request is answered,
+// so in that mode every received message is acknowledged right away.
+static size_t receiveMessage(INetIOMP &net, Mode mode, std::vector<char> &buffer, PARTY_ID_T &sender) {
+    while (true) {
+        size_t length = net.receive(sender, buffer.data(), buffer.size());
+        if (length == 0) continue; // timed out
+        if (mode == Mode::REQ_REP) {
+            const CMD_T ack = CMD_SUCCESS;
+            net.reply(&ack, sizeof(CMD_T));
+        }
+        return length;
+    }
+}
+
+static double percentile(std::vector<double> sorted, double p) {
+    if (sorted.empty()) return 0;
+    std::sort(sorted.begin(), sorted.end());
+    SIZE_T index = static_cast<SIZE_T>(p * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+static void printHeader() {
+    std::printf("mode,test,parties,payload_bytes,messages,p50_us,p90_us,p99_us,max_us,mean_us,mb_per_s\n");
+}
+
+static void printLatencyRow(Mode mode, const char* test, int parties, SIZE_T payload, const std::vector<double> &us) {
+    double mean = 0;
+    for (double sample : us) mean += sample;
+    mean /= std::max<SIZE_T>(us.size(), 1);
+    std::printf("%s,%s,%d,%lu,%lu,%.2f,%.2f,%.2f,%.2f,%.2f,\n", NetIOMPFactory::modeName(mode).c_str(), test,
+                parties, payload, us.size(), percentile(us, 0.5), percentile(us, 0.9), percentile(us, 0.99),
+                percentile(us, 1.0), mean);
+    std::fflush(stdout);
+}
+
+static void benchLatency(Mode mode, SIZE_T payload, int rounds) {
+    auto nets = makeMesh(mode, 2);
+    const int warmup = std::min(rounds, 100);
+    std::vector<char> message(payload, 'p');
+
+    std::thread echo([&]() {
+        std::vector<char> buffer(payload + 1);
+        PARTY_ID_T sender;
+        for (int r = 0; r < warmup + rounds; ++r) {
+            size_t length = receiveMessage(*nets[2], mode, buffer, sender);
+            nets[2]->sendTo(1, buffer.data(), length);
+        }
+    });
+
+    std::vector<double> us;
+    us.reserve(rounds);
+    std::vector<char> buffer(payload + 1);
+    PARTY_ID_T sender;
+    for (int r = 0; r < warmup + rounds; ++r) {
+        auto start = Clock::now();
+        nets[1]->sendTo(2, message.data(), message.size());
+        receiveMessage(*nets[1], mode, buffer, sender);
+        if (r >= warmup) {
+            us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+        }
+    }
+    echo.join();
+    printLatencyRow(mode, "latency", 2, payload, us);
+}
+
+static void benchThroughput(Mode mode, SIZE_T payload) {
+    auto nets = makeMesh(mode, 2);
+    // About 256 MB per measurement, and never fewer than 4 messages
+    const SIZE_T messages = std::max<SIZE_T>(4, std::min<SIZE_T>(10000, (256u << 20) / payload));
+    std::vector<char> message(payload, 't');
+
+    std::thread sink([&]() {
+        std::vector<char> buffer(payload);
+        PARTY_ID_T sender;
+        for (SIZE_T m = 0; m < messages; ++m) {
+            receiveMessage(*nets[2], mode, buffer, sender);
+        }
+        const CMD_T done = CMD_SUCCESS;
+        nets[2]->sendTo(1, &done, sizeof(CMD_T));
+    });
+
+    std::vector<char> ack(16);
+    PARTY_ID_T sender;
+    auto start = Clock::now();
+    for (SIZE_T m = 0; m < messages; ++m) {
+        nets[1]->sendTo(2, message.data(), message.size());
+    }
+    receiveMessage(*nets[1], mode, ack, sender);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    sink.join();
+
+    double mbPerSecond = static_cast<double>(payload) * messages / seconds / (1 << 20);
+    std::printf("%s,throughput,2,%lu,%lu,,,,,%.2f,%.2f\n", NetIOMPFactory::modeName(mode).c_str(), payload, messages,
+                seconds * 1e6 / messages, mbPerSecond);
+    std::fflush(stdout);
+}
+
+static void benchFanout(Mode mode, int parties, int rounds) {
+    auto nets = makeMesh(mode, parties);
+    const SIZE_T payload = 1024;
+    std::vector<char> message(payload, 'f');
+
+    std::vector<std::thread> receivers;
+    for (int pid = 2; pid <= parties; ++pid) {
+        receivers.emplace_back([&, pid]() {
+            std::vector<char> buffer(payload + 1);
+            PARTY_ID_T sender;
+            const CMD_T ack = CMD_SUCCESS;
+            for (int r = 0; r < rounds; ++r) {
+                receiveMessage(*nets[pid], mode, buffer, sender);
+                nets[pid]->sendTo(1, &ack, sizeof(CMD_T));
+            }
+        });
+    }
+
+    std::vector<double> us;
+    us.reserve(rounds);
+    std::vector<char> buffer(16);
+    PARTY_ID_T sender;
+    for (int r = 0; r < rounds; ++r) {
+        auto start = Clock::now();
+        nets[1]->sendToAll(message.data(), message.size());
+        for (int pid = 2; pid <= parties; ++pid) {
+            receiveMessage(*nets[1], mode, buffer, sender);
+        }
+        us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    for (auto &receiver : receivers) receiver.join();
+    printLatencyRow(mode, "fanout", parties, payload, us);
+}
+
+static Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+        std::string value = argv[++i];
+        if (arg == "--mode") {
+            bool known = false;
+            for (Mode mode : NetIOMPFactory::allModes()) {
+                if (NetIOMPFactory::modeName(mode) == value) {
+                    options.modes.push_back(mode);
+                    known = true;
+                }
+            }
+            if (!known) throw std::invalid_argument("Unknown mode: " + value);
+        } else if (arg == "--max-payload") {
+            options.maxPayload = std::stoul(value);
+        } else if (arg == "--max-parties") {
+            options.maxParties = std::stoi(value);
+        } else if (arg == "--rounds") {
+            options.rounds = std::stoi(value);
+        } else if (arg == "--base-port") {
+            options.basePort = std::stoi(value);
+        } else {
+            throw std::invalid_argument("Unknown option: " + arg);
+        }
+    }
+    if (options.modes.empty()) options.modes = NetIOMPFactory::allModes();
+    return options;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    g_nextPort = options.basePort;
+
+    printHeader();
+    for (Mode mode : options.modes) {
+        for (SIZE_T payload : {8ul, 64ul, 512ul}) {
+            benchLatency(mode, payload, options.rounds);
+        }
+        for (SIZE_T payload = 1024; payload <= options.maxPayload; payload *= 4) {
+            benchThroughput(mode, payload);
+        }
+        // Fewer rounds for large meshes, where a round is one message per party
+        for (int parties = 2; parties <= options.maxParties; parties *= 2) {
+            benchFanout(mode, parties, std::max(20, options.rounds / parties));
+        }
+    }
+    return 0;
+}
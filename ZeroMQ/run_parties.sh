@@ -2,10 +2,14 @@
 
 # Usage function
 usage() {
-    echo "Usage: $0 <num_mpc_parties> [mode] [operation]"
+    echo "Usage: $0 <num_mpc_parties> [mode] [operation] [partitions] [security] [batch] [input_parties]"
     echo "Modes: reqrep, dealerrouter (default: dealerrouter)"
     echo "Default number of MPC parties: 3"
-    echo "Default operation: add"
+    echo "Default operation: add (use \"ip\", \"matmul\" or \"circuit\" to also run the inner-product, matrix or circuit phase)"
+    echo "Default partitions: 1 (use N to run every party as N processes, each on a slice of the inputs)"
+    echo "Default security: malicious (use \"semihonest\" to run without MACs)"
+    echo "Default batch: 2 (number of inputs the secret party shares)"
+    echo "Default input parties: 1 (use M to also start input parties NUM_PARTIES+2..NUM_PARTIES+M, sharing concurrently with the dealer)"
     echo "We automatically create one additional parties (IDs = NUM_PARTIES+1) holding secrets."
     exit 1
 }
@@ -18,17 +22,36 @@ fi
 NUM_MPC_PARTIES=${1:-3}  # Default to 3 parties if not specified
 MODE=${2:-dealerrouter}  # Default to dealerrouter if not specified
 OPERATION=${3:-add}  # Default operation is "add" if not specified
+PARTITIONS=${4:-1}  # Default: one process per party
+SECURITY=${5:-malicious}  # Default: MAC-checked protocol
+BATCH=${6:-2}  # Default: two inputs
+INPUT_PARTIES=${7:-1}  # Default: only the dealer holds inputs
+# Must match PARTITION_PORT_STRIDE and PARTITION_CONTROL_OFFSET in src/config.h
+PORT_STRIDE=1000
+CONTROL_OFFSET=500
 
-# The total parties = MPC parties + 1 secret parties
-TOTAL_PARTIES=$((NUM_MPC_PARTIES + 1))
+if [ "$INPUT_PARTIES" -gt 1 ] && [ "$PARTITIONS" -gt 1 ]; then
+    echo "Input parties other than the dealer cannot be partitioned."
+    exit 1
+fi
 
-echo "Launching $NUM_MPC_PARTIES MPC parties + 1 secret parties = $TOTAL_PARTIES total."
-echo "Mode: $MODE, Operation: $OPERATION"
+# The total parties = MPC parties + secret parties
+TOTAL_PARTIES=$((NUM_MPC_PARTIES + INPUT_PARTIES))
+
+echo "Launching $NUM_MPC_PARTIES MPC parties + $INPUT_PARTIES secret parties = $TOTAL_PARTIES total."
+echo "Mode: $MODE, Operation: $OPERATION, Partitions: $PARTITIONS, Security: $SECURITY, Batch: $BATCH, Input parties: $INPUT_PARTIES"
 
 # Clean ports
 PORTS=()
-for ((i=0; i<$NUM_MPC_PARTIES; i++)); do
-    PORTS+=($((5555 + i)))
+for ((q=0; q<$PARTITIONS; q++)); do
+    for ((i=0; i<$NUM_MPC_PARTIES; i++)); do
+        PORTS+=($((5555 + q * PORT_STRIDE + i)))
+    done
+    if [ "$PARTITIONS" -gt 1 ]; then
+        for ((i=0; i<$TOTAL_PARTIES; i++)); do
+            PORTS+=($((5555 + q * PORT_STRIDE + CONTROL_OFFSET + i)))
+        done
+    fi
 done
 
 # Function to clean ports
@@ -55,20 +78,25 @@ clean_ports
 PIDS=()
 for ((i=1; i<=$NUM_MPC_PARTIES; i++)); do
     INPUT_VALUE=$((i * 10))
-    ./netiomp_test "$MODE" "$i" "$NUM_MPC_PARTIES" "$INPUT_VALUE" 0 "$OPERATION" &
-    PIDS+=($!)
+    for ((q=0; q<$PARTITIONS; q++)); do
+        ./netiomp_test "$MODE" "$i" "$NUM_MPC_PARTIES" "$INPUT_VALUE" 0 "$OPERATION" "$q" "$PARTITIONS" --security="$SECURITY" &
+        PIDS+=($!)
+    done
     sleep 1
 done
 
 sleep 1
 # Now launch the secret parties
 SECRET_PARTY_1=$((NUM_MPC_PARTIES + 1))
+LAST_SECRET_PARTY=$((NUM_MPC_PARTIES + INPUT_PARTIES))
 
-for sp in $SECRET_PARTY_1; do
+for ((sp=$SECRET_PARTY_1; sp<=$LAST_SECRET_PARTY; sp++)); do
     INPUT_VALUE=$((sp * 10))
-    ./netiomp_test "$MODE" "$sp" "$NUM_MPC_PARTIES" "$INPUT_VALUE" 1 "$OPERATION" &
-    PIDS+=($!)
-    sleep 1
+    for ((q=0; q<$PARTITIONS; q++)); do
+        # Only the dealer (the first secret party) collects the other input parties
+        ./netiomp_test "$MODE" "$sp" "$NUM_MPC_PARTIES" "$INPUT_VALUE" 1 "$OPERATION" "$q" "$PARTITIONS" --security="$SECURITY" --batch="$BATCH" --input-parties="$INPUT_PARTIES" &
+        PIDS+=($!)
+    done
 done
 
 # Wait for all parties to finish
@@ -1,30 +1,64 @@
 #include "AdditiveSecretSharing.h"
 #include "config.h"
+#include "ThreadPool.h"
 #include <openssl/bn.h>
 #include <openssl/rand.h>
+#include <openssl/evp.h>
 #include <chrono>
 #include <stdexcept>
+#include <algorithm>
+#include <functional>
 
-// Thread-local context: used for BN operations
-static thread_local BN_CTX* s_bnCtx = nullptr;
+// Thread-local context: used for BN operations, freed when its thread exits
+struct ThreadLocalCtx {
+    BN_CTX* ctx = nullptr;
+    ~ThreadLocalCtx() { BN_CTX_free(ctx); }
+};
+static thread_local ThreadLocalCtx s_bnCtx;
 // Thread-local prime
-static thread_local BIGNUM* s_prime = nullptr;
+struct ThreadLocalPrime {
+    BIGNUM* prime = nullptr;
+    ~ThreadLocalPrime() { BN_free(prime); }
+};
+static thread_local ThreadLocalPrime s_prime;
+
+// Tile edge for the matrix kernels, sized so a tile of BIGNUM pointers stays in L1
+static const SIZE_T GEMM_BLOCK = 32;
+// Below this many multiply-adds the matrix kernels stay on the calling thread
+static const SIZE_T GEMM_PARALLEL_THRESHOLD = 32 * 32 * 32;
+
+// PRG output per derived value: twice the prime's width keeps the bias mod p negligible
+static const SIZE_T PRG_BYTES_PER_VALUE = 32;
 
 BIGNUM* AdditiveSecretSharing::getPrime() {
-    if (!s_prime) {
-        s_prime = BN_new();
-        if (!s_prime) throw std::runtime_error("Failed to allocate prime BIGNUM");
-        BN_dec2bn(&s_prime, PRIME_128_STR); // from config.h
+    if (!s_prime.prime) {
+        s_prime.prime = BN_new();
+        if (!s_prime.prime) throw std::runtime_error("Failed to allocate prime BIGNUM");
+        BN_dec2bn(&s_prime.prime, PRIME_128_STR); // from config.h
     }
-    return s_prime;
+    return s_prime.prime;
 }
 
 BN_CTX* AdditiveSecretSharing::getCtx() {
-    if (!s_bnCtx) {
-        s_bnCtx = BN_CTX_new();
-        if (!s_bnCtx) throw std::runtime_error("Failed to create BN_CTX");
+    if (!s_bnCtx.ctx) {
+        s_bnCtx.ctx = BN_CTX_new();
+        if (!s_bnCtx.ctx) throw std::runtime_error("Failed to create BN_CTX");
     }
-    return s_bnCtx;
+    return s_bnCtx.ctx;
+}
+
+BigIntScratch::BigIntScratch(BN_CTX* ctx) : m_ctx(ctx) {
+    BN_CTX_start(m_ctx);
+}
+
+BigIntScratch::~BigIntScratch() {
+    BN_CTX_end(m_ctx);
+}
+
+BIGNUM* BigIntScratch::get() {
+    BIGNUM* bn = BN_CTX_get(m_ctx);
+    if (!bn) throw std::runtime_error("BN_CTX_get failed");
+    return bn;
 }
 
 ShareType AdditiveSecretSharing::newBigInt() {
@@ -43,11 +77,10 @@ ShareType AdditiveSecretSharing::cloneBigInt(ShareType source) {
 }
 
 void AdditiveSecretSharing::generateShares(ShareType secret, int numParties, std::vector<ShareType>& sharesOut) {
-    // unsigned seedValue = (unsigned)time(NULL);
-    // RAND_seed(&seedValue, sizeof(seedValue));
     sharesOut.resize(numParties);
 
-    BIGNUM* sumSoFar = newBigInt(); // Initialize to 0
+    BigIntScratch scratch;
+    BIGNUM* sumSoFar = scratch.get(); // Initialize to 0
     for(int i = 0; i < numParties; i++) {
         sharesOut[i] = newBigInt();
     }
@@ -57,31 +90,38 @@ void AdditiveSecretSharing::generateShares(ShareType secret, int numParties, std
         BN_mod_add(sumSoFar, sumSoFar, sharesOut[i], getPrime(), getCtx());
     }
 
-    BIGNUM* tmp = newBigInt();
-    BN_mod_sub(tmp, secret, sumSoFar, getPrime(), getCtx());
-    BN_copy(sharesOut[numParties - 1], tmp);
+    BN_mod_sub(sharesOut[numParties - 1], secret, sumSoFar, getPrime(), getCtx());
+}
 
-    BN_free(tmp);
-    BN_free(sumSoFar);
+std::vector<Share> AdditiveSecretSharing::generateShares(ShareType secret, int numParties) {
+    std::vector<ShareType> raw;
+    generateShares(secret, numParties, raw);
+    return adoptShares(raw);
 }
 
 void AdditiveSecretSharing::generateMacShares(ShareType secret, ShareType macKey, PARTY_ID_T numParties, std::vector<ShareType>& sharesOut) {
     sharesOut.resize(numParties);
 
-    ShareType macSecret = newBigInt();
+    BigIntScratch scratch;
+    ShareType macSecret = scratch.get();
     BN_mod_mul(macSecret, secret, macKey, getPrime(), getCtx());
     generateShares(macSecret, numParties, sharesOut);
-    BN_free(macSecret);
+}
+
+std::vector<Share> AdditiveSecretSharing::generateMacShares(ShareType secret, ShareType macKey, PARTY_ID_T numParties) {
+    std::vector<ShareType> raw;
+    generateMacShares(secret, macKey, numParties, raw);
+    return adoptShares(raw);
 }
 
 void AdditiveSecretSharing::reconstructSecret(const std::vector<ShareType>& shares, ShareType &result) {
-    BIGNUM* total = newBigInt();
+    BigIntScratch scratch;
+    BIGNUM* total = scratch.get();
     for (auto s : shares) {
         BN_mod_add(total, total, s, getPrime(), getCtx());
     }
     // Copy final value into caller-provided space
     BN_copy(result, total);
-    BN_free(total);
 }
 
 // Remove or comment out any leftover function:
@@ -106,42 +146,30 @@ void AdditiveSecretSharing::addShares(const std::vector<ShareType>& inputShares,
 void AdditiveSecretSharing::multiplyShares(ShareType x, ShareType y,
                                            const BeaverTriple &triple, ShareType &product)
 {
+    BigIntScratch scratch;
     // 1) Locally compute d = (x - a), e = (y - b)
-    BIGNUM* d = newBigInt();
-    BIGNUM* e = newBigInt();
+    BIGNUM* d = scratch.get();
+    BIGNUM* e = scratch.get();
     if(!BN_mod_sub(d, x, triple.a, getPrime(), getCtx())) {
         throw std::runtime_error("BN_mod_sub failed for d");
     }
     if(!BN_mod_sub(e, y, triple.b, getPrime(), getCtx())) {
-        BN_free(d);
         throw std::runtime_error("BN_mod_sub failed for e");
     }
 
     // 2) Compute a * E and b * D
-    BIGNUM* aE = newBigInt();
-    BIGNUM* bD = newBigInt();
+    BIGNUM* aE = scratch.get();
+    BIGNUM* bD = scratch.get();
     if(!BN_mod_mul(aE, triple.a, e, getPrime(), getCtx())) {
-        BN_free(d);
-        BN_free(e);
-        BN_free(aE);
         throw std::runtime_error("BN_mod_mul failed for aE");
     }
     if(!BN_mod_mul(bD, triple.b, d, getPrime(), getCtx())) {
-        BN_free(d);
-        BN_free(e);
-        BN_free(aE);
-        BN_free(bD);
         throw std::runtime_error("BN_mod_mul failed for bD");
     }
 
     // 3) Compute D * E
-    BIGNUM* DE = newBigInt();
+    BIGNUM* DE = scratch.get();
     if(!BN_mod_mul(DE, d, e, getPrime(), getCtx())) {
-        BN_free(d);
-        BN_free(e);
-        BN_free(aE);
-        BN_free(bD);
-        BN_free(DE);
         throw std::runtime_error("BN_mod_mul failed for DE");
     }
 
@@ -155,11 +183,185 @@ void AdditiveSecretSharing::multiplyShares(ShareType x, ShareType y,
     if(!BN_mod_add(product, product, DE, getPrime(), getCtx())) {
         throw std::runtime_error("BN_mod_add failed for + DE");
     }
+}
+
+void AdditiveSecretSharing::innerProductShares(const std::vector<ShareType>& D, const std::vector<ShareType>& E,
+                                               const InnerProductTriple &triple, ShareType deFactor, ShareType &result)
+{
+    if (D.size() != E.size() || D.size() != triple.a.size() || D.size() != triple.b.size()) {
+        throw std::runtime_error("innerProductShares: length mismatch");
+    }
+    // Accumulate a_k * E_k + b_k * D_k and D_k * E_k without modular reduction
+    BigIntScratch scratch;
+    BIGNUM* acc = scratch.get();
+    BIGNUM* deAcc = scratch.get();
+    BIGNUM* term = scratch.get();
+    for (size_t k = 0; k < D.size(); ++k) {
+        if (!BN_mul(term, triple.a[k], E[k], getCtx()) || !BN_add(acc, acc, term) ||
+            !BN_mul(term, triple.b[k], D[k], getCtx()) || !BN_add(acc, acc, term)) {
+            throw std::runtime_error("BN_mul/BN_add failed for a*E + b*D");
+        }
+        if (deFactor && (!BN_mul(term, D[k], E[k], getCtx()) || !BN_add(deAcc, deAcc, term))) {
+            throw std::runtime_error("BN_mul/BN_add failed for D*E");
+        }
+    }
+    // Fold in deFactor * sum(D_k * E_k) and c, then reduce once
+    if (deFactor && (!BN_nnmod(deAcc, deAcc, getPrime(), getCtx()) ||
+                     !BN_mul(term, deAcc, deFactor, getCtx()) || !BN_add(acc, acc, term))) {
+        throw std::runtime_error("BN_mul/BN_add failed for deFactor * D*E");
+    }
+    if (!BN_add(acc, acc, triple.c) || !BN_nnmod(result, acc, getPrime(), getCtx())) {
+        throw std::runtime_error("BN_nnmod failed for inner product");
+    }
+}
+
+// acc[i*cols + j] += sum_t X[i*inner + t] * Y[t*cols + j] for rows [rowBegin, rowEnd), unreduced
+static void gemmAccumulate(const std::vector<ShareType>& X, const std::vector<ShareType>& Y,
+                           SIZE_T rowBegin, SIZE_T rowEnd, SIZE_T inner, SIZE_T cols,
+                           std::vector<BIGNUM*>& acc, BIGNUM* term, BN_CTX* ctx)
+{
+    for (SIZE_T i0 = rowBegin; i0 < rowEnd; i0 += GEMM_BLOCK) {
+        SIZE_T i1 = std::min(i0 + GEMM_BLOCK, rowEnd);
+        for (SIZE_T t0 = 0; t0 < inner; t0 += GEMM_BLOCK) {
+            SIZE_T t1 = std::min(t0 + GEMM_BLOCK, inner);
+            for (SIZE_T j0 = 0; j0 < cols; j0 += GEMM_BLOCK) {
+                SIZE_T j1 = std::min(j0 + GEMM_BLOCK, cols);
+                for (SIZE_T i = i0; i < i1; ++i) {
+                    for (SIZE_T t = t0; t < t1; ++t) {
+                        const BIGNUM* x = X[i * inner + t];
+                        for (SIZE_T j = j0; j < j1; ++j) {
+                            if (!BN_mul(term, x, Y[t * cols + j], ctx) ||
+                                !BN_add(acc[i * cols + j], acc[i * cols + j], term)) {
+                                throw std::runtime_error("BN_mul/BN_add failed in matrix kernel");
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Runs work(rowBegin, rowEnd, ctx) over row blocks, on worker threads when the product is large
+static void forEachRowBlock(SIZE_T rows, SIZE_T work,
+                            const std::function<void(SIZE_T, SIZE_T, BN_CTX*)>& body)
+{
+    if (work < GEMM_PARALLEL_THRESHOLD) {
+        body(0, rows, AdditiveSecretSharing::getCtx());
+        return;
+    }
+    // Whole row blocks per chunk; each pool thread uses its own thread-local BN_CTX
+    SIZE_T blocks = (rows + GEMM_BLOCK - 1) / GEMM_BLOCK;
+    ThreadPool::shared().parallelFor(0, blocks, 1, [&](SIZE_T blockBegin, SIZE_T blockEnd) {
+        body(blockBegin * GEMM_BLOCK, std::min(rows, blockEnd * GEMM_BLOCK), AdditiveSecretSharing::getCtx());
+    });
+}
+
+static void allocateMatrix(std::vector<ShareType>& matrix, SIZE_T size)
+{
+    matrix.resize(size, nullptr);
+    for (auto &entry : matrix) {
+        if (!entry) entry = AdditiveSecretSharing::newBigInt();
+    }
+}
+
+void AdditiveSecretSharing::matrixMultiply(const std::vector<ShareType>& X, const std::vector<ShareType>& Y,
+                                           SIZE_T rows, SIZE_T inner, SIZE_T cols, std::vector<ShareType>& result)
+{
+    if (X.size() != rows * inner || Y.size() != inner * cols) {
+        throw std::runtime_error("matrixMultiply: dimension mismatch");
+    }
+    allocateMatrix(result, rows * cols);
+    const BIGNUM* prime = getPrime();
+    forEachRowBlock(rows, rows * inner * cols, [&](SIZE_T rowBegin, SIZE_T rowEnd, BN_CTX* ctx) {
+        BigIntScratch scratch(ctx);
+        BIGNUM* term = scratch.get();
+        std::vector<BIGNUM*> acc(rows * cols, nullptr);
+        for (SIZE_T i = rowBegin * cols; i < rowEnd * cols; ++i) {
+            acc[i] = result[i];
+            BN_zero(acc[i]);
+        }
+        gemmAccumulate(X, Y, rowBegin, rowEnd, inner, cols, acc, term, ctx);
+        for (SIZE_T i = rowBegin * cols; i < rowEnd * cols; ++i) {
+            BN_nnmod(acc[i], acc[i], prime, ctx);
+        }
+    });
+}
+
+void AdditiveSecretSharing::matrixProductShares(const std::vector<ShareType>& D, const std::vector<ShareType>& E,
+                                                const MatrixTriple &triple, ShareType deFactor, std::vector<ShareType>& result)
+{
+    SIZE_T rows = triple.rows, inner = triple.inner, cols = triple.cols;
+    if (D.size() != rows * inner || E.size() != inner * cols ||
+        triple.A.size() != rows * inner || triple.B.size() != inner * cols || triple.C.size() != rows * cols) {
+        throw std::runtime_error("matrixProductShares: dimension mismatch");
+    }
+    allocateMatrix(result, rows * cols);
+    const BIGNUM* prime = getPrime();
+    forEachRowBlock(rows, rows * inner * cols, [&](SIZE_T rowBegin, SIZE_T rowEnd, BN_CTX* ctx) {
+        BigIntScratch scratch(ctx);
+        BIGNUM* term = scratch.get();
+        std::vector<BIGNUM*> acc(rows * cols, nullptr);
+        std::vector<BIGNUM*> deAcc(rows * cols, nullptr);
+        for (SIZE_T i = rowBegin * cols; i < rowEnd * cols; ++i) {
+            acc[i] = result[i];
+            BN_copy(acc[i], triple.C[i]);
+            if (deFactor) deAcc[i] = scratch.get();
+        }
+        // A * E + D * B share one unreduced accumulator per entry
+        gemmAccumulate(triple.A, E, rowBegin, rowEnd, inner, cols, acc, term, ctx);
+        gemmAccumulate(D, triple.B, rowBegin, rowEnd, inner, cols, acc, term, ctx);
+        if (deFactor) {
+            gemmAccumulate(D, E, rowBegin, rowEnd, inner, cols, deAcc, term, ctx);
+        }
+        for (SIZE_T i = rowBegin * cols; i < rowEnd * cols; ++i) {
+            if (deFactor && (!BN_nnmod(deAcc[i], deAcc[i], prime, ctx) ||
+                             !BN_mul(term, deAcc[i], deFactor, ctx) || !BN_add(acc[i], acc[i], term))) {
+                throw std::runtime_error("BN_mul/BN_add failed for deFactor * D*E");
+            }
+            if (!BN_nnmod(acc[i], acc[i], prime, ctx)) {
+                throw std::runtime_error("BN_nnmod failed for matrix product");
+            }
+        }
+    });
+}
+
+std::string AdditiveSecretSharing::sha256(const std::string& data) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLength = 0;
+    if (EVP_Digest(data.data(), data.size(), digest, &digestLength, EVP_sha256(), nullptr) != 1) {
+        throw std::runtime_error("SHA-256 digest failed");
+    }
+    return std::string(reinterpret_cast<const char*>(digest), digestLength);
+}
+
+std::string AdditiveSecretSharing::randomBytes(SIZE_T n) {
+    std::string bytes(n, '\0');
+    if (n > 0 && RAND_bytes(reinterpret_cast<unsigned char*>(&bytes[0]), static_cast<int>(n)) != 1) {
+        throw std::runtime_error("RAND_bytes failed");
+    }
+    return bytes;
+}
+
+void AdditiveSecretSharing::expandSeed(const std::string& seed, SIZE_T count, std::vector<ShareType>& values) {
+    std::string key = sha256(seed);
+    std::vector<unsigned char> stream(count * PRG_BYTES_PER_VALUE, 0);
+    unsigned char iv[16] = {0};
+    int outLength = 0;
+    EVP_CIPHER_CTX* cipher = EVP_CIPHER_CTX_new();
+    if (!cipher) throw std::runtime_error("Failed to allocate cipher context");
+    // Encrypting zeros in CTR mode yields the raw keystream
+    bool ok = EVP_EncryptInit_ex(cipher, EVP_aes_128_ctr(), nullptr,
+                                 reinterpret_cast<const unsigned char*>(key.data()), iv) == 1 &&
+              (stream.empty() || EVP_EncryptUpdate(cipher, stream.data(), &outLength, stream.data(),
+                                                   static_cast<int>(stream.size())) == 1);
+    EVP_CIPHER_CTX_free(cipher);
+    if (!ok) throw std::runtime_error("AES-CTR seed expansion failed");
 
-    // 5) Free temporary BIGNUMs
-    BN_free(d);
-    BN_free(e);
-    BN_free(aE);
-    BN_free(bD);
-    BN_free(DE);
+    values.resize(count);
+    for (SIZE_T k = 0; k < count; ++k) {
+        values[k] = BN_bin2bn(stream.data() + k * PRG_BYTES_PER_VALUE, PRG_BYTES_PER_VALUE, nullptr);
+        if (!values[k]) throw std::runtime_error("BN_bin2bn failed");
+        BN_nnmod(values[k], values[k], getPrime(), getCtx());
+    }
 }
\ No newline at end of file
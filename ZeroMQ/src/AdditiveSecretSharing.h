@@ -1,20 +1,46 @@
 #pragma once
 #include <vector>
+#include <string>
 #include <random>
 #include <cstdint>
 #include "config.h"
+#include "Share.h"
 #include <openssl/bn.h>
 
 
 
 /**
  * @brief Struct or class to represent a Beaver Triple (a, b, c).
- *        For brevity, not all details are shown.
+ *        For brevity, not all details are shown. The triple owns its shares.
  */
 struct BeaverTriple {
-    ShareType a;
-    ShareType b;
-    ShareType c;
+    Share a;
+    Share b;
+    Share c;
+};
+
+/**
+ * @brief Correlated randomness for an inner product of length N:
+ *        vectors a, b and a single c = <a, b>, so only 2N + 1 shares
+ *        travel instead of the 3N of N independent triples.
+ */
+struct InnerProductTriple {
+    std::vector<ShareType> a;
+    std::vector<ShareType> b;
+    ShareType c = nullptr;
+};
+
+/**
+ * @brief Matrix Beaver triple A (rows x inner), B (inner x cols) and C = A * B,
+ *        all stored row-major.
+ */
+struct MatrixTriple {
+    SIZE_T rows = 0;
+    SIZE_T inner = 0;
+    SIZE_T cols = 0;
+    std::vector<ShareType> A;
+    std::vector<ShareType> B;
+    std::vector<ShareType> C;
 };
 
 /**
@@ -29,6 +55,10 @@ public:
      * @param sharesOut Vector to store the generated shares (size = numParties).
      */
     static void generateShares(ShareType secret, int numParties, std::vector<ShareType>& sharesOut);
+    /**
+     * @brief generateShares returning owned shares.
+     */
+    static std::vector<Share> generateShares(ShareType secret, int numParties);
     /**
      * @brief Generates n additive shares of multiplication of secret with a mac key, mod PRIME_MODULUS.
      * @param secret The original secret value in [0..PRIME_MODULUS-1].
@@ -37,6 +67,10 @@ public:
      * @param sharesOut Vector to store the generated shares (size = numParties).
      */
     static void generateMacShares(ShareType secret, ShareType macKey, PARTY_ID_T numParties, std::vector<ShareType>& sharesOut);
+    /**
+     * @brief generateMacShares returning owned shares.
+     */
+    static std::vector<Share> generateMacShares(ShareType secret, ShareType macKey, PARTY_ID_T numParties);
 
     /**
      * @brief Reconstructs the secret from shares, mod PRIME_MODULUS.
@@ -70,6 +104,59 @@ public:
     static void multiplyShares(ShareType x, ShareType y,
                                const BeaverTriple &triple, ShareType &product);
 
+    /**
+     * @brief Computes this party's share of <x, y> once D = x - a and E = y - b are open.
+     *        Products are accumulated unreduced and reduced mod PRIME_MODULUS only once.
+     * @param D Opened values x_k - a_k.
+     * @param E Opened values y_k - b_k.
+     * @param triple This party's inner-product triple shares (or their MAC shares).
+     * @param deFactor Multiplier of the public term sum(D_k * E_k): one for a single
+     *                 designated party, the MAC key share for MAC shares, nullptr to skip it.
+     * @param result c + sum(a_k * E_k + b_k * D_k) + deFactor * sum(D_k * E_k).
+     */
+    static void innerProductShares(const std::vector<ShareType>& D, const std::vector<ShareType>& E,
+                                   const InnerProductTriple &triple, ShareType deFactor, ShareType &result);
+
+    /**
+     * @brief Multiplies two row-major matrices mod PRIME_MODULUS with a cache-blocked
+     *        kernel that splits row blocks across threads.
+     * @param X Left matrix (rows x inner).
+     * @param Y Right matrix (inner x cols).
+     * @param result Output matrix (rows x cols), resized and allocated as needed.
+     */
+    static void matrixMultiply(const std::vector<ShareType>& X, const std::vector<ShareType>& Y,
+                               SIZE_T rows, SIZE_T inner, SIZE_T cols, std::vector<ShareType>& result);
+
+    /**
+     * @brief Computes this party's share of X * Y once D = X - A and E = Y - B are open.
+     * @param D Opened matrix X - A (rows x inner).
+     * @param E Opened matrix Y - B (inner x cols).
+     * @param triple This party's matrix triple shares (or their MAC shares).
+     * @param deFactor Multiplier of the public term D * E, as in innerProductShares().
+     * @param result C + A * E + D * B + deFactor * (D * E), resized and allocated as needed.
+     */
+    static void matrixProductShares(const std::vector<ShareType>& D, const std::vector<ShareType>& E,
+                                    const MatrixTriple &triple, ShareType deFactor, std::vector<ShareType>& result);
+
+    /**
+     * @brief SHA-256 digest of data (32 raw bytes), used for commitments and seeds.
+     */
+    static std::string sha256(const std::string& data);
+
+    /**
+     * @brief Returns n bytes from the OpenSSL CSPRNG.
+     */
+    static std::string randomBytes(SIZE_T n);
+
+    /**
+     * @brief Expands a short seed into count field elements with AES-128-CTR.
+     *        Every party holding the same seed derives the same values.
+     * @param seed Shared seed; its SHA-256 digest keys the cipher.
+     * @param count Number of values to derive.
+     * @param values Output values mod PRIME_MODULUS (caller frees).
+     */
+    static void expandSeed(const std::string& seed, SIZE_T count, std::vector<ShareType>& values);
+
     /**
      * @brief Creates and returns a new BIGNUM with value = 0.
      */
@@ -95,4 +182,25 @@ private:
      * @brief For demonstration, a naive random distribution used in generateShares().
      */
     static std::mt19937& getRng();
+};
+
+/**
+ * @brief RAII frame of scratch BIGNUMs on a thread's BN_CTX (BN_CTX_start / BN_CTX_end).
+ *        The context keeps its BIGNUMs when a frame ends and hands them out again, so
+ *        temporaries on the hot path stop allocating once a thread has warmed up, and
+ *        they are released on every exit path. Values from get() start at zero, belong
+ *        to the frame and must be neither freed nor kept past it. Frames nest, so callees
+ *        may open their own; they must end on the thread that opened them.
+ */
+class BigIntScratch {
+public:
+    explicit BigIntScratch(BN_CTX* ctx = AdditiveSecretSharing::getCtx());
+    ~BigIntScratch();
+    BigIntScratch(const BigIntScratch&) = delete;
+    BigIntScratch& operator=(const BigIntScratch&) = delete;
+
+    BIGNUM* get();
+
+private:
+    BN_CTX* m_ctx;
 };
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "BufferPool.h"
+#include <stdexcept>
+#include <string>
+
+PooledBuffer::PooledBuffer(BufferPool* pool, SIZE_T sizeClass, std::unique_ptr<char[]> data)
+    : m_pool(pool), m_sizeClass(sizeClass), m_data(std::move(data))
+{
+}
+
+PooledBuffer::~PooledBuffer() {
+    giveBack();
+}
+
+PooledBuffer::PooledBuffer(PooledBuffer &&other) noexcept
+    : m_pool(other.m_pool), m_sizeClass(other.m_sizeClass), m_data(std::move(other.m_data)), m_size(other.m_size)
+{
+    other.m_pool = nullptr;
+    other.m_size = 0;
+}
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer &&other) noexcept {
+    if (this != &other) {
+        giveBack();
+        m_pool = other.m_pool;
+        m_sizeClass = other.m_sizeClass;
+        m_data = std::move(other.m_data);
+        m_size = other.m_size;
+        other.m_pool = nullptr;
+        other.m_size = 0;
+    }
+    return *this;
+}
+
+SIZE_T PooledBuffer::capacity() const {
+    return m_data ? BufferPool::classCapacity(m_sizeClass) : 0;
+}
+
+void PooledBuffer::resize(SIZE_T size) {
+    if (size > capacity()) {
+        throw std::runtime_error("PooledBuffer: size " + std::to_string(size) + " exceeds capacity " +
+                                 std::to_string(capacity()));
+    }
+    m_size = size;
+}
+
+void PooledBuffer::giveBack() {
+    if (m_pool && m_data) {
+        m_pool->release(m_sizeClass, std::move(m_data));
+    }
+    m_pool = nullptr;
+    m_data.reset();
+    m_size = 0;
+}
+
+PooledBuffer BufferPool::acquire(SIZE_T minCapacity) {
+    SIZE_T sizeClass = 0;
+    while (classCapacity(sizeClass) < minCapacity) ++sizeClass;
+    if (sizeClass >= m_idle.size()) {
+        m_idle.resize(sizeClass + 1);
+    }
+    auto &idle = m_idle[sizeClass];
+    if (idle.empty()) {
+        ++m_allocations;
+        // Reserve now so that returning this buffer later never grows the free list
+        idle.reserve(BUFFER_POOL_MAX_IDLE);
+        return PooledBuffer(this, sizeClass, std::unique_ptr<char[]>(new char[classCapacity(sizeClass)]));
+    }
+    PooledBuffer buffer(this, sizeClass, std::move(idle.back()));
+    idle.pop_back();
+    return buffer;
+}
+
+void BufferPool::release(SIZE_T sizeClass, std::unique_ptr<char[]> data) {
+    auto &idle = m_idle[sizeClass];
+    if (idle.size() < BUFFER_POOL_MAX_IDLE) {
+        idle.push_back(std::move(data));
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "config.h"
+
+class BufferPool;
+
+/**
+ * @brief A message buffer on loan from a BufferPool. It goes back to its pool when
+ *        destroyed, so the next message of a similar size reuses the same memory.
+ */
+class PooledBuffer {
+public:
+    PooledBuffer() = default;
+    ~PooledBuffer();
+    PooledBuffer(PooledBuffer &&other) noexcept;
+    PooledBuffer& operator=(PooledBuffer &&other) noexcept;
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    char* data() { return m_data.get(); }
+    const char* data() const { return m_data.get(); }
+    SIZE_T capacity() const;
+
+    // Number of valid bytes, as set by the writer or receiver
+    SIZE_T size() const { return m_size; }
+    void resize(SIZE_T size);
+
+private:
+    friend class BufferPool;
+    PooledBuffer(BufferPool* pool, SIZE_T sizeClass, std::unique_ptr<char[]> data);
+    void giveBack();
+
+    BufferPool* m_pool = nullptr;
+    SIZE_T m_sizeClass = 0;
+    std::unique_ptr<char[]> m_data;
+    SIZE_T m_size = 0;
+};
+
+/**
+ * @brief Size-classed free lists of message buffers for one session. Capacities are
+ *        powers of two from BUFFER_POOL_MIN_CAPACITY, so once every size class in use
+ *        has been touched, acquiring and returning buffers no longer allocates.
+ *        Not thread-safe: a pool belongs to the thread that owns the session's socket,
+ *        and it must outlive every buffer it hands out.
+ */
+class BufferPool {
+public:
+    BufferPool() = default;
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * @brief A buffer with at least minCapacity bytes and size() == 0.
+     */
+    PooledBuffer acquire(SIZE_T minCapacity);
+
+    static SIZE_T classCapacity(SIZE_T sizeClass) { return BUFFER_POOL_MIN_CAPACITY << sizeClass; }
+
+    // Buffers this pool had to allocate because no idle one of the right class was left
+    SIZE_T allocations() const { return m_allocations; }
+
+private:
+    friend class PooledBuffer;
+    void release(SIZE_T sizeClass, std::unique_ptr<char[]> data);
+
+    // m_idle[c] holds returned buffers of classCapacity(c) bytes
+    std::vector<std::vector<std::unique_ptr<char[]>>> m_idle;
+    SIZE_T m_allocations = 0;
+};
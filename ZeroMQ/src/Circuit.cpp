@@ -0,0 +1,145 @@
+#include "Circuit.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+SIZE_T Circuit::addGate(const Gate& gate) {
+    SIZE_T wire = m_gates.size();
+    bool binary = gate.type == GateType::ADD || gate.type == GateType::MUL;
+    if (gate.type != GateType::INPUT && (gate.in0 >= wire || (binary && gate.in1 >= wire))) {
+        throw std::runtime_error("Circuit gate references a wire that does not exist yet");
+    }
+    m_gates.push_back(gate);
+    return wire;
+}
+
+SIZE_T Circuit::addInput() {
+    ++m_numInputs;
+    return addGate({GateType::INPUT, 0, 0, 0});
+}
+
+SIZE_T Circuit::addAdd(SIZE_T a, SIZE_T b) {
+    return addGate({GateType::ADD, a, b, 0});
+}
+
+SIZE_T Circuit::addConstMul(SIZE_T a, uint64_t constant) {
+    return addGate({GateType::CONST_MUL, a, 0, constant});
+}
+
+SIZE_T Circuit::addMul(SIZE_T a, SIZE_T b) {
+    SIZE_T wire = addGate({GateType::MUL, a, b, 0});
+    ++m_numMultiplications;
+    return wire;
+}
+
+SIZE_T Circuit::addOutput(SIZE_T a) {
+    SIZE_T wire = addGate({GateType::OUTPUT, a, 0, 0});
+    ++m_numOutputs;
+    return wire;
+}
+
+std::vector<SIZE_T> Circuit::wireDepths() const {
+    std::vector<SIZE_T> depth(m_gates.size(), 0);
+    for (SIZE_T w = 0; w < m_gates.size(); ++w) {
+        const Gate& gate = m_gates[w];
+        switch (gate.type) {
+            case GateType::INPUT:
+                depth[w] = 0;
+                break;
+            case GateType::ADD:
+                depth[w] = std::max(depth[gate.in0], depth[gate.in1]);
+                break;
+            case GateType::MUL:
+                depth[w] = std::max(depth[gate.in0], depth[gate.in1]) + 1;
+                break;
+            case GateType::CONST_MUL:
+            case GateType::OUTPUT:
+                depth[w] = depth[gate.in0];
+                break;
+        }
+    }
+    return depth;
+}
+
+std::vector<std::vector<SIZE_T>> Circuit::layers() const {
+    std::vector<SIZE_T> depth = wireDepths();
+    SIZE_T maxDepth = depth.empty() ? 0 : *std::max_element(depth.begin(), depth.end());
+    std::vector<std::vector<SIZE_T>> result(maxDepth + 1);
+    // Multiplications first so the local gates of the same depth see their outputs
+    for (SIZE_T w = 0; w < m_gates.size(); ++w) {
+        if (m_gates[w].type == GateType::MUL) result[depth[w]].push_back(w);
+    }
+    for (SIZE_T w = 0; w < m_gates.size(); ++w) {
+        if (m_gates[w].type != GateType::MUL) result[depth[w]].push_back(w);
+    }
+    return result;
+}
+
+SIZE_T Circuit::multiplicativeDepth() const {
+    std::vector<SIZE_T> depth = wireDepths();
+    return depth.empty() ? 0 : *std::max_element(depth.begin(), depth.end());
+}
+
+std::string Circuit::serialize() const {
+    std::ostringstream out;
+    for (const Gate& gate : m_gates) {
+        out << static_cast<int>(gate.type) << " " << gate.in0 << " " << gate.in1 << " " << gate.constant << "\n";
+    }
+    return out.str();
+}
+
+Circuit Circuit::deserialize(const std::string& data) {
+    Circuit circuit;
+    std::istringstream in(data);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        // Exactly four numbers per line, so a truncated last gate is not silently dropped
+        std::istringstream fields(line);
+        int type;
+        SIZE_T in0, in1;
+        uint64_t constant;
+        if (!(fields >> type >> in0 >> in1 >> constant) || !(fields >> std::ws).eof()) {
+            throw std::runtime_error("Malformed circuit description");
+        }
+        switch (static_cast<GateType>(type)) {
+            case GateType::INPUT:     circuit.addInput(); break;
+            case GateType::ADD:       circuit.addAdd(in0, in1); break;
+            case GateType::CONST_MUL: circuit.addConstMul(in0, constant); break;
+            case GateType::MUL:       circuit.addMul(in0, in1); break;
+            case GateType::OUTPUT:    circuit.addOutput(in0); break;
+            default:
+                throw std::runtime_error("Unknown gate type in circuit description");
+        }
+    }
+    return circuit;
+}
+
+Circuit Circuit::productAndSum(SIZE_T numInputs) {
+    if (numInputs == 0) {
+        throw std::runtime_error("productAndSum needs at least one input");
+    }
+    Circuit circuit;
+    std::vector<SIZE_T> level;
+    for (SIZE_T i = 0; i < numInputs; ++i) {
+        level.push_back(circuit.addInput());
+    }
+    SIZE_T sum = level[0];
+    for (SIZE_T i = 1; i < numInputs; ++i) {
+        sum = circuit.addAdd(sum, level[i]);
+    }
+    // Balanced product tree keeps the depth at ceil(log2(numInputs))
+    while (level.size() > 1) {
+        std::vector<SIZE_T> next;
+        for (SIZE_T i = 0; i + 1 < level.size(); i += 2) {
+            next.push_back(circuit.addMul(level[i], level[i + 1]));
+        }
+        if (level.size() % 2 == 1) next.push_back(level.back());
+        level = next;
+    }
+    SIZE_T product = level[0];
+    circuit.addOutput(product);
+    circuit.addOutput(circuit.addConstMul(sum, 3));
+    circuit.addOutput(circuit.addMul(product, sum));
+    return circuit;
+}
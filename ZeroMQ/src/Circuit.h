@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "config.h"
+
+/**
+ * @brief Gate kinds of the arithmetic circuit IR.
+ */
+enum class GateType : uint8_t {
+    INPUT = 0,
+    ADD = 1,
+    CONST_MUL = 2,
+    MUL = 3,
+    OUTPUT = 4
+};
+
+/**
+ * @brief One gate; its output wire id is the gate's index in the circuit.
+ */
+struct Gate {
+    GateType type;
+    SIZE_T in0 = 0;        // First input wire (unused for INPUT)
+    SIZE_T in1 = 0;        // Second input wire (ADD and MUL only)
+    uint64_t constant = 0; // Public factor of CONST_MUL
+};
+
+/**
+ * @brief Arithmetic circuit over the shared field. Gates can only reference
+ *        wires that already exist, so the gate list is always in topological order.
+ */
+class Circuit {
+public:
+    /**
+     * @brief Adds the next input wire; inputs are numbered in the order they are added.
+     * @return The new wire id.
+     */
+    SIZE_T addInput();
+
+    /**
+     * @brief Adds a + b (local, no communication).
+     */
+    SIZE_T addAdd(SIZE_T a, SIZE_T b);
+
+    /**
+     * @brief Adds constant * a (local, no communication).
+     */
+    SIZE_T addConstMul(SIZE_T a, uint64_t constant);
+
+    /**
+     * @brief Adds a * b (consumes one Beaver triple and one opening).
+     */
+    SIZE_T addMul(SIZE_T a, SIZE_T b);
+
+    /**
+     * @brief Marks wire a as an output; outputs are numbered in the order they are added.
+     */
+    SIZE_T addOutput(SIZE_T a);
+
+    const std::vector<Gate>& gates() const { return m_gates; }
+    SIZE_T numInputs() const { return m_numInputs; }
+    SIZE_T numOutputs() const { return m_numOutputs; }
+    SIZE_T numMultiplications() const { return m_numMultiplications; }
+
+    /**
+     * @brief Multiplicative depth of every wire: inputs are 0 and a MUL gate is one
+     *        more than the deeper of its inputs.
+     */
+    std::vector<SIZE_T> wireDepths() const;
+
+    /**
+     * @brief Groups gate ids by multiplicative depth. Layer d holds the MUL gates of
+     *        depth d first, then the local gates of depth d in topological order, so
+     *        evaluating layers in order needs exactly one batched opening per layer.
+     */
+    std::vector<std::vector<SIZE_T>> layers() const;
+
+    /**
+     * @brief Number of layers that contain multiplications (the round complexity).
+     */
+    SIZE_T multiplicativeDepth() const;
+
+    /**
+     * @brief Text encoding "type in0 in1 constant" per gate, one gate per line.
+     */
+    std::string serialize() const;
+    static Circuit deserialize(const std::string& data);
+
+    /**
+     * @brief Demo circuit over numInputs inputs: the product p of all inputs as a
+     *        balanced tree, the sum s, and outputs p, 3 * s and p * s.
+     */
+    static Circuit productAndSum(SIZE_T numInputs);
+
+private:
+    SIZE_T addGate(const Gate& gate);
+
+    std::vector<Gate> m_gates;
+    SIZE_T m_numInputs = 0;
+    SIZE_T m_numOutputs = 0;
+    SIZE_T m_numMultiplications = 0;
+};
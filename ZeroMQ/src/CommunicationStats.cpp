@@ -0,0 +1,273 @@
+#include "CommunicationStats.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace mpc {
+
+size_t LatencyHistogram::bucketIndex(uint64_t value) {
+    const uint64_t subBuckets = uint64_t(1) << SUB_BUCKET_BITS;
+    if (value < subBuckets) {
+        return static_cast<size_t>(value);
+    }
+    unsigned msb = 63 - __builtin_clzll(value);
+    if (msb >= MAX_VALUE_BITS) {
+        return NUM_BUCKETS - 1;
+    }
+    unsigned shift = msb - SUB_BUCKET_BITS;
+    size_t sub = static_cast<size_t>((value >> shift) & (subBuckets - 1));
+    return (static_cast<size_t>(shift + 1) << SUB_BUCKET_BITS) + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    const uint64_t subBuckets = uint64_t(1) << SUB_BUCKET_BITS;
+    if (index < subBuckets) {
+        return index;
+    }
+    unsigned shift = static_cast<unsigned>(index >> SUB_BUCKET_BITS) - 1;
+    uint64_t lower = (subBuckets + (index & (subBuckets - 1))) << shift;
+    return lower + (uint64_t(1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    counts_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::addTo(std::vector<uint64_t>& buckets, uint64_t& sum, uint64_t& max) const {
+    buckets.resize(NUM_BUCKETS, 0);
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        buckets[i] += counts_[i].load(std::memory_order_relaxed);
+    }
+    sum += sum_.load(std::memory_order_relaxed);
+    max = std::max(max, max_.load(std::memory_order_relaxed));
+}
+
+// Summed histogram as {"count","mean","max","p50","p90","p99","p999","buckets": [[upper, count], ...]}
+static void writeHistogram(std::ostream& out, const std::vector<uint64_t>& buckets, uint64_t sum, uint64_t max) {
+    uint64_t count = 0;
+    for (uint64_t bucket : buckets) count += bucket;
+    out << "{\"count\": " << count;
+    if (count > 0) {
+        out << ",\"mean\": " << sum / count << ",\"max\": " << max;
+        const std::pair<const char*, double> quantiles[] = {{"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999}};
+        for (const auto& [name, quantile] : quantiles) {
+            uint64_t rank = static_cast<uint64_t>(quantile * count + 0.999999);
+            uint64_t seen = 0;
+            size_t index = 0;
+            while (index < buckets.size() && seen + buckets[index] < rank) seen += buckets[index++];
+            uint64_t value = index < buckets.size() ? LatencyHistogram::bucketUpperBound(index) : max;
+            out << ",\"" << name << "\": " << std::min(value, max);
+        }
+        out << ",\"buckets\": [";
+        bool first = true;
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            if (buckets[i] == 0) continue;
+            out << (first ? "" : ",") << "[" << LatencyHistogram::bucketUpperBound(i) << "," << buckets[i] << "]";
+            first = false;
+        }
+        out << "]";
+    }
+    out << "}";
+}
+
+CommunicationStats::CommunicationStats(const std::vector<PartyId>& peers) : peers_(peers) {
+    for (size_t i = 0; i < peers_.size(); ++i) {
+        peerIndex_[peers_[i]] = i;
+    }
+    for (size_t s = 0; s < NUM_SHARDS; ++s) {
+        shards_.push_back(std::make_unique<Shard>(peers_.size()));
+    }
+    phaseNames_[0] = "untagged";
+}
+
+CommunicationStats::Shard& CommunicationStats::shard() {
+    // Threads are handed out slots round-robin, once each
+    static std::atomic<size_t> nextSlot{0};
+    thread_local size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed);
+    return *shards_[slot % NUM_SHARDS];
+}
+
+long CommunicationStats::peerIndex(PartyId peer) const {
+    auto it = peerIndex_.find(peer);
+    return it == peerIndex_.end() ? -1 : static_cast<long>(it->second);
+}
+
+size_t CommunicationStats::typeIndex(Message::Type type) {
+    auto value = static_cast<size_t>(type);
+    // DATA .. PARTIAL_OPEN, then CUSTOM and anything unknown
+    return value < NUM_TYPES - 1 ? value : NUM_TYPES - 1;
+}
+
+const char* CommunicationStats::typeName(size_t index) {
+    static const char* const names[NUM_TYPES] = {"DATA", "CONTROL", "SYNC", "SHARE", "TRIPLE", "PARTIAL_OPEN", "CUSTOM"};
+    return names[index];
+}
+
+void CommunicationStats::addTraffic(Traffic& traffic, bool sent, uint64_t bytes, uint64_t blockedNs) {
+    if (sent) {
+        traffic.messagesSent.fetch_add(1, std::memory_order_relaxed);
+        traffic.bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+        traffic.sendBlockingNs.fetch_add(blockedNs, std::memory_order_relaxed);
+    } else {
+        traffic.messagesReceived.fetch_add(1, std::memory_order_relaxed);
+        traffic.bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+    }
+}
+
+void CommunicationStats::recordSent(PartyId peer, Message::Type type, uint64_t bytes, uint64_t blockedNs) {
+    Shard& s = shard();
+    size_t t = typeIndex(type);
+    long p = peerIndex(peer);
+    addTraffic(s.total, true, bytes, blockedNs);
+    addTraffic(s.types[t].traffic, true, bytes, blockedNs);
+    addTraffic(s.phases[currentPhase_.load(std::memory_order_relaxed)], true, bytes, blockedNs);
+    s.types[t].latencies[static_cast<size_t>(Latency::SEND)].record(blockedNs);
+    if (p >= 0) {
+        addTraffic(s.peers[p].traffic, true, bytes, blockedNs);
+        s.peers[p].latencies[static_cast<size_t>(Latency::SEND)].record(blockedNs);
+    }
+}
+
+void CommunicationStats::recordReceived(PartyId peer, Message::Type type, uint64_t bytes) {
+    Shard& s = shard();
+    long p = peerIndex(peer);
+    addTraffic(s.total, false, bytes, 0);
+    addTraffic(s.types[typeIndex(type)].traffic, false, bytes, 0);
+    addTraffic(s.phases[currentPhase_.load(std::memory_order_relaxed)], false, bytes, 0);
+    if (p >= 0) {
+        addTraffic(s.peers[p].traffic, false, bytes, 0);
+    }
+}
+
+void CommunicationStats::recordLatency(Latency latency, PartyId peer, Message::Type type, uint64_t ns) {
+    Shard& s = shard();
+    long p = peerIndex(peer);
+    s.types[typeIndex(type)].latencies[static_cast<size_t>(latency)].record(ns);
+    if (p >= 0) {
+        s.peers[p].latencies[static_cast<size_t>(latency)].record(ns);
+    }
+}
+
+void CommunicationStats::recordQueueDepth(size_t depth) {
+    std::atomic<uint64_t>& highWater = shard().queueDepthHighWater;
+    uint64_t seen = highWater.load(std::memory_order_relaxed);
+    while (depth > seen && !highWater.compare_exchange_weak(seen, depth, std::memory_order_relaxed)) {
+    }
+}
+
+void CommunicationStats::setPhase(const std::string& phase) {
+    std::lock_guard<std::mutex> lock(phaseMutex_);
+    size_t count = numPhases_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) {
+        if (phaseNames_[i] == phase) {
+            currentPhase_.store(i, std::memory_order_relaxed);
+            return;
+        }
+    }
+    if (count == MAX_PHASES) {
+        throw std::runtime_error("Too many communication phases (at most " + std::to_string(MAX_PHASES) + ")");
+    }
+    phaseNames_[count] = phase;
+    numPhases_.store(count + 1, std::memory_order_release);
+    currentPhase_.store(count, std::memory_order_relaxed);
+}
+
+void CommunicationStats::addTo(const Traffic& traffic, TrafficTotals& totals) {
+    totals.messagesSent += traffic.messagesSent.load(std::memory_order_relaxed);
+    totals.bytesSent += traffic.bytesSent.load(std::memory_order_relaxed);
+    totals.messagesReceived += traffic.messagesReceived.load(std::memory_order_relaxed);
+    totals.bytesReceived += traffic.bytesReceived.load(std::memory_order_relaxed);
+    totals.sendBlockingNs += traffic.sendBlockingNs.load(std::memory_order_relaxed);
+}
+
+void CommunicationStats::writeTraffic(std::ostream& out, const TrafficTotals& totals) {
+    out << "\"messages_sent\": " << totals.messagesSent << ","
+        << "\"messages_received\": " << totals.messagesReceived << ","
+        << "\"bytes_sent\": " << totals.bytesSent << ","
+        << "\"bytes_received\": " << totals.bytesReceived << ","
+        << "\"send_blocking_ns\": " << totals.sendBlockingNs;
+}
+
+void CommunicationStats::writeChannel(std::ostream& out, size_t type, long peer) const {
+    static const char* const latencyNames[NUM_LATENCIES] = {"send_ns", "queue_wait_ns", "handler_ns"};
+    TrafficTotals totals;
+    for (const auto& s : shards_) {
+        addTo(peer < 0 ? s->types[type].traffic : s->peers[peer].traffic, totals);
+    }
+    out << "{";
+    writeTraffic(out, totals);
+    for (size_t l = 0; l < NUM_LATENCIES; ++l) {
+        std::vector<uint64_t> buckets;
+        uint64_t sum = 0, max = 0;
+        for (const auto& s : shards_) {
+            const Channel& channel = peer < 0 ? s->types[type] : s->peers[peer];
+            channel.latencies[l].addTo(buckets, sum, max);
+        }
+        out << ",\"" << latencyNames[l] << "\": ";
+        writeHistogram(out, buckets, sum, max);
+    }
+    out << "}";
+}
+
+std::string CommunicationStats::toJson(PartyId partyId, size_t queuedMessages) const {
+    TrafficTotals total;
+    uint64_t highWater = 0;
+    for (const auto& s : shards_) {
+        addTo(s->total, total);
+        highWater = std::max(highWater, s->queueDepthHighWater.load(std::memory_order_relaxed));
+    }
+
+    std::stringstream ss;
+    ss << "{"
+       << "\"party_id\": " << partyId << ","
+       << "\"messages_sent\": " << total.messagesSent << ","
+       << "\"messages_received\": " << total.messagesReceived << ","
+       << "\"bytes_sent\": " << total.bytesSent << ","
+       << "\"bytes_received\": " << total.bytesReceived << ","
+       << "\"queued_messages\": " << queuedMessages << ","
+       << "\"queue_depth_high_water\": " << highWater << ","
+       << "\"send_blocking_ns\": " << total.sendBlockingNs;
+
+    // Only types that were used
+    ss << ",\"by_type\": {";
+    bool first = true;
+    for (size_t t = 0; t < NUM_TYPES; ++t) {
+        bool used = false;
+        for (const auto& s : shards_) {
+            const Traffic& traffic = s->types[t].traffic;
+            used = used || traffic.messagesSent.load(std::memory_order_relaxed) > 0 ||
+                   traffic.messagesReceived.load(std::memory_order_relaxed) > 0;
+        }
+        if (!used) continue;
+        ss << (first ? "" : ",") << "\"" << typeName(t) << "\": ";
+        writeChannel(ss, t, -1);
+        first = false;
+    }
+    ss << "}";
+
+    ss << ",\"by_peer\": {";
+    for (size_t p = 0; p < peers_.size(); ++p) {
+        ss << (p == 0 ? "" : ",") << "\"" << peers_[p] << "\": ";
+        writeChannel(ss, 0, static_cast<long>(p));
+    }
+    ss << "}";
+
+    ss << ",\"by_phase\": {";
+    size_t numPhases = numPhases_.load(std::memory_order_acquire);
+    for (size_t ph = 0; ph < numPhases; ++ph) {
+        TrafficTotals totals;
+        for (const auto& s : shards_) addTo(s->phases[ph], totals);
+        ss << (ph == 0 ? "" : ",") << "\"" << phaseNames_[ph] << "\": {";
+        writeTraffic(ss, totals);
+        ss << "}";
+    }
+    ss << "}}";
+
+    return ss.str();
+}
+
+} // namespace mpc
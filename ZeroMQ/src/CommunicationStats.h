@@ -0,0 +1,156 @@
+#ifndef COMMUNICATION_STATS_H
+#define COMMUNICATION_STATS_H
+
+#include "IMPCCommunication.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mpc {
+
+/**
+ * @brief Log-linear latency histogram in the style of HdrHistogram. Values below
+ *        2^SUB_BUCKET_BITS get one bucket each and every further power of two is split
+ *        into 2^SUB_BUCKET_BITS buckets, so a reported value is within 1/8 of the
+ *        recorded one. Recording is a few relaxed atomic operations.
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 3;
+    // Values from 2^MAX_VALUE_BITS ns (about 68 s) on are counted in the last bucket
+    static constexpr unsigned MAX_VALUE_BITS = 36;
+    static constexpr size_t NUM_BUCKETS = static_cast<size_t>(MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+    void record(uint64_t value);
+
+    static size_t bucketIndex(uint64_t value);
+    // Largest value that falls into the bucket
+    static uint64_t bucketUpperBound(size_t index);
+
+    /**
+     * @brief Adds this histogram into the running totals of several shards.
+     * @param buckets Resized to NUM_BUCKETS on first use.
+     */
+    void addTo(std::vector<uint64_t>& buckets, uint64_t& sum, uint64_t& max) const;
+
+private:
+    std::array<std::atomic<uint64_t>, NUM_BUCKETS> counts_{};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+/**
+ * @brief Traffic, latency and queueing statistics of one ZMQMPCCommunication endpoint,
+ *        exported as JSON. Every counter is a relaxed atomic in one of NUM_SHARDS
+ *        shards; a thread always updates the same shard, so the receiver thread and
+ *        the sending threads do not contend on counters. Shards are only added up on
+ *        export.
+ *
+ *        Latencies in nanoseconds, per Message::Type and per peer:
+ *        - send_ns: time blocked in the socket send (summed in send_blocking_ns)
+ *        - queue_wait_ns: from arrival until receive() takes the message from the queue
+ *        - handler_ns: time spent in the asynchronous message handler
+ *        Traffic is also split by the phase set with setPhase().
+ */
+class CommunicationStats {
+public:
+    using PartyId = IMPCCommunication::PartyId;
+
+    static constexpr size_t NUM_SHARDS = 4;
+    static constexpr size_t MAX_PHASES = 32;
+
+    enum class Latency : uint8_t { SEND, QUEUE_WAIT, HANDLER };
+    static constexpr size_t NUM_LATENCIES = 3;
+
+    /**
+     * @param peers Every party this endpoint may talk to; others only count in the totals.
+     */
+    explicit CommunicationStats(const std::vector<PartyId>& peers);
+
+    void recordSent(PartyId peer, Message::Type type, uint64_t bytes, uint64_t blockedNs);
+    void recordReceived(PartyId peer, Message::Type type, uint64_t bytes);
+    void recordLatency(Latency latency, PartyId peer, Message::Type type, uint64_t ns);
+    void recordQueueDepth(size_t depth);
+
+    /**
+     * @brief Attributes all following traffic to the named phase ("untagged" until the
+     *        first call). Registering a new name takes a lock; recording never does.
+     * @throws std::runtime_error when more than MAX_PHASES phases are used.
+     */
+    void setPhase(const std::string& phase);
+
+    /**
+     * @brief All statistics as one JSON object.
+     * @param partyId Reported as party_id.
+     * @param queuedMessages Current receive queue length, reported as queued_messages.
+     */
+    std::string toJson(PartyId partyId, size_t queuedMessages) const;
+
+private:
+    static constexpr size_t NUM_TYPES = 7;
+
+    struct Traffic {
+        std::atomic<uint64_t> messagesSent{0};
+        std::atomic<uint64_t> bytesSent{0};
+        std::atomic<uint64_t> messagesReceived{0};
+        std::atomic<uint64_t> bytesReceived{0};
+        std::atomic<uint64_t> sendBlockingNs{0};
+    };
+
+    // Traffic and latencies of one Message::Type or one peer
+    struct Channel {
+        Traffic traffic;
+        std::array<LatencyHistogram, NUM_LATENCIES> latencies;
+    };
+
+    struct alignas(64) Shard {
+        explicit Shard(size_t numPeers) : peers(numPeers) {}
+        Traffic total;
+        std::array<Channel, NUM_TYPES> types;
+        std::vector<Channel> peers;
+        std::array<Traffic, MAX_PHASES> phases;
+        std::atomic<uint64_t> queueDepthHighWater{0};
+    };
+
+    // Traffic summed over shards, as plain numbers
+    struct TrafficTotals {
+        uint64_t messagesSent = 0;
+        uint64_t bytesSent = 0;
+        uint64_t messagesReceived = 0;
+        uint64_t bytesReceived = 0;
+        uint64_t sendBlockingNs = 0;
+    };
+
+    static size_t typeIndex(Message::Type type);
+    static const char* typeName(size_t index);
+    static void addTraffic(Traffic& traffic, bool sent, uint64_t bytes, uint64_t blockedNs);
+    static void addTo(const Traffic& traffic, TrafficTotals& totals);
+    static void writeTraffic(std::ostream& out, const TrafficTotals& totals);
+
+    // This thread's shard
+    Shard& shard();
+    // Peer slot of a party id, or -1
+    long peerIndex(PartyId peer) const;
+    // JSON of one type (peer < 0) or one peer channel, summed over shards
+    void writeChannel(std::ostream& out, size_t type, long peer) const;
+
+    std::vector<PartyId> peers_;
+    std::unordered_map<PartyId, size_t> peerIndex_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    // Phase names; a name is written before numPhases_ is raised past it
+    std::array<std::string, MAX_PHASES> phaseNames_;
+    std::atomic<size_t> numPhases_{1};
+    std::atomic<size_t> currentPhase_{0};
+    std::mutex phaseMutex_;
+};
+
+} // namespace mpc
+
+#endif // COMMUNICATION_STATS_H
@@ -2,6 +2,7 @@
 #define INET_IOMP_H
 
 #include <cstdint>  // For fixed-width integer types
+#include <functional>
 #include <map>
 #include <string>
 #include "config.h"
@@ -48,6 +49,16 @@ public:
      */
     virtual size_t receive(PARTY_ID_T& senderId, void* buffer, LENGTH_T maxLength) = 0;
 
+    /**
+     * @brief Receives binary data of any length from another party. The data is copied
+     *        into the memory allocate returns for its size, so the caller need not know
+     *        how large the next message is.
+     * @param senderId   Output parameter to store the sender's party ID.
+     * @param allocate   Returns a buffer of at least the given number of bytes.
+     * @return Size of the received data in bytes; 0 if nothing arrived.
+     */
+    virtual size_t receiveAny(PARTY_ID_T& senderId, const std::function<void*(size_t)>& allocate) = 0;
+
     /**
      * @brief Receives binary data from a DEALER socket.
      * @param routerId   Output parameter to store the router's party ID.
@@ -68,6 +79,14 @@ public:
 
     virtual void reply(void* routingIdMsg, LENGTH_T idSize, const void* data, LENGTH_T length) = 0;
 
+    /**
+     * @brief Moves receiving onto a thread of the endpoint's own, which keeps draining the
+     *        socket while the caller handles earlier messages; receive, receiveAny and reply
+     *        then hand messages over to that thread. Messages are delivered in arrival
+     *        order. Endpoints without one keep receiving on the caller's thread.
+     */
+    virtual void startReceiveThread() {}
+
     /**
      * @brief Closes all sockets.
      */
@@ -0,0 +1,134 @@
+#include "InputLoader.h"
+#include <limits>
+#include <stdexcept>
+
+InputLoader::InputLoader(const std::string& path, Format format, SIZE_T chunkValues)
+    : m_path(path), m_file(path, std::ios::binary), m_format(format), m_chunkValues(chunkValues) {
+    if (!m_file) {
+        throw std::runtime_error("Cannot open input file " + path);
+    }
+    if (chunkValues == 0) {
+        throw std::invalid_argument("Input chunks need at least one value");
+    }
+    if (m_format == Format::CSV) {
+        m_text.resize(INPUT_READ_BYTES);
+    }
+    m_reader = std::thread([this]() { readLoop(); });
+}
+
+InputLoader::~InputLoader() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+    m_reader.join();
+}
+
+InputLoader::Format InputLoader::formatFromPath(const std::string& path) {
+    const std::string extension = ".csv";
+    if (path.size() >= extension.size() &&
+        path.compare(path.size() - extension.size(), extension.size(), extension) == 0) {
+        return Format::CSV;
+    }
+    return Format::BINARY;
+}
+
+bool InputLoader::next(std::vector<uint64_t>& values) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this]() { return m_hasReady || m_endOfFile || m_error; });
+    if (!m_hasReady) {
+        // A chunk read before the error is still handed out first
+        if (m_error) std::rethrow_exception(m_error);
+        return false;
+    }
+    values.swap(m_ready);
+    m_hasReady = false;
+    m_valuesRead += values.size();
+    lock.unlock();
+    // Let the reader start on the chunk after this one
+    m_cv.notify_all();
+    return true;
+}
+
+void InputLoader::readLoop() {
+    std::vector<uint64_t> chunk;
+    while (true) {
+        try {
+            readChunk(chunk);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_error = std::current_exception();
+            m_cv.notify_all();
+            return;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this]() { return m_stopping || !m_hasReady; });
+        if (m_stopping) return;
+        if (chunk.empty()) {
+            m_endOfFile = true;
+            m_cv.notify_all();
+            return;
+        }
+        // The caller's previous buffer comes back through m_ready
+        m_ready.swap(chunk);
+        m_hasReady = true;
+        m_cv.notify_all();
+    }
+}
+
+void InputLoader::readChunk(std::vector<uint64_t>& values) {
+    values.clear();
+    if (m_format == Format::BINARY) {
+        readBinary(values);
+    } else {
+        readCsv(values);
+    }
+}
+
+void InputLoader::readBinary(std::vector<uint64_t>& values) {
+    // Packed values in host order, which is little-endian on every supported platform
+    values.resize(m_chunkValues);
+    m_file.read(reinterpret_cast<char*>(values.data()), m_chunkValues * sizeof(uint64_t));
+    SIZE_T bytes = static_cast<SIZE_T>(m_file.gcount());
+    if (bytes % sizeof(uint64_t) != 0) {
+        throw std::runtime_error(m_path + " does not hold a whole number of 8-byte values");
+    }
+    values.resize(bytes / sizeof(uint64_t));
+}
+
+void InputLoader::readCsv(std::vector<uint64_t>& values) {
+    values.reserve(m_chunkValues);
+    while (values.size() < m_chunkValues) {
+        if (m_textPos == m_textEnd) {
+            m_file.read(m_text.data(), m_text.size());
+            m_textPos = 0;
+            m_textEnd = static_cast<SIZE_T>(m_file.gcount());
+            if (m_textEnd == 0) {
+                // A value may end the file without a trailing separator
+                if (m_hasPartialValue) {
+                    values.push_back(m_partialValue);
+                    m_hasPartialValue = false;
+                }
+                return;
+            }
+        }
+        char c = m_text[m_textPos++];
+        if (c >= '0' && c <= '9') {
+            uint64_t digit = static_cast<uint64_t>(c - '0');
+            if (m_partialValue > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+                throw std::runtime_error("Value out of range in " + m_path);
+            }
+            m_partialValue = 10 * m_partialValue + digit;
+            m_hasPartialValue = true;
+        } else if (c == ',' || c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            if (m_hasPartialValue) {
+                values.push_back(m_partialValue);
+                m_partialValue = 0;
+                m_hasPartialValue = false;
+            }
+        } else {
+            throw std::runtime_error("Invalid character '" + std::string(1, c) + "' in " + m_path);
+        }
+    }
+}
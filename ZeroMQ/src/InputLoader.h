@@ -0,0 +1,75 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "config.h"
+
+/**
+ * @brief Reads the values an input party shares from a file, one chunk at a time. A
+ *        background thread reads the next chunk while the caller shares the current one,
+ *        so at most a few chunks are in memory whatever the size of the file.
+ *
+ *        BINARY files hold packed little-endian uint64 values; CSV files hold decimal
+ *        values separated by commas, spaces or line breaks.
+ */
+class InputLoader {
+public:
+    enum class Format : uint8_t { BINARY, CSV };
+
+    /**
+     * @param chunkValues Values per chunk; only the last chunk may be shorter.
+     * @throws std::runtime_error when the file cannot be opened.
+     */
+    InputLoader(const std::string& path, Format format, SIZE_T chunkValues);
+    ~InputLoader();
+    InputLoader(const InputLoader&) = delete;
+    InputLoader& operator=(const InputLoader&) = delete;
+
+    // CSV for a path ending in ".csv", BINARY otherwise
+    static Format formatFromPath(const std::string& path);
+
+    /**
+     * @brief Moves the next chunk into values; the buffer given back is reused for reading.
+     * @return false once the file is exhausted.
+     * @throws std::runtime_error for a malformed file, once the chunks read before the error are out.
+     */
+    bool next(std::vector<uint64_t>& values);
+
+    // Values handed out by next() so far
+    SIZE_T valuesRead() const { return m_valuesRead; }
+
+private:
+    void readLoop();
+    // Fills values with up to m_chunkValues values; empty at the end of the file
+    void readChunk(std::vector<uint64_t>& values);
+    void readBinary(std::vector<uint64_t>& values);
+    void readCsv(std::vector<uint64_t>& values);
+
+    std::string m_path;
+    std::ifstream m_file;
+    Format m_format;
+    SIZE_T m_chunkValues;
+    SIZE_T m_valuesRead = 0;
+
+    // CSV text not parsed yet, and the digits of a value cut off at its end
+    std::vector<char> m_text;
+    SIZE_T m_textPos = 0;
+    SIZE_T m_textEnd = 0;
+    uint64_t m_partialValue = 0;
+    bool m_hasPartialValue = false;
+
+    std::thread m_reader;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    // Chunk read ahead of the caller
+    std::vector<uint64_t> m_ready;
+    bool m_hasReady = false;
+    bool m_endOfFile = false;
+    bool m_stopping = false;
+    std::exception_ptr m_error;
+};
@@ -0,0 +1,194 @@
+#include "Logger.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <openssl/crypto.h>
+#include <stdexcept>
+
+std::atomic<uint8_t> Logger::s_level{LOG_RUNTIME_LEVEL};
+
+static uint64_t steadyNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+template <typename T>
+static void put(std::vector<char>& out, T value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static T take(const char*& cursor) {
+    T value;
+    std::memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return value;
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+LogLevel Logger::levelFromName(const std::string& name) {
+    if (name == "trace") return LogLevel::TRACE;
+    if (name == "debug") return LogLevel::DEBUG;
+    if (name == "info") return LogLevel::INFO;
+    if (name == "warn") return LogLevel::WARN;
+    if (name == "error") return LogLevel::ERROR;
+    throw std::invalid_argument("Unknown log level: " + name);
+}
+
+Logger::Logger() : m_startNs(steadyNs()) {
+    m_pending.reserve(LOG_BUFFER_BYTES);
+    m_writer = std::thread([this]() { writerLoop(); });
+}
+
+Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_writerCv.notify_one();
+    m_writer.join();
+}
+
+void Logger::encodeSigned(std::vector<char>& out, int64_t value) {
+    out.push_back(TAG_SIGNED);
+    put(out, value);
+}
+
+void Logger::encodeUnsigned(std::vector<char>& out, uint64_t value) {
+    out.push_back(TAG_UNSIGNED);
+    put(out, value);
+}
+
+void Logger::encodeDouble(std::vector<char>& out, double value) {
+    out.push_back(TAG_DOUBLE);
+    put(out, value);
+}
+
+void Logger::encodeString(std::vector<char>& out, std::string_view value) {
+    out.push_back(TAG_STRING);
+    put(out, static_cast<uint32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+void Logger::encodeBignum(std::vector<char>& out, const BIGNUM* value) {
+    if (!value) {
+        out.push_back(TAG_NULL);
+        return;
+    }
+    out.push_back(TAG_BIGNUM);
+    out.push_back(BN_is_negative(value) ? 1 : 0);
+    uint32_t length = static_cast<uint32_t>(BN_num_bytes(value));
+    put(out, length);
+    size_t offset = out.size();
+    out.resize(offset + length);
+    BN_bn2bin(value, reinterpret_cast<unsigned char*>(out.data() + offset));
+}
+
+std::vector<char>& Logger::threadRecord() {
+    thread_local std::vector<char> record;
+    record.clear();
+    return record;
+}
+
+void Logger::beginRecord(std::vector<char>& record, LogLevel level) const {
+    static std::atomic<uint32_t> nextThread{1};
+    thread_local uint32_t thread = nextThread.fetch_add(1, std::memory_order_relaxed);
+    record.push_back(static_cast<char>(level));
+    put(record, steadyNs() - m_startNs);
+    put(record, thread);
+}
+
+void Logger::append(const std::vector<char>& record) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // Wait for the writer rather than drop records; a record larger than the buffer still goes in alone
+    while (!m_pending.empty() && m_pending.size() + record.size() > LOG_BUFFER_BYTES) {
+        m_writerCv.notify_one();
+        m_doneCv.wait(lock);
+    }
+    m_pending.insert(m_pending.end(), record.begin(), record.end());
+    m_appendedBytes += record.size();
+    if (m_pending.size() >= LOG_BUFFER_BYTES / 2) m_writerCv.notify_one();
+}
+
+void Logger::flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    uint64_t target = m_appendedBytes;
+    m_flushRequested = true;
+    m_writerCv.notify_one();
+    m_doneCv.wait(lock, [&]() { return m_writtenBytes >= target; });
+}
+
+void Logger::writerLoop() {
+    std::vector<char> batch;
+    batch.reserve(LOG_BUFFER_BYTES);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_writerCv.wait_for(lock, std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MS), [this]() {
+            return m_stopping || m_flushRequested || m_pending.size() >= LOG_BUFFER_BYTES / 2;
+        });
+        bool stopping = m_stopping;
+        m_flushRequested = false;
+        batch.swap(m_pending);
+        lock.unlock();
+        m_doneCv.notify_all();
+        if (!batch.empty()) writeRecords(batch);
+        lock.lock();
+        m_writtenBytes += batch.size();
+        batch.clear();
+        m_doneCv.notify_all();
+        if (stopping && m_pending.empty()) return;
+    }
+}
+
+void Logger::writeRecords(const std::vector<char>& records) const {
+    static const char* const LEVEL_NAMES[] = {"TRACE", "DEBUG", "INFO ", "WARN ", "ERROR"};
+    std::string line;
+    const char* cursor = records.data();
+    const char* end = cursor + records.size();
+    while (cursor < end) {
+        uint8_t level = static_cast<uint8_t>(*cursor++);
+        uint64_t ns = take<uint64_t>(cursor);
+        uint32_t thread = take<uint32_t>(cursor);
+        char prefix[64];
+        std::snprintf(prefix, sizeof(prefix), "%s %lu.%06lu t%u ", LEVEL_NAMES[level], ns / 1000000000ul,
+                      ns / 1000 % 1000000, thread);
+        line = prefix;
+        for (char tag = *cursor++; tag != TAG_END; tag = *cursor++) {
+            if (tag == TAG_SIGNED) {
+                line += std::to_string(take<int64_t>(cursor));
+            } else if (tag == TAG_UNSIGNED) {
+                line += std::to_string(take<uint64_t>(cursor));
+            } else if (tag == TAG_DOUBLE) {
+                char number[32];
+                std::snprintf(number, sizeof(number), "%g", take<double>(cursor));
+                line += number;
+            } else if (tag == TAG_STRING) {
+                uint32_t length = take<uint32_t>(cursor);
+                line.append(cursor, length);
+                cursor += length;
+            } else if (tag == TAG_BIGNUM) {
+                bool negative = *cursor++ != 0;
+                uint32_t length = take<uint32_t>(cursor);
+                BIGNUM* value = BN_bin2bn(reinterpret_cast<const unsigned char*>(cursor), static_cast<int>(length), nullptr);
+                cursor += length;
+                BN_set_negative(value, negative ? 1 : 0);
+                char* decimal = BN_bn2dec(value);
+                line += decimal;
+                OPENSSL_free(decimal);
+                BN_free(value);
+            } else if (tag == TAG_NULL) {
+                line += "(null)";
+            }
+        }
+        line += '\n';
+        std::ostream& out = level >= static_cast<uint8_t>(LogLevel::WARN) ? std::cerr : std::cout;
+        out.write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+    std::cout.flush();
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "config.h"
+
+enum class LogLevel : uint8_t {
+    TRACE = LOG_LEVEL_TRACE,
+    DEBUG = LOG_LEVEL_DEBUG,
+    INFO = LOG_LEVEL_INFO,
+    WARN = LOG_LEVEL_WARN,
+    ERROR = LOG_LEVEL_ERROR,
+};
+
+/**
+ * @brief Asynchronous leveled logger. A log call encodes its arguments as tagged binary
+ *        values into a per-thread record and appends it to a shared buffer under one short
+ *        lock; a background thread turns records into text and writes them every
+ *        LOG_FLUSH_INTERVAL_MS, so callers never wait on terminal I/O. BIGNUM arguments are
+ *        copied as bytes and converted to decimal on the background thread.
+ *
+ *        Use the LOG_* macros: levels below LOG_COMPILE_LEVEL compile to nothing, and the
+ *        arguments of a call below the runtime level are not evaluated. Each record is one
+ *        line "<LEVEL> <seconds since start> t<thread> <message>"; WARN and ERROR go to
+ *        stderr, the rest to stdout. A full buffer (LOG_BUFFER_BYTES) makes callers wait
+ *        for the writer instead of dropping records.
+ */
+class Logger {
+public:
+    static Logger& instance();
+
+    static bool enabled(LogLevel level) {
+        return static_cast<uint8_t>(level) >= s_level.load(std::memory_order_relaxed);
+    }
+    // Runtime threshold; LOG_RUNTIME_LEVEL until changed
+    static void setLevel(LogLevel level) { s_level.store(static_cast<uint8_t>(level), std::memory_order_relaxed); }
+    /**
+     * @brief Parses "trace", "debug", "info", "warn" or "error".
+     * @throws std::invalid_argument for any other name.
+     */
+    static LogLevel levelFromName(const std::string& name);
+
+    // Concatenates the arguments like a chain of operator<<
+    template <typename... Args>
+    void log(LogLevel level, const Args&... args) {
+        std::vector<char>& record = threadRecord();
+        beginRecord(record, level);
+        (encode(record, args), ...);
+        record.push_back(TAG_END);
+        append(record);
+    }
+
+    // Blocks until every record logged before the call has been written
+    void flush();
+
+    ~Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+private:
+    static constexpr char TAG_END = 'e';
+    static constexpr char TAG_SIGNED = 'i';
+    static constexpr char TAG_UNSIGNED = 'u';
+    static constexpr char TAG_DOUBLE = 'd';
+    static constexpr char TAG_STRING = 's';
+    static constexpr char TAG_BIGNUM = 'b';
+    static constexpr char TAG_NULL = 'n';
+
+    Logger();
+
+    template <typename T>
+    static void encode(std::vector<char>& out, const T& value) {
+        if constexpr (std::is_same_v<T, bool> || (std::is_integral_v<T> && std::is_unsigned_v<T>)) {
+            encodeUnsigned(out, static_cast<uint64_t>(value));
+        } else if constexpr (std::is_integral_v<T>) {
+            encodeSigned(out, static_cast<int64_t>(value));
+        } else if constexpr (std::is_floating_point_v<T>) {
+            encodeDouble(out, static_cast<double>(value));
+        } else if constexpr (std::is_convertible_v<const T&, const BIGNUM*>) {
+            encodeBignum(out, value);
+        } else {
+            encodeString(out, std::string_view(value));
+        }
+    }
+    static void encodeSigned(std::vector<char>& out, int64_t value);
+    static void encodeUnsigned(std::vector<char>& out, uint64_t value);
+    static void encodeDouble(std::vector<char>& out, double value);
+    static void encodeString(std::vector<char>& out, std::string_view value);
+    static void encodeBignum(std::vector<char>& out, const BIGNUM* value);
+
+    static std::vector<char>& threadRecord();
+    void beginRecord(std::vector<char>& record, LogLevel level) const;
+    void append(const std::vector<char>& record);
+
+    void writerLoop();
+    // Formats and writes a batch of records
+    void writeRecords(const std::vector<char>& records) const;
+
+    static std::atomic<uint8_t> s_level;
+
+    std::mutex m_mutex;
+    std::condition_variable m_writerCv; // wakes the writer
+    std::condition_variable m_doneCv;   // space freed or records written
+    std::vector<char> m_pending;
+    uint64_t m_appendedBytes = 0;
+    uint64_t m_writtenBytes = 0;
+    bool m_flushRequested = false;
+    bool m_stopping = false;
+    uint64_t m_startNs;
+    std::thread m_writer;
+};
+
+#define LOG_AT(level, ...) \
+    do { if (Logger::enabled(level)) Logger::instance().log(level, __VA_ARGS__); } while (0)
+
+// Compiled out: still type-checked, never evaluated
+#define LOG_DISCARD(level, ...) \
+    do { if (false) Logger::instance().log(level, __VA_ARGS__); } while (0)
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(...) LOG_AT(LogLevel::TRACE, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) LOG_DISCARD(LogLevel::TRACE, __VA_ARGS__)
+#endif
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_AT(LogLevel::DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_DISCARD(LogLevel::DEBUG, __VA_ARGS__)
+#endif
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_AT(LogLevel::INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_DISCARD(LogLevel::INFO, __VA_ARGS__)
+#endif
+#define LOG_WARN(...) LOG_AT(LogLevel::WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LogLevel::ERROR, __VA_ARGS__)
@@ -1,6 +1,8 @@
 #include "NetIOMPDealerRouter.h"
+#include "Logger.h"
+#include "Trace.h"
+#include <chrono>
 #include <cstring>
-#include <iostream>
 #include <thread>
 
 NetIOMPDealerRouter::NetIOMPDealerRouter(PARTY_ID_T partyId,
@@ -27,13 +29,12 @@ void NetIOMPDealerRouter::init()
     // Setup the ROUTER (server) socket
     int linger = 0;
     m_routerSocket.set(zmq::sockopt::linger, linger);
-    int rcvTimeout = 300; // ms
-    m_routerSocket.set(zmq::sockopt::rcvtimeo, rcvTimeout);
+    m_routerSocket.set(zmq::sockopt::rcvtimeo, RECEIVE_TIMEOUT_MS);
 
     auto [myIp, myPort] = m_partyInfo.at(m_partyId);
     std::string bindEndpoint = "tcp://" + myIp + ":" + std::to_string(myPort);
 
-    std::cout << "Party " << m_partyId << " binding to " << bindEndpoint << "\n";
+    LOG_INFO("Party ", m_partyId, " binding to ", bindEndpoint);
     m_routerSocket.bind(bindEndpoint);
 
     // Setup DEALER (client) sockets for all other parties
@@ -64,7 +65,7 @@ void NetIOMPDealerRouter::initRouter() {
     // Bind to our Party's endpoint
     auto [myIp, myPort] = m_partyInfo.at(m_partyId);
     std::string bindEndpoint = "tcp://" + myIp + ":" + std::to_string(myPort);
-    std::cout << "Party " << m_partyId << " binding to " << bindEndpoint << "\n";
+    LOG_INFO("Party ", m_partyId, " binding to ", bindEndpoint);
     m_routerSocket.bind(bindEndpoint);
 }
 
@@ -93,6 +94,7 @@ void NetIOMPDealerRouter::initDealers() {
 
 void NetIOMPDealerRouter::sendTo(PARTY_ID_T targetId, const void* data, LENGTH_T length)
 {
+    TraceSpan span("sendTo", "net");
     if (m_dealerSockets.find(targetId) == m_dealerSockets.end()) {
         throw std::runtime_error("[NetIOMPDealerRouter] Invalid targetId or socket not initialized.");
     }
@@ -102,9 +104,7 @@ void NetIOMPDealerRouter::sendTo(PARTY_ID_T targetId, const void* data, LENGTH_T
 
     m_dealerSockets[targetId]->send(dataMessage, zmq::send_flags::none);
 
-    #ifdef ENABLE_COUT
-    std::cout << "[NetIOMPDealerRouter] Sent message to Party " << targetId << "\n";
-    #endif
+    LOG_TRACE("[NetIOMPDealerRouter] Sent message to Party ", targetId);
 }
 
 void NetIOMPDealerRouter::sendToAll(const void* data, LENGTH_T length)
@@ -112,17 +112,32 @@ void NetIOMPDealerRouter::sendToAll(const void* data, LENGTH_T length)
     for (const auto& [pid, sockPtr] : m_dealerSockets) {
         try {
             sendTo(pid, data, length);
-            #if defined(ENABLE_COUT)
-            std::cout << "[NetIOMPDealerRouter] Sent data to Party " << pid << "\n";
-            #endif
+            LOG_TRACE("[NetIOMPDealerRouter] Sent data to Party ", pid);
         } catch (const std::exception& e) {
-            std::cerr << "[NetIOMPDealerRouter] Failed to send to Party " << pid << ": " << e.what() << "\n";
+            LOG_ERROR("[NetIOMPDealerRouter] Failed to send to Party ", pid, ": ", e.what());
         }
     }
 }
 
 size_t NetIOMPDealerRouter::receive(PARTY_ID_T& senderId, void* buffer, LENGTH_T maxLength)
 {
+    return receiveAny(senderId, [&](size_t receivedLength) -> void* {
+        if (receivedLength > maxLength) {
+            throw std::runtime_error("[NetIOMPDealerRouter] Buffer too small for received message.");
+        }
+        return buffer;
+    });
+}
+
+size_t NetIOMPDealerRouter::receiveAny(PARTY_ID_T& senderId, const std::function<void*(size_t)>& allocate)
+{
+    TraceSpan span("receive", "net");
+    if (m_received) {
+        Received message;
+        if (!nextReceived(message)) return 0;
+        return deliver(message.routingId, message.data, senderId, allocate);
+    }
+
     // 1) Attempt to receive routing ID frame with set timeout
     zmq::message_t routingIdMsg;
     auto idRes = m_routerSocket.recv(routingIdMsg, zmq::recv_flags::none);
@@ -138,39 +153,120 @@ size_t NetIOMPDealerRouter::receive(PARTY_ID_T& senderId, void* buffer, LENGTH_T
         // No data arrived for the second frame
         return 0;
     }
+    return deliver(routingIdMsg.to_string(), dataMsg, senderId, allocate);
+}
 
-    // Extract senderId from the routing ID
-    std::string routingId = routingIdMsg.to_string();
+size_t NetIOMPDealerRouter::deliver(const std::string& routingId, const zmq::message_t& dataMsg, PARTY_ID_T& senderId,
+                                    const std::function<void*(size_t)>& allocate)
+{
     // Store routingId for use in reply(...)
     m_lastRoutingId = routingId;
     if (routingId.find("Party") != 0) {
         throw std::runtime_error("[NetIOMPDealerRouter] Invalid routing ID format.");
     }
     senderId = static_cast<PARTY_ID_T>(std::stoi(routingId.substr(5)));
-    #if defined(ENABLE_COUT)
-    std::cout << "[NetIOMPDealerRouter] Message received from Party " << senderId << "\n";
-    #endif
+    LOG_TRACE("[NetIOMPDealerRouter] Message received from Party ", senderId);
 
-    // Copy the data into the provided buffer
+    // Copy the data into the memory the caller provides for its size
     size_t receivedLength = dataMsg.size();
-    if (receivedLength > maxLength) {
-        throw std::runtime_error("[NetIOMPDealerRouter] Buffer too small for received message.");
-    }
-    std::memcpy(buffer, dataMsg.data(), receivedLength);
+    std::memcpy(allocate(receivedLength), dataMsg.data(), receivedLength);
 
     return receivedLength;
 }
 
+void NetIOMPDealerRouter::startReceiveThread()
+{
+    if (m_received) return;
+    m_received = std::make_unique<SpscQueue<Received>>(RECEIVE_QUEUE_CAPACITY);
+    // The receive thread is the only one left using the ROUTER socket, so replies reach it
+    // over an inproc pair and double as its wake-up
+    std::string wakeEndpoint = "inproc://receive-thread-" + std::to_string(m_partyId);
+    m_wakeReceiver = zmq::socket_t(m_context, ZMQ_PAIR);
+    m_wakeReceiver.bind(wakeEndpoint);
+    m_wakeSender = zmq::socket_t(m_context, ZMQ_PAIR);
+    m_wakeSender.connect(wakeEndpoint);
+    m_receiveThread = std::thread([this]() { receiveLoop(); });
+}
+
+void NetIOMPDealerRouter::receiveLoop()
+{
+    try {
+        zmq::pollitem_t items[] = {
+            {m_routerSocket.handle(), 0, ZMQ_POLLIN, 0},
+            {m_wakeReceiver.handle(), 0, ZMQ_POLLIN, 0},
+        };
+        Received pending;
+        bool havePending = false;
+        while (true) {
+            // While the ring is full the socket is left alone and ZMQ queues what arrives
+            if (havePending && m_received->push(std::move(pending))) {
+                havePending = false;
+                notifyReceived();
+            }
+            items[0].events = havePending ? 0 : ZMQ_POLLIN;
+            zmq::poll(items, 2, std::chrono::milliseconds(havePending ? 1 : -1));
+
+            if (items[1].revents & ZMQ_POLLIN) {
+                zmq::message_t routingId;
+                (void)m_wakeReceiver.recv(routingId, zmq::recv_flags::none);
+                if (routingId.size() == 0) break;
+                zmq::message_t replyMsg;
+                (void)m_wakeReceiver.recv(replyMsg, zmq::recv_flags::none);
+                m_routerSocket.send(routingId, zmq::send_flags::sndmore);
+                m_routerSocket.send(replyMsg, zmq::send_flags::none);
+            }
+            if (!havePending && (items[0].revents & ZMQ_POLLIN)) {
+                zmq::message_t routingIdMsg;
+                if (!m_routerSocket.recv(routingIdMsg, zmq::recv_flags::none).has_value()) continue;
+                pending.routingId = routingIdMsg.to_string();
+                // Both frames of a message arrive together
+                if (!m_routerSocket.recv(pending.data, zmq::recv_flags::none).has_value()) continue;
+                havePending = true;
+            }
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_waitMutex);
+        m_receiveError = std::current_exception();
+        m_waitCv.notify_all();
+    }
+}
+
+void NetIOMPDealerRouter::notifyReceived()
+{
+    // Pairs with the fence in nextReceived: either the caller sees the new message before it
+    // sleeps, or this thread sees it waiting
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_callerWaiting.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(m_waitMutex);
+        m_waitCv.notify_one();
+    }
+}
+
+bool NetIOMPDealerRouter::nextReceived(Received& message)
+{
+    if (m_received->pop(message)) return true;
+    std::unique_lock<std::mutex> lock(m_waitMutex);
+    m_callerWaiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool popped = false;
+    m_waitCv.wait_for(lock, std::chrono::milliseconds(RECEIVE_TIMEOUT_MS), [&]() {
+        popped = m_received->pop(message);
+        return popped || m_receiveError;
+    });
+    m_callerWaiting.store(false, std::memory_order_relaxed);
+    if (popped) return true;
+    if (m_receiveError) std::rethrow_exception(m_receiveError);
+    return false;
+}
+
 size_t NetIOMPDealerRouter::dealerReceive(PARTY_ID_T& routerId, void* buffer, LENGTH_T maxLength) {
-   
+    TraceSpan span("dealerReceive", "net");
     // Make sure the dealer socket is valid
     if (m_dealerSockets.find(routerId) == m_dealerSockets.end()) {
         throw std::runtime_error("[NetIOMPDealerRouter] Invalid routerId or socket not initialized.");
     }
     zmq::message_t msg;
-    #if defined(ENABLE_COUT)
-    std::cout << "[NetIOMPDealerRouter] Receiving from DEALER socket...\n";
-    #endif
+    LOG_TRACE("[NetIOMPDealerRouter] Receiving from DEALER socket...");
     auto res = m_dealerSockets[routerId]->recv(msg, zmq::recv_flags::none);
     if (!res.has_value()) {
         return 0;
@@ -186,49 +282,42 @@ size_t NetIOMPDealerRouter::dealerReceive(PARTY_ID_T& routerId, void* buffer, LE
 
 void NetIOMPDealerRouter::reply(const void* data, LENGTH_T length)
 {
-    // Prepare routing ID message
-    zmq::message_t routingIdMsg(m_lastRoutingId.size());
-    std::memcpy(routingIdMsg.data(), m_lastRoutingId.data(), m_lastRoutingId.size());
-
-    // Prepare reply message
-    zmq::message_t replyMsg(length);
-    std::memcpy(replyMsg.data(), data, length);
-
-    // Send multipart reply: [routing ID][reply data]
-    m_routerSocket.send(routingIdMsg, zmq::send_flags::sndmore);
-    m_routerSocket.send(replyMsg, zmq::send_flags::none);
+    TraceSpan span("reply", "net");
+    sendReply(m_lastRoutingId.data(), m_lastRoutingId.size(), data, length);
 }
 
 void NetIOMPDealerRouter::reply(void* routingIdMsg, const void* data, LENGTH_T length)
 {
+    TraceSpan span("reply", "net");
     const char* routingIdCharPtr = static_cast<const char*>(routingIdMsg);
     std::string routingIdStr(routingIdCharPtr, m_lastRoutingId.size());
-    std::cout << "[NetIOMPDealerRouter] Received routing ID: " << routingIdStr << "\n";
-
-    zmq::message_t routingId(routingIdStr.size());
-    std::memcpy(routingId.data(), routingIdStr.data(), routingIdStr.size());
-
-    zmq::message_t reply(length);
-    std::memcpy(reply.data(), data, length);
-
-    m_routerSocket.send(routingId, zmq::send_flags::sndmore);
-    m_routerSocket.send(reply, zmq::send_flags::none);
+    LOG_DEBUG("[NetIOMPDealerRouter] Received routing ID: ", routingIdStr);
+    sendReply(routingIdStr.data(), routingIdStr.size(), data, length);
 }
 
 void NetIOMPDealerRouter::reply(void* routingIdMsg, LENGTH_T size, const void* data, LENGTH_T length)
 {
+    TraceSpan span("reply", "net");
     const char* routingIdCharPtr = static_cast<const char*>(routingIdMsg);
     std::string routingIdStr(routingIdCharPtr, size);
-    std::cout << "[NetIOMPDealerRouter] Received routing ID: " << routingIdStr << "\n";
+    LOG_DEBUG("[NetIOMPDealerRouter] Received routing ID: ", routingIdStr);
+    sendReply(routingIdStr.data(), size, data, length);
+}
 
-    zmq::message_t routingId(size);
-    std::memcpy(routingId.data(), routingIdStr.data(), size);
+void NetIOMPDealerRouter::sendReply(const void* routingId, size_t idSize, const void* data, LENGTH_T length)
+{
+    // Prepare routing ID message
+    zmq::message_t routingIdMsg(idSize);
+    std::memcpy(routingIdMsg.data(), routingId, idSize);
 
+    // Prepare reply message
     zmq::message_t replyMsg(length);
     std::memcpy(replyMsg.data(), data, length);
 
-    m_routerSocket.send(routingId, zmq::send_flags::sndmore);
-    m_routerSocket.send(replyMsg, zmq::send_flags::none);
+    // Send multipart reply: [routing ID][reply data]; the receive thread forwards it unchanged
+    zmq::socket_t& socket = m_received ? m_wakeSender : m_routerSocket;
+    socket.send(routingIdMsg, zmq::send_flags::sndmore);
+    socket.send(replyMsg, zmq::send_flags::none);
 }
 
 std::string NetIOMPDealerRouter::getLastRoutingId() const
@@ -241,21 +330,30 @@ void NetIOMPDealerRouter::close()
     // Set linger to 0 to prevent hanging on close
     int linger = 0;
 
+    if (m_receiveThread.joinable()) {
+        // An empty message stops the receive thread, which hands the ROUTER socket back
+        zmq::message_t stop;
+        m_wakeSender.send(stop, zmq::send_flags::none);
+        m_receiveThread.join();
+    }
+    for (zmq::socket_t* wake : {&m_wakeSender, &m_wakeReceiver}) {
+        if (*wake) {
+            wake->set(zmq::sockopt::linger, linger);
+            wake->close();
+        }
+    }
+
     if (m_routerSocket) {
         m_routerSocket.set(zmq::sockopt::linger, linger);
         m_routerSocket.close();
-        #ifdef ENABLE_COUT
-        std::cout << "[NetIOMPDealerRouter] Closed ROUTER socket.\n";
-        #endif
+        LOG_TRACE("[NetIOMPDealerRouter] Closed ROUTER socket.");
     }
 
     for (auto& [pid, sockPtr] : m_dealerSockets) {
         if (sockPtr) {
             sockPtr->set(zmq::sockopt::linger, linger);
             sockPtr->close();
-            #ifdef ENABLE_COUT
-            std::cout << "[NetIOMPDealerRouter] Closed DEALER socket for Party " << pid << ".\n";
-            #endif
+            LOG_TRACE("[NetIOMPDealerRouter] Closed DEALER socket for Party ", pid, ".");
         }
     }
 
@@ -2,11 +2,17 @@
 #define NET_IOMP_DEALERROUTER_H
 
 #include "INetIOMP.h"
+#include "SpscQueue.h"
 #include <zmq.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string> // ...existing includes...
+#include <thread>
 
 /**
  * @brief Implementation of INetIOMP using DEALER/ROUTER sockets.
@@ -20,10 +26,17 @@ public:
     void initRouter(); // Add this method
     void sendTo(PARTY_ID_T targetId, const void* data, LENGTH_T length) override;
     size_t receive(PARTY_ID_T& senderId, void* buffer, LENGTH_T maxLength) override;
+    size_t receiveAny(PARTY_ID_T& senderId, const std::function<void*(size_t)>& allocate) override;
     size_t dealerReceive(PARTY_ID_T& routerId, void* buffer, LENGTH_T maxLength) override; // Add this method
     void reply(const void* data, LENGTH_T length) override;
     void reply(void* routingIdMsg, const void* data, LENGTH_T length) override;
     void reply(void* routingIdMsg, LENGTH_T size, const void* data, LENGTH_T length) override; // Add this method
+    /**
+     * @brief From now on a receive thread owns the ROUTER socket: it polls the socket and
+     *        an inproc wake-up socket, hands every message to the caller through a lock-free
+     *        SPSC ring and sends the replies the caller queues on the wake-up socket.
+     */
+    void startReceiveThread() override;
     void close() override;
     void sendToAll(const void* data, LENGTH_T length) override; // Ensure this is declared
     std::string getLastRoutingId() const override;
@@ -47,6 +60,31 @@ private:
 
     // Store the routing ID of the last received message
     std::string m_lastRoutingId; // Ensure this is correctly updated in receive()
+
+    // Sends [routing ID][data] on the ROUTER socket, through the receive thread once it runs
+    void sendReply(const void* routingId, size_t idSize, const void* data, LENGTH_T length);
+    // Parses the sender from the routing ID and copies the data into memory from allocate
+    size_t deliver(const std::string& routingId, const zmq::message_t& dataMsg, PARTY_ID_T& senderId,
+                   const std::function<void*(size_t)>& allocate);
+
+    // Receive thread (see startReceiveThread)
+    struct Received {
+        std::string routingId;
+        zmq::message_t data;
+    };
+    void receiveLoop();
+    // Caller side: next message from the receive thread, waiting at most RECEIVE_TIMEOUT_MS
+    bool nextReceived(Received& message);
+    void notifyReceived();
+    std::unique_ptr<SpscQueue<Received>> m_received;
+    std::thread m_receiveThread;
+    zmq::socket_t m_wakeReceiver; // receive thread end
+    zmq::socket_t m_wakeSender;   // caller end: replies, and an empty message to stop
+    // The caller only sleeps when the ring is empty; the receive thread only locks to wake it
+    std::atomic<bool> m_callerWaiting{false};
+    std::mutex m_waitMutex;
+    std::condition_variable m_waitCv;
+    std::exception_ptr m_receiveError; // guarded by m_waitMutex
 };
 
 #endif // NET_IOMP_DEALERROUTER_H
\ No newline at end of file
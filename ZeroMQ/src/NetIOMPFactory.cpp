@@ -12,4 +12,22 @@ std::unique_ptr<INetIOMP> NetIOMPFactory::createNetIOMP(Mode mode, PARTY_ID_T pa
         default:
             throw std::invalid_argument("Unknown NetIOMP mode");
     }
-}
\ No newline at end of file
+}
+
+const std::vector<NetIOMPFactory::Mode>& NetIOMPFactory::allModes()
+{
+    static const std::vector<Mode> modes = {Mode::REQ_REP, Mode::DEALER_ROUTER};
+    return modes;
+}
+
+std::string NetIOMPFactory::modeName(Mode mode)
+{
+    switch (mode) {
+        case Mode::REQ_REP:
+            return "reqrep";
+        case Mode::DEALER_ROUTER:
+            return "dealerrouter";
+        default:
+            throw std::invalid_argument("Unknown NetIOMP mode");
+    }
+}
@@ -5,6 +5,7 @@
 #include <map>
 #include <string>
 #include <memory>
+#include <vector>
 #include "config.h"
 
 /**
@@ -32,6 +33,17 @@ public:
     static std::unique_ptr<INetIOMP> createNetIOMP(Mode mode,
                                                    PARTY_ID_T partyId,
                                                    const std::map<PARTY_ID_T, std::pair<std::string, int>>& partyInfo, int totalParties);
+
+    /**
+     * @brief Every mode createNetIOMP accepts, for tools that sweep over transports.
+     *        New backends are added here as well as to Mode.
+     */
+    static const std::vector<Mode>& allModes();
+
+    /**
+     * @brief Command-line name of a mode, as accepted by main ("reqrep", "dealerrouter").
+     */
+    static std::string modeName(Mode mode);
 };
 
 #endif // NET_IOMP_FACTORY_H
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "NetIOMPMetered.h"
+
+void NetIOMPMetered::countSent(SIZE_T messages, SIZE_T bytes)
+{
+    m_messagesSent.fetch_add(messages, std::memory_order_relaxed);
+    m_bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void NetIOMPMetered::countReceived(SIZE_T bytes)
+{
+    // A zero-length receive is a timeout, not a message
+    if (bytes == 0) return;
+    m_messagesReceived.fetch_add(1, std::memory_order_relaxed);
+    m_bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void NetIOMPMetered::sendTo(PARTY_ID_T targetId, const void* data, LENGTH_T length)
+{
+    m_inner->sendTo(targetId, data, length);
+    countSent(1, length);
+}
+
+void NetIOMPMetered::sendToAll(const void* data, LENGTH_T length)
+{
+    m_inner->sendToAll(data, length);
+    countSent(m_peers, static_cast<SIZE_T>(m_peers) * length);
+}
+
+size_t NetIOMPMetered::receive(PARTY_ID_T& senderId, void* buffer, LENGTH_T maxLength)
+{
+    size_t length = m_inner->receive(senderId, buffer, maxLength);
+    countReceived(length);
+    return length;
+}
+
+size_t NetIOMPMetered::receiveAny(PARTY_ID_T& senderId, const std::function<void*(size_t)>& allocate)
+{
+    size_t length = m_inner->receiveAny(senderId, allocate);
+    countReceived(length);
+    return length;
+}
+
+size_t NetIOMPMetered::dealerReceive(PARTY_ID_T& routerId, void* buffer, LENGTH_T maxLength)
+{
+    size_t length = m_inner->dealerReceive(routerId, buffer, maxLength);
+    countReceived(length);
+    return length;
+}
+
+void NetIOMPMetered::reply(const void* data, LENGTH_T length)
+{
+    m_inner->reply(data, length);
+    countSent(1, length);
+}
+
+void NetIOMPMetered::reply(void* routingIdMsg, const void* data, LENGTH_T length)
+{
+    m_inner->reply(routingIdMsg, data, length);
+    countSent(1, length);
+}
+
+void NetIOMPMetered::reply(void* routingIdMsg, LENGTH_T idSize, const void* data, LENGTH_T length)
+{
+    m_inner->reply(routingIdMsg, idSize, data, length);
+    countSent(1, length);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include "INetIOMP.h"
+#include "config.h"
+
+/**
+ * @brief INetIOMP decorator that counts the messages and payload bytes this endpoint
+ *        sends and receives, for benchmarks. Every call is forwarded to the wrapped
+ *        endpoint; routing frames are not counted.
+ */
+class NetIOMPMetered : public INetIOMP
+{
+public:
+    /**
+     * @param inner Endpoint to forward to; must outlive this object.
+     * @param peers Number of parties a sendToAll reaches.
+     */
+    NetIOMPMetered(INetIOMP* inner, int peers) : m_inner(inner), m_peers(peers) {}
+
+    void init() override { m_inner->init(); }
+    void initDealers() override { m_inner->initDealers(); }
+    void sendTo(PARTY_ID_T targetId, const void* data, LENGTH_T length) override;
+    void sendToAll(const void* data, LENGTH_T length) override;
+    size_t receive(PARTY_ID_T& senderId, void* buffer, LENGTH_T maxLength) override;
+    size_t receiveAny(PARTY_ID_T& senderId, const std::function<void*(size_t)>& allocate) override;
+    size_t dealerReceive(PARTY_ID_T& routerId, void* buffer, LENGTH_T maxLength) override;
+    void reply(const void* data, LENGTH_T length) override;
+    void reply(void* routingIdMsg, const void* data, LENGTH_T length) override;
+    void reply(void* routingIdMsg, LENGTH_T idSize, const void* data, LENGTH_T length) override;
+    void startReceiveThread() override { m_inner->startReceiveThread(); }
+    void close() override { m_inner->close(); }
+    std::string getLastRoutingId() const override { return m_inner->getLastRoutingId(); }
+
+    SIZE_T messagesSent() const { return m_messagesSent.load(std::memory_order_relaxed); }
+    SIZE_T bytesSent() const { return m_bytesSent.load(std::memory_order_relaxed); }
+    SIZE_T messagesReceived() const { return m_messagesReceived.load(std::memory_order_relaxed); }
+    SIZE_T bytesReceived() const { return m_bytesReceived.load(std::memory_order_relaxed); }
+
+private:
+    void countSent(SIZE_T messages, SIZE_T bytes);
+    void countReceived(SIZE_T bytes);
+
+    INetIOMP* m_inner;
+    int m_peers;
+    std::atomic<SIZE_T> m_messagesSent{0};
+    std::atomic<SIZE_T> m_bytesSent{0};
+    std::atomic<SIZE_T> m_messagesReceived{0};
+    std::atomic<SIZE_T> m_bytesReceived{0};
+};
@@ -1,8 +1,9 @@
 #include "NetIOMPReqRep.h"
+#include "Logger.h"
+#include "Trace.h"
 #include <cstring>
-#include <iostream>
 #include <thread>
-#include "config.h" // Include config.h for ENABLE_COUT
+#include "config.h"
 
 NetIOMPReqRep::NetIOMPReqRep(PARTY_ID_T partyId,
                              const std::map<PARTY_ID_T, std::pair<std::string, int>>& partyInfo)
@@ -25,9 +26,7 @@ void NetIOMPReqRep::init()
     auto [myIp, myPort] = m_partyInfo.at(m_partyId);
     std::string bindEndpoint = "tcp://" + myIp + ":" + std::to_string(myPort);
 
-    #ifdef ENABLE_COUT
-    std::cout << "Party " << m_partyId << " binding to " << bindEndpoint << "\n";
-    #endif
+    LOG_TRACE("Party ", m_partyId, " binding to ", bindEndpoint);
     m_repSocket->bind(bindEndpoint);
 
     // Setup REQ (client) sockets for all other parties
@@ -53,6 +52,7 @@ void NetIOMPReqRep::initDealers() {
 
 void NetIOMPReqRep::sendTo(PARTY_ID_T targetId, const void* data, LENGTH_T length)
 {
+    TraceSpan span("sendTo", "net");
     if (m_reqSockets.find(targetId) == m_reqSockets.end()) {
         throw std::runtime_error("[NetIOMPReqRep] Invalid targetId or socket not initialized.");
     }
@@ -84,7 +84,7 @@ void NetIOMPReqRep::sendTo(PARTY_ID_T targetId, const void* data, LENGTH_T lengt
             // Optionally handle the reply (e.g., log it, process it).
             break; // Exit the retry loop if successful
         } catch (const zmq::error_t& e) {
-            std::cerr << "[NetIOMPReqRep] Error sending to target " << targetId << ": " << e.what() << std::endl;
+            LOG_ERROR("[NetIOMPReqRep] Error sending to target ", targetId, ": ", e.what());
             std::this_thread::sleep_for(std::chrono::seconds(1)); // Wait before retrying
             retries++;
         }
@@ -106,6 +106,17 @@ void NetIOMPReqRep::sendToAll(const void* data, LENGTH_T length)
 
 size_t NetIOMPReqRep::receive(PARTY_ID_T& senderId, void* buffer, LENGTH_T maxLength)
 {
+    return receiveAny(senderId, [&](size_t receivedLength) -> void* {
+        if (receivedLength > maxLength) {
+            throw std::runtime_error("[NetIOMPReqRep] Buffer too small for received message.");
+        }
+        return buffer;
+    });
+}
+
+size_t NetIOMPReqRep::receiveAny(PARTY_ID_T& senderId, const std::function<void*(size_t)>& allocate)
+{
+    TraceSpan span("receive", "net");
     // Receive the multipart message
     zmq::message_t idMessage;
     zmq::message_t dataMessage;
@@ -129,11 +140,7 @@ size_t NetIOMPReqRep::receive(PARTY_ID_T& senderId, void* buffer, LENGTH_T maxLe
 
     // Extract the data
     size_t receivedLength = dataMessage.size();
-    if (receivedLength > maxLength) {
-        throw std::runtime_error("[NetIOMPReqRep] Buffer too small for received message.");
-    }
-
-    std::memcpy(buffer, dataMessage.data(), receivedLength);
+    std::memcpy(allocate(receivedLength), dataMessage.data(), receivedLength);
     return receivedLength;
 }
 
@@ -144,6 +151,7 @@ size_t NetIOMPReqRep::dealerReceive(PARTY_ID_T& routerId, void* buffer, LENGTH_T
 
 void NetIOMPReqRep::reply(const void* data, LENGTH_T length)
 {
+    TraceSpan span("reply", "net");
     zmq::message_t reply(length);
     std::memcpy(reply.data(), data, length);
 
@@ -151,6 +159,7 @@ void NetIOMPReqRep::reply(const void* data, LENGTH_T length)
 }
 
 void NetIOMPReqRep::reply(void* routingIdMsg, const void* data, LENGTH_T length) {
+    TraceSpan span("reply", "net");
     // For REQ/REP sockets, the routing ID is the first message part
     zmq::message_t routingId(routingIdMsg, sizeof(PARTY_ID_T));
     zmq::message_t reply(length);
@@ -162,6 +171,7 @@ void NetIOMPReqRep::reply(void* routingIdMsg, const void* data, LENGTH_T length)
 
 void NetIOMPReqRep::reply(void* routingIdMsg, LENGTH_T size, const void* data, LENGTH_T length)
 {
+    TraceSpan span("reply", "net");
     (void)routingIdMsg;
     (void)size;
     // For REQ/REP, we generally ignore the routing ID.
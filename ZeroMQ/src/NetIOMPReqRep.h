@@ -17,6 +17,7 @@ public:
     void init() override;
     void sendTo(PARTY_ID_T targetId, const void* data, LENGTH_T length) override;
     size_t receive(PARTY_ID_T& senderId, void* buffer, LENGTH_T maxLength) override;
+    size_t receiveAny(PARTY_ID_T& senderId, const std::function<void*(size_t)>& allocate) override;
     void reply(const void* data, LENGTH_T length) override;
     void reply(void* routingIdMsg, const void* data, LENGTH_T length) override;
     void reply(void* routingIdMsg, LENGTH_T size, const void* data, LENGTH_T length) override;
@@ -0,0 +1,158 @@
+#include "PartitionGroup.h"
+#include "AdditiveSecretSharing.h"
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+PartitionGroup::PartitionHosts PartitionGroup::parseHosts(const std::string &spec, int numPartitions)
+{
+    PartitionHosts hosts;
+    std::stringstream lines(spec);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (!line.empty() && line[0] == '#') continue;
+        std::stringstream entries(line);
+        std::string entry;
+        while (std::getline(entries, entry, ';')) {
+            entry.erase(0, entry.find_first_not_of(" \t\r"));
+            entry.erase(entry.find_last_not_of(" \t\r") + 1);
+            if (entry.empty()) continue;
+            size_t colon = entry.find(':');
+            char* end = nullptr;
+            unsigned long party = colon == std::string::npos ? 0 : std::strtoul(entry.c_str(), &end, 10);
+            if (party == 0 || end != entry.c_str() + colon) {
+                throw std::invalid_argument("Hosts entry \"" + entry + "\" does not start with a party id and ':'");
+            }
+            PARTY_ID_T pid = static_cast<PARTY_ID_T>(party);
+            if (hosts.count(pid)) {
+                throw std::invalid_argument("Hosts of party " + std::to_string(pid) + " are listed twice");
+            }
+            std::stringstream hostList(entry.substr(colon + 1));
+            std::string host;
+            auto &partyHosts = hosts[pid];
+            while (std::getline(hostList, host, ',')) partyHosts.push_back(host);
+            if (static_cast<int>(partyHosts.size()) != numPartitions) {
+                throw std::invalid_argument("Expected " + std::to_string(numPartitions) + " hosts for party " +
+                                            std::to_string(pid) + ", got " + std::to_string(partyHosts.size()));
+            }
+        }
+    }
+    return hosts;
+}
+
+PartitionGroup::PartyInfo PartitionGroup::partitionInfo(const PartyInfo &partyInfo, int partition,
+                                                        const PartitionHosts &hosts)
+{
+    PartyInfo shifted;
+    for (const auto &[pid, endpoint] : partyInfo) {
+        auto listed = hosts.find(pid);
+        std::string host = listed == hosts.end() ? endpoint.first : listed->second.at(partition);
+        shifted[pid] = {host, endpoint.second + partition * PARTITION_PORT_STRIDE};
+    }
+    return shifted;
+}
+
+PartitionGroup::PartyInfo PartitionGroup::controlInfo(const PartyInfo &partyInfo, PARTY_ID_T partyId, int numPartitions,
+                                                      const PartitionHosts &hosts)
+{
+    if (partyInfo.empty()) throw std::runtime_error("controlInfo: empty partyInfo");
+    std::pair<std::string, int> endpoint;
+    auto it = partyInfo.find(partyId);
+    if (it != partyInfo.end()) {
+        endpoint = it->second;
+    } else {
+        const auto &first = *partyInfo.begin();
+        endpoint = {first.second.first, first.second.second + (partyId - first.first)};
+    }
+    auto listed = hosts.find(partyId);
+    PartyInfo control;
+    for (int q = 0; q < numPartitions; ++q) {
+        std::string host = listed == hosts.end() ? endpoint.first : listed->second.at(q);
+        control[static_cast<PARTY_ID_T>(q + 1)] = {host, endpoint.second + q * PARTITION_PORT_STRIDE + PARTITION_CONTROL_OFFSET};
+    }
+    return control;
+}
+
+PartitionGroup::PartitionGroup(INetIOMP* control, int partition, int numPartitions)
+    : m_control(control), m_partition(partition), m_numPartitions(numPartitions)
+{
+    if (numPartitions < 1 || partition < 0 || partition >= numPartitions) {
+        throw std::runtime_error("PartitionGroup: partition " + std::to_string(partition) + " out of range");
+    }
+}
+
+std::string PartitionGroup::receiveFrom(PARTY_ID_T member, CMD_T tag)
+{
+    while (true) {
+        auto &queue = m_pending[member];
+        if (!queue.empty()) {
+            std::string message = std::move(queue.front());
+            queue.pop_front();
+            if (message.empty() || static_cast<CMD_T>(message[0]) != tag) {
+                throw std::runtime_error("PartitionGroup: unexpected control message from partition " +
+                                         std::to_string(member - 1));
+            }
+            return message.substr(1);
+        }
+        PARTY_ID_T sender = 0;
+        size_t length = m_control->receiveAny(sender, [&](size_t size) -> void* {
+            if (m_receiveBuffer.size() < size) m_receiveBuffer.resize(size);
+            return &m_receiveBuffer[0];
+        });
+        if (length == 0) continue; // timed out, keep waiting
+        m_pending[sender].emplace_back(m_receiveBuffer.data(), length);
+    }
+}
+
+void PartitionGroup::barrier()
+{
+    if (m_numPartitions == 1) return;
+    const CMD_T ready = CMD_PARTITION_BARRIER;
+    if (isLeader()) {
+        for (PARTY_ID_T member = 2; member <= m_numPartitions; ++member) {
+            receiveFrom(member, CMD_PARTITION_BARRIER);
+        }
+        for (PARTY_ID_T member = 2; member <= m_numPartitions; ++member) {
+            m_control->sendTo(member, &ready, sizeof(CMD_T));
+        }
+    } else {
+        m_control->sendTo(1, &ready, sizeof(CMD_T));
+        receiveFrom(1, CMD_PARTITION_BARRIER);
+    }
+}
+
+bool PartitionGroup::reduceSum(std::vector<ShareType> &values)
+{
+    if (m_numPartitions == 1) return true;
+    if (!isLeader()) {
+        std::string message(1, static_cast<char>(CMD_PARTITION_REDUCE));
+        for (SIZE_T i = 0; i < values.size(); ++i) {
+            char* hex = BN_bn2hex(values[i]);
+            if (!hex) throw std::runtime_error("PartitionGroup: failed to serialize a result");
+            if (i > 0) message += "|";
+            message += hex;
+            OPENSSL_free(hex);
+        }
+        m_control->sendTo(1, message.data(), message.size());
+        return false;
+    }
+    for (PARTY_ID_T member = 2; member <= m_numPartitions; ++member) {
+        std::stringstream ss(receiveFrom(member, CMD_PARTITION_REDUCE));
+        std::string item;
+        SIZE_T i = 0;
+        for (; std::getline(ss, item, '|'); ++i) {
+            if (i >= values.size()) break;
+            ShareType partial = nullptr;
+            if (!BN_hex2bn(&partial, item.c_str())) {
+                throw std::runtime_error("PartitionGroup: malformed result from partition " + std::to_string(member - 1));
+            }
+            AdditiveSecretSharing::addShares(values[i], partial, values[i]);
+            BN_free(partial);
+        }
+        if (i != values.size()) {
+            throw std::runtime_error("PartitionGroup: partition " + std::to_string(member - 1) + " sent " +
+                                     std::to_string(i) + " results, expected " + std::to_string(values.size()));
+        }
+    }
+    return true;
+}
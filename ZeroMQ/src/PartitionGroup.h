@@ -0,0 +1,85 @@
+#pragma once
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include "INetIOMP.h"
+#include "config.h"
+
+/**
+ * @brief Runs one logical MPC party as several processes, possibly on several hosts.
+ *        Partition q of every party is a complete MPC instance over slice q of the
+ *        inputs and only talks to partition q of the other parties. The partitions of
+ *        one logical party coordinate over a small control channel: a start barrier
+ *        and the reduction of per-partition results into partition 0.
+ */
+class PartitionGroup {
+public:
+    using PartyInfo = std::map<PARTY_ID_T, std::pair<std::string, int>>;
+    // Host of every partition, per logical party
+    using PartitionHosts = std::map<PARTY_ID_T, std::vector<std::string>>;
+
+    /**
+     * @brief Parses "party:host,host,...;party:host,..." with one host per partition.
+     *        Entries may also be separated by newlines, as in a hosts file, where blank
+     *        lines and lines starting with '#' are skipped. Parties that are not listed
+     *        run every partition on their partyInfo host.
+     * @throws std::invalid_argument on a malformed entry, a repeated party or a host
+     *         count other than numPartitions.
+     */
+    static PartitionHosts parseHosts(const std::string &spec, int numPartitions);
+
+    /**
+     * @brief Data endpoints of partition q: the partyInfo ports shifted by
+     *        q * PARTITION_PORT_STRIDE, each party on its own hosts[q] when listed.
+     * @param partyInfo Endpoints of partition 0, as built by main.
+     * @param partition Partition index q.
+     * @param hosts Partition hosts of the parties that do not keep their partyInfo host.
+     */
+    static PartyInfo partitionInfo(const PartyInfo &partyInfo, int partition, const PartitionHosts &hosts);
+
+    /**
+     * @brief Control endpoints of the partitions of one party, keyed by partition + 1.
+     *        Each lies PARTITION_CONTROL_OFFSET above the partition's data port. Party
+     *        ids missing from partyInfo (the dealer) continue its port numbering.
+     * @param partyId Logical party the group belongs to.
+     * @param numPartitions Number of partitions per party.
+     */
+    static PartyInfo controlInfo(const PartyInfo &partyInfo, PARTY_ID_T partyId, int numPartitions,
+                                 const PartitionHosts &hosts);
+
+    /**
+     * @param control Initialized mesh over controlInfo; this process is partition + 1.
+     * @param partition Index of this process within its party.
+     * @param numPartitions Number of partitions per party.
+     */
+    PartitionGroup(INetIOMP* control, int partition, int numPartitions);
+
+    int partition() const { return m_partition; }
+    int numPartitions() const { return m_numPartitions; }
+    bool isLeader() const { return m_partition == 0; }
+
+    /**
+     * @brief Returns once every partition of this party has reached the barrier.
+     */
+    void barrier();
+
+    /**
+     * @brief Adds the values element-wise mod p over all partitions, into partition 0.
+     * @param values This partition's values; on partition 0 they are replaced by the totals.
+     * @return True on partition 0.
+     */
+    bool reduceSum(std::vector<ShareType> &values);
+
+private:
+    // Next control message from member with the given tag; other members' messages are stashed
+    std::string receiveFrom(PARTY_ID_T member, CMD_T tag);
+
+    INetIOMP* m_control;
+    int m_partition;
+    int m_numPartitions;
+    // Control messages that arrived before they were asked for, per member in arrival order
+    std::map<PARTY_ID_T, std::deque<std::string>> m_pending;
+    // Reused by every receive and grown to the largest message so far
+    std::string m_receiveBuffer;
+};
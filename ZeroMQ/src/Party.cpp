@@ -6,37 +6,65 @@
 #include <cassert>
 #include <sstream>
 #include <iomanip>
-#include "config.h" // Include config.h for ENABLE_COUT
+#include <algorithm>
+#include <openssl/sha.h>
+#include "config.h"
 #include <zmq.hpp>
+#include "Circuit.h"
+#include "ThreadPool.h"
+#include "ShareCodec.h"
+#include "PhaseStats.h"
+#include "Trace.h"
+#include "InputLoader.h"
+#include "ResultSink.h"
 
 #define BUFFER_SIZE (1024)  // 1 KB buffer
 
-Party::~Party() {
+// Receive buffer large enough for a '|'-delimited message of numShares shares
+static SIZE_T batchBufferSize(SIZE_T numShares) {
+    return encodedSharesSize(numShares) + BUFFER_SIZE;
+}
+
+// Span name of a dealer command in traces
+static const char* commandName(CMD_T cmd) {
+    switch (cmd) {
+        case CMD_SEND_SHARES: return "CMD_SEND_SHARES";
+        case CMD_SHUTDOWN: return "CMD_SHUTDOWN";
+        case CMD_ADDITION: return "CMD_ADDITION";
+        case CMD_MULTIPLICATION: return "CMD_MULTIPLICATION";
+        case CMD_FETCH_MULT_SHARE: return "CMD_FETCH_MULT_SHARE";
+        case CMD_INNER_PRODUCT: return "CMD_INNER_PRODUCT";
+        case CMD_PARTIAL_OPEN: return "CMD_PARTIAL_OPEN";
+        case CMD_MATRIX_MULTIPLICATION: return "CMD_MATRIX_MULTIPLICATION";
+        case CMD_EVALUATE_CIRCUIT: return "CMD_EVALUATE_CIRCUIT";
+        case CMD_MAC_CHECK: return "CMD_MAC_CHECK";
+        case CMD_PRSS_SETUP: return "CMD_PRSS_SETUP";
+        case CMD_SEND_SHARE_CHUNK: return "CMD_SEND_SHARE_CHUNK";
+        case CMD_INPUT_SHARES: return "CMD_INPUT_SHARES";
+        case CMD_INPUT_DONE: return "CMD_INPUT_DONE";
+        case CMD_COLLECT_INPUTS: return "CMD_COLLECT_INPUTS";
+        case CMD_SHARES_REJECTED: return "CMD_SHARES_REJECTED";
+        case CMD_INPUT_MASKS: return "CMD_INPUT_MASKS";
+        case CMD_INPUT_OPENED: return "CMD_INPUT_OPENED";
+        default: return "CMD_UNKNOWN";
+    }
+}
+
+template <typename Security>
+Party<Security>::~Party() {
     {
+        // Members held as Share free themselves
         if (m_myPartialSum) BN_free(m_myPartialSum);
-        for (auto &secret : m_secrets) {
-            if (secret) BN_free(secret);
-        }
-        #if defined(ENABLE_MALICIOUS_SECURITY)
-        if (m_global_mac_key) BN_free(m_global_mac_key);
-        for (auto &shares : m_macShares) {
-            for (auto &share : shares) {
-                if (share) BN_free(share);
-            }
-        }
-        for (auto &shares : m_addition_partial_sum) {
-            for (auto &share : shares) {
-                if (share) BN_free(share);
-            }
+        if constexpr (Security::MALICIOUS) {
+            freeInnerProductTriple(myInnerProductTripleMac);
+            freeMatrixTriple(myMatrixTripleMac);
+            for (auto &share : m_matrix_product_mac) BN_free(share);
         }
-        if (m_secret_sum) BN_free(m_secret_sum);
-        if (m_secret_sum_mac) BN_free(m_secret_sum_mac);
-        if (m_epsilon) BN_free(m_epsilon);
-        if (m_rho) BN_free(m_rho);
-        // if (m_z_i_mac) BN_free(m_z_i_mac);
-        if (m_global_key_share) BN_free(m_global_key_share);
-        if (m_sigma) BN_free(m_sigma);
-        #endif // ENABLE_MALICIOUS_SECURITY
+        freeInnerProductTriple(myInnerProductTriple);
+        freeMatrixTriple(myMatrixTriple);
+        for (auto &share : m_matrix_product) BN_free(share);
+        for (auto &share : m_peerBatch) BN_free(share);
+        for (auto &share : m_inputBatch) BN_free(share);
     }
 }
 
@@ -67,326 +95,908 @@ ShareType deserializeShare(const std::string& data) {
     return bn;
 }
 
-void Party::init() {
+// Helper function to deserialize a batch of shares into fresh BIGNUMs (caller frees)
+std::vector<ShareType> deserializeShares(const char* data, SIZE_T length) {
+    std::vector<ShareType> shares;
+    try {
+        decodeShares(data, length, shares);
+    } catch (...) {
+        for (auto &share : shares) BN_free(share);
+        throw;
+    }
+    return shares;
+}
+
+template <typename Security>
+void Party<Security>::init() {
     // Optionally do extra setup here
-    #ifdef ENABLE_COUT
-    std::cout << "[Party " << m_partyId << "] init called.\n";
-    #endif
+    LOG_TRACE("[Party ", m_partyId, "] init called.");
+    if (m_hasSecret && m_partyId > m_totalParties + 1) {
+        // Input parties after the dealer only share their inputs
+        this->contributeInputs();
+        return;
+    }
     if (m_hasSecret) {
         // Generate the global key to be used for MAC values
-        #if defined(ENABLE_MALICIOUS_SECURITY)
-        BN_rand_range(m_global_mac_key, AdditiveSecretSharing::getPrime());
-        #if defined(ENABLE_UNIT_TESTS)
-        BN_set_word(m_global_mac_key, 2);
-        std::cout << "[Party " << m_partyId << "] Global MAC key: " << BN_bn2dec(m_global_mac_key) << "\n";
-        #endif
-        #endif
-
-        this->broadcastAllData(&CMD_SEND_SHARES, sizeof(CMD_T));
-        // Prepare the ShareType secrets for this party by initialing two secrets into the ShareType array
-        // std::vector<ShareType> secrets;
-        for (int i = 0; i < NUM_SECRETS; ++i) {
-            ShareType secret_share_type = AdditiveSecretSharing::newBigInt();
-            BN_set_word(secret_share_type, m_localValue + i);
-            // secrets.push_back(secret_share_type);
-            // secrets.emplace_back(secret_share_type);
-            m_secrets[i] = secret_share_type;
-            #if defined(ENABLE_COUT)
-            std::cout << "[Party " << m_partyId << "] Secret share type value: " << BN_bn2dec(secret_share_type) << "\n";
+        if constexpr (Security::MALICIOUS) {
+            BN_rand_range(m_global_mac_key, AdditiveSecretSharing::getPrime());
+            #if defined(ENABLE_UNIT_TESTS)
+            // A known key makes the logged MACs easy to follow, and worthless (see config.h)
+            BN_set_word(m_global_mac_key, 2);
+            LOG_DEBUG("[Party ", m_partyId, "] Global MAC key: ", m_global_mac_key);
             #endif
         }
-        // Generate shares for the secrets
-        std::unordered_map<ShareType, std::vector<ShareType>> shares;
-        this->generateMyShares(m_secrets, shares);
-        #if defined(ENABLE_UNIT_TESTS)
-        // Cout the Shares 
-        for (auto &secret : shares) {
-            std::cout << "[Party " << m_partyId << "] Shares for secret " << BN_bn2dec(secret.first) << ":\n";
-            for (auto &share : secret.second) {
-                std::cout << "  " << BN_bn2dec(share) << "\n";
+
+        // Pairwise PRSS keys first; later steps re-randomize their shares with them
+        {
+            PhaseStats::Scope phase(m_phaseStats, PHASE_SETUP);
+            this->broadcastAllData(&CMD_PRSS_SETUP, sizeof(CMD_T));
+            this->syncAfterDealerStep("setupPrss");
+        }
+
+        {
+            PhaseStats::Scope phase(m_phaseStats, PHASE_SHARE_DISTRIBUTION);
+            if (m_inputPath.empty()) {
+                this->distributeInputs();
+            } else {
+                this->distributeInputStream();
+            }
+            if (m_numInputParties > 1) {
+                this->collectInputs();
             }
         }
+        std::vector<ShareType> globalSum, globalSumMac;
+        {
+            PhaseStats::Scope phase(m_phaseStats, PHASE_ADDITION);
+            this->broadcastAllData(&CMD_ADDITION, sizeof(CMD_T));
+            this->receiveAndReconstructResults(1, globalSum, &globalSumMac);
+        }
+        // Print the global sum; only the output party sees it when one is set
+        #if defined(ENABLE_FINAL_RESULT)
+        if (globalSum.empty()) {
+            // Nothing to print
+        } else if constexpr (Security::MALICIOUS) {
+            LOG_INFO("[Party ", m_partyId, "] Global secret sum: ", globalSum[0]);
+            LOG_INFO("[Party ", m_partyId, "] Global MAC sum: ", globalSumMac[0]);
+        } else {
+            LOG_INFO("[Party ", m_partyId, "] Global sum: ", globalSum[0]);
+        }
         #endif
-        #if defined(ENABLE_MALICIOUS_SECURITY)
-        // Generate the MAC secret with its corresponding shares
-        for (int i = 0; i < NUM_SECRETS; ++i) {
-            std::cout << "[Party " << m_partyId << "] Generating MAC shares for secret " << i << "\n";
-            AdditiveSecretSharing::generateMacShares(m_secrets[i], m_global_mac_key, m_totalParties, m_macShares[i]);
+        this->reducePartitionResults("secret sum", globalSum);
+        for (auto bn : globalSum) BN_free(bn);
+        for (auto bn : globalSumMac) BN_free(bn);
+        if (!m_inputPath.empty()) {
+            // Streamed inputs are folded into one sum at every party, so the job ends here
+            this->finishDealerJob();
+            return;
         }
-            #if defined(ENABLE_UNIT_TESTS)
-            // Reconstrcut the MAC shares and print the results
-            for (int i = 0; i < NUM_SECRETS; ++i) {
-                ShareType macShare = AdditiveSecretSharing::newBigInt();
-                AdditiveSecretSharing::reconstructSecret(m_macShares[i], macShare);
-                std::cout << "[Party " << m_partyId << "] Reconstructed MAC share for secret " << i << ": " << BN_bn2dec(macShare) << "\n";
-                BN_free(macShare);
-            }
-            #endif
-        #endif 
-
-        // Broadcast the shares to all parties
-        for (PARTY_ID_T j = 1; j <= m_totalParties; ++j) {
-            // Serialize each share separately and send as a structured message
-            std::ostringstream shareStream;
-            for (int i = 0; i < NUM_SECRETS; ++i) {
-                shareStream << serializeShare(shares[m_secrets[i]][j - 1]);
-                if (i < NUM_SECRETS - 1) {
-                    shareStream << "|"; // Delimiter between shares
-                }
-            }
-            #if defined(ENABLE_MALICIOUS_SECURITY)
-            for (int i = 0; i < NUM_SECRETS; ++i) {
-                shareStream << "|"; // Delimiter between secrets and MAC shares
-                shareStream << serializeShare(m_macShares[i][j - 1]);
-                if (i < NUM_SECRETS - 1) {
-                    shareStream << "|"; // Delimiter between MAC shares
-                }
-            }
-            #endif
-            std::string shareStr = shareStream.str();
-
-            // Add error handling for send operation
-            try {
-                m_comm->sendTo(j, shareStr.c_str(), shareStr.size());
-                #ifdef ENABLE_COUT
-                std::cout << "[Party " << m_partyId << "] Sent shares to Party " << j << "\n";
-                #endif
-            } catch (const std::exception& e) {
-                std::cerr << "[Party " << m_partyId << "] Failed to send shares to Party " << j 
-                          << ": " << e.what() << "\n";
-            }
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        // Element-wise product of the first and second half of the batch
+        SIZE_T numProducts = m_batchSize / 2;
+        {
+            PhaseStats::Scope phase(m_phaseStats, PHASE_TRIPLE_DISTRIBUTION);
+            this->broadcastAllData(&CMD_MULTIPLICATION, sizeof(CMD_T));
+            this->distributeBeaverTriples(numProducts);
+            // Sync after distributing shares
+            this->syncAfterDealerStep("distributeBeaverTriples");
         }
+        PhaseStats::Scope multiplicationPhase(m_phaseStats, PHASE_MULTIPLICATION);
+         // Sync after distributing shares
+        this->syncAfterDealerStep("MultipliationDone");
+        this->broadcastAllData(&CMD_FETCH_MULT_SHARE, sizeof(CMD_T));
         // Sync after distributing shares
-        for (PARTY_ID_T i = 1; i <= m_totalParties; ++i) {
-            m_comm->dealerReceive(i, &m_cmd, sizeof(CMD_T));
-            if (m_cmd == CMD_SUCCESS) {
-                std::cout << "[Party " << m_partyId << "] Received success from Party " << i << "\n";
+        this->syncAfterDealerStep("fetchMultShare");
+        std::vector<ShareType> product, macProduct;
+        this->receiveAndReconstructResults(numProducts, product, &macProduct);
+        multiplicationPhase.stop();
+        // Print the final products
+        #if defined(ENABLE_FINAL_RESULT)
+        for (SIZE_T k = 0; k < product.size(); ++k) {
+            LOG_INFO("[Party ", m_partyId, "] Final product[", k, "]: ", product[k]);
+            if constexpr (Security::MALICIOUS) {
+                LOG_INFO("[Party ", m_partyId, "] Final MAC product[", k, "]: ", macProduct[k]);
             }
         }
-        this->broadcastAllData(&CMD_ADDITION, sizeof(CMD_T));
-        #if defined(ENABLE_MALICIOUS_SECURITY)
-        std::vector<ShareType> receivedSecretPartialSumShares(m_totalParties);
-        std::vector<ShareType> receivedMacPartialSumShares(m_totalParties);
-        for (PARTY_ID_T i = 1; i <= m_totalParties; ++i) {
-            char buffer[BUFFER_SIZE];
-            size_t bytesRead = m_comm->dealerReceive(i, buffer, sizeof(buffer));
-            if (bytesRead == 0) {
-                throw std::runtime_error("Received empty message from Party " + std::to_string(i));
+        #endif
+        for (auto bn : product) BN_free(bn);
+        for (auto bn : macProduct) BN_free(bn);
+
+        if (m_operation == "ip") {
+            // Inner product of the first and second half of the secrets with one opening
+            SIZE_T length = m_batchSize / 2;
+            {
+                PhaseStats::Scope phase(m_phaseStats, PHASE_TRIPLE_DISTRIBUTION);
+                this->broadcastAllData(&CMD_INNER_PRODUCT, sizeof(CMD_T));
+                this->distributeInnerProductTriple(length);
+                this->syncAfterDealerStep("distributeInnerProductTriple");
             }
-            // Split the received message into secret and MAC shares
-            std::string partialSumStr(buffer, bytesRead);
-            std::vector<std::string> shareParts;
-            std::stringstream ss(partialSumStr);
-            std::string item;
-            while (std::getline(ss, item, '|')) {
-                if (!item.empty()) {
-                    shareParts.push_back(item);
-                }
+            std::vector<ShareType> innerProduct;
+            {
+                PhaseStats::Scope phase(m_phaseStats, PHASE_INNER_PRODUCT);
+                this->receiveAndReconstructResults(1, innerProduct);
+            }
+            #if defined(ENABLE_FINAL_RESULT)
+            for (auto value : innerProduct) {
+                LOG_INFO("[Party ", m_partyId, "] Final inner product: ", value);
+            }
+            #endif
+            this->reducePartitionResults("inner product", innerProduct);
+            for (auto value : innerProduct) BN_free(value);
+        }
+
+        if (m_operation == "matmul") {
+            // Square product of the first and second block of secrets with one opening
+            SIZE_T rows, inner, cols;
+            matrixDimsForInputs(m_batchSize, rows, inner, cols);
+            {
+                PhaseStats::Scope phase(m_phaseStats, PHASE_TRIPLE_DISTRIBUTION);
+                this->broadcastAllData(&CMD_MATRIX_MULTIPLICATION, sizeof(CMD_T));
+                this->distributeMatrixTriple(rows, inner, cols);
+                this->syncAfterDealerStep("distributeMatrixTriple");
             }
-            if (shareParts.size() != 2) {
-                throw std::runtime_error("Received invalid number of shares from Party " + std::to_string(i));
+            std::vector<ShareType> product;
+            {
+                PhaseStats::Scope phase(m_phaseStats, PHASE_MATRIX_MULTIPLICATION);
+                this->receiveAndReconstructResults(rows * cols, product);
             }
-            // Deserialize the secret and MAC shares
-            for (int ii = 0; ii < NUM_TWO; ++ii) {
-                m_addition_partial_sum[ii][i - 1] = deserializeShare(shareParts[ii]);
+            for (SIZE_T e = 0; e < product.size(); ++e) {
+                #if defined(ENABLE_FINAL_RESULT)
+                LOG_INFO("[Party ", m_partyId, "] Final matrix product[", e / cols, "][", e % cols, "]: ", product[e]);
+                #endif
+                BN_free(product[e]);
             }
         }
-        #if defined(ENABLE_UNIT_TESTS)
-        // check the received partial sums
-        for (int i = 0; i < NUM_TWO; ++i) {
-            if (i == 0) {
-                std::cout << "Partial secrets sum " << std::endl;
-            } else {
-                std::cout << "Partial MAC sum " << std::endl;
+
+        if (m_operation == "circuit") {
+            // Layer-batched evaluation: one opening per multiplicative layer
+            Circuit circuit = Circuit::productAndSum(m_batchSize);
+            {
+                PhaseStats::Scope phase(m_phaseStats, PHASE_TRIPLE_DISTRIBUTION);
+                this->broadcastAllData(&CMD_EVALUATE_CIRCUIT, sizeof(CMD_T));
+                std::string circuitMsg = circuit.serialize();
+                this->broadcastAllData(circuitMsg.c_str(), circuitMsg.size());
+                this->distributeBeaverTriples(circuit.numMultiplications());
+                this->syncAfterDealerStep("distributeBeaverTriples");
+            }
+            std::vector<ShareType> outputs;
+            {
+                PhaseStats::Scope phase(m_phaseStats, PHASE_CIRCUIT);
+                this->receiveAndReconstructResults(circuit.numOutputs(), outputs);
             }
-            for (PARTY_ID_T j = 1; j <= m_totalParties; ++j) {
-                std::cout << "[Party " << m_partyId << "] Received partial sum " << i << " from Party " << j << ": " << BN_bn2dec(m_addition_partial_sum[i][j - 1]) << "\n";
+            for (SIZE_T o = 0; o < outputs.size(); ++o) {
+                #if defined(ENABLE_FINAL_RESULT)
+                LOG_INFO("[Party ", m_partyId, "] Final circuit output[", o, "]: ", outputs[o]);
+                #endif
+                BN_free(outputs[o]);
             }
         }
-        #endif
-        // Reconstruct the global sum for the secrets and MAC shares
-        AdditiveSecretSharing::reconstructSecret(m_addition_partial_sum[0], m_secret_sum);
-        AdditiveSecretSharing::reconstructSecret(m_addition_partial_sum[1], m_secret_sum_mac);
-        // Print the global sum
+
+        this->finishDealerJob();
+    } else {
+        this->runEventLoop();
+        if (m_resultSink) m_resultSink->close();
+    }
+
+    // Now party init is simpler, no direct broadcasting or looping.
+}
+
+template <typename Security>
+void Party<Security>::reducePartitionResults(const char* label, std::vector<ShareType> &results)
+{
+    // Results revealed to an output party stay with it in every partition
+    if (!m_partitionGroup || m_partitionGroup->numPartitions() == 1 || results.empty()) return;
+    if (m_partitionGroup->reduceSum(results)) {
         #if defined(ENABLE_FINAL_RESULT)
-        std::cout << "[Party " << m_partyId << "] Global secret sum: " << BN_bn2dec(m_secret_sum) << "\n";
-        std::cout << "[Party " << m_partyId << "] Global MAC sum: " << BN_bn2dec(m_secret_sum_mac) << "\n";
-        #endif
-        // use the assert to check the equality of the m_global_mac_key * m_secret_sum and m_secret_sum_mac
-        ShareType macAdditionProduct = AdditiveSecretSharing::newBigInt();
-        BN_mod_mul(macAdditionProduct, m_global_mac_key, m_secret_sum, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-        assert(BN_cmp(macAdditionProduct, m_secret_sum_mac) == 0 && "The MAC product is not equal to the MAC sum");
-        BN_free(macAdditionProduct);
+        for (auto result : results) {
+            LOG_INFO("[Party ", m_partyId, "] Global ", label, " over ", m_partitionGroup->numPartitions(), " partitions: ", result);
+        }
         #else
-            std::vector<ShareType> receivedParitialSums(m_totalParties);
-            for (PARTY_ID_T i = 1; i <= m_totalParties; ++i) {
-                char buffer[BUFFER_SIZE];
-                size_t bytesRead = m_comm->dealerReceive(i, buffer, sizeof(buffer));
-                if (bytesRead > 0) {
-                    std::string partialSumStr(buffer, bytesRead);
-                    ShareType partialSum = deserializeShare(partialSumStr);
-                    receivedParitialSums[i - 1] = partialSum;
-                }
+        (void)label;
+        #endif
+    }
+}
+
+template <typename Security>
+void Party<Security>::distributeInputs()
+{
+    // [CMD_SEND_SHARES][security mode][batch size]: parties check the mode before they
+    // parse the shares, whose layout depends on it
+    const SecurityMode mode = Security::MODE;
+    char sendSharesCmd[sizeof(CMD_T) + sizeof(SecurityMode) + sizeof(SIZE_T)];
+    std::memcpy(sendSharesCmd, &CMD_SEND_SHARES, sizeof(CMD_T));
+    std::memcpy(sendSharesCmd + sizeof(CMD_T), &mode, sizeof(SecurityMode));
+    std::memcpy(sendSharesCmd + sizeof(CMD_T) + sizeof(SecurityMode), &m_batchSize, sizeof(SIZE_T));
+    this->broadcastAllData(sendSharesCmd, sizeof(sendSharesCmd));
+    // Prepare the ShareType secrets for this party: one per batch element
+    // Partition q of a partitioned party holds slice q of the inputs
+    SIZE_T inputOffset = m_partitionGroup ? m_partitionGroup->partition() * m_batchSize : 0;
+    m_secrets.resize(m_batchSize);
+    if constexpr (Security::MALICIOUS) {
+        m_macShares.resize(m_batchSize);
+    }
+    for (SIZE_T i = 0; i < m_batchSize; ++i) {
+        Share secret_share_type = Share::zero();
+        BN_set_word(secret_share_type, m_localValue + inputOffset + i);
+        m_secrets[i] = std::move(secret_share_type);
+        LOG_TRACE("[Party ", m_partyId, "] Secret share type value: ", m_secrets[i]);
+    }
+    // Generate shares for the secrets
+    std::vector<std::vector<Share>> shares;
+    this->generateMyShares(borrowShares(m_secrets), shares);
+    // Log the shares
+    if (Logger::enabled(LogLevel::DEBUG)) {
+        for (SIZE_T i = 0; i < m_batchSize; ++i) {
+            LOG_DEBUG("[Party ", m_partyId, "] Shares for secret ", m_secrets[i], ":");
+            for (auto &share : shares[i]) {
+                LOG_DEBUG("  ", share);
+            }
+        }
+    }
+    if constexpr (Security::MALICIOUS) {
+        // Generate the MAC secret with its corresponding shares; each costs O(n) random draws
+        LOG_DEBUG("[Party ", m_partyId, "] Generating MAC shares for ", m_batchSize, " secrets");
+        SIZE_T sharingGrain = std::max<SIZE_T>(1, PARALLEL_GRAIN / m_totalParties);
+        ThreadPool::shared().parallelFor(0, m_batchSize, sharingGrain, [&](SIZE_T begin, SIZE_T end) {
+            for (SIZE_T i = begin; i < end; ++i) {
+                m_macShares[i] = AdditiveSecretSharing::generateMacShares(m_secrets[i], m_global_mac_key, m_totalParties);
             }
-            // check the received partial sums
+        });
             #if defined(ENABLE_UNIT_TESTS)
-            for (auto &partialSum : receivedParitialSums) {
-                std::cout << "[Party " << m_partyId << "] Received partial sum from Party " << BN_bn2dec(partialSum) << "\n";
+            // Reconstrcut the MAC shares and print the results
+            for (SIZE_T i = 0; i < m_batchSize; ++i) {
+                Share macShare = Share::zero();
+                ShareType macShareRaw = macShare.get();
+                AdditiveSecretSharing::reconstructSecret(borrowShares(m_macShares[i]), macShareRaw);
+                LOG_DEBUG("[Party ", m_partyId, "] Reconstructed MAC share for secret ", i, ": ", macShare);
             }
             #endif
-            // Reconstruct the global sum
-            ShareType globalSum = AdditiveSecretSharing::newBigInt();
-            AdditiveSecretSharing::reconstructSecret(receivedParitialSums, globalSum);
-            // Print the global sum
-            #if defined(ENABLE_FINAL_RESULT)
-            std::cout << "[Party " << m_partyId << "] Global sum: " << BN_bn2dec(globalSum) << "\n";
-            #endif
-            // Free the global sum
-            BN_free(globalSum);
-        #endif
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        this->broadcastAllData(&CMD_MULTIPLICATION, sizeof(CMD_T));
-        this->distributeBeaverTriple();
-        // Sync after distributing shares
-        for (PARTY_ID_T i = 1; i <= m_totalParties; ++i) {
-            m_comm->dealerReceive(i, &m_cmd, sizeof(CMD_T));
-            if (m_cmd == CMD_SUCCESS) {
-                std::cout << "[distributeBeaverTriple][Party " << m_partyId << "] Received success from Party " << i << "\n";
-            }
+    }
+
+    // Broadcast the shares to all parties
+    for (PARTY_ID_T j = 1; j <= m_totalParties; ++j) {
+        // "share_1|..|share_k[|mac_1|..|mac_k]" for Party j
+        std::vector<ShareType> fields;
+        for (SIZE_T i = 0; i < m_batchSize; ++i) {
+            fields.push_back(shares[i][j - 1]);
         }
-         // Sync after distributing shares
-        for (PARTY_ID_T i = 1; i <= m_totalParties; ++i) {
-            m_comm->dealerReceive(i, &m_cmd, sizeof(CMD_T));
-            if (m_cmd == CMD_SUCCESS) {
-                std::cout << "[MultipliationDone][Party " << m_partyId << "] Received success from Party " << i << "\n";
+        if constexpr (Security::MALICIOUS) {
+            for (SIZE_T i = 0; i < m_batchSize; ++i) {
+                fields.push_back(m_macShares[i][j - 1]);
             }
         }
-        // make a pause to allow the dealer to send the triple shares
-        // std::this_thread::sleep_for(std::chrono::seconds(2));
-        this->broadcastAllData(&CMD_FETCH_MULT_SHARE, sizeof(CMD_T));
-        // Sync after distributing shares
-        for (PARTY_ID_T i = 1; i <= m_totalParties; ++i) {
-            m_comm->dealerReceive(i, &m_cmd, sizeof(CMD_T));
-            if (m_cmd == CMD_SUCCESS) {
-                std::cout << "[Party " << m_partyId << "] Received success from Party " << i << "\n";
-            }
+        PooledBuffer shareMsg = this->encodeBatch(fields, false);
+
+        // Add error handling for send operation
+        try {
+            m_comm->sendTo(j, shareMsg.data(), shareMsg.size());
+            LOG_TRACE("[Party ", m_partyId, "] Sent shares to Party ", j);
+        } catch (const std::exception& e) {
+            LOG_ERROR("[Party ", m_partyId, "] Failed to send shares to Party ", j, ": ", e.what());
         }
-        m_receivedMultiplicationShares.reserve(m_totalParties);
-        m_receivedMultiplicationShares.resize(m_totalParties);
-        for (PARTY_ID_T i = 1; i <= m_totalParties; ++i) {
-            #if defined(ENABLE_UNIT_TESTS)
-            std::cout << "[Party " << m_partyId << "] Receiving multiplication shares from Party " << i << "\n";
-            #endif
-            char buffer[BUFFER_SIZE];
-            size_t bytesRead = m_comm->dealerReceive(i, buffer, sizeof(buffer));
-            if (bytesRead > 0) {
-                std::string shareStr(buffer, bytesRead);
-                ShareType share = deserializeShare(shareStr);
-                m_receivedMultiplicationShares[i - 1] = share;
+    }
+    // Sync after distributing shares
+    this->syncAfterDealerStep("distributeShares");
+}
+
+template <typename Security>
+void Party<Security>::distributeInputStream()
+{
+    InputLoader loader(m_inputPath, InputLoader::formatFromPath(m_inputPath), m_inputChunkValues);
+    // Partition q of a partitioned party shares chunks q, q + P, q + 2P, ... of the file
+    SIZE_T partition = m_partitionGroup ? m_partitionGroup->partition() : 0;
+    SIZE_T numPartitions = m_partitionGroup ? m_partitionGroup->numPartitions() : 1;
+    std::vector<uint64_t> values;
+    SIZE_T sentChunks = 0;
+    m_batchSize = 0;
+    for (SIZE_T chunk = 0; loader.next(values); ++chunk) {
+        if (chunk % numPartitions != partition) continue;
+        this->distributeInputChunk(sentChunks++, values);
+        m_batchSize += values.size();
+    }
+    if (loader.valuesRead() == 0) {
+        throw std::runtime_error("No input values in " + m_inputPath);
+    }
+    if (sentChunks == 0) {
+        // More partitions than chunks: this partition contributes an empty sum
+        std::vector<uint64_t> none;
+        this->distributeInputChunk(0, none);
+    }
+    LOG_DEBUG("[Party ", m_partyId, "] Streamed ", m_batchSize, " input values in ", sentChunks, " chunks");
+}
+
+template <typename Security>
+void Party<Security>::distributeInputChunk(SIZE_T chunkIndex, const std::vector<uint64_t> &values)
+{
+    TraceSpan span("distributeInputChunk", "party");
+    // [CMD_SEND_SHARE_CHUNK][security mode][chunk index][values in the chunk]; chunk 0
+    // restarts the parties' sums
+    SIZE_T count = values.size();
+    const SecurityMode mode = Security::MODE;
+    const SIZE_T prefix = sizeof(CMD_T) + sizeof(SecurityMode);
+    char chunkCmd[prefix + 2 * sizeof(SIZE_T)];
+    std::memcpy(chunkCmd, &CMD_SEND_SHARE_CHUNK, sizeof(CMD_T));
+    std::memcpy(chunkCmd + sizeof(CMD_T), &mode, sizeof(SecurityMode));
+    std::memcpy(chunkCmd + prefix, &chunkIndex, sizeof(SIZE_T));
+    std::memcpy(chunkCmd + prefix + sizeof(SIZE_T), &count, sizeof(SIZE_T));
+    this->broadcastAllData(chunkCmd, sizeof(chunkCmd));
+
+    // Share every value (and its MAC); each value costs O(n) random draws
+    std::vector<std::vector<Share>> valueShares(count);
+    std::vector<std::vector<Share>> valueMacShares(Security::MALICIOUS ? count : 0);
+    SIZE_T sharingGrain = std::max<SIZE_T>(1, PARALLEL_GRAIN / m_totalParties);
+    ThreadPool::shared().parallelFor(0, count, sharingGrain, [&](SIZE_T begin, SIZE_T end) {
+        Share value = Share::zero();
+        for (SIZE_T v = begin; v < end; ++v) {
+            BN_set_word(value, values[v]);
+            valueShares[v] = AdditiveSecretSharing::generateShares(value, m_totalParties);
+            if constexpr (Security::MALICIOUS) {
+                valueMacShares[v] = AdditiveSecretSharing::generateMacShares(value, m_global_mac_key, m_totalParties);
             }
         }
-        // Check the values in the multiplication shares
-        #if defined(ENABLE_UNIT_TESTS)
-        for (auto &share : m_receivedMultiplicationShares) {
-            std::cout << "[Party " << m_partyId << "] Received multiplication share: " << BN_bn2dec(share) << "\n";
+    });
+
+    // One message per party: "share_1|..|share_k[|mac_1|..|mac_k]"
+    std::vector<ShareType> fields;
+    for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
+        fields.clear();
+        for (auto &shares : valueShares) fields.push_back(shares[pid - 1]);
+        if constexpr (Security::MALICIOUS) {
+            for (auto &shares : valueMacShares) fields.push_back(shares[pid - 1]);
+        }
+        PooledBuffer chunkMsg = this->encodeBatch(fields, false);
+        m_comm->sendTo(pid, chunkMsg.data(), chunkMsg.size());
+    }
+    // Every party acknowledges the chunk, which also keeps at most one chunk in flight
+    this->syncAfterDealerStep("distributeInputChunk");
+}
+
+template <typename Security>
+void Party<Security>::finishDealerJob()
+{
+    if constexpr (Security::MALICIOUS) {
+        // One batched check over every opening of the whole computation; a failure is
+        // an attack, so it ends the job in every build rather than only under assert
+        {
+            PhaseStats::Scope phase(m_phaseStats, PHASE_MAC_CHECK);
+            this->broadcastAllData(&CMD_MAC_CHECK, sizeof(CMD_T));
+            this->syncAfterDealerStep("finishDealerJob");
+            if (!this->checkOutputMacs()) {
+                this->broadcastAllData(&CMD_SHUTDOWN, sizeof(CMD_T));
+                throw std::runtime_error("finishDealerJob: the MAC check over the outputs failed");
+            }
         }
-        #endif
-        // Use the multiplication shares to compute the final product
-        ShareType product = AdditiveSecretSharing::newBigInt();
-        AdditiveSecretSharing::reconstructSecret(m_receivedMultiplicationShares, product);
-        // Print the final product
         #if defined(ENABLE_FINAL_RESULT)
-        std::cout << "[Party " << m_partyId << "] Final product: " << BN_bn2dec(product) << "\n";
+        LOG_INFO("[Party ", m_partyId, "] MAC check passed");
         #endif
-        #if defined(ENABLE_MALICIOUS_SECURITY)
-        // Receive the MAC shares from all parties and Check the MAC product
-        for (PARTY_ID_T i = 1; i <= m_totalParties; ++i) {
-            #if defined(ENABLE_UNIT_TESTS)
-            std::cout << "[Party " << m_partyId << "] Receiving MAC shares from Party " << i << "\n";
-            #endif
-            char buffer[BUFFER_SIZE];
-            size_t bytesRead = m_comm->dealerReceive(i, buffer, sizeof(buffer));
-            if (bytesRead > 0) {
-                std::string shareStr(buffer, bytesRead);
-                ShareType share = deserializeShare(shareStr);
-                m_receivedMultiplicationMacShares[i - 1] = share;
+    }
+
+    this->broadcastAllData(&CMD_SHUTDOWN, sizeof(CMD_T));
+    if (m_resultSink) m_resultSink->close();
+}
+
+template <typename Security>
+void Party<Security>::collectInputs()
+{
+    TraceSpan span("collectInputs", "party");
+    // [CMD_COLLECT_INPUTS][input parties after the dealer]
+    SIZE_T extraParties = m_numInputParties - 1;
+    char collectCmd[sizeof(CMD_T) + sizeof(SIZE_T)];
+    std::memcpy(collectCmd, &CMD_COLLECT_INPUTS, sizeof(CMD_T));
+    std::memcpy(collectCmd + sizeof(CMD_T), &extraParties, sizeof(SIZE_T));
+    this->broadcastAllData(collectCmd, sizeof(collectCmd));
+
+    // Every party appends the same inputs, so all must report the same counts
+    SIZE_T counts[2] = {0, 0};
+    std::string error;
+    for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
+        SIZE_T reported[2];
+        size_t received = m_comm->dealerReceive(pid, reported, sizeof(reported));
+        CMD_T status = CMD_SUCCESS;
+        if (received == sizeof(CMD_T)) std::memcpy(&status, reported, sizeof(CMD_T));
+        if (!error.empty()) {
+            continue;
+        } else if (status == CMD_SHARES_REJECTED) {
+            error = "Party " + std::to_string(pid) + " rejected an input party's messages; every party of a job must run the same --security";
+        } else if (received != sizeof(reported)) {
+            error = "Invalid input counts from Party " + std::to_string(pid);
+        } else if (pid == 1) {
+            counts[0] = reported[0];
+            counts[1] = reported[1];
+        } else if (reported[0] != counts[0] || reported[1] != counts[1]) {
+            // An input party sent different inputs to different compute parties
+            error = "Party " + std::to_string(pid) + " merged other inputs than Party 1";
+        }
+    }
+    if (!error.empty()) {
+        // The compute parties wait for the next command; stop them with the job
+        this->broadcastAllData(&CMD_SHUTDOWN, sizeof(CMD_T));
+        throw std::runtime_error(error);
+    }
+    LOG_DEBUG("[Party ", m_partyId, "] ", extraParties, " more input parties shared ", counts[1], " values as ", counts[0], " inputs");
+
+    if constexpr (Security::MALICIOUS) {
+        if (counts[0] > 0) {
+            // One random mask r with its MAC per announced input, then beta and
+            // t = beta * r without MACs: the input parties check the shares of r they are
+            // relayed against them (see authenticateInputs)
+            std::vector<Share> masks(counts[0]);
+            std::vector<Share> tags(2 * counts[0]);
+            ThreadPool::shared().parallelFor(0, masks.size(), PARALLEL_GRAIN, [&](SIZE_T begin, SIZE_T end) {
+                for (SIZE_T k = begin; k < end; ++k) {
+                    masks[k] = Share::zero();
+                    tags[k] = Share::zero();
+                    tags[counts[0] + k] = Share::zero();
+                    BN_rand_range(masks[k], AdditiveSecretSharing::getPrime());
+                    BN_rand_range(tags[k], AdditiveSecretSharing::getPrime());
+                    BN_mod_mul(tags[counts[0] + k], tags[k], masks[k], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+                }
+            });
+            this->sendValueShares(masks);
+            this->sendValueShares(tags, false);
+            this->checkInputOpenings();
+        }
+    }
+    m_batchSize += m_inputPath.empty() ? counts[0] : counts[1];
+}
+
+template <typename Security>
+void Party<Security>::checkInputOpenings()
+{
+    // Every party replies the SHA-256 of the x - r it took, or CMD_SHARES_REJECTED
+    std::string first;
+    std::string error;
+    for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
+        char digest[SHA256_DIGEST_LENGTH];
+        size_t received = m_comm->dealerReceive(pid, digest, sizeof(digest));
+        if (!error.empty()) {
+            continue;
+        } else if (received == sizeof(CMD_T) && static_cast<CMD_T>(digest[0]) == CMD_SHARES_REJECTED) {
+            error = "Party " + std::to_string(pid) + " rejected an input party's openings";
+        } else if (received != sizeof(digest)) {
+            error = "Invalid input digest from Party " + std::to_string(pid);
+        } else if (pid == 1) {
+            first.assign(digest, sizeof(digest));
+        } else if (first != std::string(digest, sizeof(digest))) {
+            // An input party opened different values to different compute parties
+            error = "Party " + std::to_string(pid) + " received other input openings than Party 1";
+        }
+    }
+    if (!error.empty()) {
+        this->broadcastAllData(&CMD_SHUTDOWN, sizeof(CMD_T));
+        throw std::runtime_error(error);
+    }
+}
+
+template <typename Security>
+void Party<Security>::contributeInputs()
+{
+    PhaseStats::Scope phase(m_phaseStats, PHASE_SHARE_DISTRIBUTION);
+    std::vector<uint64_t> values;
+    SIZE_T shared = 0;
+    if constexpr (Security::MALICIOUS) {
+        // Shares of x would have no MAC and any compute party could shift them, so x - r
+        // is opened instead
+        shared = this->openInputs();
+    } else if (m_inputPath.empty()) {
+        // The same kind of batch the dealer generates, starting at this party's value
+        values.resize(m_batchSize);
+        for (SIZE_T i = 0; i < m_batchSize; ++i) {
+            values[i] = static_cast<uint64_t>(m_localValue) + i;
+        }
+        for (SIZE_T begin = 0; begin < values.size(); begin += INPUT_MESSAGE_VALUES) {
+            this->sendInputShares(values.data() + begin, std::min(INPUT_MESSAGE_VALUES, values.size() - begin), false);
+        }
+        shared = values.size();
+    } else {
+        // Streamed files only count with their sum, so the compute parties fold them
+        InputLoader loader(m_inputPath, InputLoader::formatFromPath(m_inputPath), m_inputChunkValues);
+        while (loader.next(values)) {
+            for (SIZE_T begin = 0; begin < values.size(); begin += INPUT_MESSAGE_VALUES) {
+                this->sendInputShares(values.data() + begin, std::min(INPUT_MESSAGE_VALUES, values.size() - begin), true);
             }
         }
-            #if defined(ENABLE_UNIT_TESTS)
-            std::cout << "Received MAC shares" << std::endl;
-            for (auto &share : m_receivedMultiplicationMacShares) {
-                std::cout << "[Party " << m_partyId << "] Received MAC share: " << BN_bn2dec(share) << "\n";
+        if (loader.valuesRead() == 0) {
+            throw std::runtime_error("No input values in " + m_inputPath);
+        }
+        shared = loader.valuesRead();
+        m_batchSize = shared;
+    }
+
+    // Sockets do not linger, so stay until every compute party has taken all messages
+    this->broadcastAllData(&CMD_INPUT_DONE, sizeof(CMD_T));
+    for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
+        m_comm->dealerReceive(pid, &m_cmd, sizeof(CMD_T));
+        if (m_cmd != CMD_SUCCESS) {
+            throw std::runtime_error("Party " + std::to_string(pid) + " did not confirm the inputs");
+        }
+    }
+    LOG_INFO("[Party ", m_partyId, "] Shared ", shared, " input values");
+}
+
+template <typename Security>
+SIZE_T Party<Security>::openInputs()
+{
+    BN_CTX* ctx = AdditiveSecretSharing::getCtx();
+    const BIGNUM* prime = AdditiveSecretSharing::getPrime();
+    std::vector<Share> inputs;
+    SIZE_T values = 0;
+    if (m_inputPath.empty()) {
+        inputs.resize(m_batchSize);
+        for (SIZE_T i = 0; i < m_batchSize; ++i) {
+            inputs[i] = Share::zero();
+            BN_set_word(inputs[i], static_cast<uint64_t>(m_localValue) + i);
+        }
+        values = m_batchSize;
+    } else {
+        // A streamed file only counts with its sum, so only the sum is masked
+        InputLoader loader(m_inputPath, InputLoader::formatFromPath(m_inputPath), m_inputChunkValues);
+        std::vector<uint64_t> chunk;
+        Share sum = Share::zero();
+        while (loader.next(chunk)) {
+            for (uint64_t value : chunk) BN_add_word(sum, value);
+        }
+        if (loader.valuesRead() == 0) {
+            throw std::runtime_error("No input values in " + m_inputPath);
+        }
+        BN_nnmod(sum, sum, prime, ctx);
+        inputs.push_back(std::move(sum));
+        values = loader.valuesRead();
+        m_batchSize = values;
+    }
+    SIZE_T count = inputs.size();
+
+    // [CMD_INPUT_MASKS][inputs][values they stand for]
+    char announce[sizeof(CMD_T) + 2 * sizeof(SIZE_T)];
+    std::memcpy(announce, &CMD_INPUT_MASKS, sizeof(CMD_T));
+    std::memcpy(announce + sizeof(CMD_T), &count, sizeof(SIZE_T));
+    std::memcpy(announce + sizeof(CMD_T) + sizeof(SIZE_T), &values, sizeof(SIZE_T));
+    this->broadcastAllData(announce, sizeof(announce));
+
+    // Every compute party relays its shares of "r_1|..|r_count|beta_1|..|beta_count|t_1|..|t_count"
+    std::vector<Share> masks(3 * count);
+    for (auto &mask : masks) mask = Share::zero();
+    if (count > 0) {
+        PooledBuffer relay = m_recvBuffers.acquire(batchBufferSize(masks.size()));
+        std::vector<ShareType> parts;
+        for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
+            size_t received = m_comm->dealerReceive(pid, relay.data(), relay.capacity());
+            if (received == sizeof(CMD_T) && static_cast<CMD_T>(relay.data()[0]) == CMD_SHARES_REJECTED) {
+                for (auto bn : parts) BN_free(bn);
+                throw std::runtime_error("Party " + std::to_string(pid) + " did not take the inputs; every party of a job must run the same --security");
             }
-            #endif
-        ShareType macProduct = AdditiveSecretSharing::newBigInt();
-        AdditiveSecretSharing::reconstructSecret(m_receivedMultiplicationMacShares, macProduct);
-        // Print the final product
-            #if defined(ENABLE_FINAL_RESULT)
-            std::cout << "[Party " << m_partyId << "] Final MAC product: " << BN_bn2dec(macProduct) << "\n";
-            #endif
-        // assert the equality of the product multiplied by the global MAC key and the MAC product
-        ShareType macProductCheck = AdditiveSecretSharing::newBigInt();
-        BN_mod_mul(macProductCheck, product, m_global_mac_key, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-        assert(BN_cmp(macProductCheck, macProduct) == 0 && "The MAC product is not equal to the MAC sum");
-        BN_free(macProduct);
-        BN_free(macProductCheck);
-        // Receive the sigma shares from all parties
-        for (PARTY_ID_T i = 1; i <= m_totalParties; ++i) {
-            #if defined(ENABLE_UNIT_TESTS)
-            std::cout << "[Party " << m_partyId << "] Receiving sigma shares from Party " << i << "\n";
-            #endif
-            char buffer[BUFFER_SIZE];
-            size_t bytesRead = m_comm->dealerReceive(i, buffer, sizeof(buffer));
-            if (bytesRead > 0) {
-                std::string shareStr(buffer, bytesRead);
-                ShareType share = deserializeShare(shareStr);
-                m_receivedMultiplicationSigmaShares[i - 1] = share;
+            if (decodeShares(relay.data(), received, parts) != masks.size()) {
+                for (auto bn : parts) BN_free(bn);
+                throw std::runtime_error("Invalid input masks from Party " + std::to_string(pid));
             }
-        }
-            #if defined(ENABLE_UNIT_TESTS)
-            std::cout << "Received sigma shares" << std::endl;
-            for (auto &share : m_receivedMultiplicationSigmaShares) {
-                std::cout << "[Party " << m_partyId << "] Received sigma share: " << BN_bn2dec(share) << "\n";
+            for (SIZE_T k = 0; k < masks.size(); ++k) {
+                BN_mod_add(masks[k], masks[k], parts[k], prime, ctx);
             }
-            #endif
-        // Reconstruct the sigma product and check it is equal to the zero or not
-        ShareType sigmaProduct = AdditiveSecretSharing::newBigInt();
-        AdditiveSecretSharing::reconstructSecret(m_receivedMultiplicationSigmaShares, sigmaProduct);
-        // Print the final product
-            #if defined(ENABLE_FINAL_RESULT)
-            std::cout << "[Party " << m_partyId << "] Final sigma product: " << BN_bn2dec(sigmaProduct) << "\n";
-            #endif
-        // assert the equality of the sigma product and the zero
-        assert(BN_is_zero(sigmaProduct) && "The sigma product is not equal to zero");
-        #endif
+        }
+        for (auto bn : parts) BN_free(bn);
+    }
 
-        BN_free(product);
+    // A compute party that changed its share of r_k would have to change t_k by beta_k
+    // times as much, and beta_k is as hidden from it as r_k
+    Share tag = Share::zero();
+    for (SIZE_T k = 0; k < count; ++k) {
+        BN_mod_mul(tag, masks[count + k], masks[k], prime, ctx);
+        if (BN_cmp(tag, masks[2 * count + k]) != 0) {
+            this->broadcastAllData(&CMD_SHARES_REJECTED, sizeof(CMD_T));
+            throw std::runtime_error("The input masks were changed on the way to Party " + std::to_string(m_partyId));
+        }
+    }
 
-        this->broadcastAllData(&CMD_SHUTDOWN, sizeof(CMD_T));
+    // x - r is uniformly random, so every compute party may see it; the dealer checks
+    // that all of them took the same (see checkInputOpenings)
+    for (SIZE_T k = 0; k < count; ++k) {
+        BN_mod_sub(inputs[k], inputs[k], masks[k], prime, ctx);
+    }
+    std::vector<ShareType> opened = borrowShares(inputs);
+    const SIZE_T header = sizeof(CMD_T) + sizeof(SIZE_T);
+    for (SIZE_T begin = 0; begin < count; begin += INPUT_MESSAGE_VALUES) {
+        SIZE_T chunk = std::min(INPUT_MESSAGE_VALUES, count - begin);
+        // [CMD_INPUT_OPENED][count] then "d_1|..|d_count"
+        PooledBuffer msg = m_sendBuffers.acquire(header + encodedSharesSize(chunk));
+        std::memcpy(msg.data(), &CMD_INPUT_OPENED, sizeof(CMD_T));
+        std::memcpy(msg.data() + sizeof(CMD_T), &chunk, sizeof(SIZE_T));
+        msg.resize(header + encodeShares(std::vector<ShareType>(opened.begin() + begin, opened.begin() + begin + chunk),
+                                         msg.data() + header));
+        this->broadcastAllData(msg.data(), msg.size());
+    }
+    return values;
+}
+
+template <typename Security>
+void Party<Security>::sendInputShares(const uint64_t* values, SIZE_T count, bool fold)
+{
+    TraceSpan span("sendInputShares", "party");
+    // Share every value; each costs O(n) random draws
+    std::vector<std::vector<Share>> valueShares(count);
+    SIZE_T sharingGrain = std::max<SIZE_T>(1, PARALLEL_GRAIN / m_totalParties);
+    ThreadPool::shared().parallelFor(0, count, sharingGrain, [&](SIZE_T begin, SIZE_T end) {
+        Share value = Share::zero();
+        for (SIZE_T v = begin; v < end; ++v) {
+            BN_set_word(value, values[v]);
+            valueShares[v] = AdditiveSecretSharing::generateShares(value, m_totalParties);
+        }
+    });
+
+    // [CMD_INPUT_SHARES][fold][count] then "share_1|..|share_count" of each party
+    const SIZE_T header = sizeof(CMD_T) + sizeof(uint8_t) + sizeof(SIZE_T);
+    uint8_t foldFlag = fold ? 1 : 0;
+    std::vector<ShareType> fields;
+    for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
+        fields.clear();
+        for (auto &shares : valueShares) fields.push_back(shares[pid - 1]);
+        PooledBuffer msg = m_sendBuffers.acquire(header + encodedSharesSize(count));
+        std::memcpy(msg.data(), &CMD_INPUT_SHARES, sizeof(CMD_T));
+        std::memcpy(msg.data() + sizeof(CMD_T), &foldFlag, sizeof(uint8_t));
+        std::memcpy(msg.data() + sizeof(CMD_T) + sizeof(uint8_t), &count, sizeof(SIZE_T));
+        msg.resize(header + encodeShares(fields, msg.data() + header));
+        m_comm->sendTo(pid, msg.data(), msg.size());
+    }
+}
+
+template <typename Security>
+bool Party<Security>::takeInputMessage(PARTY_ID_T senderId, const char* bytes, SIZE_T length)
+{
+    // The dealer is party n+1; every party above it is an input party
+    if (senderId <= m_totalParties + 1 || length < sizeof(CMD_T)) {
+        return false;
+    }
+    CMD_T cmd = static_cast<CMD_T>(bytes[0]);
+    InputContribution &input = m_contributions[senderId];
+    if (cmd == CMD_INPUT_SHARES) {
+        const SIZE_T header = sizeof(CMD_T) + sizeof(uint8_t) + sizeof(SIZE_T);
+        if (length < header || input.done) {
+            throw std::runtime_error("Unexpected input message from Party " + std::to_string(senderId));
+        }
+        if constexpr (Security::MALICIOUS) {
+            // Shares of x without a MAC; its CMD_INPUT_DONE is answered with CMD_SHARES_REJECTED
+            input.rejected = true;
+            return true;
+        }
+        uint8_t fold;
+        SIZE_T count;
+        std::memcpy(&fold, bytes + sizeof(CMD_T), sizeof(uint8_t));
+        std::memcpy(&count, bytes + sizeof(CMD_T) + sizeof(uint8_t), sizeof(SIZE_T));
+        if (decodeShares(bytes + header, length - header, m_inputBatch) != count) {
+            throw std::runtime_error("Invalid input shares from Party " + std::to_string(senderId));
+        }
+        if (fold ? !input.shares.empty() : static_cast<bool>(input.sum)) {
+            throw std::runtime_error("Party " + std::to_string(senderId) + " mixed streamed and batched inputs");
+        }
+        if (fold) {
+            // Only the sum of a streamed file is kept, as for the dealer's own stream
+            if (!input.sum) input.sum = Share::zero();
+            BigIntScratch scratch;
+            ShareType batchSum = scratch.get();
+            AdditiveSecretSharing::addShares(std::vector<ShareType>(m_inputBatch.begin(), m_inputBatch.begin() + count), batchSum);
+            ShareType sum = input.sum.get();
+            AdditiveSecretSharing::addShares(sum, batchSum, sum);
+        } else {
+            for (SIZE_T k = 0; k < count; ++k) {
+                input.shares.emplace_back(AdditiveSecretSharing::cloneBigInt(m_inputBatch[k]));
+            }
+        }
+        input.values += count;
+    } else if (cmd == CMD_INPUT_MASKS) {
+        if (length != sizeof(CMD_T) + 2 * sizeof(SIZE_T) || input.announced || input.done) {
+            throw std::runtime_error("Unexpected input message from Party " + std::to_string(senderId));
+        }
+        if constexpr (!Security::MALICIOUS) {
+            // It waits for masks this job does not deal; stop it instead
+            input.rejected = true;
+            input.done = true;
+            this->replyToInputParty(senderId, &CMD_SHARES_REJECTED, sizeof(CMD_T));
+            return true;
+        }
+        std::memcpy(&input.inputs, bytes + sizeof(CMD_T), sizeof(SIZE_T));
+        std::memcpy(&input.values, bytes + sizeof(CMD_T) + sizeof(SIZE_T), sizeof(SIZE_T));
+        input.announced = true;
+    } else if (cmd == CMD_INPUT_OPENED) {
+        const SIZE_T header = sizeof(CMD_T) + sizeof(SIZE_T);
+        if (length < header || !input.announced || input.done) {
+            throw std::runtime_error("Unexpected input message from Party " + std::to_string(senderId));
+        }
+        SIZE_T count;
+        std::memcpy(&count, bytes + sizeof(CMD_T), sizeof(SIZE_T));
+        if (decodeShares(bytes + header, length - header, m_inputBatch) != count) {
+            throw std::runtime_error("Invalid input openings from Party " + std::to_string(senderId));
+        }
+        for (SIZE_T k = 0; k < count; ++k) {
+            input.opened.emplace_back(AdditiveSecretSharing::cloneBigInt(m_inputBatch[k]));
+        }
+    } else if (cmd == CMD_SHARES_REJECTED) {
+        // The input party found its relayed masks changed and stopped
+        input.rejected = true;
+        input.done = true;
+    } else if (cmd == CMD_INPUT_DONE) {
+        input.done = true;
+        this->replyToInputParty(senderId, input.rejected ? &CMD_SHARES_REJECTED : &CMD_SUCCESS, sizeof(CMD_T));
     } else {
-        this->runEventLoop();
+        throw std::runtime_error("Unexpected command " + std::to_string(cmd) + " from input Party " + std::to_string(senderId));
     }
+    return true;
+}
 
-    // Now party init is simpler, no direct broadcasting or looping.
+template <typename Security>
+void Party<Security>::replyToInputParty(PARTY_ID_T pid, const void* data, LENGTH_T length)
+{
+    std::string routingId = "Party" + std::to_string(pid) + "_to_" + std::to_string(m_partyId);
+    m_comm->reply((void*)routingId.c_str(), routingId.size(), data, length);
+}
+
+template <typename Security>
+void Party<Security>::waitForInputs(SIZE_T extraParties, bool announced)
+{
+    PARTY_ID_T firstInputParty = static_cast<PARTY_ID_T>(m_totalParties + 2);
+    PARTY_ID_T endInputParty = static_cast<PARTY_ID_T>(firstInputParty + extraParties);
+    auto allReady = [&]() {
+        for (PARTY_ID_T pid = firstInputParty; pid < endInputParty; ++pid) {
+            auto input = m_contributions.find(pid);
+            if (input == m_contributions.end()) return false;
+            if (!input->second.done && !(announced && input->second.announced)) return false;
+        }
+        return true;
+    };
+    // Input parties that started before the dealer are usually ready already
+    while (!allReady()) {
+        PARTY_ID_T senderId;
+        PooledBuffer msg = this->receiveMessage(senderId);
+        if (msg.size() == 0 || this->takeInputMessage(senderId, msg.data(), msg.size())) {
+            continue;
+        }
+        if (static_cast<CMD_T>(msg.data()[0]) != CMD_PARTIAL_OPEN) {
+            throw std::runtime_error("Unexpected message from Party " + std::to_string(senderId) + " while merging inputs");
+        }
+        m_pendingOpenings.emplace_back(senderId, std::move(msg));
+    }
+}
+
+template <typename Security>
+bool Party<Security>::mergeInputs(SIZE_T extraParties, SIZE_T counts[2])
+{
+    // Malicious jobs only count what was announced; authenticateInputs appends the inputs
+    this->waitForInputs(extraParties, Security::MALICIOUS);
+    PARTY_ID_T firstInputParty = static_cast<PARTY_ID_T>(m_totalParties + 2);
+    PARTY_ID_T endInputParty = static_cast<PARTY_ID_T>(firstInputParty + extraParties);
+    counts[0] = 0;
+    counts[1] = 0;
+    bool accepted = true;
+    for (PARTY_ID_T pid = firstInputParty; pid < endInputParty; ++pid) {
+        InputContribution &input = m_contributions[pid];
+        accepted = accepted && !input.rejected;
+        if constexpr (Security::MALICIOUS) {
+            counts[0] += input.inputs;
+        } else {
+            counts[0] += (input.sum ? 1 : 0) + input.shares.size();
+            if (input.sum) m_receivedShares.push_back(std::move(input.sum));
+            for (auto &share : input.shares) m_receivedShares.push_back(std::move(share));
+        }
+        counts[1] += input.values;
+    }
+    if constexpr (!Security::MALICIOUS) {
+        m_contributions.clear();
+    }
+    return accepted;
+}
+
+template <typename Security>
+void Party<Security>::rejectInputParties()
+{
+    // Input parties still waiting for masks would wait for good otherwise
+    for (auto &entry : m_contributions) {
+        if (entry.second.announced && !entry.second.done) {
+            this->replyToInputParty(entry.first, &CMD_SHARES_REJECTED, sizeof(CMD_T));
+        }
+    }
+    m_contributions.clear();
+}
+
+template <typename Security>
+void Party<Security>::authenticateInputs(SIZE_T extraParties, SIZE_T count)
+{
+    if (m_receivedMacShares.size() != m_receivedShares.size()) {
+        throw std::runtime_error("authenticateInputs: the dealer's inputs lack MAC shares");
+    }
+    // "r_1|..|r_count|mac_1|..|mac_count|key" from sendValueShares, unless the dealer
+    // stopped the job because the counts differ
+    PooledBuffer buffer = this->receiveFromDealer();
+    if (buffer.size() == sizeof(CMD_T) && static_cast<CMD_T>(buffer.data()[0]) == CMD_SHUTDOWN) {
+        this->rejectInputParties();
+        m_running = false;
+        return;
+    }
+    std::vector<Share> fields = adoptShares(deserializeShares(buffer.data(), buffer.size()));
+    // Then "beta_1|..|beta_count|t_1|..|t_count" without MACs
+    PooledBuffer tagBuffer = this->receiveFromDealer();
+    std::vector<Share> tags = adoptShares(deserializeShares(tagBuffer.data(), tagBuffer.size()));
+    if (fields.size() != 2 * count + 1 || tags.size() != 2 * count) {
+        throw std::runtime_error("Invalid input masks received");
+    }
+    m_global_key_share = std::move(fields.back());
+
+    // Each input party gets this party's shares of its own masks, so r stays hidden from
+    // everyone else; the MACs of r never leave the compute parties
+    PARTY_ID_T firstInputParty = static_cast<PARTY_ID_T>(m_totalParties + 2);
+    PARTY_ID_T endInputParty = static_cast<PARTY_ID_T>(firstInputParty + extraParties);
+    SIZE_T offset = 0;
+    for (PARTY_ID_T pid = firstInputParty; pid < endInputParty; ++pid) {
+        SIZE_T inputs = m_contributions[pid].inputs;
+        if (inputs == 0) continue;
+        std::vector<ShareType> relay;
+        for (SIZE_T k = offset; k < offset + inputs; ++k) relay.push_back(fields[k]);
+        for (SIZE_T k = offset; k < offset + inputs; ++k) relay.push_back(tags[k]);
+        for (SIZE_T k = offset; k < offset + inputs; ++k) relay.push_back(tags[count + k]);
+        PooledBuffer msg = this->encodeBatch(relay, false);
+        this->replyToInputParty(pid, msg.data(), msg.size());
+        offset += inputs;
+    }
+
+    this->waitForInputs(extraParties, false);
+    std::vector<Share> opened;
+    bool accepted = true;
+    for (PARTY_ID_T pid = firstInputParty; pid < endInputParty; ++pid) {
+        InputContribution &input = m_contributions[pid];
+        accepted = accepted && !input.rejected && input.opened.size() == input.inputs;
+        for (auto &value : input.opened) opened.push_back(std::move(value));
+    }
+    m_contributions.clear();
+    if (!accepted) {
+        // The dealer stops the job
+        this->replyToDealer(&CMD_SHARES_REJECTED, sizeof(CMD_T));
+        return;
+    }
+
+    // x = r + (x - r) with mac(x) = mac(r) + (x - r) * alpha; as for any public constant,
+    // only party 1 adds x - r to its share
+    BN_CTX* ctx = AdditiveSecretSharing::getCtx();
+    const BIGNUM* prime = AdditiveSecretSharing::getPrime();
+    for (SIZE_T k = 0; k < count; ++k) {
+        Share mac = Share::zero();
+        BN_mod_mul(mac, opened[k], m_global_key_share, prime, ctx);
+        BN_mod_add(mac, mac, fields[count + k], prime, ctx);
+        if (m_partyId == 1) {
+            BN_mod_add(fields[k], fields[k], opened[k], prime, ctx);
+        }
+        m_receivedShares.push_back(std::move(fields[k]));
+        m_receivedMacShares.push_back(std::move(mac));
+    }
+    // An input party could open different values to different compute parties; the
+    // dealer compares what each of them took
+    PooledBuffer openings = this->encodeBatch(borrowShares(opened), false);
+    std::string digest = AdditiveSecretSharing::sha256(std::string(openings.data(), openings.size()));
+    this->replyToDealer(digest.data(), digest.size());
+}
+
+template <typename Security>
+void Party<Security>::replyToDealer(const void* data, LENGTH_T length)
+{
+    // Peer and input-party messages move the last routing id, so the dealer is addressed explicitly
+    m_comm->reply((void*)m_dealRouterId.c_str(), m_dealRouterId.size(), data, length);
 }
 
-void Party::broadcastAllData(const void* data, LENGTH_T length) {
+template <typename Security>
+void Party<Security>::broadcastAllData(const void* data, LENGTH_T length) {
     for (PARTY_ID_T i = 1; i <= m_totalParties; ++i) {
         m_comm->sendTo(i, data, length);
     }
 }
-void Party::receiveAllData(void* data, LENGTH_T length) {
+template <typename Security>
+void Party<Security>::receiveAllData(void* data, LENGTH_T length) {
     for (PARTY_ID_T i = 1; i <= m_totalParties; ++i) {
         m_comm->dealerReceive(i, data, length);
     }
 }
 
 // Corrected and updated broadcastShares function
-void Party::broadcastShares(const std::vector<ShareType> &shares) {
+template <typename Security>
+void Party<Security>::broadcastShares(const std::vector<ShareType> &shares) {
     for (int i = 1; i <= m_totalParties; ++i) {
         if (!shares[i - 1]) {
             // Handle null share
-            std::cerr << "[Party " << m_partyId << "] Share for Party " << i << " is null.\n";
+            LOG_ERROR("[Party ", m_partyId, "] Share for Party ", i, " is null.");
             continue;
         }
         try {
@@ -394,19 +1004,17 @@ void Party::broadcastShares(const std::vector<ShareType> &shares) {
             std::string serializedShare = serializeShare(shares[i - 1]);
             // Send the serialized share to the target party
             m_comm->sendTo(i, serializedShare.c_str(), serializedShare.size());
-            #ifdef ENABLE_COUT
-            std::cout << "[Party " << m_partyId << "] Sent share to Party " << i << "\n";
-            #endif
+            LOG_TRACE("[Party ", m_partyId, "] Sent share to Party ", i);
         }
         catch (const std::exception& e) {
-            std::cerr << "[Party " << m_partyId << "] Failed to send share to Party " << i
-                      << ": " << e.what() << "\n";
+            LOG_ERROR("[Party ", m_partyId, "] Failed to send share to Party ", i, ": ", e.what());
         }
     }
 }
 
 // Receives shares from other parties and deserializes them
-void Party::receiveShares(std::vector<ShareType> &received, int expectedCount) {
+template <typename Security>
+void Party<Security>::receiveShares(std::vector<ShareType> &received, int expectedCount) {
     received.clear();
     received.reserve(expectedCount);  // Reserve space for efficiency
     int count = 0;
@@ -418,44 +1026,27 @@ void Party::receiveShares(std::vector<ShareType> &received, int expectedCount) {
             throw std::runtime_error("Received empty share from Party " + std::to_string(senderId));
         }
         std::string shareStr(buffer, bytesRead);
-        #ifdef ENABLE_COUT
-        std::cout << "[Party " << m_partyId << "] Received share from Party " << senderId 
-                  << ": " << shareStr << "\n";
-        #endif
+        LOG_TRACE("[Party ", m_partyId, "] Received share from Party ", senderId, ": ", shareStr);
         try {
             ShareType share = deserializeShare(shareStr);
             received.push_back(share);
             count++;
         }
         catch (const std::exception& e) {
-            std::cerr << "[Party " << m_partyId << "] Failed to deserialize share from Party " 
-                      << senderId << ": " << e.what() << "\n";
+            LOG_ERROR("[Party ", m_partyId, "] Failed to deserialize share from Party ", senderId, ": ", e.what());
         }
     }
 }
 
-// Securely multiplies shares using Beaver's Triple
-void Party::secureMultiplyShares(ShareType myShareX, ShareType myShareY,
-                                 const BeaverTriple &myTripleShare, ShareType &productOut) {
-    // Suppress unused parameter warnings if parameters are not used
-    (void)myShareX;
-    (void)myShareY;
-    (void)myTripleShare;
-    (void)productOut;
-    // ...existing implementation...
-    // If implementation uses these parameters, remove the above lines.
-}
-
 // Distributes own shares to all parties
-void Party::distributeOwnShares() {
+template <typename Security>
+void Party<Security>::distributeOwnShares() {
     try {
         // Create and initialize secret BIGNUM
         ShareType secret = AdditiveSecretSharing::newBigInt();
         if (!secret) throw std::runtime_error("Failed to create secret BIGNUM");
         
-        #ifdef ENABLE_COUT
-        std::cout << "[Party " << m_partyId << "] Converting value " << m_localValue << " to BIGNUM\n";
-        #endif
+        LOG_TRACE("[Party ", m_partyId, "] Converting value ", m_localValue, " to BIGNUM");
         if (!BN_set_word(secret, m_localValue)) {
             BN_free(secret);
             throw std::runtime_error("BN_set_word failed");
@@ -466,54 +1057,37 @@ void Party::distributeOwnShares() {
         AdditiveSecretSharing::generateShares(secret, m_totalParties, myShares);
         BN_free(secret);
 
-        #ifdef ENABLE_COUT
-        std::cout << "[Party " << m_partyId << "] Generated " << myShares.size() << " shares\n";
-        #endif
+        LOG_TRACE("[Party ", m_partyId, "] Generated ", myShares.size(), " shares");
         broadcastShares(myShares);
 
         syncAfterDistribute();
     }
     catch (const std::exception& e) {
-        std::cerr << "[Party " << m_partyId << "] Error in distributeOwnShares: " << e.what() << "\n";
+        LOG_ERROR("[Party ", m_partyId, "] Error in distributeOwnShares: ", e.what());
         throw;
     }
 }
 
 // Broadcasts a partial sum to all parties
-void Party::broadcastPartialSum(long long partialSum) {
+template <typename Security>
+void Party<Security>::broadcastPartialSum(long long partialSum) {
     try {
         if (!m_comm) {
             throw std::runtime_error("Communication interface not initialized.");
         }
         std::string sumStr = std::to_string(partialSum);
         m_comm->sendToAll(sumStr.c_str(), sumStr.size());
-        #ifdef ENABLE_COUT
-        std::cout << "[Party " << m_partyId << "] Broadcasted partial sum: " << partialSum << "\n";
-        #endif
+        LOG_TRACE("[Party ", m_partyId, "] Broadcasted partial sum: ", partialSum);
     }
     catch (const std::exception& e) {
-        std::cerr << "[Party " << m_partyId << "] Error in broadcastPartialSum: " << e.what() << "\n";
+        LOG_ERROR("[Party ", m_partyId, "] Error in broadcastPartialSum: ", e.what());
         throw;
     }
 }
 
-// // Demonstrates secure multiplication using Beaver's Triple
-// void Party::doMultiplicationDemo() {
-//     // For a real multi-party multiplication, each party would hold:
-//     // - A share of X, Y
-//     // - A share of Beaver triple (a, b, c)
-//     // - Each party computes d = x - a, e = y - b
-//     // - Sum d, e among all parties => D, E
-//     // - Final share = c + aE + bD + DE
-//     // Then reconstruct the final product from all parties’ product shares.
-//     // Below is just a placeholder.
-
-//     std::cout << "[Party " << m_partyId
-//               << "] doMultiplicationDemo: multi-party Beaver logic not fully implemented.\n";
-// }
-
 // New helper for synchronization after distribution
-void Party::syncAfterDistribute() {
+template <typename Security>
+void Party<Security>::syncAfterDistribute() {
     // Broadcast a short "done distributing" message to all
     const char* doneMsg = "DONE_DISTRIBUTING";
     m_comm->sendToAll(doneMsg, std::strlen(doneMsg));
@@ -532,11 +1106,12 @@ void Party::syncAfterDistribute() {
             }
         }
     }
-    std::cout << "[Party " << m_partyId << "] All parties done distributing.\n";
+    LOG_DEBUG("[Party ", m_partyId, "] All parties done distributing.");
 }
 
 // New helper for synchronization after gathering
-void Party::syncAfterGather() {
+template <typename Security>
+void Party<Security>::syncAfterGather() {
     // Broadcast a short "done gathering" message
     const char* doneMsg = "DONE_GATHERING";
     m_comm->sendToAll(doneMsg, std::strlen(doneMsg));
@@ -555,12 +1130,11 @@ void Party::syncAfterGather() {
             }
         }
     }
-    std::cout << "[Party " << m_partyId << "] All parties done gathering.\n";
+    LOG_DEBUG("[Party ", m_partyId, "] All parties done gathering.");
 }
 
-// Other existing methods...
-
-void Party::distributeSharesAndComputeMyPartial() {
+template <typename Security>
+void Party<Security>::distributeSharesAndComputeMyPartial() {
     // 1) Convert localValue to BIGNUM
     ShareType secretBn = AdditiveSecretSharing::newBigInt();
     BN_set_word(secretBn, m_localValue);
@@ -569,10 +1143,7 @@ void Party::distributeSharesAndComputeMyPartial() {
     std::vector<ShareType> mySecretShares;
     AdditiveSecretSharing::generateShares(secretBn, m_totalParties, mySecretShares);
     for (int i = 0; i < m_totalParties; ++i) {
-        #ifdef ENABLE_COUT
-        std::cout << "[Party " << m_partyId << "] Share " << i + 1 << ": " 
-                  << BN_bn2dec(mySecretShares[i]) << "\n";
-        #endif
+        LOG_TRACE("[Party ", m_partyId, "] Share ", i + 1, ": ", mySecretShares[i]);
     }
 
     // Free the original secret BN
@@ -613,22 +1184,18 @@ void Party::distributeSharesAndComputeMyPartial() {
         m_myPartialSum = AdditiveSecretSharing::newBigInt();
     }
     BN_copy(m_myPartialSum, myPartialSumBN);
-    #ifdef ENABLE_COUT
-    std::cout << "[Party " << m_partyId << "] Partial sum computed with value: " 
-              << BN_bn2dec(m_myPartialSum) << "\n";
-    #endif
+    LOG_TRACE("[Party ", m_partyId, "] Partial sum computed with value: ", m_myPartialSum);
 
     BN_free(myPartialSumBN);
     for (auto &bn : mySecretShares) {
         BN_free(bn);
     }
-    #ifdef ENABLE_COUT
-    std::cout << "[Party " << m_partyId << "] Partial sum computed.\n";
-    #endif
+    LOG_TRACE("[Party ", m_partyId, "] Partial sum computed.");
 }
 
 // Broadcast partial sums and reconstruct global sum
-void Party::broadcastAndReconstructGlobalSum() {
+template <typename Security>
+void Party<Security>::broadcastAndReconstructGlobalSum() {
     if (!m_myPartialSum) {
         throw std::runtime_error("No partial sum available.");
     }
@@ -657,578 +1224,1797 @@ void Party::broadcastAndReconstructGlobalSum() {
     }
 
     // 3) Print final sum
-    char* decStr = BN_bn2dec(finalSum);
-    #ifdef ENABLE_COUT
-    std::cout << "[Party " << m_partyId << "] Global sum = " << decStr << "\n";
-    #endif
-    OPENSSL_free(decStr);
+    LOG_TRACE("[Party ", m_partyId, "] Global sum = ", finalSum);
     BN_free(finalSum);
 }
 
-// Comment out or remove old methods
-// void Party::broadcastAllHeldShares() { /* removed */ }
-// void Party::gatherAllShares() { /* removed */ }
-// void Party::computeGlobalSumOfSecrets() { /* removed */ }
+template <typename Security>
+void Party<Security>::doMultiplication(const std::vector<ShareType> &x, const std::vector<ShareType> &y,
+                                       const std::vector<ShareType> &xMacs, const std::vector<ShareType> &yMacs,
+                                       std::vector<Share> &z, std::vector<Share> &zMacs)
+{
+    SIZE_T count = x.size();
+    if (y.size() != count || myTriples.size() < count) {
+        throw std::runtime_error("doMultiplication: mismatched factors or missing Beaver triples");
+    }
+    if constexpr (Security::MALICIOUS) {
+        if (xMacs.size() != count || yMacs.size() != count) {
+            throw std::runtime_error("doMultiplication: missing MAC shares");
+        }
+    }
+
+    // 1) d_k = x_k - a_k and e_k = y_k - b_k for every k, flattened as d_0, e_0, d_1, ...
+    std::vector<ShareType> de(2 * count);
+    std::vector<ShareType> deMacs;
+    if constexpr (Security::MALICIOUS) {
+        deMacs.resize(2 * count);
+    }
+    forEachShard(count, [&](SIZE_T, SIZE_T begin, SIZE_T end) {
+        for (SIZE_T k = begin; k < end; ++k) {
+            const BeaverTriple &triple = myTriples[k];
+            de[2 * k] = AdditiveSecretSharing::newBigInt();
+            de[2 * k + 1] = AdditiveSecretSharing::newBigInt();
+            BN_mod_sub(de[2 * k], x[k], triple.a, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+            BN_mod_sub(de[2 * k + 1], y[k], triple.b, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+            if constexpr (Security::MALICIOUS) {
+                const BeaverTriple &tripleMac = myTriplesMac[k];
+                deMacs[2 * k] = AdditiveSecretSharing::newBigInt();
+                deMacs[2 * k + 1] = AdditiveSecretSharing::newBigInt();
+                BN_mod_sub(deMacs[2 * k], xMacs[k], tripleMac.a, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+                BN_mod_sub(deMacs[2 * k + 1], yMacs[k], tripleMac.b, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+            }
+        }
+    });
+
+    // 2) Open every D and E together in one round
+    std::vector<ShareType> opened;
+    this->openValues(de, deMacs, opened);
+
+    // 3) z_k = c_k + a_k * E_k + b_k * D_k (+ D_k * E_k at party 1), and the same on the MACs
+    ShareType one = nullptr;
+    if (m_partyId == 1) {
+        one = AdditiveSecretSharing::newBigInt();
+        BN_one(one);
+    }
+    z.resize(count);
+    if constexpr (Security::MALICIOUS) {
+        zMacs.resize(count);
+    } else {
+        (void)xMacs;
+        (void)yMacs;
+        zMacs.clear();
+    }
+    forEachShard(count, [&](SIZE_T, SIZE_T begin, SIZE_T end) {
+        for (SIZE_T k = begin; k < end; ++k) {
+            // A single Beaver multiplication is an inner product of length one
+            std::vector<ShareType> D{opened[2 * k]}, E{opened[2 * k + 1]};
+            const BeaverTriple &triple = myTriples[k];
+            z[k] = Share::zero();
+            ShareType product = z[k].get();
+            AdditiveSecretSharing::innerProductShares(D, E, {{triple.a}, {triple.b}, triple.c}, one, product);
+            if constexpr (Security::MALICIOUS) {
+                const BeaverTriple &tripleMac = myTriplesMac[k];
+                zMacs[k] = Share::zero();
+                ShareType productMac = zMacs[k].get();
+                AdditiveSecretSharing::innerProductShares(D, E, {{tripleMac.a}, {tripleMac.b}, tripleMac.c},
+                                                          m_global_key_share, productMac);
+            }
+        }
+    });
+    LOG_TRACE("[doMultiplication][Party ", m_partyId, "] computed ", count, " product shares");
+
+    // Cleanup
+    if (one) BN_free(one);
+    for (auto bn : de) BN_free(bn);
+    for (auto bn : deMacs) BN_free(bn);
+    for (auto bn : opened) BN_free(bn);
+}
+
+template <typename Security>
+void Party<Security>::openValues(const std::vector<ShareType> &myShares, const std::vector<ShareType> &myMacShares,
+                       std::vector<ShareType> &opened)
+{
+    switch (m_openingMode) {
+        case OpeningMode::KING:
+            this->openViaKing(myShares, opened);
+            break;
+        case OpeningMode::TREE:
+            this->openViaTree(myShares, opened);
+            break;
+        default:
+            this->openAllToAll(myShares, opened);
+            break;
+    }
+
+    if constexpr (Security::MALICIOUS) {
+        if (myMacShares.empty()) {
+            return;
+        }
+        if (myMacShares.size() != myShares.size()) {
+            throw std::runtime_error("openValues: every opened share needs a MAC share");
+        }
+        // Nothing is verified here; the opening is logged for the next batched check
+        for (SIZE_T k = 0; k < opened.size(); ++k) {
+            m_openedLog.emplace_back(AdditiveSecretSharing::cloneBigInt(opened[k]));
+            m_openedMacLog.emplace_back(AdditiveSecretSharing::cloneBigInt(myMacShares[k]));
+        }
+        if (MAC_CHECK_INTERVAL > 0 && m_openedLog.size() >= MAC_CHECK_INTERVAL && !this->runMacCheck()) {
+            throw std::runtime_error("MAC check failed after " + std::to_string(MAC_CHECK_INTERVAL) + " openings");
+        }
+    } else {
+        (void)myMacShares;
+    }
+}
+
+template <typename Security>
+void Party<Security>::openAllToAll(const std::vector<ShareType> &myShares, std::vector<ShareType> &opened)
+{
+    // Start every opened value from this party's own share
+    opened.resize(myShares.size());
+    for (SIZE_T k = 0; k < myShares.size(); ++k) {
+        opened[k] = AdditiveSecretSharing::cloneBigInt(myShares[k]);
+    }
+
+    // One message per peer carries the whole batch
+    PooledBuffer batch = this->encodeBatch(myShares, true);
+    for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
+        if (pid == m_partyId) continue;
+        m_comm->sendTo(pid, batch.data(), batch.size());
+    }
+    // Messages from different peers may arrive in any order; nextPeerMessage keeps the others
+    for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
+        if (pid == m_partyId) continue;
+        this->receiveSharesFromPeer(pid, myShares.size(), m_peerBatch);
+        for (SIZE_T k = 0; k < myShares.size(); ++k) {
+            BN_mod_add(opened[k], opened[k], m_peerBatch[k], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+        }
+    }
+}
+
+template <typename Security>
+void Party<Security>::openViaKing(const std::vector<ShareType> &myShares, std::vector<ShareType> &opened)
+{
+    if (m_partyId != KING_PARTY_ID) {
+        // Everyone else sends its batch to the king and waits for the opened values
+        this->sendSharesToPeer(KING_PARTY_ID, myShares);
+        opened.clear();
+        this->receiveSharesFromPeer(KING_PARTY_ID, myShares.size(), opened);
+        return;
+    }
+
+    // The king sums every batch with its own and sends the result back
+    opened.resize(myShares.size());
+    for (SIZE_T k = 0; k < myShares.size(); ++k) {
+        opened[k] = AdditiveSecretSharing::cloneBigInt(myShares[k]);
+    }
+    for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
+        if (pid == m_partyId) continue;
+        this->receiveSharesFromPeer(pid, myShares.size(), m_peerBatch);
+        for (SIZE_T k = 0; k < myShares.size(); ++k) {
+            BN_mod_add(opened[k], opened[k], m_peerBatch[k], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+        }
+    }
+    PooledBuffer openedMsg = this->encodeBatch(opened, true);
+    for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
+        if (pid == m_partyId) continue;
+        m_comm->sendTo(pid, openedMsg.data(), openedMsg.size());
+    }
+}
+
+template <typename Security>
+void Party<Security>::openViaTree(const std::vector<ShareType> &myShares, std::vector<ShareType> &opened)
+{
+    // Party p is node p - 1, so the root is party 1
+    KaryTree tree(m_totalParties, TREE_ARITY);
+    SIZE_T node = m_partyId - 1;
+
+    // Up: add the partial sums of the children to this party's shares
+    opened.resize(myShares.size());
+    for (SIZE_T k = 0; k < myShares.size(); ++k) {
+        opened[k] = AdditiveSecretSharing::cloneBigInt(myShares[k]);
+    }
+    for (SIZE_T child : tree.children(node)) {
+        this->receiveSharesFromPeer(static_cast<PARTY_ID_T>(child + 1), myShares.size(), m_peerBatch);
+        for (SIZE_T k = 0; k < myShares.size(); ++k) {
+            BN_mod_add(opened[k], opened[k], m_peerBatch[k], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+        }
+    }
+
+    // Down: the root holds the opened values; everyone else gets them from its parent
+    if (node != 0) {
+        PARTY_ID_T parentId = static_cast<PARTY_ID_T>(tree.parent(node) + 1);
+        this->sendSharesToPeer(parentId, opened);
+        // The opened values overwrite the partial sums in place
+        this->receiveSharesFromPeer(parentId, myShares.size(), opened);
+    }
+    PooledBuffer openedMsg = this->encodeBatch(opened, true);
+    for (SIZE_T child : tree.children(node)) {
+        m_comm->sendTo(static_cast<PARTY_ID_T>(child + 1), openedMsg.data(), openedMsg.size());
+    }
+}
+
+template <typename Security>
+void Party<Security>::sendResultsToDealer(std::vector<ShareType> &shares)
+{
+    this->addZeroShares(shares);
+    if (m_resultSink && m_partyId != m_outputParty) {
+        // Shares for a downstream job; they add up to the results across all parties
+        m_resultSink->write(shares);
+    }
+    if (m_outputParty != 0) {
+        this->sendResultsToOutputParty(shares);
+        return;
+    }
+    if (m_openingMode == OpeningMode::TREE) {
+        // The dealer is node 0 and party p is node p
+        KaryTree tree(m_totalParties + 1, TREE_ARITY);
+        for (SIZE_T child : tree.children(m_partyId)) {
+            this->receiveSharesFromPeer(static_cast<PARTY_ID_T>(child), shares.size(), m_peerBatch);
+            for (SIZE_T k = 0; k < shares.size(); ++k) {
+                BN_mod_add(shares[k], shares[k], m_peerBatch[k], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+            }
+        }
+        SIZE_T parent = tree.parent(m_partyId);
+        if (parent != 0) {
+            this->sendSharesToPeer(static_cast<PARTY_ID_T>(parent), shares);
+            return;
+        }
+    }
+    PooledBuffer result = this->encodeBatch(shares, false);
+    this->replyToDealer(result.data(), result.size());
+}
 
-// Implement distributeBeaverTriple
-void Party::distributeBeaverTriple()
+template <typename Security>
+void Party<Security>::sendResultsToOutputParty(std::vector<ShareType> &shares)
 {
-    // **Move the log inside the conditional check**
-    #if defined(ENABLE_COUT)
-    std::cout << "[Party " << m_partyId << "] Initiating Beaver triple distribution.\n";
+    if constexpr (Security::MALICIOUS) {
+        // Shares sent to one party carry no check, so malicious results never travel as shares
+        this->revealMaskedResults(shares);
+        return;
+    }
+    // One hop in every opening mode: the output party is the only receiver
+    if (m_partyId != m_outputParty) {
+        this->sendSharesToPeer(m_outputParty, shares);
+        return;
+    }
+    BN_CTX* ctx = AdditiveSecretSharing::getCtx();
+    const BIGNUM* prime = AdditiveSecretSharing::getPrime();
+    for (PARTY_ID_T peer = 1; peer <= m_totalParties; ++peer) {
+        if (peer == m_partyId) continue;
+        this->receiveSharesFromPeer(peer, shares.size(), m_peerBatch);
+        for (SIZE_T k = 0; k < shares.size(); ++k) {
+            BN_mod_add(shares[k], shares[k], m_peerBatch[k], prime, ctx);
+        }
+    }
+    this->writeOutputs(shares);
+    this->replyToDealer(&CMD_SUCCESS, sizeof(CMD_T));
+}
+
+template <typename Security>
+void Party<Security>::revealMaskedResults(const std::vector<ShareType> &shares)
+{
+    // The values come first, then their MACs
+    SIZE_T count = shares.size() / 2;
+    // "r_1|..|r_count|mac_1|..|mac_count|key" from sendValueShares
+    PooledBuffer buffer = this->receiveFromDealer();
+    std::vector<Share> fields = adoptShares(deserializeShares(buffer.data(), buffer.size()));
+    if (fields.size() != 2 * count + 1) {
+        throw std::runtime_error("Invalid output masks received");
+    }
+    m_global_key_share = std::move(fields.back());
+    std::vector<Share> masks;
+    if (m_partyId == m_outputParty) {
+        // r_1|..|r_count in the clear, sent to this party only
+        PooledBuffer clear = this->receiveFromDealer();
+        masks = adoptShares(deserializeShares(clear.data(), clear.size()));
+        if (masks.size() != count) {
+            throw std::runtime_error("Invalid output masks received");
+        }
+    }
+
+    // v - r is uniformly random, so every party may see it; it is opened with its MAC and
+    // checked with everything opened before, so no party can shift a result unnoticed
+    BN_CTX* ctx = AdditiveSecretSharing::getCtx();
+    const BIGNUM* prime = AdditiveSecretSharing::getPrime();
+    std::vector<Share> masked(2 * count);
+    for (SIZE_T k = 0; k < 2 * count; ++k) {
+        masked[k] = Share::zero();
+        if (!BN_mod_sub(masked[k], shares[k], fields[k], prime, ctx)) {
+            throw std::runtime_error("BN_mod_sub failed for the output masks");
+        }
+    }
+    std::vector<ShareType> maskedShares = borrowShares(masked);
+    std::vector<ShareType> opened;
+    this->openValues(std::vector<ShareType>(maskedShares.begin(), maskedShares.begin() + count),
+                     std::vector<ShareType>(maskedShares.begin() + count, maskedShares.end()), opened);
+    std::vector<Share> values = adoptShares(opened);
+    if (!this->runMacCheck()) {
+        LOG_ERROR("[Party ", m_partyId, "] The MAC check before revealing the results failed; they are not revealed");
+        this->replyToDealer(&CMD_MAC_CHECK_FAILED, sizeof(CMD_T));
+        return;
+    }
+    if (m_partyId == m_outputParty) {
+        for (SIZE_T k = 0; k < count; ++k) {
+            BN_mod_add(values[k], values[k], masks[k], prime, ctx);
+        }
+        this->writeOutputs(borrowShares(values));
+    }
+    this->replyToDealer(&CMD_SUCCESS, sizeof(CMD_T));
+}
+
+template <typename Security>
+void Party<Security>::writeOutputs(const std::vector<ShareType> &values)
+{
+    if (m_resultSink) m_resultSink->write(values);
+    #if defined(ENABLE_FINAL_RESULT)
+    for (SIZE_T k = 0; k < values.size(); ++k) {
+        LOG_INFO("[Party ", m_partyId, "] Output[", k, "]: ", values[k]);
+    }
     #endif
+}
 
-    // 1) Generate random a, b in [0..prime-1].
-    ShareType a = AdditiveSecretSharing::newBigInt();
-    ShareType b = AdditiveSecretSharing::newBigInt();
-    BN_rand_range(a, AdditiveSecretSharing::getPrime());
-    BN_rand_range(b, AdditiveSecretSharing::getPrime());
+template <typename Security>
+void Party<Security>::exchangeWithPeers(const std::string &mine, std::vector<std::string> &theirs)
+{
+    theirs.assign(m_totalParties + 1, std::string());
+    theirs[m_partyId] = mine;
+    for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
+        if (pid == m_partyId) continue;
+        this->sendToPeer(pid, mine);
+    }
+    // Messages from different peers may arrive in any order; receiveFromPeer keeps the others
+    for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
+        if (pid == m_partyId) continue;
+        theirs[pid] = this->receiveFromPeer(pid);
+    }
+}
 
-    // 2) Compute c = a*b mod prime.
-    ShareType c = AdditiveSecretSharing::newBigInt();
-    BN_mod_mul(c, a, b, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+template <typename Security>
+void Party<Security>::sendToPeer(PARTY_ID_T peer, const std::string &payload)
+{
+    // Tag the message so the event loop can tell it apart from dealer commands
+    PooledBuffer msg = m_sendBuffers.acquire(sizeof(CMD_T) + payload.size());
+    msg.data()[0] = static_cast<char>(CMD_PARTIAL_OPEN);
+    std::memcpy(msg.data() + sizeof(CMD_T), payload.data(), payload.size());
+    msg.resize(sizeof(CMD_T) + payload.size());
+    m_comm->sendTo(peer, msg.data(), msg.size());
+    LOG_TRACE("[Party ", m_partyId, "] Sent ", payload.size(), " bytes to Party ", peer);
+}
+
+template <typename Security>
+void Party<Security>::sendSharesToPeer(PARTY_ID_T peer, const std::vector<ShareType> &shares)
+{
+    PooledBuffer msg = this->encodeBatch(shares, true);
+    m_comm->sendTo(peer, msg.data(), msg.size());
+}
 
-    // 3) Make shares for a, b, c
-    std::vector<ShareType> aShares, bShares, cShares;
-    AdditiveSecretSharing::generateShares(a, m_totalParties, aShares);
-    AdditiveSecretSharing::generateShares(b, m_totalParties, bShares);
+template <typename Security>
+PooledBuffer Party<Security>::encodeBatch(const std::vector<ShareType> &shares, bool tagged)
+{
+    SIZE_T offset = tagged ? sizeof(CMD_T) : 0;
+    PooledBuffer buffer = m_sendBuffers.acquire(offset + encodedSharesSize(shares.size()));
+    if (tagged) {
+        buffer.data()[0] = static_cast<char>(CMD_PARTIAL_OPEN);
+    }
+    buffer.resize(offset + encodeShares(shares, buffer.data() + offset));
+    return buffer;
+}
+
+template <typename Security>
+std::string Party<Security>::receiveFromPeer(PARTY_ID_T peer)
+{
+    PooledBuffer msg = this->nextPeerMessage(peer);
+    return std::string(msg.data() + sizeof(CMD_T), msg.size() - sizeof(CMD_T));
+}
+
+template <typename Security>
+void Party<Security>::receiveSharesFromPeer(PARTY_ID_T peer, SIZE_T count, std::vector<ShareType> &out)
+{
+    PooledBuffer msg = this->nextPeerMessage(peer);
+    SIZE_T received = decodeShares(msg.data() + sizeof(CMD_T), msg.size() - sizeof(CMD_T), out);
+    if (received != count) {
+        throw std::runtime_error("Invalid share batch from Party " + std::to_string(peer) + ": expected " +
+                                 std::to_string(count) + " shares, got " + std::to_string(received));
+    }
+}
+
+template <typename Security>
+PooledBuffer Party<Security>::nextPeerMessage(PARTY_ID_T peer)
+{
+    // Messages from one peer arrive in order, so the oldest kept one is the next in line
+    auto pending = std::find_if(m_pendingOpenings.begin(), m_pendingOpenings.end(),
+                                [peer](const auto &entry) { return entry.first == peer; });
+    if (pending != m_pendingOpenings.end()) {
+        PooledBuffer msg = std::move(pending->second);
+        m_pendingOpenings.erase(pending);
+        return msg;
+    }
+    while (true) {
+        PARTY_ID_T senderId;
+        PooledBuffer msg = this->receiveMessage(senderId);
+        if (msg.size() == 0) {
+            continue;
+        }
+        if (this->takeInputMessage(senderId, msg.data(), msg.size())) {
+            continue;
+        }
+        if (static_cast<CMD_T>(msg.data()[0]) != CMD_PARTIAL_OPEN) {
+            throw std::runtime_error("Unexpected message during exchange from Party " + std::to_string(senderId));
+        }
+        if (senderId == peer) {
+            return msg;
+        }
+        // The buffer itself is kept, so an early message is never copied
+        m_pendingOpenings.emplace_back(senderId, std::move(msg));
+    }
+}
+
+template <typename Security>
+PooledBuffer Party<Security>::receiveMessage(PARTY_ID_T &senderId)
+{
+    // Sized by the message itself: messages from different peers are not ordered against
+    // each other, so the next one may already belong to a later, larger exchange
+    PooledBuffer msg;
+    m_comm->receiveAny(senderId, [&](size_t length) -> void* {
+        msg = m_recvBuffers.acquire(length);
+        msg.resize(length);
+        return msg.data();
+    });
+    return msg;
+}
+
+template <typename Security>
+void Party<Security>::keepPeerMessage(PARTY_ID_T senderId, const char* bytes, SIZE_T length)
+{
+    PooledBuffer msg = m_recvBuffers.acquire(length);
+    std::memcpy(msg.data(), bytes, length);
+    msg.resize(length);
+    m_pendingOpenings.emplace_back(senderId, std::move(msg));
+}
+
+template <typename Security>
+void Party<Security>::setupPrss()
+{
+    // The mesh is assumed authenticated, as for every other message between parties
+    std::vector<std::string> publicKeys;
+    this->exchangeWithPeers(m_prss.beginKeyExchange(), publicKeys);
+    m_prss.finishKeyExchange(m_partyId, publicKeys);
+}
+
+template <typename Security>
+void Party<Security>::addZeroShares(std::vector<ShareType> &shares)
+{
+    std::vector<ShareType> zeros;
+    m_prss.zeroShares(shares.size(), zeros);
+    for (SIZE_T k = 0; k < shares.size(); ++k) {
+        BN_mod_add(shares[k], shares[k], zeros[k], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+        BN_free(zeros[k]);
+    }
+}
+
+template <typename Security>
+PooledBuffer Party<Security>::receiveFromDealer()
+{
+    while (true) {
+        PARTY_ID_T senderId;
+        PooledBuffer msg = this->receiveMessage(senderId);
+        if (msg.size() == 0) {
+            continue;
+        }
+        if (this->takeInputMessage(senderId, msg.data(), msg.size())) {
+            continue;
+        }
+        if (static_cast<CMD_T>(msg.data()[0]) == CMD_PARTIAL_OPEN) {
+            // A faster peer already opened its d|e values; keep them for openValues()
+            m_pendingOpenings.emplace_back(senderId, std::move(msg));
+            continue;
+        }
+        return msg;
+    }
+}
+
+template <typename Security>
+void Party<Security>::freeInnerProductTriple(InnerProductTriple &triple)
+{
+    for (auto bn : triple.a) BN_free(bn);
+    for (auto bn : triple.b) BN_free(bn);
+    if (triple.c) BN_free(triple.c);
+    triple.a.clear();
+    triple.b.clear();
+    triple.c = nullptr;
+}
+
+template <typename Security>
+void Party<Security>::distributeInnerProductTriple(SIZE_T length)
+{
+    LOG_TRACE("[Party ", m_partyId, "] Initiating inner-product triple distribution of length ", length, ".");
+
+    // 1) Random vectors a, b and c = <a, b> mod prime
+    std::vector<ShareType> a(length), b(length);
+    ShareType c = AdditiveSecretSharing::newBigInt();
+    ShareType ab = AdditiveSecretSharing::newBigInt();
+    for (SIZE_T k = 0; k < length; ++k) {
+        a[k] = AdditiveSecretSharing::newBigInt();
+        b[k] = AdditiveSecretSharing::newBigInt();
+        BN_rand_range(a[k], AdditiveSecretSharing::getPrime());
+        BN_rand_range(b[k], AdditiveSecretSharing::getPrime());
+        BN_mod_mul(ab, a[k], b[k], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+        BN_mod_add(c, c, ab, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+    }
+    BN_free(ab);
+
+    // 2) Share every component; the single c is what saves bandwidth over N triples
+    std::vector<std::vector<ShareType>> aShares(length), bShares(length);
+    std::vector<ShareType> cShares;
+    for (SIZE_T k = 0; k < length; ++k) {
+        AdditiveSecretSharing::generateShares(a[k], m_totalParties, aShares[k]);
+        AdditiveSecretSharing::generateShares(b[k], m_totalParties, bShares[k]);
+    }
     AdditiveSecretSharing::generateShares(c, m_totalParties, cShares);
-    #if defined(ENABLE_MALICIOUS_SECURITY)
-    // Generate MAC shares for a, b, c
-    std::vector<ShareType> macAShares, macBShares, macCShares;
-    AdditiveSecretSharing::generateMacShares(a, m_global_mac_key, m_totalParties, macAShares);
-    AdditiveSecretSharing::generateMacShares(b, m_global_mac_key, m_totalParties, macBShares);
-    AdditiveSecretSharing::generateMacShares(c, m_global_mac_key, m_totalParties, macCShares);
-    // Generate the shares of global key
-    std::vector<ShareType> globalMacKeyShares;
-    AdditiveSecretSharing::generateShares(m_global_mac_key, m_totalParties, globalMacKeyShares);
-    #endif
+    std::vector<std::vector<ShareType>> macAShares, macBShares;
+    std::vector<ShareType> macCShares, globalMacKeyShares;
+    if constexpr (Security::MALICIOUS) {
+        macAShares.resize(length);
+        macBShares.resize(length);
+        for (SIZE_T k = 0; k < length; ++k) {
+            AdditiveSecretSharing::generateMacShares(a[k], m_global_mac_key, m_totalParties, macAShares[k]);
+            AdditiveSecretSharing::generateMacShares(b[k], m_global_mac_key, m_totalParties, macBShares[k]);
+        }
+        AdditiveSecretSharing::generateMacShares(c, m_global_mac_key, m_totalParties, macCShares);
+        AdditiveSecretSharing::generateShares(m_global_mac_key, m_totalParties, globalMacKeyShares);
+    }
 
-    // 4) Broadcast each share to the correct party
+    // 3) Send "a_1|..|a_N|b_1|..|b_N|c[|macA..|macB..|macC|key]" to every party
     for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
-        // Serialize shares
-        std::string aHex = serializeShare(aShares[pid-1]);
-        std::string bHex = serializeShare(bShares[pid-1]);
-        std::string cHex = serializeShare(cShares[pid-1]);
-
-        std::string tripleMsg = aHex + "|" + bHex + "|" + cHex;
-        #if defined(ENABLE_MALICIOUS_SECURITY)
-        // Serialize MAC shares in the triple message
-        std::string macAMsg = serializeShare(macAShares[pid-1]);
-        std::string macBMsg = serializeShare(macBShares[pid-1]);
-        std::string macCMsg = serializeShare(macCShares[pid-1]);
-        std::string globalMacKeyMsg = serializeShare(globalMacKeyShares[pid-1]);
-        tripleMsg += "|" + macAMsg + "|" + macBMsg + "|" + macCMsg + "|" + globalMacKeyMsg;
-        #endif
+        std::vector<ShareType> fields;
+        for (SIZE_T k = 0; k < length; ++k) fields.push_back(aShares[k][pid - 1]);
+        for (SIZE_T k = 0; k < length; ++k) fields.push_back(bShares[k][pid - 1]);
+        fields.push_back(cShares[pid - 1]);
+        if constexpr (Security::MALICIOUS) {
+            for (SIZE_T k = 0; k < length; ++k) fields.push_back(macAShares[k][pid - 1]);
+            for (SIZE_T k = 0; k < length; ++k) fields.push_back(macBShares[k][pid - 1]);
+            fields.push_back(macCShares[pid - 1]);
+            fields.push_back(globalMacKeyShares[pid - 1]);
+        }
+        PooledBuffer tripleMsg = this->encodeBatch(fields, false);
+        m_comm->sendTo(pid, tripleMsg.data(), tripleMsg.size());
+        LOG_TRACE("[Party ", m_partyId, "] Sent inner-product triple shares to Party ", pid);
+    }
 
-        // Send shares to other parties
-        m_comm->sendTo(pid, tripleMsg.c_str(), tripleMsg.size());
-        #ifdef ENABLE_COUT
-        std::cout << "[Party " << m_partyId << "] Sent Beaver triple shares to Party " << pid << "\n";
-        #endif
-        // if (pid == m_partyId) {
-        //     // Store shares locally
-        //     myTriple.a = AdditiveSecretSharing::cloneBigInt(aShares[pid-1]);
-        //     myTriple.b = AdditiveSecretSharing::cloneBigInt(bShares[pid-1]);
-        //     myTriple.c = AdditiveSecretSharing::cloneBigInt(cShares[pid-1]);
-
-        //     #ifdef ENABLE_COUT
-        //     std::cout << "[Party " << m_partyId << "] Stored own Beaver triple shares.\n";
-        //     #endif
-        // } else {
-        //     // Send shares to other parties
-        //     m_comm->sendTo(pid, tripleMsg.c_str(), tripleMsg.size());
-        //     #ifdef ENABLE_COUT
-        //     std::cout << "[Party " << m_partyId << "] Sent Beaver triple shares to Party " << pid << "\n";
-        //     #endif
-        // }
-    }
-
-    // 5) Clean up
-    BN_free(a);
-    BN_free(b);
+    // 4) Clean up
+    for (SIZE_T k = 0; k < length; ++k) {
+        BN_free(a[k]);
+        BN_free(b[k]);
+        for (auto bn : aShares[k]) BN_free(bn);
+        for (auto bn : bShares[k]) BN_free(bn);
+        if constexpr (Security::MALICIOUS) {
+            for (auto bn : macAShares[k]) BN_free(bn);
+            for (auto bn : macBShares[k]) BN_free(bn);
+        }
+    }
     BN_free(c);
-    for (auto bn : aShares) BN_free(bn);
-    for (auto bn : bShares) BN_free(bn);
     for (auto bn : cShares) BN_free(bn);
-    #if defined(ENABLE_MALICIOUS_SECURITY)
-    for (auto bn : macAShares) BN_free(bn);
-    for (auto bn : macBShares) BN_free(bn);
-    for (auto bn : macCShares) BN_free(bn);
-    for (auto bn : globalMacKeyShares) BN_free(bn);
-    #endif 
+    if constexpr (Security::MALICIOUS) {
+        for (auto bn : macCShares) BN_free(bn);
+        for (auto bn : globalMacKeyShares) BN_free(bn);
+    }
 }
 
-// Modify receiveBeaverTriple to ensure it only accepts triples from Party with BeaverTriple
-void Party::receiveBeaverTriple()
+template <typename Security>
+void Party<Security>::receiveInnerProductTriple(SIZE_T length)
 {
+    SIZE_T numFields = 2 * length + 1;
+    if constexpr (Security::MALICIOUS) {
+        numFields = 2 * numFields + 1; // MAC shares and the global key share
+    }
+    PooledBuffer buffer = this->receiveFromDealer();
+    size_t bytesRead = buffer.size();
+    std::vector<ShareType> fields = deserializeShares(buffer.data(), bytesRead);
+    if (fields.size() != numFields) {
+        for (auto &field : fields) BN_free(field);
+        throw std::runtime_error("Invalid inner-product triple format received");
+    }
 
-    // Wait for message from Party with Beaver triple
-    PARTY_ID_T sender;
-    char buffer[BUFFER_SIZE];
-    size_t bytesRead = m_comm->receive(sender, buffer, sizeof(buffer));
+    auto next = fields.begin();
+    freeInnerProductTriple(myInnerProductTriple);
+    myInnerProductTriple.a.assign(next, next + length);
+    myInnerProductTriple.b.assign(next + length, next + 2 * length);
+    myInnerProductTriple.c = *(next + 2 * length);
+    if constexpr (Security::MALICIOUS) {
+        next += 2 * length + 1;
+        freeInnerProductTriple(myInnerProductTripleMac);
+        myInnerProductTripleMac.a.assign(next, next + length);
+        myInnerProductTripleMac.b.assign(next + length, next + 2 * length);
+        myInnerProductTripleMac.c = *(next + 2 * length);
+        m_global_key_share = Share(fields.back());
+    }
 
-    #ifdef ENABLE_COUT
-    std::cout << "[Party " << m_partyId << "] Received Beaver triple from Party " << sender << "\n";
-    #endif
+    LOG_TRACE("[Party ", m_partyId, "] Successfully received inner-product triple shares.");
+}
 
-    if (bytesRead == 0) {
-        throw std::runtime_error("Failed to receive Beaver triple from Party 1");
-    }
-   
-
-    std::string tripleMsg(buffer, bytesRead);
-    #if defined(ENABLE_MALICIOUS_SECURITY)
-    // Parse "aHex|bHex|cHex|macAHex|macBHex|macCHex"
-    auto sep1 = tripleMsg.find('|');
-    auto sep2 = tripleMsg.find('|', sep1 + 1);
-    auto sep3 = tripleMsg.find('|', sep2 + 1);
-    auto sep4 = tripleMsg.find('|', sep3 + 1);
-    auto sep5 = tripleMsg.find('|', sep4 + 1);
-    auto sep6 = tripleMsg.find('|', sep5 + 1);
-    if (sep1 == std::string::npos || sep2 == std::string::npos || sep3 == std::string::npos || sep4 == std::string::npos || sep5 == std::string::npos || sep6 == std::string::npos) {
-        throw std::runtime_error("Invalid Beaver triple format received");
-    }
-    std::string aHex = tripleMsg.substr(0, sep1);
-    std::string bHex = tripleMsg.substr(sep1 + 1, sep2 - (sep1 + 1));
-    std::string cHex = tripleMsg.substr(sep2 + 1, sep3 - (sep2 + 1));
-    std::string macAHex = tripleMsg.substr(sep3 + 1, sep4 - (sep3 + 1));
-    std::string macBHex = tripleMsg.substr(sep4 + 1, sep5 - (sep4 + 1));
-    std::string macCHex = tripleMsg.substr(sep5 + 1);
-    std::string globalMacKeyHex = tripleMsg.substr(sep6 + 1);
-    #else
-    // Parse "aHex|bHex|cHex"
-    auto sep1 = tripleMsg.find('|');
-    auto sep2 = tripleMsg.rfind('|');
-    if (sep1 == std::string::npos || sep2 == std::string::npos || sep1 == sep2) {
-        throw std::runtime_error("Invalid triple format received");
-    }
-    std::string aHex = tripleMsg.substr(0, sep1);
-    std::string bHex = tripleMsg.substr(sep1 + 1, sep2 - (sep1 + 1));
-    std::string cHex = tripleMsg.substr(sep2 + 1);
-    #endif
+template <typename Security>
+void Party<Security>::setBatchSize(SIZE_T batchSize)
+{
+    if (batchSize < 2) {
+        throw std::invalid_argument("The batch needs at least two inputs");
+    }
+    m_batchSize = batchSize;
+}
 
-    // Deserialize shares
-    myTriple.a = deserializeShare(aHex);
-    myTriple.b = deserializeShare(bHex);
-    myTriple.c = deserializeShare(cHex);
-    #if defined(ENABLE_MALICIOUS_SECURITY)
-    myTripleMac.a = deserializeShare(macAHex);
-    myTripleMac.b = deserializeShare(macBHex);
-    myTripleMac.c = deserializeShare(macCHex);
-    m_global_key_share = deserializeShare(globalMacKeyHex);
-    #endif
+template <typename Security>
+void Party<Security>::setNumInputParties(SIZE_T inputParties)
+{
+    if (inputParties == 0) {
+        throw std::invalid_argument("A job needs at least one input party");
+    }
+    m_numInputParties = inputParties;
+}
 
-    #ifdef ENABLE_COUT
-    std::cout << "[Party " << m_partyId << "] Successfully received Beaver triple shares.\n";
-    #endif
+template <typename Security>
+void Party<Security>::setOutputParty(PARTY_ID_T party)
+{
+    if (party > m_totalParties) {
+        throw std::invalid_argument("Output party " + std::to_string(party) + " is not a compute party");
+    }
+    m_outputParty = party;
 }
 
-// Implement doMultiplicationDemo
-void Party::doMultiplicationDemo(ShareType &z_i)
+template <typename Security>
+void Party<Security>::setResultFile(const std::string &path)
 {
-    // Compute d_i = x_i - a_i and e_i = y_i - b_i
-    ShareType d_i = AdditiveSecretSharing::newBigInt();
-    ShareType e_i = AdditiveSecretSharing::newBigInt();
-    if(!BN_mod_sub(d_i, m_receivedShares[0], myTriple.a, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx())) {
-        throw std::runtime_error("BN_mod_sub failed for d_i");
+    m_resultSink = std::make_unique<ResultSink>(path);
+}
+
+template <typename Security>
+SIZE_T Party<Security>::shardCount(SIZE_T count)
+{
+    return std::max<SIZE_T>(1, std::min(ThreadPool::shared().size() + 1, count / PARALLEL_GRAIN));
+}
+
+template <typename Security>
+void Party<Security>::forEachShard(SIZE_T count, const std::function<void(SIZE_T, SIZE_T, SIZE_T)> &body)
+{
+    if (count == 0) return;
+    SIZE_T shards = shardCount(count);
+    SIZE_T slice = (count + shards - 1) / shards;
+    ThreadPool::shared().parallelFor(0, shards, 1, [&](SIZE_T shardBegin, SIZE_T shardEnd) {
+        for (SIZE_T shard = shardBegin; shard < shardEnd; ++shard) {
+            SIZE_T begin = std::min(count, shard * slice);
+            SIZE_T end = std::min(count, begin + slice);
+            if (begin < end) body(shard, begin, end);
+        }
+    });
+}
+
+template <typename Security>
+void Party<Security>::shardedInnerProductShares(const std::vector<ShareType> &D, const std::vector<ShareType> &E,
+                                      const InnerProductTriple &triple, ShareType deFactor, ShareType result)
+{
+    // Each shard reduces its slice with c = 0; the partial sums and c are added afterwards.
+    // The partials are owned here, so they are freed even when a shard throws.
+    std::vector<Share> partials(shardCount(D.size()));
+    forEachShard(D.size(), [&](SIZE_T shard, SIZE_T begin, SIZE_T end) {
+        BigIntScratch scratch;
+        ShareType zero = scratch.get();
+        InnerProductTriple slice{{triple.a.begin() + begin, triple.a.begin() + end},
+                                 {triple.b.begin() + begin, triple.b.begin() + end}, zero};
+        std::vector<ShareType> sliceD(D.begin() + begin, D.begin() + end);
+        std::vector<ShareType> sliceE(E.begin() + begin, E.begin() + end);
+        partials[shard] = Share::zero();
+        ShareType partial = partials[shard];
+        AdditiveSecretSharing::innerProductShares(sliceD, sliceE, slice, deFactor, partial);
+    });
+    if (!BN_copy(result, triple.c)) {
+        throw std::runtime_error("shardedInnerProductShares: BN_copy failed");
+    }
+    for (const auto &partial : partials) {
+        if (partial) AdditiveSecretSharing::addShares(result, partial, result);
     }
-    if(!BN_mod_sub(e_i, m_receivedShares[1], myTriple.b, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx())) {
-        throw std::runtime_error("BN_mod_sub failed for e_i");
+}
+
+template <typename Security>
+void Party<Security>::doInnerProduct(const std::vector<ShareType> &x, const std::vector<ShareType> &y,
+                           const std::vector<ShareType> &xMacs, const std::vector<ShareType> &yMacs, ShareType z_i)
+{
+    SIZE_T length = x.size();
+    if (y.size() != length || myInnerProductTriple.a.size() != length) {
+        throw std::runtime_error("doInnerProduct: vector and triple lengths differ");
     }
 
-    // Broadcast d_i and e_i to all other parties
-    std::string dHex = serializeShare(d_i);
-    std::string eHex = serializeShare(e_i);
-    std::string deMsg = dHex + "|" + eHex;
-    // Send to all except self
+    // d_k = x_k - a_k and e_k = y_k - b_k for all k, opened together in one round
+    std::vector<ShareType> de(2 * length);
+    std::vector<ShareType> deMacs;
+    if constexpr (Security::MALICIOUS) {
+        if (xMacs.size() != length || yMacs.size() != length) {
+            throw std::runtime_error("doInnerProduct: missing MAC shares");
+        }
+        deMacs.resize(2 * length);
+    }
+    forEachShard(length, [&](SIZE_T, SIZE_T begin, SIZE_T end) {
+        for (SIZE_T k = begin; k < end; ++k) {
+            de[k] = AdditiveSecretSharing::newBigInt();
+            de[length + k] = AdditiveSecretSharing::newBigInt();
+            BN_mod_sub(de[k], x[k], myInnerProductTriple.a[k], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+            BN_mod_sub(de[length + k], y[k], myInnerProductTriple.b[k], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+            if constexpr (Security::MALICIOUS) {
+                deMacs[k] = AdditiveSecretSharing::newBigInt();
+                deMacs[length + k] = AdditiveSecretSharing::newBigInt();
+                BN_mod_sub(deMacs[k], xMacs[k], myInnerProductTripleMac.a[k], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+                BN_mod_sub(deMacs[length + k], yMacs[k], myInnerProductTripleMac.b[k], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+            }
+        }
+    });
+    if constexpr (!Security::MALICIOUS) {
+        (void)xMacs;
+        (void)yMacs;
+    }
+    std::vector<ShareType> opened;
+    this->openValues(de, deMacs, opened);
+    std::vector<ShareType> D(opened.begin(), opened.begin() + length);
+    std::vector<ShareType> E(opened.begin() + length, opened.end());
+
+    // Only party 1 adds the public sum(D_k * E_k)
+    BigIntScratch scratch;
+    ShareType one = nullptr;
+    if (m_partyId == 1) {
+        one = scratch.get();
+        BN_one(one);
+    }
+    shardedInnerProductShares(D, E, myInnerProductTriple, one, z_i);
+    if constexpr (Security::MALICIOUS) {
+        // Every party adds its key share times sum(D_k * E_k) to the MAC
+        shardedInnerProductShares(D, E, myInnerProductTripleMac, m_global_key_share, m_inner_product_mac);
+    }
+
+    LOG_TRACE("[doInnerProduct][Party ", m_partyId, "] z_i = ", z_i);
+
+    // Cleanup
+    for (auto bn : de) BN_free(bn);
+    for (auto bn : deMacs) BN_free(bn);
+    for (auto bn : opened) BN_free(bn);
+}
+
+template <typename Security>
+void Party<Security>::matrixDimsForInputs(SIZE_T numInputs, SIZE_T &rows, SIZE_T &inner, SIZE_T &cols)
+{
+    SIZE_T d = 1;
+    while (2 * (d + 1) * (d + 1) <= numInputs) {
+        ++d;
+    }
+    if (2 * d * d > numInputs) {
+        throw std::runtime_error("Not enough secrets for a matrix product");
+    }
+    rows = inner = cols = d;
+}
+
+template <typename Security>
+void Party<Security>::freeMatrixTriple(MatrixTriple &triple)
+{
+    for (auto bn : triple.A) BN_free(bn);
+    for (auto bn : triple.B) BN_free(bn);
+    for (auto bn : triple.C) BN_free(bn);
+    triple.A.clear();
+    triple.B.clear();
+    triple.C.clear();
+    triple.rows = triple.inner = triple.cols = 0;
+}
+
+template <typename Security>
+void Party<Security>::distributeMatrixTriple(SIZE_T rows, SIZE_T inner, SIZE_T cols)
+{
+    LOG_TRACE("[Party ", m_partyId, "] Initiating matrix triple distribution (", rows, "x", inner, " by ", inner, "x", cols, ").");
+
+    // 1) Random A, B and C = A * B mod prime
+    std::vector<ShareType> A(rows * inner), B(inner * cols), C;
+    for (auto &entry : A) {
+        entry = AdditiveSecretSharing::newBigInt();
+        BN_rand_range(entry, AdditiveSecretSharing::getPrime());
+    }
+    for (auto &entry : B) {
+        entry = AdditiveSecretSharing::newBigInt();
+        BN_rand_range(entry, AdditiveSecretSharing::getPrime());
+    }
+    AdditiveSecretSharing::matrixMultiply(A, B, rows, inner, cols, C);
+
+    // 2) Share every entry of A, B and C (and their MACs)
+    std::vector<ShareType> entries(A);
+    entries.insert(entries.end(), B.begin(), B.end());
+    entries.insert(entries.end(), C.begin(), C.end());
+    std::vector<std::vector<ShareType>> entryShares(entries.size());
+    for (SIZE_T e = 0; e < entries.size(); ++e) {
+        AdditiveSecretSharing::generateShares(entries[e], m_totalParties, entryShares[e]);
+    }
+    std::vector<std::vector<ShareType>> entryMacShares;
+    std::vector<ShareType> globalMacKeyShares;
+    if constexpr (Security::MALICIOUS) {
+        entryMacShares.resize(entries.size());
+        for (SIZE_T e = 0; e < entries.size(); ++e) {
+            AdditiveSecretSharing::generateMacShares(entries[e], m_global_mac_key, m_totalParties, entryMacShares[e]);
+        }
+        AdditiveSecretSharing::generateShares(m_global_mac_key, m_totalParties, globalMacKeyShares);
+    }
+
+    // 3) Send "A..|B..|C..[|macA..|macB..|macC..|key]" to every party
     for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
-        if (pid == m_partyId) continue;
-        m_comm->sendTo(pid, deMsg.c_str(), deMsg.size());
-        #ifdef ENABLE_COUT
-        std::cout << "[Party " << m_partyId << "] Sent d_i and e_i to Party " << pid << "\n";
-        #endif
+        std::vector<ShareType> fields;
+        for (auto &shares : entryShares) fields.push_back(shares[pid - 1]);
+        if constexpr (Security::MALICIOUS) {
+            for (auto &shares : entryMacShares) fields.push_back(shares[pid - 1]);
+            fields.push_back(globalMacKeyShares[pid - 1]);
+        }
+        PooledBuffer tripleMsg = this->encodeBatch(fields, false);
+        m_comm->sendTo(pid, tripleMsg.data(), tripleMsg.size());
+        LOG_TRACE("[Party ", m_partyId, "] Sent matrix triple shares to Party ", pid);
+    }
+
+    // 4) Clean up
+    for (auto bn : entries) BN_free(bn);
+    for (auto &shares : entryShares) {
+        for (auto bn : shares) BN_free(bn);
+    }
+    if constexpr (Security::MALICIOUS) {
+        for (auto &shares : entryMacShares) {
+            for (auto bn : shares) BN_free(bn);
+        }
+        for (auto bn : globalMacKeyShares) BN_free(bn);
     }
+}
 
-    // Receive all d_j and e_j from other parties
-    ShareType D = AdditiveSecretSharing::newBigInt();
-    ShareType E = AdditiveSecretSharing::newBigInt();
-    BN_zero(D);
-    BN_zero(E);
+template <typename Security>
+void Party<Security>::receiveMatrixTriple(SIZE_T rows, SIZE_T inner, SIZE_T cols)
+{
+    SIZE_T sizeA = rows * inner, sizeB = inner * cols, sizeC = rows * cols;
+    SIZE_T numFields = sizeA + sizeB + sizeC;
+    if constexpr (Security::MALICIOUS) {
+        numFields = 2 * numFields + 1; // MAC shares and the global key share
+    }
+    PooledBuffer buffer = this->receiveFromDealer();
+    size_t bytesRead = buffer.size();
+    std::vector<ShareType> fields = deserializeShares(buffer.data(), bytesRead);
+    if (fields.size() != numFields) {
+        for (auto &field : fields) BN_free(field);
+        throw std::runtime_error("Invalid matrix triple format received");
+    }
 
-    // Add own d_i and e_i
-    BN_mod_add(D, D, d_i, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    BN_mod_add(E, E, e_i, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+    auto fill = [&](MatrixTriple &triple, std::vector<ShareType>::iterator next) {
+        freeMatrixTriple(triple);
+        triple.rows = rows;
+        triple.inner = inner;
+        triple.cols = cols;
+        triple.A.assign(next, next + sizeA);
+        triple.B.assign(next + sizeA, next + sizeA + sizeB);
+        triple.C.assign(next + sizeA + sizeB, next + sizeA + sizeB + sizeC);
+    };
+    fill(myMatrixTriple, fields.begin());
+    if constexpr (Security::MALICIOUS) {
+        fill(myMatrixTripleMac, fields.begin() + sizeA + sizeB + sizeC);
+        m_global_key_share = Share(fields.back());
+    }
 
-    for (int count = 0; count < (m_totalParties - 1); ++count) {
-        PARTY_ID_T senderId;
-        char buffer[BUFFER_SIZE];
-        size_t bytesRead = m_comm->receive(senderId, buffer, sizeof(buffer));
-        if (bytesRead == 0) {
-            throw std::runtime_error("Received empty d_j and e_j from Party " + std::to_string(senderId));
+    LOG_TRACE("[Party ", m_partyId, "] Successfully received matrix triple shares.");
+}
+
+template <typename Security>
+void Party<Security>::doMatrixMultiplication(const std::vector<ShareType> &X, const std::vector<ShareType> &Y,
+                                   const std::vector<ShareType> &XMacs, const std::vector<ShareType> &YMacs,
+                                   std::vector<ShareType> &Z)
+{
+    SIZE_T sizeX = myMatrixTriple.rows * myMatrixTriple.inner;
+    SIZE_T sizeY = myMatrixTriple.inner * myMatrixTriple.cols;
+    if (X.size() != sizeX || Y.size() != sizeY) {
+        throw std::runtime_error("doMatrixMultiplication: matrix and triple dimensions differ");
+    }
+
+    // D = X - A and E = Y - B, opened together in one round
+    std::vector<ShareType> de(sizeX + sizeY);
+    for (SIZE_T e = 0; e < sizeX; ++e) {
+        de[e] = AdditiveSecretSharing::newBigInt();
+        BN_mod_sub(de[e], X[e], myMatrixTriple.A[e], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+    }
+    for (SIZE_T e = 0; e < sizeY; ++e) {
+        de[sizeX + e] = AdditiveSecretSharing::newBigInt();
+        BN_mod_sub(de[sizeX + e], Y[e], myMatrixTriple.B[e], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+    }
+    std::vector<ShareType> deMacs;
+    if constexpr (Security::MALICIOUS) {
+        if (XMacs.size() != sizeX || YMacs.size() != sizeY) {
+            throw std::runtime_error("doMatrixMultiplication: missing MAC shares");
+        }
+        deMacs.resize(sizeX + sizeY);
+        for (SIZE_T e = 0; e < sizeX; ++e) {
+            deMacs[e] = AdditiveSecretSharing::newBigInt();
+            BN_mod_sub(deMacs[e], XMacs[e], myMatrixTripleMac.A[e], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+        }
+        for (SIZE_T e = 0; e < sizeY; ++e) {
+            deMacs[sizeX + e] = AdditiveSecretSharing::newBigInt();
+            BN_mod_sub(deMacs[sizeX + e], YMacs[e], myMatrixTripleMac.B[e], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+        }
+    } else {
+        (void)XMacs;
+        (void)YMacs;
+    }
+    std::vector<ShareType> opened;
+    this->openValues(de, deMacs, opened);
+    std::vector<ShareType> D(opened.begin(), opened.begin() + sizeX);
+    std::vector<ShareType> E(opened.begin() + sizeX, opened.end());
+
+    // Only party 1 adds the public D * E
+    ShareType one = nullptr;
+    if (m_partyId == 1) {
+        one = AdditiveSecretSharing::newBigInt();
+        BN_one(one);
+    }
+    AdditiveSecretSharing::matrixProductShares(D, E, myMatrixTriple, one, Z);
+    if constexpr (Security::MALICIOUS) {
+        AdditiveSecretSharing::matrixProductShares(D, E, myMatrixTripleMac, m_global_key_share, m_matrix_product_mac);
+    }
+
+    // Cleanup
+    if (one) BN_free(one);
+    for (auto bn : de) BN_free(bn);
+    for (auto bn : deMacs) BN_free(bn);
+    for (auto bn : opened) BN_free(bn);
+}
+
+template <typename Security>
+void Party<Security>::syncAfterDealerStep(const char* step)
+{
+    TraceSpan span("sync", "party");
+    PARTY_ID_T rejected = 0;
+    CMD_T reply = CMD_SUCCESS;
+    for (PARTY_ID_T i = 1; i <= m_totalParties; ++i) {
+        m_comm->dealerReceive(i, &m_cmd, sizeof(CMD_T));
+        if (m_cmd == CMD_SUCCESS) {
+            LOG_DEBUG("[", step, "][Party ", m_partyId, "] Received success from Party ", i);
+        } else if (rejected == 0) {
+            rejected = i;
+            reply = m_cmd;
+        }
+    }
+    if (rejected != 0) {
+        // The parties that accepted wait for the next command; stop them with the job
+        this->broadcastAllData(&CMD_SHUTDOWN, sizeof(CMD_T));
+        std::string reason = reply == CMD_SHARES_REJECTED
+            ? "rejected the shares; every party of a job must run the same --security"
+            : reply == CMD_MAC_CHECK_FAILED ? "failed the MAC check"
+            : "replied " + std::to_string(reply);
+        throw std::runtime_error(std::string(step) + ": Party " + std::to_string(rejected) + " " + reason);
+    }
+}
+
+template <typename Security>
+void Party<Security>::rejectDealerShares(const std::string &reason)
+{
+    LOG_ERROR("[Party ", m_partyId, "] Rejecting the dealer's shares: ", reason);
+    this->receiveFromDealer();
+    this->replyToDealer(&CMD_SHARES_REJECTED, sizeof(CMD_T));
+    throw std::runtime_error(reason);
+}
+
+template <typename Security>
+void Party<Security>::receiveAndReconstructResults(SIZE_T count, std::vector<ShareType> &results,
+                                         std::vector<ShareType> *macs)
+{
+    results.clear();
+    if (macs) macs->clear();
+    if (m_outputParty != 0) {
+        if constexpr (Security::MALICIOUS) {
+            // Authenticated random masks r: the parties open v - r and only the output party
+            // learns r (see revealMaskedResults)
+            std::vector<Share> masks(count);
+            for (auto &mask : masks) {
+                mask = Share::zero();
+                BN_rand_range(mask, AdditiveSecretSharing::getPrime());
+            }
+            this->sendValueShares(masks);
+            PooledBuffer clear = this->encodeBatch(borrowShares(masks), false);
+            m_comm->sendTo(m_outputParty, clear.data(), clear.size());
+            // Every party reports the MAC check; a failure stops the job with nothing revealed
+            this->syncAfterDealerStep("revealMaskedResults");
+        } else {
+            m_comm->dealerReceive(m_outputParty, &m_cmd, sizeof(CMD_T));
+            if (m_cmd != CMD_SUCCESS) {
+                throw std::runtime_error("Output party " + std::to_string(m_outputParty) + " did not confirm its results");
+            }
         }
-        std::string deReceived(buffer, bytesRead);
+        LOG_DEBUG("[Party ", m_partyId, "] ", count, " results revealed to Party ", m_outputParty);
+        return;
+    }
+    // Each sender replies "v_1|..|v_count[|mac_1|..|mac_count]"; in TREE mode only the
+    // dealer's children reply, each with the sum over its subtree
+    std::vector<PARTY_ID_T> senders;
+    if (m_openingMode == OpeningMode::TREE) {
+        for (SIZE_T child : KaryTree(m_totalParties + 1, TREE_ARITY).children(0)) {
+            senders.push_back(static_cast<PARTY_ID_T>(child));
+        }
+    } else {
+        for (PARTY_ID_T i = 1; i <= m_totalParties; ++i) senders.push_back(i);
+    }
+    std::vector<std::vector<ShareType>> shares(count, std::vector<ShareType>(senders.size()));
+    std::vector<std::vector<ShareType>> macShares;
+    SIZE_T expectedFields = count;
+    if constexpr (Security::MALICIOUS) {
+        macShares.assign(count, std::vector<ShareType>(senders.size()));
+        expectedFields = 2 * count;
+    }
+    PooledBuffer buffer = m_recvBuffers.acquire(batchBufferSize(expectedFields));
+    for (SIZE_T s = 0; s < senders.size(); ++s) {
+        size_t bytesRead = m_comm->dealerReceive(senders[s], buffer.data(), buffer.capacity());
+        std::vector<ShareType> parts = deserializeShares(buffer.data(), bytesRead);
+        if (parts.size() != expectedFields) {
+            for (auto &part : parts) BN_free(part);
+            throw std::runtime_error("Received invalid result shares from Party " + std::to_string(senders[s]));
+        }
+        for (SIZE_T r = 0; r < count; ++r) {
+            shares[r][s] = parts[r];
+            if constexpr (Security::MALICIOUS) {
+                macShares[r][s] = parts[count + r];
+            }
+        }
+    }
 
-        auto pos = deReceived.find("|");
-        if (pos == std::string::npos) {
-            throw std::runtime_error("Invalid d_j|e_j format from Party " + std::to_string(senderId));
+    results.resize(count);
+    if (macs) {
+        // Left empty by semi-honest parties
+        if constexpr (Security::MALICIOUS) {
+            macs->resize(count);
         }
-        std::string dStr = deReceived.substr(0, pos);
-        std::string eStr = deReceived.substr(pos + 1);
+    }
+    for (SIZE_T r = 0; r < count; ++r) {
+        results[r] = AdditiveSecretSharing::newBigInt();
+        AdditiveSecretSharing::reconstructSecret(shares[r], results[r]);
+        if constexpr (Security::MALICIOUS) {
+            ShareType mac = AdditiveSecretSharing::newBigInt();
+            AdditiveSecretSharing::reconstructSecret(macShares[r], mac);
+            this->recordOutput(results[r], mac);
+            if (macs) {
+                (*macs)[r] = mac;
+            } else {
+                BN_free(mac);
+            }
+            for (auto &share : macShares[r]) BN_free(share);
+        }
+        for (auto &share : shares[r]) BN_free(share);
+    }
+    if (m_resultSink) m_resultSink->write(results);
+}
 
-        ShareType d_j = deserializeShare(dStr);
-        ShareType e_j = deserializeShare(eStr);
+template <typename Security>
+void Party<Security>::distributeBeaverTriples(SIZE_T count)
+{
+    LOG_TRACE("[Party ", m_partyId, "] Initiating distribution of ", count, " Beaver triples.");
+
+    // 1) count random triples, flattened as a_0, b_0, c_0, a_1, ...
+    std::vector<Share> values(3 * count);
+    ThreadPool::shared().parallelFor(0, count, PARALLEL_GRAIN, [&](SIZE_T begin, SIZE_T end) {
+        for (SIZE_T t = begin; t < end; ++t) {
+            values[3 * t] = Share::zero();
+            values[3 * t + 1] = Share::zero();
+            values[3 * t + 2] = Share::zero();
+            BN_rand_range(values[3 * t], AdditiveSecretSharing::getPrime());
+            BN_rand_range(values[3 * t + 1], AdditiveSecretSharing::getPrime());
+            BN_mod_mul(values[3 * t + 2], values[3 * t], values[3 * t + 1], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+        }
+    });
+    this->sendValueShares(values);
+}
 
-        BN_mod_add(D, D, d_j, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-        BN_mod_add(E, E, e_j, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+template <typename Security>
+void Party<Security>::sendValueShares(const std::vector<Share> &values, bool authenticated)
+{
+    // Share every value (and its MAC); each value costs O(n) random draws
+    const bool withMacs = Security::MALICIOUS && authenticated;
+    std::vector<std::vector<Share>> valueShares(values.size());
+    std::vector<std::vector<Share>> valueMacShares(withMacs ? values.size() : 0);
+    SIZE_T sharingGrain = std::max<SIZE_T>(1, PARALLEL_GRAIN / m_totalParties);
+    ThreadPool::shared().parallelFor(0, values.size(), sharingGrain, [&](SIZE_T begin, SIZE_T end) {
+        for (SIZE_T v = begin; v < end; ++v) {
+            valueShares[v] = AdditiveSecretSharing::generateShares(values[v], m_totalParties);
+            if (withMacs) {
+                valueMacShares[v] = AdditiveSecretSharing::generateMacShares(values[v], m_global_mac_key, m_totalParties);
+            }
+        }
+    });
+    std::vector<Share> globalMacKeyShares;
+    if (withMacs) {
+        globalMacKeyShares = AdditiveSecretSharing::generateShares(m_global_mac_key, m_totalParties);
+    }
 
-        BN_free(d_j);
-        BN_free(e_j);
+    // One message per party: "v_1|..|v_k" [then "mac_1|..|mac_k", then the key]; for
+    // triples the values are a, b, c per triple
+    for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
+        std::vector<ShareType> fields;
+        for (auto &shares : valueShares) fields.push_back(shares[pid - 1]);
+        if (withMacs) {
+            for (auto &shares : valueMacShares) fields.push_back(shares[pid - 1]);
+            fields.push_back(globalMacKeyShares[pid - 1]);
+        }
+        PooledBuffer sharesMsg = this->encodeBatch(fields, false);
+        m_comm->sendTo(pid, sharesMsg.data(), sharesMsg.size());
     }
-    #if defined(ENABLE_MALICIOUS_SECURITY)
-    // Copy the D to m_epsilon and E to m_delta
-    BN_copy(m_epsilon, D);
-    BN_copy(m_rho, E);
-    #endif
-    // this->syncAfterDistribute();
-    // Compute z_i = c_i + a_i * E + b_i * D + D * E
-    // z_i = AdditiveSecretSharing::newBigInt();
-    BN_copy(z_i, myTriple.c);
+}
 
-    ShareType aE = AdditiveSecretSharing::newBigInt();
-    BN_mod_mul(aE, myTriple.a, E, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    BN_mod_add(z_i, z_i, aE, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+template <typename Security>
+void Party<Security>::receiveBeaverTriples(SIZE_T count)
+{
+    SIZE_T numFields = 3 * count;
+    if constexpr (Security::MALICIOUS) {
+        numFields = 2 * numFields + 1; // MAC shares and the global key share
+    }
+    PooledBuffer buffer = this->receiveFromDealer();
+    size_t bytesRead = buffer.size();
+    std::vector<Share> fields = adoptShares(deserializeShares(buffer.data(), bytesRead));
+    if (fields.size() != numFields) {
+        throw std::runtime_error("Invalid Beaver triple batch received");
+    }
 
-    ShareType bD = AdditiveSecretSharing::newBigInt();
-    BN_mod_mul(bD, myTriple.b, D, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    BN_mod_add(z_i, z_i, bD, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+    // The triples take over the received shares without copying them
+    myTriples.clear();
+    myTriples.reserve(count);
+    for (SIZE_T t = 0; t < count; ++t) {
+        myTriples.push_back({std::move(fields[3 * t]), std::move(fields[3 * t + 1]), std::move(fields[3 * t + 2])});
+    }
+    if constexpr (Security::MALICIOUS) {
+        myTriplesMac.clear();
+        myTriplesMac.reserve(count);
+        for (SIZE_T t = 0; t < count; ++t) {
+            SIZE_T base = 3 * count + 3 * t;
+            myTriplesMac.push_back({std::move(fields[base]), std::move(fields[base + 1]), std::move(fields[base + 2])});
+        }
+        m_global_key_share = std::move(fields.back());
+    }
+}
+
+template <typename Security>
+void Party<Security>::evaluateCircuit(const Circuit &circuit, const std::vector<ShareType> &inputs,
+                            const std::vector<ShareType> &inputMacs, std::vector<ShareType> &outputs,
+                            std::vector<ShareType> &outputMacs)
+{
+    (void)inputMacs;
+    const std::vector<Gate> &gates = circuit.gates();
+    if (inputs.size() != circuit.numInputs() || myTriples.size() < circuit.numMultiplications()) {
+        throw std::runtime_error("evaluateCircuit: missing inputs or Beaver triples");
+    }
 
+    // Inputs and outputs keep the order in which they were added to the circuit
+    std::vector<SIZE_T> ioIndex(gates.size(), 0);
+    SIZE_T numInputs = 0, numOutputs = 0;
+    for (SIZE_T g = 0; g < gates.size(); ++g) {
+        if (gates[g].type == GateType::INPUT) ioIndex[g] = numInputs++;
+        if (gates[g].type == GateType::OUTPUT) ioIndex[g] = numOutputs++;
+    }
+    outputs.assign(numOutputs, nullptr);
+    std::vector<ShareType> wires(gates.size(), nullptr);
+    std::vector<ShareType> wireMacs;
+    if constexpr (Security::MALICIOUS) {
+        outputMacs.assign(numOutputs, nullptr);
+        wireMacs.assign(gates.size(), nullptr);
+    }
+
+    ShareType one = nullptr;
     if (m_partyId == 1) {
-        ShareType DE = AdditiveSecretSharing::newBigInt();
-        BN_mod_mul(DE, D, E, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-        BN_mod_add(z_i, z_i, DE, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-        BN_free(DE);
-    }
-    
-    #if defined(ENABLE_COUT)
-    std::cout << "[doMultiplicationDemo][Party " << m_partyId << "] z_i = " << BN_bn2dec(z_i) << "\n";
-    #endif
+        one = AdditiveSecretSharing::newBigInt();
+        BN_one(one);
+    }
+    ShareType constant = AdditiveSecretSharing::newBigInt();
+    SIZE_T nextTriple = 0;
+    for (const auto &layer : circuit.layers()) {
+        // 1) Every multiplication of the layer shares a single opening of its d|e values
+        std::vector<SIZE_T> muls;
+        for (SIZE_T g : layer) {
+            if (gates[g].type == GateType::MUL) muls.push_back(g);
+        }
+        if (!muls.empty()) {
+            // Each shard owns one slice of the layer's multiplications for both passes
+            std::vector<ShareType> de(2 * muls.size());
+            std::vector<ShareType> deMacs;
+            if constexpr (Security::MALICIOUS) {
+                deMacs.resize(2 * muls.size());
+            }
+            forEachShard(muls.size(), [&](SIZE_T, SIZE_T begin, SIZE_T end) {
+                for (SIZE_T m = begin; m < end; ++m) {
+                    const BeaverTriple &triple = myTriples[nextTriple + m];
+                    de[2 * m] = AdditiveSecretSharing::newBigInt();
+                    de[2 * m + 1] = AdditiveSecretSharing::newBigInt();
+                    BN_mod_sub(de[2 * m], wires[gates[muls[m]].in0], triple.a, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+                    BN_mod_sub(de[2 * m + 1], wires[gates[muls[m]].in1], triple.b, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+                    if constexpr (Security::MALICIOUS) {
+                        const BeaverTriple &tripleMac = myTriplesMac[nextTriple + m];
+                        deMacs[2 * m] = AdditiveSecretSharing::newBigInt();
+                        deMacs[2 * m + 1] = AdditiveSecretSharing::newBigInt();
+                        BN_mod_sub(deMacs[2 * m], wireMacs[gates[muls[m]].in0], tripleMac.a, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+                        BN_mod_sub(deMacs[2 * m + 1], wireMacs[gates[muls[m]].in1], tripleMac.b, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+                    }
+                }
+            });
+            std::vector<ShareType> opened;
+            this->openValues(de, deMacs, opened);
+            forEachShard(muls.size(), [&](SIZE_T, SIZE_T begin, SIZE_T end) {
+                for (SIZE_T m = begin; m < end; ++m) {
+                    // A single Beaver multiplication is an inner product of length one
+                    std::vector<ShareType> D{opened[2 * m]}, E{opened[2 * m + 1]};
+                    const BeaverTriple &triple = myTriples[nextTriple + m];
+                    wires[muls[m]] = AdditiveSecretSharing::newBigInt();
+                    AdditiveSecretSharing::innerProductShares(D, E, {{triple.a}, {triple.b}, triple.c}, one, wires[muls[m]]);
+                    if constexpr (Security::MALICIOUS) {
+                        const BeaverTriple &tripleMac = myTriplesMac[nextTriple + m];
+                        wireMacs[muls[m]] = AdditiveSecretSharing::newBigInt();
+                        AdditiveSecretSharing::innerProductShares(D, E, {{tripleMac.a}, {tripleMac.b}, tripleMac.c},
+                                                                  m_global_key_share, wireMacs[muls[m]]);
+                    }
+                }
+            });
+            nextTriple += muls.size();
+            for (auto bn : de) BN_free(bn);
+            for (auto bn : deMacs) BN_free(bn);
+            for (auto bn : opened) BN_free(bn);
+        }
+
+        // 2) Local gates of the layer are free
+        for (SIZE_T g : layer) {
+            const Gate &gate = gates[g];
+            switch (gate.type) {
+                case GateType::MUL:
+                    break;
+                case GateType::INPUT:
+                    wires[g] = AdditiveSecretSharing::cloneBigInt(inputs[ioIndex[g]]);
+                    if constexpr (Security::MALICIOUS) {
+                        wireMacs[g] = AdditiveSecretSharing::cloneBigInt(inputMacs[ioIndex[g]]);
+                    }
+                    break;
+                case GateType::ADD:
+                    wires[g] = AdditiveSecretSharing::newBigInt();
+                    AdditiveSecretSharing::addShares(wires[gate.in0], wires[gate.in1], wires[g]);
+                    if constexpr (Security::MALICIOUS) {
+                        wireMacs[g] = AdditiveSecretSharing::newBigInt();
+                        AdditiveSecretSharing::addShares(wireMacs[gate.in0], wireMacs[gate.in1], wireMacs[g]);
+                    }
+                    break;
+                case GateType::CONST_MUL:
+                    BN_set_word(constant, gate.constant);
+                    wires[g] = AdditiveSecretSharing::newBigInt();
+                    BN_mod_mul(wires[g], wires[gate.in0], constant, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+                    if constexpr (Security::MALICIOUS) {
+                        wireMacs[g] = AdditiveSecretSharing::newBigInt();
+                        BN_mod_mul(wireMacs[g], wireMacs[gate.in0], constant, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+                    }
+                    break;
+                case GateType::OUTPUT:
+                    outputs[ioIndex[g]] = AdditiveSecretSharing::cloneBigInt(wires[gate.in0]);
+                    if constexpr (Security::MALICIOUS) {
+                        outputMacs[ioIndex[g]] = AdditiveSecretSharing::cloneBigInt(wireMacs[gate.in0]);
+                    }
+                    break;
+            }
+        }
+    }
 
     // Cleanup
-    BN_free(d_i);
-    BN_free(e_i);
-    BN_free(D);
-    BN_free(E);
-    BN_free(aE);
-    BN_free(bD);
+    if (one) BN_free(one);
+    BN_free(constant);
+    for (auto bn : wires) BN_free(bn);
+    if constexpr (Security::MALICIOUS) {
+        for (auto bn : wireMacs) BN_free(bn);
+    }
 }
 
-void Party::runEventLoop()
+template <typename Security>
+void Party<Security>::runEventLoop()
 {
-    #ifdef ENABLE_COUT
-    std::cout << "[Party " << m_partyId << "] Starting event loop.\n";
-    #endif
+    LOG_TRACE("[Party ", m_partyId, "] Starting event loop.");
+    // The socket keeps draining on the endpoint's receive thread while handlers compute;
+    // messages still reach this thread one at a time and in arrival order
+    m_comm->startReceiveThread();
 
+    // Besides commands, peers that are ahead send openings and input parties whole batches
     while (m_running) {
         PARTY_ID_T senderId;
-        char buffer[BUFFER_SIZE];
-        size_t bytesRead = m_comm->receive(senderId, buffer, sizeof(buffer));
-        if (bytesRead > 0) {
-            #if defined(ENABLE_COUT)
-            std::cout << "[Party " << m_partyId << "] Received message from Party " << senderId
-                      << ": " << std::string(buffer, bytesRead) << "\n";
-            #endif
-            // launch a new thread to handle the message
-            // std::thread([this, senderId, buffer, bytesRead]() {
-            handleMessage(senderId, buffer, bytesRead);
-            // }).detach();
-            
-        } else {
-            // std::cerr << "[Party " << m_partyId << "] Received empty message from Party "
-            //           << senderId << ".\n";
+        PooledBuffer msg = this->receiveMessage(senderId);
+        if (msg.size() > 0) {
+            LOG_TRACE("[Party ", m_partyId, "] Received message from Party ", senderId, ": ", std::string(msg.data(), msg.size()));
+            // Handlers run here because a protocol step reads its later messages in order;
+            // their batch arithmetic is spread over ThreadPool::shared()
+            handleMessage(senderId, msg.data(), msg.size());
         }
     }
 
-    // Use the interface's close method instead of just calling destructor
-    // m_comm->close();
-
-    #ifdef ENABLE_COUT
-    std::cout << "[Party " << m_partyId << "] Event loop stopping.\n";
-    #endif
+    LOG_TRACE("[Party ", m_partyId, "] Event loop stopping.");
 }
 
-void Party::handleMessage(PARTY_ID_T senderId, const void *data, LENGTH_T length){
+template <typename Security>
+void Party<Security>::handleMessage(PARTY_ID_T senderId, const void *data, LENGTH_T length){
     // Convert data to CMD_T
+    if (length == 0) return;
     CMD_T cmd;
-    std::memcpy(&cmd, data, length);
-    if (cmd == CMD_SEND_SHARES) {
-        #if defined(ENABLE_UNIT_TESTS)
-        std::cout << "[Party " << m_partyId << "] Received command to send shares from Party " 
-                  << senderId << "\n";
-        #endif // ENABLE_UNIT_TESTS
-        // m_dealRouterId = m_comm->getLastRoutingId();
-        std::cout << "[Party " << m_partyId << "] has the value of m_lastRoutingId: " << m_comm->getLastRoutingId() << "\n";
+    std::memcpy(&cmd, data, sizeof(CMD_T));
+    TraceSpan span(commandName(cmd), "command");
+    if (this->takeInputMessage(senderId, static_cast<const char*>(data), length)) {
+        return;
+    }
+    if (cmd == CMD_PARTIAL_OPEN) {
+        // A peer already started an opening this party has not reached yet
+        const char* bytes = static_cast<const char*>(data);
+        this->keepPeerMessage(senderId, bytes, length);
+    } else if (cmd == CMD_SEND_SHARES) {
+        PhaseStats::Scope phase(m_phaseStats, PHASE_SHARE_DISTRIBUTION);
+        LOG_DEBUG("[Party ", m_partyId, "] Received command to send shares from Party ", senderId);
+        LOG_DEBUG("[Party ", m_partyId, "] has the value of m_lastRoutingId: ", m_comm->getLastRoutingId());
         
-        // Receive the share string from the sender
-        char buffer[BUFFER_SIZE];
-        size_t bytesRead = m_comm->receive(senderId, buffer, sizeof(buffer));
-        std::cout << "[Party " << m_partyId << "] Received share data from Party " << senderId << "\n";
-        if (bytesRead == 0) {
-            std::cerr << "[Party " << m_partyId << "] Received empty share data from Party " 
-                      << senderId << "\n";
-            return;
+        // [CMD_SEND_SHARES][security mode][batch size]; when malicious every input comes
+        // with its MAC share
+        const SIZE_T header = sizeof(CMD_T) + sizeof(SecurityMode) + sizeof(SIZE_T);
+        if (length < header) {
+            this->rejectDealerShares("Truncated share command");
         }
-        std::string shareStr(buffer, bytesRead);
+        SecurityMode mode;
+        std::memcpy(&mode, static_cast<const char*>(data) + sizeof(CMD_T), sizeof(SecurityMode));
+        if (mode != Security::MODE) {
+            this->rejectDealerShares("The dealer runs a " + IParty::securityModeName(mode) + " job, this party is " +
+                                     IParty::securityModeName(Security::MODE));
+        }
+        std::memcpy(&m_batchSize, static_cast<const char*>(data) + sizeof(CMD_T) + sizeof(SecurityMode), sizeof(SIZE_T));
+        SIZE_T expectedFields = Security::MALICIOUS ? 2 * m_batchSize : m_batchSize;
 
-        // Split the received string into individual share hex strings
-        std::vector<std::string> shareParts;
-        std::stringstream ss(shareStr);
-        std::string item;
-        while (std::getline(ss, item, '|')) {
-            if (!item.empty()) {
-                shareParts.push_back(item);
-            }
+        // Receive the share string from the sender; large batches take the dealer a while to share
+        PooledBuffer buffer = this->receiveFromDealer();
+        size_t bytesRead = buffer.size();
+        LOG_DEBUG("[Party ", m_partyId, "] Received share data from Party ", senderId);
+
+        // Split the received message into individual shares
+        std::vector<Share> shareParts;
+        try {
+            shareParts = adoptShares(deserializeShares(buffer.data(), bytesRead));
         }
-        #if defined(ENABLE_UNIT_TESTS)
-        // Verify that the number of received shares matches expected
-        #if defined(ENABLE_MALICIOUS_SECURITY)
-        if (shareParts.size() != 2 * NUM_SECRETS) {
-            std::cerr << "[Party " << m_partyId << "] Expected " << NUM_SECRETS 
-                      << " shares but received " << shareParts.size() << " from Party " 
-                      << senderId << "\n";
-            return;
+        catch (const std::exception& e) {
+            this->replyToDealer(&CMD_SHARES_REJECTED, sizeof(CMD_T));
+            throw std::runtime_error(std::string("Failed to deserialize the dealer's shares: ") + e.what());
         }
-        #else 
-        if (shareParts.size() != NUM_SECRETS) {
-            std::cerr << "[Party " << m_partyId << "] Expected " << NUM_SECRETS 
-                      << " shares but received " << shareParts.size() << " from Party " 
-                      << senderId << "\n";
-            return;
+        // Verify that the number of received shares matches the announced batch
+        if (shareParts.size() != expectedFields) {
+            this->replyToDealer(&CMD_SHARES_REJECTED, sizeof(CMD_T));
+            throw std::runtime_error("Expected " + std::to_string(expectedFields) + " shares from the dealer, received " +
+                                     std::to_string(shareParts.size()));
         }
-        #endif // ENABLE_MALICIOUS_SECURITY
-        #endif
 
-        // Deserialize each share hex string into ShareType
-        // std::vector<ShareType> receivedShares;
+        // The first batchSize() parts are the input shares, the rest their MAC shares
+        m_foldedInputs = false;
         m_receivedShares.clear();
-        #if defined(ENABLE_MALICIOUS_SECURITY)
-        m_receivedMacShares.clear();
-        #endif
-        try {
-            // for (const auto& shareHex : shareParts) {
-            //     ShareType share = deserializeShare(shareHex);
-            //     #if defined(ENABLE_UNIT_TESTS)
-            //     std::cout << "[Party " << m_partyId << "] Received share: " << BN_bn2dec(share) << "\n";
-            //     #endif
-            //     m_receivedShares.push_back(share);
-            // }
-            for (SIZE_T i = 0; i < shareParts.size(); ++i) {
-                ShareType share = deserializeShare(shareParts[i]);
-                #if defined(ENABLE_UNIT_TESTS)
-                std::cout << "[Party " << m_partyId << "] Received share: " << BN_bn2dec(share) << "\n";
-                #endif
-                if (i < NUM_SECRETS) {
-                    m_receivedShares.push_back(share);
-                } else {
-                    #if defined(ENABLE_MALICIOUS_SECURITY)
-                    m_receivedMacShares.push_back(share);
-                    #endif
+        m_receivedShares.reserve(m_batchSize);
+        if constexpr (Security::MALICIOUS) {
+            m_receivedMacShares.clear();
+            m_receivedMacShares.reserve(m_batchSize);
+        }
+        for (SIZE_T i = 0; i < shareParts.size(); ++i) {
+            LOG_TRACE("[Party ", m_partyId, "] Received share: ", shareParts[i]);
+            if (i < m_batchSize) {
+                m_receivedShares.push_back(std::move(shareParts[i]));
+            } else {
+                if constexpr (Security::MALICIOUS) {
+                    m_receivedMacShares.push_back(std::move(shareParts[i]));
                 }
             }
         }
-        catch (const std::exception& e) {
-            std::cerr << "[Party " << m_partyId << "] Failed to deserialize shares from Party " 
-                      << senderId << ": " << e.what() << "\n";
-            return;
-        }
         // Acknowledge successful reception
-        m_comm->reply(&CMD_SUCCESS, sizeof(CMD_T));
+        this->replyToDealer(&CMD_SUCCESS, sizeof(CMD_T));
+    }
+    else if (cmd == CMD_SEND_SHARE_CHUNK) {
+        PhaseStats::Scope phase(m_phaseStats, PHASE_SHARE_DISTRIBUTION);
+        // [CMD_SEND_SHARE_CHUNK][security mode][chunk index][values in the chunk]
+        const SIZE_T prefix = sizeof(CMD_T) + sizeof(SecurityMode);
+        if (length < prefix + 2 * sizeof(SIZE_T)) {
+            this->rejectDealerShares("Truncated input chunk command");
+        }
+        SecurityMode mode;
+        std::memcpy(&mode, static_cast<const char*>(data) + sizeof(CMD_T), sizeof(SecurityMode));
+        if (mode != Security::MODE) {
+            this->rejectDealerShares("The dealer runs a " + IParty::securityModeName(mode) + " job, this party is " +
+                                     IParty::securityModeName(Security::MODE));
+        }
+        SIZE_T chunkIndex, count;
+        std::memcpy(&chunkIndex, static_cast<const char*>(data) + prefix, sizeof(SIZE_T));
+        std::memcpy(&count, static_cast<const char*>(data) + prefix + sizeof(SIZE_T), sizeof(SIZE_T));
+        SIZE_T expectedFields = Security::MALICIOUS ? 2 * count : count;
+        LOG_DEBUG("[Party ", m_partyId, "] Receiving input chunk ", chunkIndex, " of ", count, " values from Party ", senderId);
+
+        PooledBuffer buffer = this->receiveFromDealer();
+        size_t bytesRead = buffer.size();
+        std::vector<Share> shareParts;
+        try {
+            shareParts = adoptShares(deserializeShares(buffer.data(), bytesRead));
+        } catch (const std::exception& e) {
+            this->replyToDealer(&CMD_SHARES_REJECTED, sizeof(CMD_T));
+            throw std::runtime_error(std::string("Invalid input chunk: ") + e.what());
+        }
+        if (shareParts.size() != expectedFields) {
+            this->replyToDealer(&CMD_SHARES_REJECTED, sizeof(CMD_T));
+            throw std::runtime_error("Invalid input chunk: expected " + std::to_string(expectedFields) +
+                                     " shares, got " + std::to_string(shareParts.size()));
+        }
+
+        // Streamed inputs are folded into one running sum (and MAC sum) instead of being
+        // kept, so memory stays bounded by the chunk; CMD_ADDITION then returns the total
+        if (chunkIndex == 0) {
+            m_receivedShares.clear();
+            m_receivedShares.push_back(Share::zero());
+            if constexpr (Security::MALICIOUS) {
+                m_receivedMacShares.clear();
+                m_receivedMacShares.push_back(Share::zero());
+            }
+            m_batchSize = 0;
+            m_foldedInputs = true;
+        }
+        BigIntScratch scratch;
+        ShareType chunkSum = scratch.get();
+        std::vector<ShareType> parts = borrowShares(shareParts);
+        AdditiveSecretSharing::addShares(std::vector<ShareType>(parts.begin(), parts.begin() + count), chunkSum);
+        ShareType sum = m_receivedShares[0].get();
+        AdditiveSecretSharing::addShares(sum, chunkSum, sum);
+        if constexpr (Security::MALICIOUS) {
+            AdditiveSecretSharing::addShares(std::vector<ShareType>(parts.begin() + count, parts.end()), chunkSum);
+            ShareType macSum = m_receivedMacShares[0].get();
+            AdditiveSecretSharing::addShares(macSum, chunkSum, macSum);
+        }
+        m_batchSize += count;
+        // Acknowledge the chunk so the dealer sends the next one
+        this->replyToDealer(&CMD_SUCCESS, sizeof(CMD_T));
+    }
+    else if (cmd == CMD_COLLECT_INPUTS) {
+        PhaseStats::Scope phase(m_phaseStats, PHASE_SHARE_DISTRIBUTION);
+        if (length < sizeof(CMD_T) + sizeof(SIZE_T)) {
+            throw std::runtime_error("Truncated collect command");
+        }
+        SIZE_T extraParties;
+        std::memcpy(&extraParties, static_cast<const char*>(data) + sizeof(CMD_T), sizeof(SIZE_T));
+        LOG_DEBUG("[Party ", m_partyId, "] Merging the inputs of ", extraParties, " more input parties");
+        // [inputs appended][values they stand for]; both are the same at every party
+        SIZE_T counts[2];
+        if (!this->mergeInputs(extraParties, counts)) {
+            // The dealer stops the job
+            this->rejectInputParties();
+            this->replyToDealer(&CMD_SHARES_REJECTED, sizeof(CMD_T));
+        } else {
+            m_batchSize += m_foldedInputs ? counts[1] : counts[0];
+            this->replyToDealer(counts, sizeof(counts));
+            if constexpr (Security::MALICIOUS) {
+                if (counts[0] > 0) {
+                    this->authenticateInputs(extraParties, counts[0]);
+                }
+            }
+        }
     }
     else if (cmd == CMD_SHUTDOWN) {
-        std::cout << "[Party " << m_partyId << "] Received shutdown command from Party " 
-                  << senderId << "\n";
+        LOG_DEBUG("[Party ", m_partyId, "] Received shutdown command from Party ", senderId);
         m_running = false;
     } else if (cmd == CMD_ADDITION) {
-        #if defined(ENABLE_UNIT_TESTS)
-        std::cout << "[Party " << m_partyId << "] Received command to perform addition from Party " 
-                  << senderId << "\n";
-        #endif // ENABLE_UNIT_TESTS
+        PhaseStats::Scope phase(m_phaseStats, PHASE_ADDITION);
+        LOG_DEBUG("[Party ", m_partyId, "] Received command to perform addition from Party ", senderId);
         // Perform addition with received shares in m_receivedShares
         ShareType sum_result = AdditiveSecretSharing::newBigInt();
-        AdditiveSecretSharing::addShares(m_receivedShares, sum_result);
-        #if defined(ENABLE_UNIT_TESTS)
-        std::cout << "[Party " << m_partyId << "] Sum result: " << BN_bn2dec(sum_result) << "\n";
-        #endif // ENABLE_UNIT_TESTS
-        // Reply the serialized sum back to the sender
-        std::string sumStr = serializeShare(sum_result);
-        #if defined(ENABLE_MALICIOUS_SECURITY)
-        ShareType mac_result = AdditiveSecretSharing::newBigInt();
-        AdditiveSecretSharing::addShares(m_receivedMacShares, mac_result);
-        sumStr += "|" + serializeShare(mac_result);
-        #endif
-        m_comm->reply(sumStr.c_str(), sumStr.size());
+        AdditiveSecretSharing::addShares(borrowShares(m_receivedShares), sum_result);
+        LOG_DEBUG("[Party ", m_partyId, "] Sum result: ", sum_result);
+        std::vector<ShareType> reply{sum_result};
+        if constexpr (Security::MALICIOUS) {
+            ShareType mac_result = AdditiveSecretSharing::newBigInt();
+            AdditiveSecretSharing::addShares(borrowShares(m_receivedMacShares), mac_result);
+            reply.push_back(mac_result);
+        }
+        // Reply the re-randomized sum back to the sender
+        this->sendResultsToDealer(reply);
 
-        // Clean up
-        BN_free(sum_result);
-        #if defined(ENABLE_MALICIOUS_SECURITY)
-        BN_free(mac_result);
-        #endif
+        // Clean up: the sum and, for malicious parties, its MAC
+        for (auto &share : reply) BN_free(share);
     } else if (cmd == CMD_MULTIPLICATION) {
-        #if defined(ENABLE_UNIT_TESTS)
-        std::cout << "[Party " << m_partyId << "] Received command to perform multiplication from Party " 
-                  << senderId << "\n";
-        #endif // ENABLE_UNIT_TESTS
-        this->receiveBeaverTriple();
-        m_comm->reply(&CMD_SUCCESS, sizeof(CMD_T));
-        // m_comm->reply(&CMD_SUCCESS, sizeof(CMD_T));
-        
-        #if defined(ENABLE_UNIT_TESTS)
-        // check the received Beaver triple values
-        std::cout << "[Party " << m_partyId << "] Received Beaver triple shares:\n";
-        std::cout << "  a: " << BN_bn2dec(myTriple.a) << "\n";
-        std::cout << "  b: " << BN_bn2dec(myTriple.b) << "\n";
-        std::cout << "  c: " << BN_bn2dec(myTriple.c) << "\n";
-            #if defined(ENABLE_MALICIOUS_SECURITY)
-            std::cout << "  macA: " << BN_bn2dec(myTripleMac.a) << "\n";
-            std::cout << "  macB: " << BN_bn2dec(myTripleMac.b) << "\n";
-            std::cout << "  macC: " << BN_bn2dec(myTripleMac.c) << "\n";
-            std::cout << "  globalMacKeyShare: " << BN_bn2dec(m_global_key_share) << "\n";
-            #endif
-        #endif // ENABLE_UNIT_TESTS
-        this->doMultiplicationDemo(m_z_i);
-        #if defined(ENABLE_UNIT_TESTS)
-        std::cout << "[Party " << m_partyId << "] m_z_i: " << BN_bn2dec(m_z_i) << "\n";
-        #endif // ENABLE_UNIT_TESTS
-        #if defined(ENABLE_MALICIOUS_SECURITY)
-        this->generateZmac(m_z_i_mac);
-        #if defined(ENABLE_UNIT_TESTS)
-        std::cout << "[Party " << m_partyId << "] m_z_i_mac: " << BN_bn2dec(m_z_i_mac) << "\n";
-        #endif // ENABLE_UNIT_TESTS
-        #endif
-        // // send success to the dealer
-        // std::cout << "m_dealRouterId: " << m_dealRouterId << "\n";
-        // // m_comm->reply((void*)m_dealRouterId.c_str(), &CMD_SUCCESS, sizeof(CMD_T));
-        m_comm->reply((void*)m_dealRouterId.c_str(), m_dealRouterId.size(), &CMD_SUCCESS, sizeof(CMD_T));
+        LOG_DEBUG("[Party ", m_partyId, "] Received command to perform multiplication from Party ", senderId);
+        PhaseStats::Scope triplePhase(m_phaseStats, PHASE_TRIPLE_DISTRIBUTION);
+        // The first half of the batch times the second half, one triple per product
+        SIZE_T numProducts = m_receivedShares.size() / 2;
+        this->receiveBeaverTriples(numProducts);
+        this->replyToDealer(&CMD_SUCCESS, sizeof(CMD_T));
+        triplePhase.stop();
+        PhaseStats::Scope phase(m_phaseStats, PHASE_MULTIPLICATION);
+
+        std::vector<ShareType> x = borrowShares(m_receivedShares);
+        std::vector<ShareType> y(x.begin() + numProducts, x.begin() + 2 * numProducts);
+        x.resize(numProducts);
+        std::vector<ShareType> xMacs, yMacs;
+        if constexpr (Security::MALICIOUS) {
+            xMacs = borrowShares(m_receivedMacShares);
+            yMacs.assign(xMacs.begin() + numProducts, xMacs.begin() + 2 * numProducts);
+            xMacs.resize(numProducts);
+        }
+        this->doMultiplication(x, y, xMacs, yMacs, m_products, m_productMacs);
+        LOG_DEBUG("[Party ", m_partyId, "] Computed ", m_products.size(), " product shares");
+        this->replyToDealer(&CMD_SUCCESS, sizeof(CMD_T));
     } else if (cmd == CMD_FETCH_MULT_SHARE) {
-        std::cout << "[Party " << m_partyId << "] Received command to fetch multiplication share from Party " 
-                  << senderId << "\n";
-        m_comm->reply(&CMD_SUCCESS, sizeof(CMD_T));
-        std::string zStr = serializeShare(m_z_i);
-        m_comm->reply(zStr.c_str(), zStr.size());
-        BN_free(m_z_i);
-        #if defined(ENABLE_MALICIOUS_SECURITY)
-        std::string zMacStr = serializeShare(m_z_i_mac);
-        m_comm->reply(zMacStr.c_str(), zMacStr.size());
-        BN_free(m_z_i_mac);
-        generateBatchZeroShare(m_sigma);
-            #if defined(ENABLE_UNIT_TESTS)
-            std::cout << "[Party " << m_partyId << "] m_sigma: " << BN_bn2dec(m_sigma) << "\n";
-            #endif
-        std::string sigmaStr = serializeShare(m_sigma);
-        m_comm->reply(sigmaStr.c_str(), sigmaStr.size());
-        #endif
-    } else {
-        std::cerr << "[Party " << m_partyId << "] Unknown command received from Party " 
-                  << senderId << ": " << cmd << "\n";
+        PhaseStats::Scope phase(m_phaseStats, PHASE_MULTIPLICATION);
+        LOG_DEBUG("[Party ", m_partyId, "] Received command to fetch multiplication share from Party ", senderId);
+        this->replyToDealer(&CMD_SUCCESS, sizeof(CMD_T));
+        // All product shares, then their MAC shares
+        std::vector<ShareType> reply = borrowShares(m_products);
+        if constexpr (Security::MALICIOUS) {
+            for (auto &mac : m_productMacs) reply.push_back(mac);
+        }
+        this->sendResultsToDealer(reply);
+    } else if (cmd == CMD_INNER_PRODUCT) {
+        LOG_DEBUG("[Party ", m_partyId, "] Received command to perform inner product from Party ", senderId);
+        SIZE_T length = m_receivedShares.size() / 2;
+        PhaseStats::Scope triplePhase(m_phaseStats, PHASE_TRIPLE_DISTRIBUTION);
+        this->receiveInnerProductTriple(length);
+        this->replyToDealer(&CMD_SUCCESS, sizeof(CMD_T));
+        triplePhase.stop();
+        PhaseStats::Scope phase(m_phaseStats, PHASE_INNER_PRODUCT);
+        std::vector<ShareType> x(m_receivedShares.begin(), m_receivedShares.begin() + length);
+        std::vector<ShareType> y(m_receivedShares.begin() + length, m_receivedShares.begin() + 2 * length);
+        std::vector<ShareType> xMacs, yMacs;
+        if constexpr (Security::MALICIOUS) {
+            xMacs.assign(m_receivedMacShares.begin(), m_receivedMacShares.begin() + length);
+            yMacs.assign(m_receivedMacShares.begin() + length, m_receivedMacShares.begin() + 2 * length);
+        }
+        this->doInnerProduct(x, y, xMacs, yMacs, m_inner_product);
+        std::vector<ShareType> result{m_inner_product};
+        if constexpr (Security::MALICIOUS) {
+            result.push_back(m_inner_product_mac);
+        }
+        this->sendResultsToDealer(result);
+    } else if (cmd == CMD_MATRIX_MULTIPLICATION) {
+        LOG_DEBUG("[Party ", m_partyId, "] Received command to perform matrix multiplication from Party ", senderId);
+        SIZE_T rows, inner, cols;
+        matrixDimsForInputs(m_receivedShares.size(), rows, inner, cols);
+        PhaseStats::Scope triplePhase(m_phaseStats, PHASE_TRIPLE_DISTRIBUTION);
+        this->receiveMatrixTriple(rows, inner, cols);
+        this->replyToDealer(&CMD_SUCCESS, sizeof(CMD_T));
+        triplePhase.stop();
+        PhaseStats::Scope phase(m_phaseStats, PHASE_MATRIX_MULTIPLICATION);
+        auto xBegin = m_receivedShares.begin();
+        auto yBegin = xBegin + rows * inner;
+        std::vector<ShareType> X(xBegin, yBegin);
+        std::vector<ShareType> Y(yBegin, yBegin + inner * cols);
+        std::vector<ShareType> XMacs, YMacs;
+        if constexpr (Security::MALICIOUS) {
+            XMacs.assign(m_receivedMacShares.begin(), m_receivedMacShares.begin() + rows * inner);
+            YMacs.assign(m_receivedMacShares.begin() + rows * inner, m_receivedMacShares.begin() + rows * inner + inner * cols);
+        }
+        this->doMatrixMultiplication(X, Y, XMacs, YMacs, m_matrix_product);
+        std::vector<ShareType> result(m_matrix_product);
+        if constexpr (Security::MALICIOUS) {
+            result.insert(result.end(), m_matrix_product_mac.begin(), m_matrix_product_mac.end());
+        }
+        this->sendResultsToDealer(result);
+    } else if (cmd == CMD_EVALUATE_CIRCUIT) {
+        LOG_DEBUG("[Party ", m_partyId, "] Received command to evaluate a circuit from Party ", senderId);
+        // The circuit description comes first, then one triple per multiplication gate
+        PhaseStats::Scope triplePhase(m_phaseStats, PHASE_TRIPLE_DISTRIBUTION);
+        PooledBuffer buffer = this->receiveFromDealer();
+        size_t bytesRead = buffer.size();
+        Circuit circuit = Circuit::deserialize(std::string(buffer.data(), bytesRead));
+        this->receiveBeaverTriples(circuit.numMultiplications());
+        this->replyToDealer(&CMD_SUCCESS, sizeof(CMD_T));
+        triplePhase.stop();
+        PhaseStats::Scope phase(m_phaseStats, PHASE_CIRCUIT);
+        if (circuit.numInputs() > m_receivedShares.size()) {
+            throw std::runtime_error("Circuit needs more inputs than this party holds");
+        }
+        std::vector<ShareType> inputs(m_receivedShares.begin(), m_receivedShares.begin() + circuit.numInputs());
+        std::vector<ShareType> inputMacs;
+        if constexpr (Security::MALICIOUS) {
+            inputMacs.assign(m_receivedMacShares.begin(), m_receivedMacShares.begin() + circuit.numInputs());
+        }
+        std::vector<ShareType> outputs, outputMacs;
+        this->evaluateCircuit(circuit, inputs, inputMacs, outputs, outputMacs);
+        std::vector<ShareType> result(outputs);
+        result.insert(result.end(), outputMacs.begin(), outputMacs.end());
+        this->sendResultsToDealer(result);
+        for (auto &share : result) BN_free(share);
+    }
+    else if (cmd == CMD_PRSS_SETUP) {
+        LOG_DEBUG("[Party ", m_partyId, "] Received command to set up PRSS keys from Party ", senderId);
+        PhaseStats::Scope phase(m_phaseStats, PHASE_SETUP);
+        this->setupPrss();
+        this->replyToDealer(&CMD_SUCCESS, sizeof(CMD_T));
+    }
+    else if (Security::MALICIOUS && cmd == CMD_MAC_CHECK) {
+        LOG_DEBUG("[Party ", m_partyId, "] Received command to check the MACs of ", m_openedLog.size(), " opened values from Party ", senderId);
+        PhaseStats::Scope phase(m_phaseStats, PHASE_MAC_CHECK);
+        CMD_T status = this->runMacCheck() ? CMD_SUCCESS : CMD_MAC_CHECK_FAILED;
+        this->replyToDealer(&status, sizeof(CMD_T));
+    }
+    else {
+        LOG_ERROR("[Party ", m_partyId, "] Unknown command received from Party ", senderId, ": ", cmd);
     }
 }
 
-// ...existing code...
-
-void Party::generateMyShares(const std::vector<ShareType> &secretValues,
-                             std::unordered_map<ShareType, std::vector<ShareType>> &secretSharesMap){
+template <typename Security>
+void Party<Security>::generateMyShares(const std::vector<ShareType> &secretValues, std::vector<std::vector<Share>> &shares){
     #if defined(ENABLE_UNIT_TESTS)
-    ShareType reconstructed = AdditiveSecretSharing::newBigInt();
+    Share reconstructed = Share::zero();
     #endif // ENABLE_UNIT_TESTS
+    shares.clear();
+    shares.reserve(secretValues.size());
     for (ShareType secretBN : secretValues) {
         if (!secretBN) throw std::runtime_error("Secret ShareType is null.");
 
-        // Generate shares
-        std::vector<ShareType> shares;
-        AdditiveSecretSharing::generateShares(secretBN, m_totalParties, shares);
-        #if defined(ENABLE_UNIT_TESTS)
-        std::cout << "After generating shares\n";
-        for (auto &share : shares) {
-            std::cout << "[Party " << m_partyId << "] Share: " << BN_bn2dec(share) << "\n";
+        // Generate shares; indexed by the secret's position, so equal values cannot collide
+        shares.push_back(AdditiveSecretSharing::generateShares(secretBN, m_totalParties));
+        LOG_TRACE("After generating shares");
+        for (auto &share : shares.back()) {
+            LOG_TRACE("[Party ", m_partyId, "] Share: ", share);
         }
-        #endif
         // Test the correctness of the shares by reconstructing the secret
         #if defined(ENABLE_UNIT_TESTS)
-        AdditiveSecretSharing::reconstructSecret(shares, reconstructed);
-        std::cout << "[Party " << m_partyId << "] Reconstruction test for secret " 
-                  << BN_bn2dec(secretBN) << ": " << BN_bn2dec(reconstructed) << "\n";
-        #endif
-
-        // Store them in the map
-        secretSharesMap[secretBN] = std::move(shares);
-        std::cout << "After storing shares\n";
-        #if defined(ENABLE_UNIT_TESTS)
-        // Check the shares stored in the unordered_map
-        std::cout << "[Party " << m_partyId << "] Shares for secret " << BN_bn2dec(secretBN) << ":\n";
-        for (auto &share : secretSharesMap[secretBN]) {
-            std::cout << "  " << BN_bn2dec(share) << "\n";
-        }
+        ShareType reconstructedRaw = reconstructed.get();
+        AdditiveSecretSharing::reconstructSecret(borrowShares(shares.back()), reconstructedRaw);
+        LOG_DEBUG("[Party ", m_partyId, "] Reconstruction test for secret ", secretBN, ": ", reconstructed);
         #endif
 
-        #ifdef ENABLE_COUT
-        std::cout << "[Party " << m_partyId << "] Generated shares for one ShareType secret\n";
-        #endif
+        LOG_TRACE("[Party ", m_partyId, "] Generated shares for one ShareType secret");
     }
-    #if defined(ENABLE_UNIT_TESTS)
-    BN_free(reconstructed);
-    #endif // ENABLE_UNIT_TESTS
 }
 
-#if defined(ENABLE_MALICIOUS_SECURITY)
-void Party::generateZmac(ShareType z_i_mac) {
-    // check if z_i_mac is null
-    if (!z_i_mac) throw std::runtime_error("z_i_mac is null.");
-    BN_zero(z_i_mac);
-    BN_mod_add(z_i_mac, z_i_mac, myTripleMac.c, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    // m_epsilon * myTripleMac.b
-    ShareType temp = AdditiveSecretSharing::newBigInt();
-    BN_mod_mul(temp, m_epsilon, myTripleMac.b, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    BN_mod_add(z_i_mac, z_i_mac, temp, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    // m_rho * myTripleMac.a
-    BN_mod_mul(temp, m_rho, myTripleMac.a, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    BN_mod_add(z_i_mac, z_i_mac, temp, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    // m_epsilon * m_rho * m_global_key_share
-    BN_mod_mul(temp, m_epsilon, m_rho, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    BN_mod_mul(temp, temp, m_global_key_share, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    BN_mod_add(z_i_mac, z_i_mac, temp, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-}
-
-void Party::generateBatchZeroShare(ShareType zeroShare) {
+template <typename Security>
+void Party<Security>::generateBatchZeroShare(const std::vector<ShareType> &coefficients, ShareType zeroShare) {
     // check if zeroShare is null
     if (!zeroShare) throw std::runtime_error("zeroShare is null.");
-    BN_zero(zeroShare);
-    std::cout << "The value of zeroShare is: " << BN_bn2dec(zeroShare) << "\n";
-    ShareType temp = AdditiveSecretSharing::newBigInt();
-    // m_receivedMacShares[0] - myTripleMac.a
-    BN_mod_sub(temp, m_receivedMacShares[0], myTripleMac.a, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    // r_epsilon * (m_receivedMacShares[0] - myTripleMac.a)
-    BN_mod_mul(temp, m_agreed_random_values[0], temp, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    // zeroShare += temp
-    BN_mod_add(zeroShare, zeroShare, temp, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    // m_receivedMacShares[1] - myTripleMac.b
-    BN_mod_sub(temp, m_receivedMacShares[1], myTripleMac.b, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    // r_rho * (m_receivedMacShares[0] - myTripleMac.a)
-    BN_mod_mul(temp, m_agreed_random_values[1], temp, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    // zeroShare += temp
-    BN_mod_add(zeroShare, zeroShare, temp, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    // r_epsilon * m_epsilon
-    BN_mod_mul(temp, m_agreed_random_values[0], m_epsilon, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    // ShareType temp2 = AdditiveSecretSharing::newBigInt() \gets r_rho * m_rho
-    ShareType temp2 = AdditiveSecretSharing::newBigInt();
-    BN_mod_mul(temp2, m_agreed_random_values[1], m_rho, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    // temp += temp2
-    BN_mod_add(temp, temp, temp2, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    // temp *= m_global_mac_key_share
-    BN_mod_mul(temp, temp, m_global_key_share, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    // zeroShare -= temp
-    BN_mod_sub(zeroShare, zeroShare, temp, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
-    // Free the temporary ShareType
-    BN_free(temp2);
-    BN_free(temp);
-}
-#endif
\ No newline at end of file
+    if (coefficients.size() != m_openedLog.size()) {
+        throw std::runtime_error("generateBatchZeroShare: one coefficient per opened value is needed");
+    }
+    // Every party walks the same log in the same order; sums stay unreduced until the end
+    BN_CTX* ctx = AdditiveSecretSharing::getCtx();
+    const BIGNUM* prime = AdditiveSecretSharing::getPrime();
+    BigIntScratch scratch(ctx);
+    ShareType valueSum = scratch.get();
+    ShareType macSum = scratch.get();
+    ShareType temp = scratch.get();
+    for (SIZE_T k = 0; k < m_openedLog.size(); ++k) {
+        if (!BN_mul(temp, coefficients[k], m_openedLog[k], ctx) || !BN_add(valueSum, valueSum, temp) ||
+            !BN_mul(temp, coefficients[k], m_openedMacLog[k], ctx) || !BN_add(macSum, macSum, temp)) {
+            throw std::runtime_error("BN_mul/BN_add failed for the batch zero share");
+        }
+    }
+    // zeroShare = sum r_k * mac_k - (sum r_k * v_k) * alpha_i
+    if (!BN_nnmod(valueSum, valueSum, prime, ctx) || !BN_mod_mul(temp, valueSum, m_global_key_share, prime, ctx) ||
+        !BN_nnmod(macSum, macSum, prime, ctx) || !BN_mod_sub(zeroShare, macSum, temp, prime, ctx)) {
+        throw std::runtime_error("BN_nnmod/BN_mod_sub failed for the batch zero share");
+    }
+}
+
+// Hash commitment of party pid to data; the id keeps a party from replaying another's commitment
+static std::string commit(PARTY_ID_T pid, const std::string &data) {
+    return AdditiveSecretSharing::sha256(std::to_string(pid) + "|" + data);
+}
+
+template <typename Security>
+std::string Party<Security>::jointRandomSeed() {
+    std::vector<std::string> theirs;
+    if (m_peerSeedCommitments.empty()) {
+        // First use: one extra round to commit to the first seed shares
+        m_nextSeedShare = AdditiveSecretSharing::randomBytes(SEED_SHARE_SIZE);
+        this->exchangeWithPeers(commit(m_partyId, m_nextSeedShare), m_peerSeedCommitments);
+    }
+
+    // Reveal the committed share and commit to the next one in the same message
+    std::string seedShare = m_nextSeedShare;
+    m_nextSeedShare = AdditiveSecretSharing::randomBytes(SEED_SHARE_SIZE);
+    std::string nextCommitment = commit(m_partyId, m_nextSeedShare);
+    this->exchangeWithPeers(seedShare + nextCommitment, theirs);
+
+    std::string seedInput;
+    for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
+        if (theirs[pid].size() != SEED_SHARE_SIZE + nextCommitment.size()) {
+            throw std::runtime_error("Invalid seed reveal from Party " + std::to_string(pid));
+        }
+        std::string revealed = theirs[pid].substr(0, SEED_SHARE_SIZE);
+        if (commit(pid, revealed) != m_peerSeedCommitments[pid]) {
+            throw std::runtime_error("Seed share of Party " + std::to_string(pid) + " does not match its commitment");
+        }
+        seedInput += revealed;
+        m_peerSeedCommitments[pid] = theirs[pid].substr(SEED_SHARE_SIZE);
+    }
+    return AdditiveSecretSharing::sha256(seedInput);
+}
+
+template <typename Security>
+bool Party<Security>::runMacCheck() {
+    if (m_openedLog.empty()) return true;
+    // The coefficients are fixed only after every logged value has been opened
+    std::vector<ShareType> coefficients;
+    AdditiveSecretSharing::expandSeed(this->jointRandomSeed(), m_openedLog.size(), coefficients);
+    ShareType sigma = AdditiveSecretSharing::newBigInt();
+    this->generateBatchZeroShare(coefficients, sigma);
+    for (auto bn : coefficients) BN_free(bn);
+    // A fresh zero share hides this party's sigma, which depends on its key share
+    std::vector<ShareType> masked{sigma};
+    this->addZeroShares(masked);
+    // The check value is opened among all parties even in king mode, where a king could report
+    // zero, and committed to first, or the party that sends last could cancel the others' sigmas
+    Share total = Share::zero();
+    this->openCommitted(sigma, total.get());
+    bool valid = BN_is_zero(total.get());
+    LOG_DEBUG("[Party ", m_partyId, "] MAC check over ", m_openedLog.size(), " openings: ", (valid ? "passed" : "FAILED"));
+    m_openedLog.clear();
+    m_openedMacLog.clear();
+    BN_free(sigma);
+    return valid;
+}
+
+template <typename Security>
+void Party<Security>::openCommitted(ShareType mine, ShareType sum) {
+    // A random nonce keeps the commitment hiding however few values mine can take
+    std::string opening = AdditiveSecretSharing::randomBytes(SEED_SHARE_SIZE);
+    opening.resize(SEED_SHARE_SIZE + encodedSharesSize(1));
+    encodeShares({mine}, &opening[SEED_SHARE_SIZE]);
+    std::vector<std::string> commitments;
+    this->exchangeWithPeers(commit(m_partyId, opening), commitments);
+    // Every commitment is in before anything is revealed
+    std::vector<std::string> openings;
+    this->exchangeWithPeers(opening, openings);
+
+    std::vector<ShareType> value;
+    BN_zero(sum);
+    for (PARTY_ID_T pid = 1; pid <= m_totalParties; ++pid) {
+        if (openings[pid].size() != opening.size() || commit(pid, openings[pid]) != commitments[pid] ||
+            decodeShares(openings[pid].data() + SEED_SHARE_SIZE, encodedSharesSize(1), value) != 1) {
+            for (auto bn : value) BN_free(bn);
+            throw std::runtime_error("Opening of Party " + std::to_string(pid) + " does not match its commitment");
+        }
+        BN_mod_add(sum, sum, value[0], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+    }
+    for (auto bn : value) BN_free(bn);
+}
+
+template <typename Security>
+void Party<Security>::recordOutput(ShareType value, ShareType mac) {
+    m_outputLog.emplace_back(AdditiveSecretSharing::cloneBigInt(value));
+    m_outputMacLog.emplace_back(AdditiveSecretSharing::cloneBigInt(mac));
+}
+
+template <typename Security>
+bool Party<Security>::checkOutputMacs() {
+    // sum r_k * (mac_k - alpha * v_k) with fresh coefficients only the dealer knows
+    BN_CTX* ctx = AdditiveSecretSharing::getCtx();
+    const BIGNUM* prime = AdditiveSecretSharing::getPrime();
+    BigIntScratch scratch(ctx);
+    ShareType coefficient = scratch.get();
+    ShareType valueSum = scratch.get();
+    ShareType macSum = scratch.get();
+    ShareType temp = scratch.get();
+    for (SIZE_T k = 0; k < m_outputLog.size(); ++k) {
+        if (!BN_rand_range(coefficient, prime) ||
+            !BN_mul(temp, coefficient, m_outputLog[k], ctx) || !BN_add(valueSum, valueSum, temp) ||
+            !BN_mul(temp, coefficient, m_outputMacLog[k], ctx) || !BN_add(macSum, macSum, temp)) {
+            throw std::runtime_error("BN_mul/BN_add failed for the output MAC check");
+        }
+    }
+    if (!BN_mod_mul(temp, valueSum, m_global_mac_key, prime, ctx) || !BN_nnmod(macSum, macSum, prime, ctx)) {
+        throw std::runtime_error("BN_mod_mul/BN_nnmod failed for the output MAC check");
+    }
+    bool valid = BN_cmp(temp, macSum) == 0;
+    m_outputLog.clear();
+    m_outputMacLog.clear();
+    return valid;
+}
+std::unique_ptr<IParty> IParty::create(SecurityMode security, PARTY_ID_T id, int totalParties, int localValue,
+                                       INetIOMP* comm, bool hasSecret, const std::string& operation)
+{
+    switch (security) {
+        case SecurityMode::SEMI_HONEST:
+            return std::make_unique<Party<SemiHonestSecurity>>(id, totalParties, localValue, comm, hasSecret, operation);
+        case SecurityMode::MALICIOUS:
+            return std::make_unique<Party<MaliciousSecurity>>(id, totalParties, localValue, comm, hasSecret, operation);
+    }
+    throw std::invalid_argument("Unknown security mode");
+}
+
+std::string IParty::securityModeName(SecurityMode security)
+{
+    return security == SecurityMode::SEMI_HONEST ? "semihonest" : "malicious";
+}
+
+SecurityMode IParty::securityModeFromName(const std::string& name)
+{
+    if (name == "semihonest") return SecurityMode::SEMI_HONEST;
+    if (name == "malicious") return SecurityMode::MALICIOUS;
+    throw std::invalid_argument("Unknown security mode: " + name);
+}
+
+template class Party<SemiHonestSecurity>;
+template class Party<MaliciousSecurity>;
@@ -2,20 +2,83 @@
 #include "INetIOMP.h"
 #include <vector>
 #include <map>
+#include <memory>
+#include <functional>
 #include <unordered_map>
 #include <iostream>
 #include <thread>   // Add this for std::this_thread
 #include <chrono>   // Add this for std::chrono
 #include "AdditiveSecretSharing.h" // incorporate big-int sharing
+#include "BufferPool.h"
+#include "Circuit.h"
+#include "Logger.h"
+#include "PartitionGroup.h"
+#include "PhaseStats.h"
+#include "Prss.h"
+#include "ResultSink.h"
+#include "Topology.h"
 #include <string> // Add this for string operations
 #include "config.h" // Include config.h for COUT macro
 #include <openssl/bn.h> // Ensure BIGNUM is included
 
 /**
- * @brief Represents an individual party in the MPC protocol.
+ * @brief Security policies Party is instantiated with. Semi-honest parties skip every
+ *        MAC: no MAC shares are generated, sent, opened or checked.
+ */
+struct SemiHonestSecurity {
+    static constexpr bool MALICIOUS = false;
+    static constexpr SecurityMode MODE = SecurityMode::SEMI_HONEST;
+};
+
+// SPDZ-style MACs under a global key, verified by batched MAC checks
+struct MaliciousSecurity {
+    static constexpr bool MALICIOUS = true;
+    static constexpr SecurityMode MODE = SecurityMode::MALICIOUS;
+};
+
+/**
+ * @brief What main needs of a party, independent of its security policy.
  */
+class IParty {
+public:
+    virtual ~IParty() = default;
+
+    /**
+     * @brief Creates a party for the given security mode; every party of a job must use the same one.
+     * @throws std::invalid_argument for an unknown mode.
+     */
+    static std::unique_ptr<IParty> create(SecurityMode security, PARTY_ID_T id, int totalParties, int localValue,
+                                          INetIOMP* comm, bool hasSecret, const std::string& operation);
+
+    // Command-line name of a mode ("semihonest", "malicious")
+    static std::string securityModeName(SecurityMode security);
+
+    /**
+     * @brief Parses a name returned by securityModeName.
+     * @throws std::invalid_argument for any other name.
+     */
+    static SecurityMode securityModeFromName(const std::string& name);
+
+    virtual SecurityMode securityMode() const = 0;
+    virtual void init() = 0;
+    virtual void setOpeningMode(OpeningMode mode) = 0;
+    virtual void setPartitionGroup(PartitionGroup* group) = 0;
+    virtual void setPhaseStats(PhaseStats* stats) = 0;
+    virtual void setBatchSize(SIZE_T batchSize) = 0;
+    virtual SIZE_T batchSize() const = 0;
+    virtual void setInputFile(const std::string& path, SIZE_T chunkValues) = 0;
+    virtual void setOutputParty(PARTY_ID_T party) = 0;
+    virtual void setResultFile(const std::string& path) = 0;
+    virtual void setNumInputParties(SIZE_T inputParties) = 0;
+};
 
-class Party {
+/**
+ * @brief Represents an individual party in the MPC protocol.
+ * @tparam Security SemiHonestSecurity or MaliciousSecurity; both are instantiated in
+ *         Party.cpp, so one binary runs either kind of job.
+ */
+template <typename Security>
+class Party : public IParty {
 public:
     Party(PARTY_ID_T id, int totalParties, int localValue, INetIOMP* comm,
           bool hasSecret, const std::string& operation)
@@ -23,45 +86,27 @@ public:
           m_comm(comm), m_hasSecret(hasSecret), m_operation(operation) {
             // Party5_to_1
             m_dealRouterId = "Party" + std::to_string(m_totalParties + 1) + "_to_" + std::to_string(m_partyId);
-            m_receivedShares.reserve(NUM_SECRETS);
-            m_receivedShares.resize(NUM_SECRETS);
-            m_z_i = AdditiveSecretSharing::newBigInt();
-            #if defined(ENABLE_MALICIOUS_SECURITY)
-                m_macShares.resize(NUM_SECRETS);
-                m_global_mac_key = AdditiveSecretSharing::newBigInt();
-                m_addition_partial_sum.resize(NUM_TWO);
-                for (int i = 0; i < NUM_TWO; ++i) {
-                    m_addition_partial_sum[i].resize(m_totalParties);
-                }
-                m_secret_sum = AdditiveSecretSharing::newBigInt();
-                m_secret_sum_mac = AdditiveSecretSharing::newBigInt();
-                m_epsilon = AdditiveSecretSharing::newBigInt();
-                m_rho = AdditiveSecretSharing::newBigInt();
-                m_z_i_mac = AdditiveSecretSharing::newBigInt();
-                m_global_key_share = AdditiveSecretSharing::newBigInt();
-                m_receivedMultiplicationMacShares.resize(m_totalParties);
-                m_receivedMultiplicationSigmaShares.resize(m_totalParties);
-                m_sigma = AdditiveSecretSharing::newBigInt();
-                m_agreed_random_values[0] = AdditiveSecretSharing::newBigInt();
-                BN_dec2bn(&m_agreed_random_values[0], "334719540603455070832504601639945548232");
-                m_agreed_random_values[1] = AdditiveSecretSharing::newBigInt();
-                BN_dec2bn(&m_agreed_random_values[1], "8652507094118376787948708224805105047");
-                    // Check the random values
-                    #if defined(ENABLE_UNIT_TESTS)
-                    for (auto &randomValue : m_agreed_random_values) {
-                        std::cout << "[Party] Random value: " << BN_bn2dec(randomValue) << "\n";
-                    }
-                    #endif
-            #endif // ENABLE_MALICIOUS_SECURITY
-            m_secrets.resize(NUM_SECRETS);
+            m_inner_product = Share::zero();
+            if constexpr (Security::MALICIOUS) {
+                m_global_mac_key = Share::zero();
+                m_inner_product_mac = Share::zero();
+                m_global_key_share = Share::zero();
+            }
+            if (m_totalParties >= TREE_OPENING_MIN_PARTIES) {
+                m_openingMode = OpeningMode::TREE;
+            } else if (m_totalParties >= KING_OPENING_MIN_PARTIES) {
+                m_openingMode = OpeningMode::KING;
+            }
           }
     // Destructor to free the BIGNUMs
-    ~Party();
+    ~Party() override;
+
+    SecurityMode securityMode() const override { return Security::MODE; }
 
     /**
      * @brief Initializes any necessary communication steps (already done in main usually).
      */
-    void init();
+    void init() override;
     void broadcastAllData(const void* data, LENGTH_T length);
     void receiveAllData(void* data, LENGTH_T length);
     /**
@@ -71,11 +116,7 @@ public:
         for (int i = 1; i <= m_totalParties; ++i) {
             if (i != m_partyId) {
                 m_comm->sendTo(i, &m_localValue, sizeof(int));
-                #ifdef ENABLE_COUT
-                std::cout << "[Party " << m_partyId 
-                          << "] Sent local value " << m_localValue 
-                          << " to Party " << i << "\n";
-                #endif
+                LOG_TRACE("[Party ", m_partyId, "] Sent local value ", m_localValue, " to Party ", i);
             }
         }
     }
@@ -94,23 +135,14 @@ public:
             m_comm->receive(senderId, &receivedValue, sizeof(receivedValue));
             sum += receivedValue;
             receivedCount++;
-            #ifdef ENABLE_COUT
-            std::cout << "[Party " << m_partyId 
-                      << "] Received value " << receivedValue 
-                      << " from Party " << senderId << "\n";
-            #endif
+            LOG_TRACE("[Party ", m_partyId, "] Received value ", receivedValue, " from Party ", senderId);
         }
-        #ifdef ENABLE_COUT
-        std::cout << "[Party " << m_partyId 
-                  << "] Computed total sum: " << sum << "\n";
-        #endif
+        LOG_TRACE("[Party ", m_partyId, "] Computed total sum: ", sum);
         return sum;
     }
 
     void broadcastShares(const std::vector<ShareType> &shares);
     void receiveShares(std::vector<ShareType> &received, int expectedCount);
-    void secureMultiplyShares(ShareType myShareX, ShareType myShareY,
-                              const BeaverTriple &myTripleShare, ShareType &productOut);
 
     /**
      * @brief Broadcasts this party's partial sum to all other parties.
@@ -134,48 +166,201 @@ public:
     // Each party generates shares for its own secret and sends them out
     void distributeOwnShares();
 
-    // Each party receives shares from all other parties
-    void gatherAllShares();
-
-    // Reconstruct all secrets from the shares and compute global sum
-    void computeGlobalSumOfSecrets();
-
-    // // A placeholder for multi-party multiplication with beaver
-    // void doMultiplicationDemo();
-
     // Declare the new methods
     void distributeSharesAndComputeMyPartial();
     void broadcastAndReconstructGlobalSum();
 
-    // Comment out or remove old global-sharing methods
-    // void broadcastAllHeldShares();
-    // void gatherAllShares();
-    // void computeGlobalSumOfSecrets();
-    // void doMultiplicationDemo();
+    /**
+     * @brief Computes shares of x[k] * y[k] for every k with one opening of all D and E
+     *        values, consuming the first x.size() triples of myTriples.
+     * @param x This party's shares of the left factors.
+     * @param y This party's shares of the right factors.
+     * @param xMacs MAC shares of x (ignored by semi-honest parties).
+     * @param yMacs MAC shares of y (ignored by semi-honest parties).
+     * @param z Output shares of the products.
+     * @param zMacs MAC shares of the products (left empty by semi-honest parties).
+     */
+    void doMultiplication(const std::vector<ShareType> &x, const std::vector<ShareType> &y,
+                          const std::vector<ShareType> &xMacs, const std::vector<ShareType> &yMacs,
+                          std::vector<Share> &z, std::vector<Share> &zMacs);
+
+    // Inner-product correlation [a], [b], [c=<a,b>] and its MAC shares
+    InnerProductTriple myInnerProductTriple;
+    // MaliciousSecurity only
+    InnerProductTriple myInnerProductTripleMac;
+
+    // Dealer side: distribute an inner-product triple of the given length
+    void distributeInnerProductTriple(SIZE_T length);
+
+    // Receive this party's inner-product triple shares from the dealer
+    void receiveInnerProductTriple(SIZE_T length);
+
+    /**
+     * @brief Computes a share of <x, y> with a single opening of all D and E values.
+     * @param x This party's shares of the first vector.
+     * @param y This party's shares of the second vector.
+     * @param xMacs MAC shares of x (ignored by semi-honest parties).
+     * @param yMacs MAC shares of y (ignored by semi-honest parties).
+     * @param z_i Output share of the inner product (its MAC lands in m_inner_product_mac).
+     */
+    void doInnerProduct(const std::vector<ShareType> &x, const std::vector<ShareType> &y,
+                        const std::vector<ShareType> &xMacs, const std::vector<ShareType> &yMacs, ShareType z_i);
+
+    /**
+     * @brief Partially opens a batch of shares in one round: every party sends all of
+     *        its shares in one message to every other party and sums what it receives.
+     *        Malicious parties log every opened value with its MAC
+     *        share and verified later by one batched check (see runMacCheck).
+     * @param myShares This party's shares of the values to open.
+     * @param myMacShares MAC shares of the same values; empty skips the log.
+     * @param opened Output opened values (caller frees).
+     */
+    void openValues(const std::vector<ShareType> &myShares, const std::vector<ShareType> &myMacShares,
+                    std::vector<ShareType> &opened);
+
+    /**
+     * @brief Selects how openValues and result collection move shares:
+     *        ALL_TO_ALL: n(n-1) messages, one hop.
+     *        KING: KING_PARTY_ID reconstructs and sends the values back; 2(n-1) messages, two hops.
+     *        TREE: partial sums are added up a TREE_ARITY-ary tree and the values come back
+     *              down it; 2(n-1) messages, fan-in TREE_ARITY, 2 log_k(n) hops.
+     *        A lying king or interior node is caught by the batched MAC check. The default
+     *        follows KING_OPENING_MIN_PARTIES and TREE_OPENING_MIN_PARTIES; the dealer and
+     *        all compute parties must use the same mode.
+     */
+    void setOpeningMode(OpeningMode mode) override { m_openingMode = mode; }
+
+    /**
+     * @brief Makes this process one partition of its logical party. A partitioned dealer
+     *        holds slice q of the inputs (values offset by q * batchSize()) and adds the
+     *        sum and the inner product of all partitions up in partition 0.
+     * @param group Control channel of the partitions; must outlive the party.
+     */
+    void setPartitionGroup(PartitionGroup* group) override { m_partitionGroup = group; }
+
+    /**
+     * @brief Records the wall time and traffic of every protocol phase this party runs.
+     *        The dealer times whole phases; compute parties time their part of each.
+     * @param stats Must outlive the party; nullptr (the default) records nothing.
+     */
+    void setPhaseStats(PhaseStats* stats) override { m_phaseStats = stats; }
+
+    /**
+     * @brief Number of inputs the dealer shares (DEFAULT_BATCH_SIZE unless set). The
+     *        dealer announces it with CMD_SEND_SHARES, next to its security mode, so
+     *        compute parties take it over and only the dealer's setting matters. A party
+     *        of another security mode rejects the shares and the job aborts.
+     * @throws std::invalid_argument below 2, the smallest batch the multiplication takes.
+     */
+    void setBatchSize(SIZE_T batchSize) override;
+    SIZE_T batchSize() const override { return m_batchSize; }
+
+    /**
+     * @brief Makes the dealer share the values of a file instead of generating a batch.
+     *        The file is streamed in chunks of chunkValues values, each shared and sent
+     *        as one message per party while the next chunk is read (see InputLoader).
+     *        Parties fold every chunk into a running sum, so only the addition phase and
+     *        the MAC check run, and the batch size becomes the number of values streamed.
+     * @param path Binary file of uint64 values, or CSV when it ends in ".csv".
+     */
+    void setInputFile(const std::string& path, SIZE_T chunkValues) override {
+        m_inputPath = path;
+        m_inputChunkValues = chunkValues;
+    }
+
+    /**
+     * @brief Reveals results only to the given compute party: every party sends its
+     *        result shares straight to it instead of to the dealer, so the dealer and
+     *        the other parties never see a reconstructed value. In malicious jobs no
+     *        shares are sent: the parties open each result minus a mask only the output
+     *        party knows, with its MAC (see revealMaskedResults). 0 (the default) reveals
+     *        to the dealer.
+     *        The dealer and all compute parties must use the same output party.
+     * @throws std::invalid_argument for an id above the number of compute parties.
+     */
+    void setOutputParty(PARTY_ID_T party) override;
+    PARTY_ID_T outputParty() const { return m_outputParty; }
+
+    /**
+     * @brief Streams this party's results to a file as each batch completes (see
+     *        ResultSink). The party that reconstructs, the dealer or the output party,
+     *        writes the values; any other compute party writes its re-randomized result
+     *        shares, which add up to the values across the parties' files.
+     * @throws std::runtime_error when the file cannot be created.
+     */
+    void setResultFile(const std::string& path) override;
+
+    /**
+     * @brief Number of input parties, ids n+1 .. n+inputParties. Party n+1, the dealer,
+     *        still drives the protocol; the others only share their inputs, concurrently
+     *        and straight to the compute parties (see contributeInputs). Their inputs
+     *        follow the dealer's, in party order. Only the dealer's setting matters.
+     * @throws std::invalid_argument for 0.
+     */
+    void setNumInputParties(SIZE_T inputParties) override;
+
+    // Batch of Beaver triples for circuit evaluation and their MAC shares
+    std::vector<BeaverTriple> myTriples;
+    // MaliciousSecurity only
+    std::vector<BeaverTriple> myTriplesMac;
+
+    // Dealer side: distribute count independent Beaver triples in one message per party
+    void distributeBeaverTriples(SIZE_T count);
+
+    // Receive a batch of count Beaver triples from the dealer
+    void receiveBeaverTriples(SIZE_T count);
+
+    /**
+     * @brief Evaluates a circuit layer by layer: local gates cost nothing and all
+     *        multiplications of one layer share a single batched Beaver opening,
+     *        so the number of rounds equals the multiplicative depth.
+     * @param circuit The circuit to evaluate (all parties must hold the same one).
+     * @param inputs This party's shares of the circuit inputs.
+     * @param inputMacs MAC shares of the inputs (ignored by semi-honest parties).
+     * @param outputs Output shares, in the order the outputs were added (caller frees).
+     * @param outputMacs MAC shares of the outputs (left empty by semi-honest parties).
+     */
+    void evaluateCircuit(const Circuit &circuit, const std::vector<ShareType> &inputs,
+                         const std::vector<ShareType> &inputMacs, std::vector<ShareType> &outputs,
+                         std::vector<ShareType> &outputMacs);
 
-    // A place to store the triple share we receive
-    BeaverTriple myTriple;
-    // A place to store the triple mac share we receive
-    #if defined(ENABLE_MALICIOUS_SECURITY)
-    BeaverTriple myTripleMac;
-    #endif // ENABLE_MALICIOUS_SECURITY
+    // Matrix triple [A], [B], [C=AB] and its MAC shares
+    MatrixTriple myMatrixTriple;
+    // MaliciousSecurity only
+    MatrixTriple myMatrixTripleMac;
 
-    // Distribute a random triple [a], [b], [c=a*b] among all parties
-    void distributeBeaverTriple();
+    // Dealer side: distribute a (rows x inner) * (inner x cols) matrix triple
+    void distributeMatrixTriple(SIZE_T rows, SIZE_T inner, SIZE_T cols);
 
-    // Receive triple shares from the designated "dealer" or from each party
-    void receiveBeaverTriple();
+    // Receive this party's matrix triple shares from the dealer
+    void receiveMatrixTriple(SIZE_T rows, SIZE_T inner, SIZE_T cols);
+
+    /**
+     * @brief Computes shares of X * Y, opening only rows*inner + inner*cols values in one round.
+     * @param X This party's shares of the left matrix (row-major).
+     * @param Y This party's shares of the right matrix (row-major).
+     * @param XMacs MAC shares of X (ignored by semi-honest parties).
+     * @param YMacs MAC shares of Y (ignored by semi-honest parties).
+     * @param Z Output shares of the product (its MACs land in m_matrix_product_mac).
+     */
+    void doMatrixMultiplication(const std::vector<ShareType> &X, const std::vector<ShareType> &Y,
+                                const std::vector<ShareType> &XMacs, const std::vector<ShareType> &YMacs,
+                                std::vector<ShareType> &Z);
 
-    // Perform a single “demo” multiply of (x,y) using the triple
-    // and reconstruct final product
-    void doMultiplicationDemo(ShareType &z_i);
+    /**
+     * @brief Largest square d x d times d x d product that fits in numInputs secrets.
+     */
+    static void matrixDimsForInputs(SIZE_T numInputs, SIZE_T &rows, SIZE_T &inner, SIZE_T &cols);
 
     // Add these two methods
     void runEventLoop();
     void handleMessage(PARTY_ID_T senderId, const void *data, LENGTH_T length);
 
-    void generateMyShares(const std::vector<ShareType> &secretValues,
-                          std::unordered_map<ShareType, std::vector<ShareType>> &secretSharesMap);
+    /**
+     * @brief Splits every secret into one share per compute party.
+     * @param shares Output; shares[i][pid - 1] is Party pid's share of secretValues[i].
+     */
+    void generateMyShares(const std::vector<ShareType> &secretValues, std::vector<std::vector<Share>> &shares);
 
 private:
     PARTY_ID_T m_partyId;
@@ -196,44 +381,279 @@ private:
 
     // Helper to receive a single BN from one party
     BIGNUM* receiveBN(PARTY_ID_T& sender);
+
+    /**
+     * @brief One round in which every party sends the same message to all peers.
+     * @param mine This party's message.
+     * @param theirs Output indexed by party id; theirs[m_partyId] is mine.
+     */
+    void exchangeWithPeers(const std::string &mine, std::vector<std::string> &theirs);
+
+    // Send a tagged peer message
+    void sendToPeer(PARTY_ID_T peer, const std::string &payload);
+
+    // Send a batch of shares as a tagged peer message
+    void sendSharesToPeer(PARTY_ID_T peer, const std::vector<ShareType> &shares);
+
+    // Encode a batch of shares into a pooled send buffer, behind the CMD_PARTIAL_OPEN tag if tagged
+    PooledBuffer encodeBatch(const std::vector<ShareType> &shares, bool tagged);
+
+    // Payload of the next tagged message from the given peer
+    std::string receiveFromPeer(PARTY_ID_T peer);
+
+    /**
+     * @brief Receives the next batch from the given peer and decodes it into out.
+     * @param count Number of shares the batch must hold.
+     * @param out Reused as in decodeShares; out[0 .. count) holds the batch.
+     */
+    void receiveSharesFromPeer(PARTY_ID_T peer, SIZE_T count, std::vector<ShareType> &out);
+
+    // Next tagged message from the given peer, tag included; messages from other peers are kept for later
+    PooledBuffer nextPeerMessage(PARTY_ID_T peer);
+
+    // Next message from anyone in a pooled buffer of its own size; empty if nothing arrived
+    PooledBuffer receiveMessage(PARTY_ID_T &senderId);
+
+    // Keep a peer message that arrived before this party asked for it
+    void keepPeerMessage(PARTY_ID_T senderId, const char* bytes, SIZE_T length);
+
+    // Opening strategies behind openValues(); both return the opened values (caller frees)
+    void openAllToAll(const std::vector<ShareType> &myShares, std::vector<ShareType> &opened);
+    void openViaKing(const std::vector<ShareType> &myShares, std::vector<ShareType> &opened);
+    void openViaTree(const std::vector<ShareType> &myShares, std::vector<ShareType> &opened);
+
+    /**
+     * @brief Re-randomizes this party's result shares and hands them to the dealer. In TREE
+     *        mode the dealer is the root of a TREE_ARITY-ary tree over the compute parties:
+     *        each party adds its children's partial sums to its own before passing them up,
+     *        so no party ever holds more than a random subtree sum.
+     */
+    void sendResultsToDealer(std::vector<ShareType> &shares);
+
+    // Result shares go straight to m_outputParty, which confirms to the dealer; malicious results are masked
+    void sendResultsToOutputParty(std::vector<ShareType> &shares);
+    /**
+     * @brief MaliciousSecurity only: reveals results to m_outputParty through masks. The dealer
+     *        shares a random [r] with its MAC per result and sends r to the output party alone;
+     *        v - r is opened with its MAC and checked with runMacCheck, and only then does the
+     *        output party add r. Every party reports the check to the dealer.
+     * @param shares The result values followed by their MACs.
+     */
+    void revealMaskedResults(const std::vector<ShareType> &shares);
+    // Output party: write the reconstructed results to the result file and the log
+    void writeOutputs(const std::vector<ShareType> &values);
+
+    // Agree on the pairwise PRSS keys with every peer (one round)
+    void setupPrss();
+
+    // Re-randomize shares with fresh PRSS zero shares so only their sum carries information
+    void addZeroShares(std::vector<ShareType> &shares);
+
+    // Receive the next dealer message, keeping early peer openings for openValues()
+    PooledBuffer receiveFromDealer();
+
+    // Release the shares held by an inner-product triple
+    void freeInnerProductTriple(InnerProductTriple &triple);
+
+    // Release the shares held by a matrix triple
+    void freeMatrixTriple(MatrixTriple &triple);
+
+    // Dealer side: wait for CMD_SUCCESS from every party after a distribution step. If any
+    // party replies otherwise, the others are shut down and the step throws
+    void syncAfterDealerStep(const char* step);
+
+    // Compute party side: drop the dealer's share message, reply CMD_SHARES_REJECTED and throw
+    [[noreturn]] void rejectDealerShares(const std::string &reason);
+
+    // Dealer side: share batchSize() generated inputs in one message per party
+    void distributeInputs();
+    // Dealer side: share the values of the input file chunk by chunk
+    void distributeInputStream();
+    // Dealer side: share one chunk of values in one message per party and wait for the acks
+    void distributeInputChunk(SIZE_T chunkIndex, const std::vector<uint64_t> &values);
+    // Dealer side: MAC check (malicious only) and shutdown of the compute parties
+    void finishDealerJob();
+    // Dealer side: have the compute parties merge the other input parties' inputs
+    void collectInputs();
+    // Dealer side: stop the job unless every compute party took the same x - r from the input parties
+    void checkInputOpenings();
+    // Dealer side: share every value (and its MAC) in one message per party, the MAC key share
+    // last; unauthenticated values are shared alone, in either security mode
+    void sendValueShares(const std::vector<Share> &values, bool authenticated = true);
+
+    /**
+     * @brief Input party other than the dealer: shares batchSize() generated values, or the
+     *        input file, straight to the compute parties in CMD_INPUT_SHARES messages and
+     *        waits until each of them has taken them. Malicious jobs take no shares of
+     *        inputs; the inputs are masked and opened instead (see openInputs).
+     */
+    void contributeInputs();
+    /**
+     * @brief MaliciousSecurity only: announces the inputs in CMD_INPUT_MASKS, sums the masks
+     *        r the compute parties relay and opens x - r to all of them in CMD_INPUT_OPENED
+     *        messages. Each r_k comes with a random beta_k and t_k = beta_k * r_k, all three
+     *        shared; the masks are only used if t_k matches. A streamed file is one input,
+     *        its sum.
+     * @return Number of values the inputs stand for.
+     */
+    SIZE_T openInputs();
+    // Share count values in one CMD_INPUT_SHARES message per compute party; fold asks for their sum only
+    void sendInputShares(const uint64_t* values, SIZE_T count, bool fold);
+    // Take a message of an input party other than the dealer; false for anyone else's message
+    bool takeInputMessage(PARTY_ID_T senderId, const char* bytes, SIZE_T length);
+    // Reply to an input party after the dealer on its DEALER socket
+    void replyToInputParty(PARTY_ID_T pid, const void* data, LENGTH_T length);
+    // Take input-party messages until every input party after the dealer is done, or with
+    // announced, has at least announced its inputs
+    void waitForInputs(SIZE_T extraParties, bool announced);
+    /**
+     * @brief Waits for the input parties after the dealer and counts their inputs into
+     *        counts: [inputs][values they stand for]. Semi-honest jobs append the inputs
+     *        to m_receivedShares in party order, a streamed file as its sum; malicious
+     *        jobs count what was announced and leave the inputs to authenticateInputs.
+     * @return False if an input party sent what this job's security mode does not take.
+     */
+    bool mergeInputs(SIZE_T extraParties, SIZE_T counts[2]);
+    // Tell input parties still waiting for masks that the job takes no inputs, and forget them all
+    void rejectInputParties();
+    /**
+     * @brief MaliciousSecurity only: appends the count announced inputs with their MAC
+     *        shares. The dealer shares a random [r] with its MAC per input, which is relayed
+     *        to its input party only; that party opens x - r itself, so
+     *        [x] = [r] + (x - r) and mac(x) = mac(r) + (x - r) * alpha. No compute party
+     *        holds shares of x before that, so none can shift x. Replies the SHA-256 of the
+     *        openings to the dealer, which stops the job unless all parties took the same.
+     */
+    void authenticateInputs(SIZE_T extraParties, SIZE_T count);
+    // Reply to the dealer, whoever sent the last message
+    void replyToDealer(const void* data, LENGTH_T length);
+
+    // Dealer side: collect count result shares (and MACs) from the parties, log them for the MAC check
+    // and reconstruct; the reconstructed MACs go to macs when it is given. With an output
+    // party both stay empty and only its confirmation is received
+    void receiveAndReconstructResults(SIZE_T count, std::vector<ShareType> &results,
+                                      std::vector<ShareType> *macs = nullptr);
     
-    #if defined(ENABLE_MALICIOUS_SECURITY)
-    // Helper to generate the MAC key for the multiplication
-    void generateZmac(ShareType z_i_mac);
-    void generateBatchZeroShare(ShareType zeroShare);
-    #endif // ENABLE_MALICIOUS_SECURITY
+    // MaliciousSecurity only
+    // Share of sum_k r_k * (mac(v_k) - alpha * v_k) over the opened-value log; zero if all MACs hold
+    void generateBatchZeroShare(const std::vector<ShareType> &coefficients, ShareType zeroShare);
+    /**
+     * @brief Commit-then-reveal coin toss among the compute parties. Each party reveals
+     *        the seed share it committed to last time together with a commitment to the
+     *        next one, so after the first call a seed costs a single round.
+     * @return SHA-256 of all revealed shares in party order.
+     */
+    std::string jointRandomSeed();
+    /**
+     * @brief Opens the sum of one value per compute party by commit-then-reveal: hash
+     *        commitments are exchanged first and the values only once all of them are in,
+     *        so no party can choose its value after seeing the others'. Throws if a
+     *        revealed value does not match its commitment.
+     */
+    void openCommitted(ShareType mine, ShareType sum);
+    // Open the batch zero share of every logged opening and clear the log; false if a MAC is wrong
+    bool runMacCheck();
+    // Dealer side: keep a reconstructed output and its MAC for the final check
+    void recordOutput(ShareType value, ShareType mac);
+    // Dealer side: one random linear combination over all recorded outputs; false if a MAC is wrong
+    bool checkOutputMacs();
 
     bool m_hasSecret;              // Indicates if this party holds a secret
     std::string m_operation;       // "add" or "mul"
     CMD_T m_cmd;
     bool m_running = true;
-    std::vector<ShareType> m_receivedShares;
-    #if defined(ENABLE_MALICIOUS_SECURITY)
-    std::vector<ShareType> m_receivedMacShares;
-    #endif // ENABLE_MALICIOUS_SECURITY
-    std::vector<ShareType> m_receivedMultiplicationShares;
-    #if defined(ENABLE_MALICIOUS_SECURITY)
-    std::vector<ShareType> m_receivedMultiplicationMacShares;
-    std::vector<ShareType> m_receivedMultiplicationSigmaShares;
-    #endif // ENABLE_MALICIOUS_SECURITY
-    ShareType m_z_i;
-    #if defined(ENABLE_MALICIOUS_SECURITY)
-    ShareType m_z_i_mac;
-    #endif // ENABLE_MALICIOUS_SECURITY
+    std::vector<Share> m_receivedShares;
+    // MaliciousSecurity only
+    std::vector<Share> m_receivedMacShares;
+    SIZE_T m_batchSize = DEFAULT_BATCH_SIZE;
+    // Input file streamed by the dealer; empty shares a generated batch
+    std::string m_inputPath;
+    SIZE_T m_inputChunkValues = INPUT_CHUNK_VALUES;
+    // Input parties n+1 .. n+m_numInputParties; only the dealer's value is used
+    SIZE_T m_numInputParties = DEFAULT_INPUT_PARTIES;
+    // Inputs of one input party after the dealer, merged on CMD_COLLECT_INPUTS
+    struct InputContribution {
+        std::vector<Share> shares; // inputs to append
+        Share sum;                 // or the running sum of a streamed file
+        SIZE_T values = 0;
+        // MaliciousSecurity only: the announced inputs and x - r of each, as opened
+        SIZE_T inputs = 0;
+        bool announced = false;
+        std::vector<Share> opened;
+        bool rejected = false;     // it sent what this job's security mode does not take
+        bool done = false;
+    };
+    std::map<PARTY_ID_T, InputContribution> m_contributions;
+    // Decoded input shares, reused across CMD_INPUT_SHARES messages
+    std::vector<ShareType> m_inputBatch;
+    // The dealer streamed its inputs, so m_receivedShares holds only their sum
+    bool m_foldedInputs = false;
+    // Compute party that alone reconstructs results; 0 is the dealer
+    PARTY_ID_T m_outputParty = 0;
+    // Where results or result shares are streamed; null keeps them in the log only
+    std::unique_ptr<ResultSink> m_resultSink;
+    // Shares of the element-wise products of the multiplication phase
+    std::vector<Share> m_products;
+    // MaliciousSecurity only
+    std::vector<Share> m_productMacs;
+    Share m_inner_product;
+    // MaliciousSecurity only
+    Share m_inner_product_mac;
+    std::vector<ShareType> m_matrix_product;
+    // MaliciousSecurity only
+    std::vector<ShareType> m_matrix_product_mac;
+    OpeningMode m_openingMode = OpeningMode::ALL_TO_ALL;
+    PartitionGroup* m_partitionGroup = nullptr;
+    PhaseStats* m_phaseStats = nullptr;
+
+    /**
+     * @brief Adds results that are sums over the inputs up across partitions and
+     *        prints the totals in partition 0. No-op without a partition group.
+     */
+    void reducePartitionResults(const char* label, std::vector<ShareType> &results);
+
+    /**
+     * @brief Number of slices forEachShard splits count elements into: one per pool
+     *        thread and the caller, but none shorter than PARALLEL_GRAIN elements.
+     */
+    static SIZE_T shardCount(SIZE_T count);
+
+    /**
+     * @brief Runs body(shard, begin, end) on the shardCount(count) slices of [0, count),
+     *        each with its own BN_CTX. Only the local arithmetic runs in parallel; the
+     *        I/O stays on this party's thread.
+     */
+    void forEachShard(SIZE_T count, const std::function<void(SIZE_T, SIZE_T, SIZE_T)> &body);
+
+    /**
+     * @brief innerProductShares with the sum split across shards and the c term
+     *        added once.
+     */
+    void shardedInnerProductShares(const std::vector<ShareType> &D, const std::vector<ShareType> &E,
+                                   const InnerProductTriple &triple, ShareType deFactor, ShareType result);
+    // Pairwise keys for local zero and random sharings
+    Prss m_prss;
+    // Reusable message buffers; declared before everything that may hold one of their buffers
+    BufferPool m_sendBuffers;
+    BufferPool m_recvBuffers;
+    // Opening messages that arrived before this party reached openValues(), tag included
+    std::vector<std::pair<PARTY_ID_T, PooledBuffer>> m_pendingOpenings;
+    // Decoded peer batch, reused across openings so its BIGNUMs are allocated once
+    std::vector<ShareType> m_peerBatch;
     // Party5_to_1
     std::string m_dealRouterId;
-    #if defined(ENABLE_MALICIOUS_SECURITY)
-    ShareType m_global_mac_key;
-    std::vector<std::vector<ShareType>> m_macShares;
-    // Addition operation
-    std::vector<std::vector<ShareType>> m_addition_partial_sum;
-    ShareType m_secret_sum;
-    ShareType m_secret_sum_mac;
-    // Multiplication operation
-    ShareType m_epsilon, m_rho;
-    ShareType m_global_key_share;
-    ShareType m_sigma;
-    ShareType m_agreed_random_values[NUM_PARTIALLY_OPEN_VALUES];
-    #endif // ENABLE_MALICIOUS_SECURITY
-    std::vector<ShareType> m_secrets;
+    // MaliciousSecurity only
+    Share m_global_mac_key;
+    std::vector<std::vector<Share>> m_macShares;
+    Share m_global_key_share;
+    // Every value opened since the last MAC check and this party's MAC share of it
+    std::vector<Share> m_openedLog;
+    std::vector<Share> m_openedMacLog;
+    // Dealer side: reconstructed outputs and their MACs awaiting the final check
+    std::vector<Share> m_outputLog;
+    std::vector<Share> m_outputMacLog;
+    // Coin tossing: this party's committed share of the next seed and the peers' commitments
+    std::string m_nextSeedShare;
+    std::vector<std::string> m_peerSeedCommitments;
+    std::vector<Share> m_secrets;
 };
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "PhaseStats.h"
+
+PhaseStats::Scope::Scope(PhaseStats* stats, const char* name)
+    : m_stats(stats), m_name(name), m_span(name, "phase")
+{
+    if (!m_stats) return;
+    if (m_stats->m_net) {
+        m_messagesAtStart = m_stats->m_net->messagesSent();
+        m_bytesAtStart = m_stats->m_net->bytesSent();
+    }
+    m_start = std::chrono::steady_clock::now();
+}
+
+void PhaseStats::Scope::stop()
+{
+    m_span.end();
+    if (!m_stats) return;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    SIZE_T messages = 0, bytes = 0;
+    if (m_stats->m_net) {
+        messages = m_stats->m_net->messagesSent() - m_messagesAtStart;
+        bytes = m_stats->m_net->bytesSent() - m_bytesAtStart;
+    }
+    m_stats->add(m_name, seconds, messages, bytes);
+    m_stats = nullptr;
+}
+
+void PhaseStats::add(const std::string &name, double seconds, SIZE_T messagesSent, SIZE_T bytesSent)
+{
+    Phase* phase = nullptr;
+    for (auto &existing : m_phases) {
+        if (existing.name == name) phase = &existing;
+    }
+    if (!phase) {
+        m_phases.push_back(Phase{name});
+        phase = &m_phases.back();
+    }
+    phase->seconds += seconds;
+    phase->entries += 1;
+    phase->messagesSent += messagesSent;
+    phase->bytesSent += bytesSent;
+}
+
+void PhaseStats::print(std::ostream &out, PARTY_ID_T partyId, const std::string &security, SIZE_T batch) const
+{
+    for (const auto &phase : m_phases) {
+        out << "PHASE," << partyId << "," << security << "," << batch << "," << phase.name << ","
+            << static_cast<SIZE_T>(phase.seconds * 1e6) << "," << phase.messagesSent << "," << phase.bytesSent << "\n";
+    }
+    out.flush();
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "NetIOMPMetered.h"
+#include "Trace.h"
+#include "config.h"
+
+// Protocol phases, as named in PhaseStats reports
+const char* const PHASE_SETUP = "setup";
+const char* const PHASE_SHARE_DISTRIBUTION = "share_distribution";
+const char* const PHASE_ADDITION = "addition";
+const char* const PHASE_TRIPLE_DISTRIBUTION = "triple_distribution";
+const char* const PHASE_MULTIPLICATION = "multiplication";
+const char* const PHASE_INNER_PRODUCT = "inner_product";
+const char* const PHASE_MATRIX_MULTIPLICATION = "matrix_multiplication";
+const char* const PHASE_CIRCUIT = "circuit";
+const char* const PHASE_MAC_CHECK = "mac_check";
+
+/**
+ * @brief Wall time and traffic of the protocol phases one party takes part in. A phase
+ *        that is entered several times accumulates. Traffic is what this party sent
+ *        while the phase ran, so the sum over all parties is what went over the wire.
+ */
+class PhaseStats {
+public:
+    struct Phase {
+        std::string name;
+        double seconds = 0;
+        SIZE_T entries = 0;
+        SIZE_T messagesSent = 0;
+        SIZE_T bytesSent = 0;
+    };
+
+    /**
+     * @brief Times the enclosing block, or up to stop(), as the given phase. Without
+     *        stats it only records the phase as a trace span.
+     */
+    class Scope {
+    public:
+        Scope(PhaseStats* stats, const char* name);
+        ~Scope() { stop(); }
+        // Record the phase now instead of at the end of the block
+        void stop();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        PhaseStats* m_stats;
+        const char* m_name;
+        TraceSpan m_span;
+        std::chrono::steady_clock::time_point m_start;
+        SIZE_T m_messagesAtStart = 0;
+        SIZE_T m_bytesAtStart = 0;
+    };
+
+    /**
+     * @param net Counts this party's traffic; without it only wall time is recorded.
+     */
+    explicit PhaseStats(const NetIOMPMetered* net = nullptr) : m_net(net) {}
+
+    // Add one run of a phase
+    void add(const std::string &name, double seconds, SIZE_T messagesSent, SIZE_T bytesSent);
+
+    // Phases in the order they were first entered
+    const std::vector<Phase> &phases() const { return m_phases; }
+
+    /**
+     * @brief Writes one line per phase for bench_protocol to collect:
+     *        PHASE,<party>,<security>,<batch>,<phase>,<wall_us>,<messages_sent>,<bytes_sent>
+     * @param security Security mode of the job, e.g. "malicious" or "semihonest".
+     * @param batch Number of inputs of the job.
+     */
+    void print(std::ostream &out, PARTY_ID_T partyId, const std::string &security, SIZE_T batch) const;
+
+private:
+    const NetIOMPMetered* m_net;
+    std::vector<Phase> m_phases;
+};
@@ -0,0 +1,85 @@
+#include "Prss.h"
+#include "AdditiveSecretSharing.h"
+#include <algorithm>
+#include <stdexcept>
+
+Prss::~Prss() {
+    if (m_keyPair) EVP_PKEY_free(m_keyPair);
+}
+
+std::string Prss::beginKeyExchange() {
+    if (m_keyPair) {
+        EVP_PKEY_free(m_keyPair);
+        m_keyPair = nullptr;
+    }
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_X25519, nullptr);
+    bool ok = ctx && EVP_PKEY_keygen_init(ctx) == 1 && EVP_PKEY_keygen(ctx, &m_keyPair) == 1;
+    EVP_PKEY_CTX_free(ctx);
+    if (!ok) throw std::runtime_error("PRSS key generation failed");
+
+    std::string publicKey(32, '\0');
+    size_t length = publicKey.size();
+    if (EVP_PKEY_get_raw_public_key(m_keyPair, reinterpret_cast<unsigned char*>(&publicKey[0]), &length) != 1) {
+        throw std::runtime_error("Failed to export the PRSS public key");
+    }
+    publicKey.resize(length);
+    return publicKey;
+}
+
+void Prss::finishKeyExchange(PARTY_ID_T myId, const std::vector<std::string>& publicKeys) {
+    if (!m_keyPair) throw std::runtime_error("finishKeyExchange called before beginKeyExchange");
+    m_partyId = myId;
+    m_pairwiseKeys.assign(publicKeys.size(), std::string());
+    for (PARTY_ID_T pid = 1; pid < static_cast<PARTY_ID_T>(publicKeys.size()); ++pid) {
+        if (pid == myId) continue;
+        const std::string& peerKey = publicKeys[pid];
+        EVP_PKEY* peer = EVP_PKEY_new_raw_public_key(EVP_PKEY_X25519, nullptr,
+                                                     reinterpret_cast<const unsigned char*>(peerKey.data()), peerKey.size());
+        EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(m_keyPair, nullptr);
+        std::string secret(32, '\0');
+        size_t length = secret.size();
+        bool ok = peer && ctx && EVP_PKEY_derive_init(ctx) == 1 && EVP_PKEY_derive_set_peer(ctx, peer) == 1 &&
+                  EVP_PKEY_derive(ctx, reinterpret_cast<unsigned char*>(&secret[0]), &length) == 1;
+        EVP_PKEY_CTX_free(ctx);
+        EVP_PKEY_free(peer);
+        if (!ok) throw std::runtime_error("PRSS key agreement with Party " + std::to_string(pid) + " failed");
+        secret.resize(length);
+        // Bind the key to the pair so both ends derive the same value
+        PARTY_ID_T low = std::min(myId, pid), high = std::max(myId, pid);
+        m_pairwiseKeys[pid] = AdditiveSecretSharing::sha256("prss|" + std::to_string(low) + "|" +
+                                                            std::to_string(high) + "|" + secret);
+    }
+    EVP_PKEY_free(m_keyPair);
+    m_keyPair = nullptr;
+    m_counter = 0;
+}
+
+void Prss::zeroShares(SIZE_T count, std::vector<ShareType>& shares) {
+    derive("zero", true, count, shares);
+}
+
+void Prss::randomShares(SIZE_T count, std::vector<ShareType>& shares) {
+    derive("rand", false, count, shares);
+}
+
+void Prss::derive(const std::string& label, bool signedByOrder, SIZE_T count, std::vector<ShareType>& shares) {
+    if (!ready()) throw std::runtime_error("PRSS keys are not set up");
+    shares.resize(count);
+    for (auto& share : shares) {
+        share = AdditiveSecretSharing::newBigInt();
+    }
+    std::string nonce = "|" + label + "|" + std::to_string(m_counter++);
+    for (PARTY_ID_T pid = 1; pid < static_cast<PARTY_ID_T>(m_pairwiseKeys.size()); ++pid) {
+        if (pid == m_partyId) continue;
+        std::vector<ShareType> stream;
+        AdditiveSecretSharing::expandSeed(m_pairwiseKeys[pid] + nonce, count, stream);
+        for (SIZE_T k = 0; k < count; ++k) {
+            if (signedByOrder && pid < m_partyId) {
+                BN_mod_sub(shares[k], shares[k], stream[k], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+            } else {
+                BN_mod_add(shares[k], shares[k], stream[k], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+            }
+            BN_free(stream[k]);
+        }
+    }
+}
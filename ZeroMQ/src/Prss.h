@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <openssl/evp.h>
+#include "config.h"
+
+/**
+ * @brief Pseudo-random secret sharing. After one key exchange every pair of compute
+ *        parties shares a key; from then on each party derives shares of zero and of
+ *        fresh random values locally from a counter, without any communication.
+ *        All parties must request sharings in the same order to stay in step.
+ */
+class Prss {
+public:
+    Prss() = default;
+    ~Prss();
+    Prss(const Prss&) = delete;
+    Prss& operator=(const Prss&) = delete;
+
+    /**
+     * @brief Generates a fresh X25519 key pair.
+     * @return The raw public key to send to every peer.
+     */
+    std::string beginKeyExchange();
+
+    /**
+     * @brief Derives the pairwise keys from the peers' public keys and resets the counter.
+     * @param myId This party's id.
+     * @param publicKeys Public keys indexed by party id (index 0 unused, own entry ignored).
+     */
+    void finishKeyExchange(PARTY_ID_T myId, const std::vector<std::string>& publicKeys);
+
+    bool ready() const { return !m_pairwiseKeys.empty(); }
+
+    /**
+     * @brief This party's shares of count fresh zeros: sum_j +-PRF(k_ij, counter),
+     *        positive towards higher ids and negative towards lower ones.
+     * @param shares Output shares (caller frees).
+     */
+    void zeroShares(SIZE_T count, std::vector<ShareType>& shares);
+
+    /**
+     * @brief This party's shares of count fresh random values no coalition missing
+     *        one pairwise key can predict: sum_j PRF(k_ij, counter).
+     * @param shares Output shares (caller frees).
+     */
+    void randomShares(SIZE_T count, std::vector<ShareType>& shares);
+
+private:
+    // Sum of the PRF outputs of every pairwise key, signed for zero sharings
+    void derive(const std::string& label, bool signedByOrder, SIZE_T count, std::vector<ShareType>& shares);
+
+    PARTY_ID_T m_partyId = 0;
+    EVP_PKEY* m_keyPair = nullptr;
+    // Indexed by peer id; empty for this party and index 0
+    std::vector<std::string> m_pairwiseKeys;
+    uint64_t m_counter = 0;
+};
@@ -0,0 +1,87 @@
+#include "ResultSink.h"
+#include <stdexcept>
+#include "ShareCodec.h"
+
+ResultSink::ResultSink(const std::string& path, SIZE_T chunkBytes)
+    : m_path(path), m_file(path, std::ios::binary | std::ios::trunc), m_chunkBytes(chunkBytes) {
+    if (!m_file) {
+        throw std::runtime_error("Cannot create result file " + path);
+    }
+    m_pending.reserve(m_chunkBytes);
+    m_writer = std::thread([this]() { writeLoop(); });
+}
+
+ResultSink::~ResultSink() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void ResultSink::write(const std::vector<ShareType>& values) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_error) std::rethrow_exception(m_error);
+    }
+    if (m_closed) {
+        throw std::runtime_error("Result file " + m_path + " is already closed");
+    }
+    SIZE_T offset = m_pending.size();
+    m_pending.resize(offset + encodedSharesBinarySize(values.size()));
+    encodeSharesBinary(values, m_pending.data() + offset);
+    m_valuesWritten += values.size();
+    if (m_pending.size() >= m_chunkBytes) handOff();
+}
+
+void ResultSink::close() {
+    if (m_closed) return;
+    m_closed = true;
+    if (!m_pending.empty()) handOff();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+    m_writer.join();
+    if (m_error) std::rethrow_exception(m_error);
+    m_file.close();
+    if (!m_file) {
+        throw std::runtime_error("Failed to finish result file " + m_path);
+    }
+}
+
+void ResultSink::handOff() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this]() { return !m_hasFull || m_error; });
+    // A failed writer has stopped; the error surfaces on the next write() or close()
+    if (m_error) return;
+    m_full.swap(m_pending);
+    m_hasFull = true;
+    lock.unlock();
+    m_cv.notify_all();
+    m_pending.clear();
+}
+
+void ResultSink::writeLoop() {
+    std::vector<char> chunk;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_hasFull || m_stopping; });
+            // Stopping only ends the loop once the last chunk is written
+            if (!m_hasFull) return;
+            // The caller gets this thread's drained buffer back with the next hand-off
+            chunk.swap(m_full);
+            m_hasFull = false;
+        }
+        m_cv.notify_all();
+        m_file.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        if (!m_file) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_error = std::make_exception_ptr(std::runtime_error("Failed to write result file " + m_path));
+            m_cv.notify_all();
+            return;
+        }
+        chunk.clear();
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "config.h"
+
+/**
+ * @brief Streams results to a binary file as batches complete. Values are encoded into
+ *        a chunk buffer and every full chunk is written by a background thread while the
+ *        caller carries on, so at most two chunks are in memory however many results a
+ *        job produces.
+ *
+ *        The file is back-to-back big-endian SHARE_BYTES fields (see encodeSharesBinary)
+ *        in the order the values were written: reconstructed outputs, or one party's
+ *        output shares that a downstream job adds up with the other parties' files.
+ */
+class ResultSink {
+public:
+    /**
+     * @param chunkBytes Encoded bytes buffered before a chunk goes to the writer thread.
+     * @throws std::runtime_error when the file cannot be created.
+     */
+    explicit ResultSink(const std::string& path, SIZE_T chunkBytes = RESULT_CHUNK_BYTES);
+    // Writes what is left; errors are only reported by close()
+    ~ResultSink();
+    ResultSink(const ResultSink&) = delete;
+    ResultSink& operator=(const ResultSink&) = delete;
+
+    // Appends one batch; blocks only while the writer thread is still busy with the previous chunk
+    void write(const std::vector<ShareType>& values);
+
+    /**
+     * @brief Writes the last partial chunk and stops the writer thread.
+     * @throws std::runtime_error when any write failed.
+     */
+    void close();
+
+    // Values passed to write() so far
+    SIZE_T valuesWritten() const { return m_valuesWritten; }
+
+private:
+    void writeLoop();
+    // Hands m_pending to the writer thread and takes back its empty buffer
+    void handOff();
+
+    std::string m_path;
+    std::ofstream m_file;
+    SIZE_T m_chunkBytes;
+    SIZE_T m_valuesWritten = 0;
+    bool m_closed = false;
+    // Chunk the caller is filling
+    std::vector<char> m_pending;
+
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    // Chunk handed to the writer thread
+    std::vector<char> m_full;
+    bool m_hasFull = false;
+    bool m_stopping = false;
+    std::exception_ptr m_error;
+};
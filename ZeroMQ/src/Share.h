@@ -0,0 +1,82 @@
+#pragma once
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <openssl/bn.h>
+#include "config.h"
+
+/**
+ * @brief Move-only owner of one BIGNUM share. It converts implicitly to ShareType, so
+ *        it can be passed straight to BN_* calls and to APIs that only borrow shares;
+ *        vectors of Share move their elements on growth instead of copying them.
+ */
+class Share {
+public:
+    Share() = default;
+    // Takes ownership of bn
+    explicit Share(BIGNUM* bn) : m_bn(bn) {}
+    ~Share() { BN_free(m_bn); }
+
+    Share(Share &&other) noexcept : m_bn(other.m_bn) { other.m_bn = nullptr; }
+    Share& operator=(Share &&other) noexcept {
+        if (this != &other) {
+            BN_free(m_bn);
+            m_bn = other.m_bn;
+            other.m_bn = nullptr;
+        }
+        return *this;
+    }
+    Share(const Share&) = delete;
+    Share& operator=(const Share&) = delete;
+
+    /**
+     * @brief A new share holding zero.
+     */
+    static Share zero() {
+        BIGNUM* bn = BN_new();
+        if (!bn) throw std::runtime_error("Failed to create BIGNUM");
+        return Share(bn);
+    }
+
+    // Deep copy, for the few places that need two owners of one value
+    Share clone() const {
+        if (!m_bn) return Share();
+        BIGNUM* bn = BN_dup(m_bn);
+        if (!bn) throw std::runtime_error("Failed to clone BIGNUM");
+        return Share(bn);
+    }
+
+    BIGNUM* get() const { return m_bn; }
+    operator BIGNUM*() const { return m_bn; }
+    explicit operator bool() const { return m_bn != nullptr; }
+
+    // Gives up ownership; the caller frees the result
+    BIGNUM* release() {
+        BIGNUM* bn = m_bn;
+        m_bn = nullptr;
+        return bn;
+    }
+
+private:
+    BIGNUM* m_bn = nullptr;
+};
+
+/**
+ * @brief Borrowed ShareType view of owned shares, for APIs taking std::vector<ShareType>.
+ */
+inline std::vector<ShareType> borrowShares(const std::vector<Share> &shares) {
+    std::vector<ShareType> view;
+    view.reserve(shares.size());
+    for (const auto &share : shares) view.push_back(share.get());
+    return view;
+}
+
+/**
+ * @brief Takes ownership of raw shares, e.g. from deserializeShares or receive helpers.
+ */
+inline std::vector<Share> adoptShares(const std::vector<ShareType> &raw) {
+    std::vector<Share> owned;
+    owned.reserve(raw.size());
+    for (auto bn : raw) owned.emplace_back(bn);
+    return owned;
+}
@@ -0,0 +1,149 @@
+#include "ShareCodec.h"
+#include <stdexcept>
+#include <string>
+#include "ThreadPool.h"
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+// Value of every hex digit character, -1 for anything else
+static const struct HexTable {
+    signed char value[256];
+    HexTable() {
+        for (int c = 0; c < 256; ++c) value[c] = -1;
+        for (int d = 0; d < 10; ++d) value['0' + d] = static_cast<signed char>(d);
+        for (int d = 0; d < 6; ++d) {
+            value['A' + d] = static_cast<signed char>(10 + d);
+            value['a' + d] = static_cast<signed char>(10 + d);
+        }
+    }
+} HEX_TABLE;
+
+static int hexValue(char c) {
+    return HEX_TABLE.value[static_cast<unsigned char>(c)];
+}
+
+SIZE_T encodedSharesSize(SIZE_T count) {
+    return count == 0 ? 0 : count * SHARE_FIELD_SIZE - 1;
+}
+
+// Batches that fit in one chunk skip the pool: wrapping the body in its task would be
+// the only allocation left on the message path
+static bool runsInline(SIZE_T count) {
+    return count <= PARALLEL_GRAIN || ThreadPool::shared().size() == 0;
+}
+
+// Big-endian, zero-padded SHARE_BYTES bytes of one share
+static void shareToBytes(ShareType share, unsigned char* bytes) {
+    if (!share) {
+        throw std::runtime_error("encodeShares: cannot encode a null share");
+    }
+    if (BN_is_negative(share) || BN_bn2binpad(share, bytes, SHARE_BYTES) < 0) {
+        throw std::runtime_error("encodeShares: share does not fit in " + std::to_string(SHARE_BYTES) + " bytes");
+    }
+}
+
+// BN_bin2bn allocates only when share is null
+static ShareType bytesToShare(const unsigned char* bytes, ShareType share, SIZE_T index) {
+    ShareType result = BN_bin2bn(bytes, SHARE_BYTES, share);
+    if (!result) {
+        throw std::runtime_error("decodeShares: failed to convert share " + std::to_string(index));
+    }
+    return result;
+}
+
+static void encodeRange(const std::vector<ShareType> &shares, char* out, SIZE_T begin, SIZE_T end) {
+    unsigned char bytes[SHARE_BYTES];
+    for (SIZE_T i = begin; i < end; ++i) {
+        shareToBytes(shares[i], bytes);
+        char* field = out + i * SHARE_FIELD_SIZE;
+        for (SIZE_T b = 0; b < SHARE_BYTES; ++b) {
+            field[2 * b] = HEX_DIGITS[bytes[b] >> 4];
+            field[2 * b + 1] = HEX_DIGITS[bytes[b] & 0x0F];
+        }
+        if (i + 1 < shares.size()) field[SHARE_HEX_DIGITS] = '|';
+    }
+}
+
+static void decodeRange(const char* data, SIZE_T count, std::vector<ShareType> &out, SIZE_T begin, SIZE_T end) {
+    unsigned char bytes[SHARE_BYTES];
+    for (SIZE_T i = begin; i < end; ++i) {
+        const char* field = data + i * SHARE_FIELD_SIZE;
+        if (i + 1 < count && field[SHARE_HEX_DIGITS] != '|') {
+            throw std::runtime_error("decodeShares: missing delimiter after share " + std::to_string(i));
+        }
+        for (SIZE_T b = 0; b < SHARE_BYTES; ++b) {
+            int high = hexValue(field[2 * b]);
+            int low = hexValue(field[2 * b + 1]);
+            if (high < 0 || low < 0) {
+                throw std::runtime_error("decodeShares: invalid hex in share " + std::to_string(i));
+            }
+            bytes[b] = static_cast<unsigned char>((high << 4) | low);
+        }
+        out[i] = bytesToShare(bytes, out[i], i);
+    }
+}
+
+SIZE_T encodeShares(const std::vector<ShareType> &shares, char* out) {
+    if (runsInline(shares.size())) {
+        encodeRange(shares, out, 0, shares.size());
+    } else {
+        ThreadPool::shared().parallelFor(0, shares.size(), PARALLEL_GRAIN, [&](SIZE_T begin, SIZE_T end) {
+            encodeRange(shares, out, begin, end);
+        });
+    }
+    return encodedSharesSize(shares.size());
+}
+
+SIZE_T decodeShares(const char* data, SIZE_T length, std::vector<ShareType> &out) {
+    if (length == 0) return 0;
+    if ((length + 1) % SHARE_FIELD_SIZE != 0) {
+        throw std::runtime_error("decodeShares: " + std::to_string(length) + " bytes is not a whole batch of shares");
+    }
+    SIZE_T count = (length + 1) / SHARE_FIELD_SIZE;
+    if (out.size() < count) out.resize(count, nullptr);
+    if (runsInline(count)) {
+        decodeRange(data, count, out, 0, count);
+    } else {
+        ThreadPool::shared().parallelFor(0, count, PARALLEL_GRAIN, [&](SIZE_T begin, SIZE_T end) {
+            decodeRange(data, count, out, begin, end);
+        });
+    }
+    return count;
+}
+
+SIZE_T encodedSharesBinarySize(SIZE_T count) {
+    return count * SHARE_BYTES;
+}
+
+SIZE_T encodeSharesBinary(const std::vector<ShareType> &shares, char* out) {
+    auto encode = [&](SIZE_T begin, SIZE_T end) {
+        for (SIZE_T i = begin; i < end; ++i) {
+            shareToBytes(shares[i], reinterpret_cast<unsigned char*>(out + i * SHARE_BYTES));
+        }
+    };
+    if (runsInline(shares.size())) {
+        encode(0, shares.size());
+    } else {
+        ThreadPool::shared().parallelFor(0, shares.size(), PARALLEL_GRAIN, encode);
+    }
+    return encodedSharesBinarySize(shares.size());
+}
+
+SIZE_T decodeSharesBinary(const char* data, SIZE_T length, std::vector<ShareType> &out) {
+    if (length % SHARE_BYTES != 0) {
+        throw std::runtime_error("decodeSharesBinary: " + std::to_string(length) + " bytes is not a whole batch of shares");
+    }
+    SIZE_T count = length / SHARE_BYTES;
+    if (out.size() < count) out.resize(count, nullptr);
+    auto decode = [&](SIZE_T begin, SIZE_T end) {
+        for (SIZE_T i = begin; i < end; ++i) {
+            out[i] = bytesToShare(reinterpret_cast<const unsigned char*>(data + i * SHARE_BYTES), out[i], i);
+        }
+    };
+    if (runsInline(count)) {
+        decode(0, count);
+    } else {
+        ThreadPool::shared().parallelFor(0, count, PARALLEL_GRAIN, decode);
+    }
+    return count;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include "config.h"
+
+// Hex digits of one share on the wire; every share is zero-padded to this width
+const SIZE_T SHARE_HEX_DIGITS = 2 * SHARE_BYTES;
+// Bytes one share takes in an encoded batch, including its '|' delimiter
+const SIZE_T SHARE_FIELD_SIZE = SHARE_HEX_DIGITS + 1;
+
+/**
+ * @brief Bytes encodeShares writes for a batch of count shares.
+ */
+SIZE_T encodedSharesSize(SIZE_T count);
+
+/**
+ * @brief Writes the shares as '|'-delimited, fixed-width upper-case hex. Nothing is
+ *        allocated, and the fixed width lets large batches be encoded in parallel.
+ * @param out Must hold encodedSharesSize(shares.size()) bytes.
+ * @return Number of bytes written.
+ */
+SIZE_T encodeShares(const std::vector<ShareType> &shares, char* out);
+
+/**
+ * @brief Parses a batch written by encodeShares. Existing entries of out are reused,
+ *        so decoding into the same vector again does not allocate; missing ones are
+ *        created. out never shrinks and the caller owns every entry in it.
+ * @return Number of shares decoded into out[0 .. count).
+ */
+SIZE_T decodeShares(const char* data, SIZE_T length, std::vector<ShareType> &out);
+
+/**
+ * @brief Bytes encodeSharesBinary writes for a batch of count shares.
+ */
+SIZE_T encodedSharesBinarySize(SIZE_T count);
+
+/**
+ * @brief Writes the shares as back-to-back big-endian SHARE_BYTES fields, half the size
+ *        of the hex encoding. The wire format stays hex; benchmarks compare the two.
+ * @param out Must hold encodedSharesBinarySize(shares.size()) bytes.
+ * @return Number of bytes written.
+ */
+SIZE_T encodeSharesBinary(const std::vector<ShareType> &shares, char* out);
+
+/**
+ * @brief Parses a batch written by encodeSharesBinary, reusing out as decodeShares does.
+ * @return Number of shares decoded into out[0 .. count).
+ */
+SIZE_T decodeSharesBinary(const char* data, SIZE_T length, std::vector<ShareType> &out);
@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <utility>
+#include <vector>
+#include "config.h"
+
+/**
+ * @brief Bounded ring for exactly one producer thread and one consumer thread. push and
+ *        pop never lock or wait: only the producer writes m_tail and only the consumer
+ *        writes m_head, and each publishes its slot with a release store the other side
+ *        reads with acquire.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscQueue(SIZE_T capacity) : m_slots(roundUp(capacity)), m_mask(m_slots.size() - 1) {}
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer only; false when full, in which case item is left untouched
+    bool push(T&& item) {
+        SIZE_T tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == m_slots.size()) return false;
+        m_slots[tail & m_mask] = std::move(item);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only; false when empty
+    bool pop(T& item) {
+        SIZE_T head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) return false;
+        item = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    SIZE_T capacity() const { return m_slots.size(); }
+
+private:
+    static SIZE_T roundUp(SIZE_T n) {
+        SIZE_T capacity = 1;
+        while (capacity < n) capacity <<= 1;
+        return capacity;
+    }
+
+    std::vector<T> m_slots;
+    SIZE_T m_mask;
+    // Separate cache lines, so the two threads do not invalidate each other's index
+    alignas(64) std::atomic<SIZE_T> m_head{0};
+    alignas(64) std::atomic<SIZE_T> m_tail{0};
+};
@@ -0,0 +1,91 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+ThreadPool::ThreadPool(SIZE_T numThreads) {
+    for (SIZE_T i = 0; i < numThreads; ++i) {
+        m_workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+    for (auto &worker : m_workers) worker.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+            if (m_tasks.empty()) return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(SIZE_T begin, SIZE_T end, SIZE_T grain,
+                             const std::function<void(SIZE_T, SIZE_T)>& body) {
+    if (end <= begin) return;
+    SIZE_T length = end - begin;
+    SIZE_T chunks = std::min<SIZE_T>((length + std::max<SIZE_T>(grain, 1) - 1) / std::max<SIZE_T>(grain, 1),
+                                     m_workers.size() + 1);
+    if (chunks <= 1) {
+        body(begin, end);
+        return;
+    }
+    SIZE_T chunkSize = (length + chunks - 1) / chunks;
+
+    // Chunks are claimed through an atomic counter, so late helpers find nothing left to do
+    struct Job {
+        std::atomic<SIZE_T> next{0};
+        std::atomic<SIZE_T> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+    auto job = std::make_shared<Job>();
+    auto run = [job, chunks, chunkSize, begin, end, &body]() {
+        SIZE_T chunk;
+        while ((chunk = job->next++) < chunks) {
+            SIZE_T chunkBegin = std::min(end, begin + chunk * chunkSize);
+            SIZE_T chunkEnd = std::min(end, chunkBegin + chunkSize);
+            try {
+                if (chunkBegin < chunkEnd) body(chunkBegin, chunkEnd);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(job->mutex);
+                if (!job->error) job->error = std::current_exception();
+            }
+            if (++job->done == chunks) {
+                std::lock_guard<std::mutex> lock(job->mutex);
+                job->finished.notify_all();
+            }
+        }
+    };
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (SIZE_T helper = 0; helper + 1 < chunks; ++helper) {
+            m_tasks.emplace_back(run);
+        }
+    }
+    m_cv.notify_all();
+    run();
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [&job, chunks]() { return job->done == chunks; });
+    if (job->error) std::rethrow_exception(job->error);
+}
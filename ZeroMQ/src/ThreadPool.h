@@ -0,0 +1,45 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "config.h"
+
+/**
+ * @brief Fixed set of worker threads for the CPU-heavy parts of the protocol (share
+ *        arithmetic, (de)serialization, share generation). Socket I/O never runs here:
+ *        ZMQ sockets are not thread-safe, so each party keeps its socket on its own thread.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(SIZE_T numThreads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Process-wide pool with one worker per hardware thread, minus the caller.
+     */
+    static ThreadPool& shared();
+
+    SIZE_T size() const { return m_workers.size(); }
+
+    /**
+     * @brief Runs body on consecutive chunks of [begin, end) and waits for all of them.
+     *        The calling thread works on chunks too, so calling it from inside a pool
+     *        task cannot deadlock. The first exception thrown by body is rethrown.
+     * @param grain Ranges shorter than this run inline on the calling thread.
+     */
+    void parallelFor(SIZE_T begin, SIZE_T end, SIZE_T grain, const std::function<void(SIZE_T, SIZE_T)>& body);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stopping = false;
+};
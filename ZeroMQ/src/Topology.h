@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+#include "config.h"
+
+/**
+ * @brief Complete k-ary tree over nodes 0..numNodes-1 with node 0 as the root.
+ *        Node i has parent (i - 1) / arity and children arity * i + 1 .. arity * i + arity.
+ */
+struct KaryTree {
+    SIZE_T numNodes;
+    SIZE_T arity;
+
+    KaryTree(SIZE_T nodes, SIZE_T k) : numNodes(nodes), arity(k < 2 ? 2 : k) {}
+
+    // Parent of a non-root node
+    SIZE_T parent(SIZE_T node) const { return (node - 1) / arity; }
+
+    std::vector<SIZE_T> children(SIZE_T node) const {
+        std::vector<SIZE_T> result;
+        for (SIZE_T c = arity * node + 1; c <= arity * node + arity && c < numNodes; ++c) {
+            result.push_back(c);
+        }
+        return result;
+    }
+};
@@ -0,0 +1,111 @@
+#include "Trace.h"
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+std::atomic<bool> Trace::s_enabled{false};
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    uint64_t startNs;
+    uint64_t endNs;
+};
+
+// One thread's spans; only that thread writes, dump() reads after it is done
+struct TraceRing {
+    explicit TraceRing(int tid) : tid(tid), events(TRACE_BUFFER_EVENTS) {}
+    int tid;
+    std::vector<TraceEvent> events;
+    std::atomic<uint64_t> written{0};
+};
+
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceRing>> rings;
+    int pid = 0;
+    std::string processName;
+};
+
+TraceRegistry &registry() {
+    static TraceRegistry instance;
+    return instance;
+}
+
+// The calling thread's ring, registered on its first span; rings outlive their threads
+TraceRing &threadRing() {
+    thread_local TraceRing* ring = nullptr;
+    if (!ring) {
+        TraceRegistry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.rings.push_back(std::make_unique<TraceRing>(static_cast<int>(reg.rings.size()) + 1));
+        ring = reg.rings.back().get();
+    }
+    return *ring;
+}
+
+void writeMicros(std::ostream &out, uint64_t ns) {
+    out << ns / 1000 << "." << static_cast<char>('0' + ns / 100 % 10) << static_cast<char>('0' + ns / 10 % 10)
+        << static_cast<char>('0' + ns % 10);
+}
+
+} // namespace
+
+void Trace::enable(int pid, const std::string &processName) {
+    TraceRegistry &reg = registry();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.pid = pid;
+        reg.processName = processName;
+    }
+    s_enabled.store(true, std::memory_order_relaxed);
+}
+
+uint64_t Trace::nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Trace::record(const char* name, const char* category, uint64_t startNs, uint64_t endNs) {
+    TraceRing &ring = threadRing();
+    uint64_t index = ring.written.load(std::memory_order_relaxed);
+    ring.events[index % ring.events.size()] = TraceEvent{name, category, startNs, endNs};
+    ring.written.store(index + 1, std::memory_order_release);
+}
+
+void Trace::dump(const std::string &path) {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Trace::dump: cannot write " + path);
+    }
+    TraceRegistry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    out << "{\"traceEvents\": [\n";
+    out << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << reg.pid
+        << ", \"args\": {\"name\": \"" << reg.processName << "\"}}";
+    for (const auto &ring : reg.rings) {
+        out << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << reg.pid << ", \"tid\": " << ring->tid
+            << ", \"args\": {\"name\": \"thread " << ring->tid << "\"}}";
+        uint64_t written = ring->written.load(std::memory_order_acquire);
+        uint64_t capacity = ring->events.size();
+        uint64_t first = written > capacity ? written - capacity : 0;
+        for (uint64_t i = first; i < written; ++i) {
+            const TraceEvent &event = ring->events[i % capacity];
+            out << ",\n{\"name\": \"" << event.name << "\", \"cat\": \"" << event.category
+                << "\", \"ph\": \"X\", \"pid\": " << reg.pid << ", \"tid\": " << ring->tid << ", \"ts\": ";
+            writeMicros(out, event.startNs);
+            out << ", \"dur\": ";
+            writeMicros(out, event.endNs - event.startNs);
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    if (!out) {
+        throw std::runtime_error("Trace::dump: failed writing " + path);
+    }
+}
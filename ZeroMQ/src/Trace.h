@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "config.h"
+
+/**
+ * @brief Span tracing in Chrome trace format (chrome://tracing, ui.perfetto.dev). Each
+ *        thread keeps the spans it completed in its own ring of TRACE_BUFFER_EVENTS, so
+ *        recording takes no lock; once a ring is full its oldest spans are overwritten.
+ *        Timestamps come from the monotonic clock, so the traces of all parties on one
+ *        host line up when they are loaded together.
+ */
+class Trace {
+public:
+    /**
+     * @brief Starts recording spans.
+     * @param pid Process id in the trace; main uses the party id.
+     * @param processName Label of the process in the trace viewer.
+     */
+    static void enable(int pid, const std::string &processName);
+
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // Monotonic time in nanoseconds
+    static uint64_t nowNs();
+
+    // Append a completed span to the calling thread's ring
+    static void record(const char* name, const char* category, uint64_t startNs, uint64_t endNs);
+
+    /**
+     * @brief Writes the spans of every thread as {"traceEvents": [...]}. Call it once the
+     *        recording threads are done, at shutdown.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    static void dump(const std::string &path);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+/**
+ * @brief Records the enclosing block, or the time up to end(), as one span. Names and
+ *        categories must be string literals: only the pointers are kept. Costs one
+ *        relaxed load while tracing is off.
+ */
+class TraceSpan {
+public:
+    TraceSpan(const char* name, const char* category)
+        : m_name(name), m_category(category), m_active(Trace::enabled()) {
+        if (m_active) m_startNs = Trace::nowNs();
+    }
+    ~TraceSpan() { end(); }
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    void end() {
+        if (!m_active) return;
+        Trace::record(m_name, m_category, m_startNs, Trace::nowNs());
+        m_active = false;
+    }
+
+private:
+    const char* m_name;
+    const char* m_category;
+    bool m_active;
+    uint64_t m_startNs = 0;
+};
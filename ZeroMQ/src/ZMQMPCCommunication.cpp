@@ -5,8 +5,22 @@
 
 namespace mpc {
 
+static std::vector<IMPCCommunication::PartyId> remoteParties(IMPCCommunication::PartyId partyId,
+                                                             const std::map<IMPCCommunication::PartyId, std::string>& partyEndpoints) {
+    std::vector<IMPCCommunication::PartyId> peers;
+    for (const auto& [pid, endpoint] : partyEndpoints) {
+        if (pid != partyId) peers.push_back(pid);
+    }
+    return peers;
+}
+
+static uint64_t nanosecondsSince(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
 ZMQMPCCommunication::ZMQMPCCommunication(PartyId partyId, const std::map<PartyId, std::string>& partyEndpoints)
-    : partyId_(partyId), partyEndpoints_(partyEndpoints), context_(1) {
+    : partyId_(partyId), partyEndpoints_(partyEndpoints), context_(1), stats_(remoteParties(partyId, partyEndpoints)) {
     routerSocket_ = std::make_unique<zmq::socket_t>(context_, zmq::socket_type::router);
 }
 
@@ -115,10 +129,10 @@ bool ZMQMPCCommunication::send(PartyId targetId, const Message& message) {
         auto serialized = message.serialize();
         zmq::message_t zmqMsg(serialized.data(), serialized.size());
         
+        auto sendStart = std::chrono::steady_clock::now();
         it->second->send(zmqMsg, zmq::send_flags::none);
         
-        messagesSent_++;
-        bytessSent_ += serialized.size();
+        stats_.recordSent(targetId, message.getType(), serialized.size(), nanosecondsSince(sendStart));
         
         logMessage("Sent message to party " + std::to_string(targetId) + 
                   " (type: " + std::to_string(static_cast<int>(message.getType())) + 
@@ -176,11 +190,13 @@ bool ZMQMPCCommunication::receive(PartyId& senderId, Message& message, TimeoutDu
     }
     
     // Get message from queue
-    auto [sid, msg] = std::move(messageQueue_.front());
+    QueuedMessage queued = std::move(messageQueue_.front());
     messageQueue_.pop();
     
-    senderId = sid;
-    message = std::move(msg);
+    stats_.recordLatency(CommunicationStats::Latency::QUEUE_WAIT, queued.senderId, queued.message.getType(),
+                         nanosecondsSince(queued.arrival));
+    senderId = queued.senderId;
+    message = std::move(queued.message);
     
     return true;
 }
@@ -206,19 +222,7 @@ size_t ZMQMPCCommunication::getTotalParties() const {
 }
 
 std::string ZMQMPCCommunication::getStatistics() const {
-    std::lock_guard<std::mutex> lock(statsMutex_);
-    
-    std::stringstream ss;
-    ss << "{"
-       << "\"party_id\": " << partyId_ << ","
-       << "\"messages_sent\": " << messagesSent_ << ","
-       << "\"messages_received\": " << messagesReceived_ << ","
-       << "\"bytes_sent\": " << bytessSent_ << ","
-       << "\"bytes_received\": " << bytesReceived_ << ","
-       << "\"queued_messages\": " << getQueuedMessageCount()
-       << "}";
-    
-    return ss.str();
+    return stats_.toJson(partyId_, getQueuedMessageCount());
 }
 
 size_t ZMQMPCCommunication::getQueuedMessageCount() const {
@@ -256,8 +260,7 @@ void ZMQMPCCommunication::receiverLoop() {
                                      static_cast<uint8_t*>(dataMsg.data()) + dataMsg.size());
             Message message = Message::deserialize(data);
             
-            messagesReceived_++;
-            bytesReceived_ += data.size();
+            stats_.recordReceived(senderId, message.getType(), data.size());
             
             logMessage("Received message from party " + std::to_string(senderId) + 
                       " (type: " + std::to_string(static_cast<int>(message.getType())) + 
@@ -281,15 +284,19 @@ void ZMQMPCCommunication::receiverLoop() {
 void ZMQMPCCommunication::processReceivedMessage(PartyId senderId, const Message& message) {
     // If async handler is set, use it
     if (messageHandler_) {
+        auto handlerStart = std::chrono::steady_clock::now();
         try {
             messageHandler_(senderId, message);
         } catch (const std::exception& e) {
             reportError("Error in message handler: " + std::string(e.what()));
         }
+        stats_.recordLatency(CommunicationStats::Latency::HANDLER, senderId, message.getType(),
+                             nanosecondsSince(handlerStart));
     } else {
         // Otherwise, queue the message for synchronous receive
         std::lock_guard<std::mutex> lock(queueMutex_);
-        messageQueue_.emplace(senderId, message);
+        messageQueue_.push({senderId, message, std::chrono::steady_clock::now()});
+        stats_.recordQueueDepth(messageQueue_.size());
         queueCV_.notify_one();
     }
 }
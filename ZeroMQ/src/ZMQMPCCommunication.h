@@ -2,6 +2,7 @@
 #define ZMQ_MPC_COMMUNICATION_H
 
 #include "IMPCCommunication.h"
+#include "CommunicationStats.h"
 #include <zmq.hpp>
 #include <thread>
 #include <atomic>
@@ -48,6 +49,11 @@ public:
     // Additional methods for testing and debugging
     void enableLogging(bool enable) { loggingEnabled_ = enable; }
     size_t getQueuedMessageCount() const;
+
+    /**
+     * @brief Tags all following traffic with a protocol phase in getStatistics().
+     */
+    void setPhase(const std::string& phase) { stats_.setPhase(phase); }
     
 private:
     // Configuration
@@ -65,7 +71,12 @@ private:
     std::atomic<bool> isReady_{false};
     
     // Message queue for async handling
-    std::queue<std::pair<PartyId, Message>> messageQueue_;
+    struct QueuedMessage {
+        PartyId senderId;
+        Message message;
+        std::chrono::steady_clock::time_point arrival;
+    };
+    std::queue<QueuedMessage> messageQueue_;
     mutable std::mutex queueMutex_;
     std::condition_variable queueCV_;
     
@@ -73,12 +84,8 @@ private:
     MessageHandler messageHandler_;
     ErrorHandler errorHandler_;
     
-    // Statistics
-    mutable std::mutex statsMutex_;
-    std::atomic<uint64_t> messagesSent_{0};
-    std::atomic<uint64_t> messagesReceived_{0};
-    std::atomic<uint64_t> bytessSent_{0};
-    std::atomic<uint64_t> bytesReceived_{0};
+    // Statistics; lock-free, see CommunicationStats
+    CommunicationStats stats_;
     
     // Configuration options
     bool loggingEnabled_{false};
@@ -29,13 +29,32 @@ using ShareType = BIGNUM*;
 // #define BUFFER_SIZE 1024 * 100
 // #endif
 
-// Uncomment the following line to enable cout statements
-// #define ENABLE_COUT
+// Log levels (see Logger). Calls below LOG_COMPILE_LEVEL compile to nothing; calls below the
+// runtime level, LOG_RUNTIME_LEVEL or MPC_LOG_LEVEL=trace|debug|info|warn|error, only cost a branch
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARN 3
+#define LOG_LEVEL_ERROR 4
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+#define LOG_RUNTIME_LEVEL LOG_LEVEL_INFO
+// Bytes of encoded records buffered before callers wait for the writer thread
+const SIZE_T LOG_BUFFER_BYTES = 1 << 20;
+const int LOG_FLUSH_INTERVAL_MS = 50;
 
-#define ENABLE_UNIT_TESTS
+// Self-checks of the protocol, e.g. reconstructing freshly generated shares. Debugging only:
+// it also fixes the MAC key at 2, which lets anyone forge MACs. Build with -DENABLE_UNIT_TESTS
+// #define ENABLE_UNIT_TESTS
 
 #define ENABLE_FINAL_RESULT
-#define ENABLE_MALICIOUS_SECURITY
+// Print the wall time and traffic of every protocol phase when a party finishes (see PhaseStats)
+#define ENABLE_PHASE_STATS
+// Record protocol, command and transport spans and write trace_party<id>.json at shutdown (see Trace)
+// #define ENABLE_TRACE
+// Spans kept per thread; older ones are overwritten
+const SIZE_T TRACE_BUFFER_EVENTS = 1 << 16;
 
 #define CMD_T uint8_t
 const CMD_T CMD_SEND_SHARES = 0;
@@ -44,10 +63,80 @@ const CMD_T CMD_SHUTDOWN = 2;
 const CMD_T CMD_ADDITION = 3;
 const CMD_T CMD_MULTIPLICATION = 4;
 const CMD_T CMD_FETCH_MULT_SHARE = 5;
-// Define the number of secrets as a constant or retrieve dynamically
-const int NUM_SECRETS = 2;
-const int NUM_TWO = 2;
-const int NUM_PARTIALLY_OPEN_VALUES = 2;
-
-static std::vector<ShareType> AGREE_RANDOM_VALUES(NUM_PARTIALLY_OPEN_VALUES);
+const CMD_T CMD_INNER_PRODUCT = 6;
+// Tag for d|e style partial-opening messages exchanged between compute parties
+const CMD_T CMD_PARTIAL_OPEN = 7;
+const CMD_T CMD_MATRIX_MULTIPLICATION = 8;
+const CMD_T CMD_EVALUATE_CIRCUIT = 9;
+const CMD_T CMD_MAC_CHECK = 10;
+const CMD_T CMD_MAC_CHECK_FAILED = 11;
+const CMD_T CMD_PRSS_SETUP = 12;
+// Control-channel tags between the partitions of one logical party
+const CMD_T CMD_PARTITION_BARRIER = 13;
+const CMD_T CMD_PARTITION_REDUCE = 14;
+// One chunk of a streamed input file (see Party::setInputFile)
+const CMD_T CMD_SEND_SHARE_CHUNK = 15;
+// Input parties beyond the dealer share straight to the compute parties (see Party::contributeInputs)
+const CMD_T CMD_INPUT_SHARES = 16;
+const CMD_T CMD_INPUT_DONE = 17;
+// The dealer has the compute parties merge what the other input parties shared
+const CMD_T CMD_COLLECT_INPUTS = 18;
+// A compute party's reply to shares it cannot take, e.g. from a dealer of another security mode
+const CMD_T CMD_SHARES_REJECTED = 19;
+// In malicious jobs an input party announces its inputs, is relayed masks for them and
+// opens each input minus its mask (see Party::openInputs)
+const CMD_T CMD_INPUT_MASKS = 20;
+const CMD_T CMD_INPUT_OPENED = 21;
+// Batch MAC check after this many logged openings; 0 checks only at output time
+const SIZE_T MAC_CHECK_INTERVAL = 0;
+// Inputs the dealer shares unless --batch says otherwise; the multiplication and inner
+// product multiply the first half of the batch with the second half element-wise
+const SIZE_T DEFAULT_BATCH_SIZE = 2;
+// Values per chunk when an input file is streamed; bounds the input party's memory
+const SIZE_T INPUT_CHUNK_VALUES = 1 << 14;
+// Bytes per read of a CSV input file
+const SIZE_T INPUT_READ_BYTES = 1 << 16;
+// Input parties, the dealer included, unless --input-parties says otherwise
+const SIZE_T DEFAULT_INPUT_PARTIES = 1;
+// Values per CMD_INPUT_SHARES or CMD_INPUT_OPENED message; bounds the memory one input message takes
+const SIZE_T INPUT_MESSAGE_VALUES = 1 << 10;
+// Encoded result bytes buffered before a chunk is written out (see ResultSink)
+const SIZE_T RESULT_CHUNK_BYTES = 1 << 16;
+// Security of a job, chosen at start with --security (see IParty::create)
+enum class SecurityMode : uint8_t {
+    SEMI_HONEST, // no MACs
+    MALICIOUS    // SPDZ-style MACs checked in batches
+};
+const SecurityMode DEFAULT_SECURITY_MODE = SecurityMode::MALICIOUS;
+// How compute parties open values among themselves and return results to the dealer
+enum class OpeningMode : uint8_t {
+    ALL_TO_ALL, // every party sends to every party
+    KING,       // through KING_PARTY_ID
+    TREE        // k-ary aggregation and dissemination tree
+};
+// Openings go through a king party instead of all-to-all from this many compute parties on
+const int KING_OPENING_MIN_PARTIES = 8;
+const PARTY_ID_T KING_PARTY_ID = 1;
+// ... and through a TREE_ARITY-ary tree from this many on
+const int TREE_OPENING_MIN_PARTIES = 32;
+const SIZE_T TREE_ARITY = 4;
+// Batches with fewer elements than this per worker stay on the calling thread
+const SIZE_T PARALLEL_GRAIN = 256;
+// Milliseconds a receive waits before reporting that nothing arrived
+const int RECEIVE_TIMEOUT_MS = 300;
+// Messages a party's receive thread may hold for its event loop before it stops draining
+// the socket (see INetIOMP::startReceiveThread)
+const SIZE_T RECEIVE_QUEUE_CAPACITY = 1024;
+// Ports of partition q are the partition-0 ports shifted by q * PARTITION_PORT_STRIDE
+const int PARTITION_PORT_STRIDE = 1000;
+// A partition's control-channel port lies this far above its data port (needs n + 1 < offset)
+const int PARTITION_CONTROL_OFFSET = 500;
+// Bytes each party contributes to a jointly sampled seed
+const SIZE_T SEED_SHARE_SIZE = 32;
+// Bytes of one share in fixed-width encodings; shares are reduced mod the 129-bit PRIME_128_STR
+const SIZE_T SHARE_BYTES = 17;
+// Smallest pooled message buffer; size classes double from here
+const SIZE_T BUFFER_POOL_MIN_CAPACITY = 4096;
+// Idle buffers a pool keeps per size class; further returns are freed
+const SIZE_T BUFFER_POOL_MAX_IDLE = 8;
 #endif // CONFIG_H
\ No newline at end of file
@@ -8,12 +8,67 @@
 #include <thread>  // For std::thread
 #include <chrono>  // For timing
 #include "Party.h" // Add this include for the Party class
+#include "PartitionGroup.h"
+#include "NetIOMPMetered.h"
+#include "Logger.h"
+#include "PhaseStats.h"
+#include "Trace.h"
+#include <fstream>
+#include <sstream>
 
 int main(int argc, char* argv[])
 {
+    // --security=, --batch=, --input=, --chunk=, --output=, --output-party=, --input-parties= and
+    // --hosts-file= may appear anywhere; the remaining arguments are positional
+    SecurityMode security = DEFAULT_SECURITY_MODE;
+    SIZE_T batchSize = DEFAULT_BATCH_SIZE;
+    std::string inputPath;
+    SIZE_T chunkValues = INPUT_CHUNK_VALUES;
+    std::string resultPath;
+    PARTY_ID_T outputParty = 0;
+    SIZE_T numInputParties = DEFAULT_INPUT_PARTIES;
+    std::string hostsPath;
+    int positional = 1;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--security=", 0) == 0) {
+            try {
+                security = IParty::securityModeFromName(arg.substr(std::strlen("--security=")));
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--batch=", 0) == 0) {
+            batchSize = static_cast<SIZE_T>(std::strtoul(arg.c_str() + std::strlen("--batch="), nullptr, 10));
+        } else if (arg.rfind("--input=", 0) == 0) {
+            inputPath = arg.substr(std::strlen("--input="));
+        } else if (arg.rfind("--chunk=", 0) == 0) {
+            chunkValues = static_cast<SIZE_T>(std::strtoul(arg.c_str() + std::strlen("--chunk="), nullptr, 10));
+        } else if (arg.rfind("--output=", 0) == 0) {
+            resultPath = arg.substr(std::strlen("--output="));
+        } else if (arg.rfind("--output-party=", 0) == 0) {
+            outputParty = static_cast<PARTY_ID_T>(std::atoi(arg.c_str() + std::strlen("--output-party=")));
+        } else if (arg.rfind("--input-parties=", 0) == 0) {
+            numInputParties = static_cast<SIZE_T>(std::strtoul(arg.c_str() + std::strlen("--input-parties="), nullptr, 10));
+        } else if (arg.rfind("--hosts-file=", 0) == 0) {
+            hostsPath = arg.substr(std::strlen("--hosts-file="));
+        } else {
+            argv[positional++] = argv[i];
+        }
+    }
+    argc = positional;
+
     if (argc < 7) {
-        std::cerr << "Usage: " << argv[0] << " <mode> <party_id> <num_parties> <input_value> <has_secret> <operation>\n";
+        std::cerr << "Usage: " << argv[0] << " <mode> <party_id> <num_parties> <input_value> <has_secret> <operation> [partition num_partitions [hosts]] [--security=malicious|semihonest] [--batch=n] [--input=file [--chunk=n]] [--output=file] [--output-party=id] [--input-parties=m] [--hosts-file=file]\n";
         std::cerr << "Modes: reqrep, dealerrouter" << std::endl;
+        std::cerr << "security: must match across all parties of a job (default: " << IParty::securityModeName(DEFAULT_SECURITY_MODE) << ")" << std::endl;
+        std::cerr << "batch: inputs the dealer shares, at least 2 (default: " << DEFAULT_BATCH_SIZE << "); compute parties take it from the dealer" << std::endl;
+        std::cerr << "input: the dealer streams the values of this file (uint64 binary, or CSV for *.csv) in chunks of n values (default: " << INPUT_CHUNK_VALUES << ") and only sums them" << std::endl;
+        std::cerr << "output: results are streamed to this file, or this compute party's result shares when it does not reconstruct" << std::endl;
+        std::cerr << "output-party: only this compute party reconstructs results (default: 0, the dealer); must match across all parties" << std::endl;
+        std::cerr << "input-parties: the dealer and parties n+2..n+m share inputs concurrently (default: " << DEFAULT_INPUT_PARTIES << "); only the dealer needs it" << std::endl;
+        std::cerr << "hosts: party:host,host,...;party:... with the host of every partition of each listed party (default: 127.0.0.1)" << std::endl;
+        std::cerr << "hosts-file: the same entries, one party per line, instead of the hosts argument" << std::endl;
         return 1;
     }
 
@@ -23,10 +78,42 @@ int main(int argc, char* argv[])
     int inputValue = std::atoi(argv[4]);
     int hasSecretFlag = std::atoi(argv[5]);
     std::string operation = argv[6];
+    // Optional: run as partition <partition> of <num_partitions> processes of this logical party
+    int partition = (argc > 8) ? std::atoi(argv[7]) : 0;
+    int numPartitions = (argc > 8) ? std::atoi(argv[8]) : 1;
+    std::string hostsSpec = (argc > 9) ? argv[9] : "";
+    if (!hostsPath.empty()) {
+        std::ifstream hostsFile(hostsPath);
+        if (!hostsFile) {
+            std::cerr << "Cannot open hosts file " << hostsPath << std::endl;
+            return 1;
+        }
+        std::stringstream contents;
+        contents << hostsFile.rdbuf();
+        hostsSpec += "\n" + contents.str();
+    }
+    PartitionGroup::PartitionHosts partitionHosts;
+    try {
+        partitionHosts = PartitionGroup::parseHosts(hostsSpec, numPartitions);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (numInputParties > 1 && numPartitions > 1) {
+        // Input parties above the dealer share their whole batch with a single partition
+        std::cerr << "Input parties other than the dealer cannot be partitioned" << std::endl;
+        return 1;
+    }
+    if (const char* logLevel = std::getenv("MPC_LOG_LEVEL")) {
+        try {
+            Logger::setLevel(Logger::levelFromName(logLevel));
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
     if (hasSecretFlag == 1) {
-        // #if defined(ENABLE_COUT)
-        std::cout << "[Party " << myPartyId << "] Starting with input value: " << inputValue << "\n";
-        // #endif
+        LOG_INFO("[Party ", myPartyId, "] Starting with input value: ", inputValue);
     } 
 
     // Build the party info map dynamically
@@ -48,29 +135,80 @@ int main(int argc, char* argv[])
     }
 
     try {
-        auto netIOMP = NetIOMPFactory::createNetIOMP(mode, myPartyId, partyInfo, totalParties);
+        // Every partition talks to the matching partition of the other parties
+        auto dataInfo = PartitionGroup::partitionInfo(partyInfo, partition, partitionHosts);
+        auto netIOMP = NetIOMPFactory::createNetIOMP(mode, myPartyId, dataInfo, totalParties);
         if (hasSecretFlag) {
             netIOMP->initDealers();
         } else {
             netIOMP->init();
         }
 
+        // The partitions of this party coordinate over their own DEALER/ROUTER mesh
+        std::unique_ptr<INetIOMP> controlNet;
+        std::unique_ptr<PartitionGroup> partitionGroup;
+        if (numPartitions > 1) {
+            auto controlInfo = PartitionGroup::controlInfo(partyInfo, myPartyId, numPartitions, partitionHosts);
+            controlNet = NetIOMPFactory::createNetIOMP(NetIOMPFactory::Mode::DEALER_ROUTER,
+                                                       static_cast<PARTY_ID_T>(partition + 1), controlInfo, numPartitions);
+            controlNet->init();
+            partitionGroup = std::make_unique<PartitionGroup>(controlNet.get(), partition, numPartitions);
+        }
+
         // Ensure all parties are initialized
         std::this_thread::sleep_for(std::chrono::seconds(2));
+        if (partitionGroup) partitionGroup->barrier();
         
-        Party myParty(myPartyId, totalParties, inputValue, netIOMP.get(), (hasSecretFlag == 1), operation);
-        myParty.init();
-
-        #if defined(ENABLE_COUT)
-        std::cout << "[Party " << myPartyId << "] Closed sockets.\n";
+        #if defined(ENABLE_PHASE_STATS)
+        // Count this party's traffic for the phase report
+        NetIOMPMetered meteredNet(netIOMP.get(), totalParties - 1);
+        PhaseStats phaseStats(&meteredNet);
+        INetIOMP* partyNet = &meteredNet;
+        #else
+        INetIOMP* partyNet = netIOMP.get();
+        #endif
+        std::unique_ptr<IParty> myParty = IParty::create(security, myPartyId, totalParties, inputValue, partyNet,
+                                                         (hasSecretFlag == 1), operation);
+        myParty->setOutputParty(outputParty);
+        if (!resultPath.empty()) myParty->setResultFile(resultPath);
+        if (hasSecretFlag == 1) {
+            myParty->setBatchSize(batchSize);
+            if (!inputPath.empty()) myParty->setInputFile(inputPath, chunkValues);
+            myParty->setNumInputParties(numInputParties);
+        }
+        myParty->setPartitionGroup(partitionGroup.get());
+        #if defined(ENABLE_PHASE_STATS)
+        myParty->setPhaseStats(&phaseStats);
         #endif
+        #if defined(ENABLE_TRACE)
+        Trace::enable(myPartyId, "Party " + std::to_string(myPartyId));
+        #endif
+        myParty->init();
+        #if defined(ENABLE_PHASE_STATS)
+        // Keep the report after the party's own output
+        Logger::instance().flush();
+        phaseStats.print(std::cout, myPartyId, IParty::securityModeName(security), myParty->batchSize());
+        #endif
+        #if defined(ENABLE_TRACE)
+        // One file per process; load them together in ui.perfetto.dev or chrome://tracing
+        std::string tracePath = "trace_party" + std::to_string(myPartyId);
+        if (numPartitions > 1) tracePath += "_partition" + std::to_string(partition);
+        Trace::dump(tracePath + ".json");
+        #endif
+        if (partitionGroup) {
+            // Followers stay up until partition 0 has collected their results; sockets do not linger
+            partitionGroup->barrier();
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+
+        LOG_TRACE("[Party ", myPartyId, "] Closed sockets.");
     }
     catch (const zmq::error_t& e) {
-        std::cerr << "ZeroMQ Error: " << e.what() << std::endl;
+        LOG_ERROR("ZeroMQ Error: ", e.what());
         return 1;
     }
     catch (const std::exception& e) {
-        std::cerr << "[Party " << myPartyId << "] Fatal error: " << e.what() << std::endl;
+        LOG_ERROR("[Party ", myPartyId, "] Fatal error: ", e.what());
         return 1;
     }
 
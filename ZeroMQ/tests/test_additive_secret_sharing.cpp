@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "../src/AdditiveSecretSharing.h"
+#include <openssl/crypto.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string toHex(const BIGNUM* bn) {
+    char* hex = BN_bn2hex(bn);
+    std::string result(hex);
+    OPENSSL_free(hex);
+    return result;
+}
+
+std::vector<std::string> expand(const std::string& seed, SIZE_T count) {
+    std::vector<ShareType> values;
+    AdditiveSecretSharing::expandSeed(seed, count, values);
+    std::vector<std::string> hex;
+    for (auto bn : values) {
+        hex.push_back(toHex(bn));
+        BN_free(bn);
+    }
+    return hex;
+}
+
+} // namespace
+
+// Test 1: Every party holding the seed derives the same coefficients
+TEST(ExpandSeedTest, SameSeedSameValues) {
+    std::string seed = AdditiveSecretSharing::randomBytes(SEED_SHARE_SIZE);
+    EXPECT_EQ(expand(seed, 64), expand(seed, 64));
+}
+
+// Test 2: Parties on different builds must agree, so the expansion is pinned:
+// the first 32 keystream bytes of AES-128-CTR under SHA-256("seed"), mod the prime
+TEST(ExpandSeedTest, KnownAnswer) {
+    std::vector<std::string> values = expand("seed", 1);
+    ASSERT_EQ(values.size(), 1u);
+    EXPECT_EQ(values[0], "3862DBBC2085FD4961EF1CAACA68535D");
+}
+
+// Test 3: A shorter expansion is a prefix of a longer one (CTR keystream)
+TEST(ExpandSeedTest, ShorterExpansionIsPrefix) {
+    std::vector<std::string> longer = expand("prefix", 40);
+    std::vector<std::string> shorter = expand("prefix", 7);
+    ASSERT_EQ(shorter.size(), 7u);
+    EXPECT_TRUE(std::equal(shorter.begin(), shorter.end(), longer.begin()));
+}
+
+// Test 4: Different seeds give unrelated values, all reduced mod the prime
+TEST(ExpandSeedTest, DifferentSeedsDiffer) {
+    std::vector<ShareType> a, b;
+    AdditiveSecretSharing::expandSeed("seed-a", 32, a);
+    AdditiveSecretSharing::expandSeed("seed-b", 32, b);
+    ASSERT_EQ(a.size(), 32u);
+    ASSERT_EQ(b.size(), 32u);
+    SIZE_T equal = 0;
+    for (SIZE_T k = 0; k < a.size(); ++k) {
+        if (BN_cmp(a[k], b[k]) == 0) ++equal;
+        EXPECT_LT(BN_cmp(a[k], AdditiveSecretSharing::getPrime()), 0);
+        EXPECT_FALSE(BN_is_negative(a[k]));
+        BN_free(a[k]);
+        BN_free(b[k]);
+    }
+    EXPECT_EQ(equal, 0u);
+}
+
+// Test 5: Nothing to derive
+TEST(ExpandSeedTest, ZeroCount) {
+    std::vector<ShareType> values;
+    AdditiveSecretSharing::expandSeed("seed", 0, values);
+    EXPECT_TRUE(values.empty());
+}
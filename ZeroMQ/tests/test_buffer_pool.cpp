@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include "../src/BufferPool.h"
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Test 1: Capacities are the power-of-two size classes; size starts at 0 and is bounded by capacity
+TEST(BufferPoolTest, SizeClasses) {
+    BufferPool pool;
+    PooledBuffer small = pool.acquire(1);
+    EXPECT_EQ(small.capacity(), BUFFER_POOL_MIN_CAPACITY);
+    EXPECT_EQ(small.size(), 0u);
+    PooledBuffer exact = pool.acquire(BUFFER_POOL_MIN_CAPACITY);
+    EXPECT_EQ(exact.capacity(), BUFFER_POOL_MIN_CAPACITY);
+    PooledBuffer larger = pool.acquire(BUFFER_POOL_MIN_CAPACITY + 1);
+    EXPECT_EQ(larger.capacity(), 2 * BUFFER_POOL_MIN_CAPACITY);
+    PooledBuffer big = pool.acquire(5 * BUFFER_POOL_MIN_CAPACITY);
+    EXPECT_EQ(big.capacity(), 8 * BUFFER_POOL_MIN_CAPACITY);
+
+    big.resize(big.capacity());
+    EXPECT_EQ(big.size(), big.capacity());
+    EXPECT_THROW(big.resize(big.capacity() + 1), std::runtime_error);
+    EXPECT_EQ(pool.allocations(), 4u);
+}
+
+// Test 2: A returned buffer is handed out again for the same size class, reset to size 0
+TEST(BufferPoolTest, ReturnedBuffersAreReused) {
+    BufferPool pool;
+    char* first;
+    {
+        PooledBuffer buffer = pool.acquire(100);
+        first = buffer.data();
+        std::memcpy(buffer.data(), "hello", 5);
+        buffer.resize(5);
+    }
+    PooledBuffer again = pool.acquire(BUFFER_POOL_MIN_CAPACITY);
+    EXPECT_EQ(again.data(), first);
+    EXPECT_EQ(again.size(), 0u);
+    EXPECT_EQ(pool.allocations(), 1u);
+
+    // Another class does not take it
+    PooledBuffer other = pool.acquire(2 * BUFFER_POOL_MIN_CAPACITY);
+    EXPECT_NE(other.data(), first);
+    EXPECT_EQ(pool.allocations(), 2u);
+}
+
+// Test 3: Once every class in use has been touched, a steady message loop allocates nothing
+TEST(BufferPoolTest, SteadyStateDoesNotAllocate) {
+    BufferPool pool;
+    const std::vector<SIZE_T> sizes = {10, 5000, 4096, 70000, 1, 12000};
+    auto round = [&]() {
+        std::vector<PooledBuffer> inFlight;
+        for (SIZE_T size : sizes) {
+            inFlight.push_back(pool.acquire(size));
+            inFlight.back().resize(size);
+        }
+    };
+    round();
+    SIZE_T warm = pool.allocations();
+    for (int i = 0; i < 100; ++i) round();
+    EXPECT_EQ(pool.allocations(), warm);
+}
+
+// Test 4: Moves carry the buffer; only the final owner returns it, exactly once
+TEST(BufferPoolTest, MoveReturnsOnce) {
+    BufferPool pool;
+    PooledBuffer source = pool.acquire(10);
+    char* data = source.data();
+    source.resize(3);
+    PooledBuffer moved(std::move(source));
+    EXPECT_EQ(moved.data(), data);
+    EXPECT_EQ(moved.size(), 3u);
+    EXPECT_EQ(source.data(), nullptr);
+    EXPECT_EQ(source.capacity(), 0u);
+
+    // Move assignment returns the buffer the target held
+    PooledBuffer target = pool.acquire(10);
+    char* replaced = target.data();
+    target = std::move(moved);
+    EXPECT_EQ(target.data(), data);
+    PooledBuffer reused = pool.acquire(10);
+    EXPECT_EQ(reused.data(), replaced);
+
+    // Had the moved-from buffers also returned theirs, two acquires would get the same memory
+    target = PooledBuffer();
+    PooledBuffer a = pool.acquire(10);
+    PooledBuffer b = pool.acquire(10);
+    EXPECT_NE(a.data(), b.data());
+    EXPECT_EQ(pool.allocations(), 3u);
+}
+
+// Test 5: At most BUFFER_POOL_MAX_IDLE buffers per class are kept; the rest are freed
+TEST(BufferPoolTest, IdleListIsBounded) {
+    BufferPool pool;
+    const SIZE_T extra = 3;
+    {
+        std::vector<PooledBuffer> buffers;
+        for (SIZE_T i = 0; i < BUFFER_POOL_MAX_IDLE + extra; ++i) buffers.push_back(pool.acquire(1));
+    }
+    SIZE_T before = pool.allocations();
+    EXPECT_EQ(before, BUFFER_POOL_MAX_IDLE + extra);
+    {
+        std::vector<PooledBuffer> buffers;
+        for (SIZE_T i = 0; i < BUFFER_POOL_MAX_IDLE + extra; ++i) buffers.push_back(pool.acquire(1));
+    }
+    EXPECT_EQ(pool.allocations(), before + extra);
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "../src/Circuit.h"
+#include <stdexcept>
+
+namespace {
+
+void expectSameGates(const Circuit& a, const Circuit& b) {
+    ASSERT_EQ(a.gates().size(), b.gates().size());
+    for (size_t i = 0; i < a.gates().size(); ++i) {
+        EXPECT_EQ(a.gates()[i].type, b.gates()[i].type) << "gate " << i;
+        EXPECT_EQ(a.gates()[i].in0, b.gates()[i].in0) << "gate " << i;
+        EXPECT_EQ(a.gates()[i].in1, b.gates()[i].in1) << "gate " << i;
+        EXPECT_EQ(a.gates()[i].constant, b.gates()[i].constant) << "gate " << i;
+    }
+}
+
+} // namespace
+
+// Test 1: One line per gate, "type in0 in1 constant"
+TEST(CircuitTest, SerializeWritesOneLinePerGate) {
+    Circuit circuit;
+    SIZE_T a = circuit.addInput();
+    SIZE_T b = circuit.addInput();
+    SIZE_T product = circuit.addMul(a, b);
+    circuit.addOutput(circuit.addConstMul(product, 7));
+
+    EXPECT_EQ(circuit.serialize(), "0 0 0 0\n0 0 0 0\n3 0 1 0\n2 2 0 7\n4 3 0 0\n");
+}
+
+// Test 2: Round trip keeps gates, counts and layering
+TEST(CircuitTest, RoundTripProductAndSum) {
+    Circuit original = Circuit::productAndSum(5);
+    Circuit copy = Circuit::deserialize(original.serialize());
+
+    expectSameGates(original, copy);
+    EXPECT_EQ(copy.numInputs(), original.numInputs());
+    EXPECT_EQ(copy.numOutputs(), original.numOutputs());
+    EXPECT_EQ(copy.numMultiplications(), original.numMultiplications());
+    EXPECT_EQ(copy.multiplicativeDepth(), original.multiplicativeDepth());
+    EXPECT_EQ(copy.layers(), original.layers());
+    EXPECT_EQ(copy.serialize(), original.serialize());
+}
+
+// Test 3: Large constants survive the text encoding
+TEST(CircuitTest, RoundTripKeepsFullWidthConstant) {
+    Circuit circuit;
+    circuit.addOutput(circuit.addConstMul(circuit.addInput(), UINT64_MAX));
+
+    Circuit copy = Circuit::deserialize(circuit.serialize());
+    ASSERT_EQ(copy.gates().size(), 3u);
+    EXPECT_EQ(copy.gates()[1].constant, UINT64_MAX);
+}
+
+// Test 4: An empty description is an empty circuit
+TEST(CircuitTest, DeserializeEmpty) {
+    Circuit circuit = Circuit::deserialize("");
+    EXPECT_TRUE(circuit.gates().empty());
+    EXPECT_EQ(circuit.numInputs(), 0u);
+    EXPECT_EQ(circuit.multiplicativeDepth(), 0u);
+}
+
+// Test 5: Malformed descriptions are rejected
+TEST(CircuitTest, DeserializeRejectsUnknownGateType) {
+    EXPECT_THROW(Circuit::deserialize("0 0 0 0\n9 0 0 0\n"), std::runtime_error);
+}
+
+TEST(CircuitTest, DeserializeRejectsForwardReference) {
+    // The MUL reads wire 2, which is its own output
+    EXPECT_THROW(Circuit::deserialize("0 0 0 0\n0 0 0 0\n3 0 2 0\n"), std::runtime_error);
+}
+
+TEST(CircuitTest, DeserializeRejectsTruncatedOrGarbledLine) {
+    EXPECT_THROW(Circuit::deserialize("0 0 0 0\n3 0\n"), std::runtime_error);
+    EXPECT_THROW(Circuit::deserialize("0 0 0 0\nmul 0 0 0\n"), std::runtime_error);
+}
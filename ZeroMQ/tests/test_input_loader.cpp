@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include "../src/InputLoader.h"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// A file under the temp directory that is removed again at the end of the test
+class TempFile {
+public:
+    TempFile(const std::string &suffix, const std::string &contents) {
+        static int counter = 0;
+        m_path = (std::filesystem::temp_directory_path() /
+                  ("test_input_loader_" + std::to_string(::getpid()) + "_" + std::to_string(counter++) + suffix)).string();
+        std::ofstream out(m_path, std::ios::binary);
+        out << contents;
+    }
+    ~TempFile() { std::filesystem::remove(m_path); }
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+    const std::string &path() const { return m_path; }
+
+private:
+    std::string m_path;
+};
+
+std::string binaryOf(const std::vector<uint64_t> &values) {
+    return std::string(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(uint64_t));
+}
+
+// Every chunk the loader hands out, in order
+std::vector<std::vector<uint64_t>> readAll(const std::string &path, SIZE_T chunkValues) {
+    InputLoader loader(path, InputLoader::formatFromPath(path), chunkValues);
+    std::vector<std::vector<uint64_t>> chunks;
+    std::vector<uint64_t> values;
+    while (loader.next(values)) chunks.push_back(values);
+    SIZE_T total = 0;
+    for (const auto &chunk : chunks) total += chunk.size();
+    EXPECT_EQ(loader.valuesRead(), total);
+    return chunks;
+}
+
+std::vector<uint64_t> flatten(const std::vector<std::vector<uint64_t>> &chunks) {
+    std::vector<uint64_t> values;
+    for (const auto &chunk : chunks) values.insert(values.end(), chunk.begin(), chunk.end());
+    return values;
+}
+
+} // namespace
+
+// Test 1: Only a ".csv" suffix selects CSV
+TEST(InputLoaderTest, FormatFromPath) {
+    EXPECT_EQ(InputLoader::formatFromPath("values.csv"), InputLoader::Format::CSV);
+    EXPECT_EQ(InputLoader::formatFromPath("values.bin"), InputLoader::Format::BINARY);
+    EXPECT_EQ(InputLoader::formatFromPath("csv"), InputLoader::Format::BINARY);
+    EXPECT_EQ(InputLoader::formatFromPath("values.csv.gz"), InputLoader::Format::BINARY);
+}
+
+// Test 2: A CSV value may end the file without a separator; runs of separators are skipped
+TEST(InputLoaderTest, CsvTrailingValueAndSeparators) {
+    TempFile file(".csv", "1,2 3\t4\r\n5,,6\n\n7");
+    EXPECT_EQ(flatten(readAll(file.path(), 100)), (std::vector<uint64_t>{1, 2, 3, 4, 5, 6, 7}));
+    TempFile single(".csv", "42");
+    EXPECT_EQ(flatten(readAll(single.path(), 1)), (std::vector<uint64_t>{42}));
+}
+
+// Test 3: Values cut off at the end of one INPUT_READ_BYTES read continue in the next
+TEST(InputLoaderTest, CsvValuesSplitAcrossReads) {
+    std::vector<uint64_t> expected;
+    std::string text;
+    for (uint64_t value = 1000000007; text.size() < 3 * INPUT_READ_BYTES + 100; value += 7919) {
+        text += std::to_string(value) + ",";
+        expected.push_back(value);
+    }
+    text.pop_back();
+    EXPECT_EQ(flatten(readAll(TempFile(".csv", text).path(), 1000)), expected);
+
+    // A value whose first digits are the last bytes of the first read
+    std::string straddle = std::string(INPUT_READ_BYTES - 3, ' ') + "123456 789";
+    EXPECT_EQ(flatten(readAll(TempFile(".csv", straddle).path(), 10)), (std::vector<uint64_t>{123456, 789}));
+}
+
+// Test 4: Values above UINT64_MAX and characters other than digits and separators are rejected
+TEST(InputLoaderTest, CsvRejectsOverflowAndInvalidCharacters) {
+    EXPECT_EQ(flatten(readAll(TempFile(".csv", "18446744073709551615").path(), 4)),
+              (std::vector<uint64_t>{UINT64_MAX}));
+    EXPECT_THROW(readAll(TempFile(".csv", "1,18446744073709551616").path(), 4), std::runtime_error);
+    EXPECT_THROW(readAll(TempFile(".csv", "1,2,x3").path(), 4), std::runtime_error);
+    EXPECT_THROW(readAll(TempFile(".csv", "-1").path(), 4), std::runtime_error);
+    EXPECT_THROW(readAll(TempFile(".csv", "1.5").path(), 4), std::runtime_error);
+}
+
+// Test 5: A binary file that ends inside a value is rejected rather than truncated
+TEST(InputLoaderTest, BinaryRejectsPartialTail) {
+    std::string contents = binaryOf({1, 2, 3, 4, 5}) + std::string(3, '\x01');
+    TempFile file(".bin", contents);
+    InputLoader loader(file.path(), InputLoader::Format::BINARY, 2);
+    std::vector<uint64_t> values;
+    // Whole chunks before the tail still come through
+    ASSERT_TRUE(loader.next(values));
+    EXPECT_EQ(values, (std::vector<uint64_t>{1, 2}));
+    ASSERT_TRUE(loader.next(values));
+    EXPECT_EQ(values, (std::vector<uint64_t>{3, 4}));
+    EXPECT_THROW(loader.next(values), std::runtime_error);
+}
+
+// Test 6: Files of 0, 1 and N chunks, with a short last chunk, in both formats
+TEST(InputLoaderTest, ChunkCounts) {
+    const SIZE_T chunkValues = 4;
+    for (SIZE_T count : {0, 1, 4, 5, 8, 13}) {
+        std::vector<uint64_t> expected;
+        std::string csv;
+        for (SIZE_T i = 0; i < count; ++i) {
+            expected.push_back(100 + i);
+            csv += std::to_string(100 + i) + "\n";
+        }
+        SIZE_T expectedChunks = (count + chunkValues - 1) / chunkValues;
+        for (const TempFile &file : {TempFile(".bin", binaryOf(expected)), TempFile(".csv", csv)}) {
+            auto chunks = readAll(file.path(), chunkValues);
+            ASSERT_EQ(chunks.size(), expectedChunks) << file.path() << " with " << count << " values";
+            for (SIZE_T c = 0; c + 1 < chunks.size(); ++c) EXPECT_EQ(chunks[c].size(), chunkValues);
+            EXPECT_EQ(flatten(chunks), expected);
+        }
+    }
+}
+
+// Test 7: Missing files and empty chunks are rejected; stopping early does not wait for the file
+TEST(InputLoaderTest, OpenErrorsAndEarlyStop) {
+    EXPECT_THROW(InputLoader("/nonexistent/values.bin", InputLoader::Format::BINARY, 4), std::runtime_error);
+    TempFile file(".bin", binaryOf(std::vector<uint64_t>(1000, 7)));
+    EXPECT_THROW(InputLoader(file.path(), InputLoader::Format::BINARY, 0), std::invalid_argument);
+
+    InputLoader loader(file.path(), InputLoader::Format::BINARY, 10);
+    std::vector<uint64_t> values;
+    ASSERT_TRUE(loader.next(values));
+    EXPECT_EQ(loader.valuesRead(), 10u);
+    // The destructor stops the reader, which has already read ahead
+}
@@ -0,0 +1,399 @@
+#include <gtest/gtest.h>
+#include "../src/Party.h"
+#include "../src/ShareCodec.h"
+#include "../src/Share.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Messages waiting for one receiver, each with the routing id it was sent under
+class Mailbox {
+public:
+    void push(std::string routingId, std::string data) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_messages.emplace_back(std::move(routingId), std::move(data));
+        }
+        m_ready.notify_all();
+    }
+
+    // A negative timeout waits for as long as it takes
+    bool pop(std::pair<std::string, std::string> &message, int timeoutMs) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto ready = [&]() { return !m_messages.empty(); };
+        if (timeoutMs < 0) {
+            m_ready.wait(lock, ready);
+        } else if (!m_ready.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready)) {
+            return false;
+        }
+        message = std::move(m_messages.front());
+        m_messages.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::deque<std::pair<std::string, std::string>> m_messages;
+};
+
+// The ROUTER inbox of every compute party and the DEALER queue of every (sender, party) pair
+class Network {
+public:
+    Mailbox &inbox(PARTY_ID_T party) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_inboxes[party];
+    }
+    Mailbox &replies(PARTY_ID_T sender, PARTY_ID_T party) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_replies[{sender, party}];
+    }
+
+private:
+    std::mutex m_mutex;
+    std::map<PARTY_ID_T, Mailbox> m_inboxes;
+    std::map<std::pair<PARTY_ID_T, PARTY_ID_T>, Mailbox> m_replies;
+};
+
+// In-memory INetIOMP with the "Party<sender>_to_<target>" routing ids of NetIOMPDealerRouter
+class LoopbackNet : public INetIOMP {
+public:
+    LoopbackNet(Network &network, PARTY_ID_T partyId, int numParties)
+        : m_network(network), m_partyId(partyId), m_numParties(numParties) {}
+
+    void init() override {}
+    void initDealers() override {}
+    void sendTo(PARTY_ID_T targetId, const void* data, LENGTH_T length) override {
+        if (targetId < 1 || targetId > m_numParties) {
+            throw std::runtime_error("No router for Party " + std::to_string(targetId));
+        }
+        m_network.inbox(targetId).push("Party" + std::to_string(m_partyId) + "_to_" + std::to_string(targetId),
+                                       std::string(static_cast<const char*>(data), length));
+    }
+    void sendToAll(const void* data, LENGTH_T length) override {
+        for (PARTY_ID_T pid = 1; pid <= m_numParties; ++pid) {
+            if (pid != m_partyId) sendTo(pid, data, length);
+        }
+    }
+    size_t receive(PARTY_ID_T& senderId, void* buffer, LENGTH_T maxLength) override {
+        return receiveAny(senderId, [&](size_t size) {
+            if (size > maxLength) throw std::runtime_error("Buffer too small for received message");
+            return buffer;
+        });
+    }
+    size_t receiveAny(PARTY_ID_T& senderId, const std::function<void*(size_t)>& allocate) override {
+        std::pair<std::string, std::string> message;
+        if (!m_network.inbox(m_partyId).pop(message, RECEIVE_TIMEOUT_MS)) return 0;
+        m_lastRoutingId = message.first;
+        senderId = static_cast<PARTY_ID_T>(std::stoi(message.first.substr(5)));
+        std::memcpy(allocate(message.second.size()), message.second.data(), message.second.size());
+        return message.second.size();
+    }
+    size_t dealerReceive(PARTY_ID_T& routerId, void* buffer, LENGTH_T maxLength) override {
+        std::pair<std::string, std::string> message;
+        m_network.replies(m_partyId, routerId).pop(message, -1);
+        if (message.second.size() > maxLength) throw std::runtime_error("Buffer too small for dealer message");
+        std::memcpy(buffer, message.second.data(), message.second.size());
+        return message.second.size();
+    }
+    void reply(const void* data, LENGTH_T length) override {
+        route(m_lastRoutingId, data, length);
+    }
+    void reply(void* routingIdMsg, const void* data, LENGTH_T length) override {
+        route(std::string(static_cast<char*>(routingIdMsg), m_lastRoutingId.size()), data, length);
+    }
+    void reply(void* routingIdMsg, LENGTH_T idSize, const void* data, LENGTH_T length) override {
+        route(std::string(static_cast<char*>(routingIdMsg), idSize), data, length);
+    }
+    void close() override {}
+    std::string getLastRoutingId() const override { return m_lastRoutingId; }
+
+private:
+    static constexpr int RECEIVE_TIMEOUT_MS = 50;
+
+    // A reply travels back to the DEALER socket of the routing id's sender
+    void route(const std::string &routingId, const void* data, LENGTH_T length) {
+        size_t separator = routingId.find("_to_");
+        PARTY_ID_T sender = static_cast<PARTY_ID_T>(std::stoi(routingId.substr(5, separator - 5)));
+        PARTY_ID_T party = static_cast<PARTY_ID_T>(std::stoi(routingId.substr(separator + 4)));
+        m_network.replies(sender, party).push(routingId, std::string(static_cast<const char*>(data), length));
+    }
+
+    Network &m_network;
+    PARTY_ID_T m_partyId;
+    int m_numParties;
+    std::string m_lastRoutingId;
+};
+
+std::string tempPath(const std::string &suffix) {
+    static int counter = 0;
+    return (std::filesystem::temp_directory_path() /
+            ("test_input_parties_" + std::to_string(::getpid()) + "_" + std::to_string(counter++) + suffix)).string();
+}
+
+// An input party after the dealer: a generated batch starting at its value, or a streamed file
+struct InputSpec {
+    int localValue;
+    SIZE_T batch;
+    std::vector<uint64_t> file;
+};
+
+// Hand-made messages of an input party, which the test sends instead of a Party
+using ForgedInputParty = std::function<void(LoopbackNet&, int numParties)>;
+
+struct JobResult {
+    std::vector<uint64_t> results; // every value the dealer reconstructed, in order
+    std::string dealerError;
+};
+
+// Runs an "add" job: the dealer (value dealerValue) shares dealerBatch values, the input parties
+// after it follow in order, a forged one last
+JobResult runJob(SecurityMode security, int numParties, int dealerValue, SIZE_T dealerBatch,
+                 const std::vector<InputSpec> &inputs, const ForgedInputParty &forged = nullptr) {
+    Network network;
+    std::string resultPath = tempPath(".bin");
+    std::vector<std::string> inputPaths;
+    for (const auto &input : inputs) {
+        inputPaths.emplace_back();
+        if (input.file.empty()) continue;
+        inputPaths.back() = tempPath(".bin");
+        std::ofstream out(inputPaths.back(), std::ios::binary);
+        out.write(reinterpret_cast<const char*>(input.file.data()), input.file.size() * sizeof(uint64_t));
+    }
+
+    PARTY_ID_T dealerId = static_cast<PARTY_ID_T>(numParties + 1);
+    SIZE_T numInputParties = 1 + inputs.size() + (forged ? 1 : 0);
+    JobResult job;
+    std::vector<std::thread> threads;
+    for (PARTY_ID_T pid = 1; pid < static_cast<PARTY_ID_T>(dealerId + numInputParties); ++pid) {
+        threads.emplace_back([&, pid]() {
+            LoopbackNet net(network, pid, numParties);
+            SIZE_T input = static_cast<SIZE_T>(pid - dealerId - 1);
+            if (pid > dealerId && input == inputs.size()) {
+                forged(net, numParties);
+                return;
+            }
+            int localValue = pid == dealerId ? dealerValue : pid > dealerId ? inputs[input].localValue : 0;
+            auto party = IParty::create(security, pid, numParties, localValue, &net, pid >= dealerId, "add");
+            if (pid == dealerId) {
+                party->setBatchSize(dealerBatch);
+                party->setNumInputParties(numInputParties);
+                party->setResultFile(resultPath);
+            } else if (pid > dealerId) {
+                if (inputs[input].file.empty()) {
+                    party->setBatchSize(inputs[input].batch);
+                } else {
+                    party->setInputFile(inputPaths[input], 4);
+                }
+            }
+            try {
+                party->init();
+            } catch (const std::exception &e) {
+                // Compute parties stopped by the dealer may throw too; only the dealer's error counts
+                if (pid == dealerId) job.dealerError = e.what();
+            }
+        });
+    }
+    for (auto &thread : threads) thread.join();
+
+    std::ifstream in(resultPath, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::filesystem::remove(resultPath);
+    for (const auto &path : inputPaths) {
+        if (!path.empty()) std::filesystem::remove(path);
+    }
+    std::vector<ShareType> raw;
+    SIZE_T count = bytes.empty() ? 0 : decodeSharesBinary(bytes.data(), bytes.size(), raw);
+    std::vector<Share> values = adoptShares(raw);
+    for (SIZE_T k = 0; k < count; ++k) job.results.push_back(BN_get_word(values[k]));
+    return job;
+}
+
+// The inputs the compute parties hold after merging: the dealer's, then each input party's
+// batch, or the sum of its file, in party order
+std::vector<uint64_t> mergedInputs(int dealerValue, SIZE_T dealerBatch, const std::vector<InputSpec> &inputs) {
+    std::vector<uint64_t> merged;
+    for (SIZE_T i = 0; i < dealerBatch; ++i) merged.push_back(dealerValue + i);
+    for (const auto &input : inputs) {
+        if (input.file.empty()) {
+            for (SIZE_T i = 0; i < input.batch; ++i) merged.push_back(input.localValue + i);
+        } else {
+            uint64_t sum = 0;
+            for (uint64_t value : input.file) sum += value;
+            merged.push_back(sum);
+        }
+    }
+    return merged;
+}
+
+// The sum of all inputs, then the first half of them times the second half
+std::vector<uint64_t> expectedResults(const std::vector<uint64_t> &merged) {
+    std::vector<uint64_t> expected{0};
+    for (uint64_t value : merged) expected[0] += value;
+    SIZE_T numProducts = merged.size() / 2;
+    for (SIZE_T k = 0; k < numProducts; ++k) expected.push_back(merged[k] * merged[numProducts + k]);
+    return expected;
+}
+
+// [CMD_INPUT_SHARES][fold][count] then the shares of count values, as sendInputShares builds it
+std::string inputSharesMessage(const std::vector<Share> &shares, bool fold) {
+    const SIZE_T header = sizeof(CMD_T) + sizeof(uint8_t) + sizeof(SIZE_T);
+    std::string msg(header + encodedSharesSize(shares.size()), '\0');
+    uint8_t foldFlag = fold ? 1 : 0;
+    SIZE_T count = shares.size();
+    std::memcpy(&msg[0], &CMD_INPUT_SHARES, sizeof(CMD_T));
+    std::memcpy(&msg[sizeof(CMD_T)], &foldFlag, sizeof(uint8_t));
+    std::memcpy(&msg[sizeof(CMD_T) + sizeof(uint8_t)], &count, sizeof(SIZE_T));
+    msg.resize(header + encodeShares(borrowShares(shares), &msg[header]));
+    return msg;
+}
+
+// [CMD_INPUT_MASKS][inputs][values], as openInputs announces the inputs of a malicious job
+std::string inputMasksMessage(SIZE_T inputs, SIZE_T values) {
+    std::string msg(sizeof(CMD_T) + 2 * sizeof(SIZE_T), '\0');
+    std::memcpy(&msg[0], &CMD_INPUT_MASKS, sizeof(CMD_T));
+    std::memcpy(&msg[sizeof(CMD_T)], &inputs, sizeof(SIZE_T));
+    std::memcpy(&msg[sizeof(CMD_T) + sizeof(SIZE_T)], &values, sizeof(SIZE_T));
+    return msg;
+}
+
+// [CMD_INPUT_OPENED][1] then one opened value, as openInputs sends it
+std::string inputOpenedMessage(const Share &value) {
+    const SIZE_T header = sizeof(CMD_T) + sizeof(SIZE_T);
+    std::string msg(header + encodedSharesSize(1), '\0');
+    SIZE_T count = 1;
+    std::memcpy(&msg[0], &CMD_INPUT_OPENED, sizeof(CMD_T));
+    std::memcpy(&msg[sizeof(CMD_T)], &count, sizeof(SIZE_T));
+    msg.resize(header + encodeShares({value.get()}, &msg[header]));
+    return msg;
+}
+
+} // namespace
+
+// Test 1: Batched and streamed contributions of several input parties merge in party order
+TEST(InputPartiesTest, MixedContributionsMergeInPartyOrder) {
+    const std::vector<InputSpec> inputs = {
+        {100, 3, {}},
+        {0, 0, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10}},
+        {200, 2, {}},
+        {0, 0, {1000}},
+    };
+    std::vector<uint64_t> expected = expectedResults(mergedInputs(10, 4, inputs));
+    for (SecurityMode security : {SecurityMode::SEMI_HONEST, SecurityMode::MALICIOUS}) {
+        JobResult job = runJob(security, 3, 10, 4, inputs);
+        EXPECT_EQ(job.dealerError, "") << IParty::securityModeName(security);
+        EXPECT_EQ(job.results, expected) << IParty::securityModeName(security);
+    }
+}
+
+// Test 2: Files and batches above INPUT_MESSAGE_VALUES arrive in several messages per party
+TEST(InputPartiesTest, ContributionsSpanSeveralMessages) {
+    std::vector<uint64_t> file;
+    for (uint64_t value = 1; value <= 3 * INPUT_MESSAGE_VALUES + 5; ++value) file.push_back(value);
+    const std::vector<InputSpec> inputs = {
+        {0, 0, file},
+        {500, INPUT_MESSAGE_VALUES + 1, {}},
+    };
+    JobResult job = runJob(SecurityMode::MALICIOUS, 2, 1, 2, inputs);
+    EXPECT_EQ(job.dealerError, "");
+    EXPECT_EQ(job.results, expectedResults(mergedInputs(1, 2, inputs)));
+}
+
+// Test 3: An input party that gives compute parties different numbers of inputs stops the job
+TEST(InputPartiesTest, CountMismatchStopsTheJob) {
+    ForgedInputParty unequalShares = [](LoopbackNet &net, int numParties) {
+        for (PARTY_ID_T pid = 1; pid <= numParties; ++pid) {
+            // Party 1 gets two inputs, the others three
+            std::vector<Share> shares;
+            for (int k = 0; k < (pid == 1 ? 2 : 3); ++k) shares.push_back(Share::zero());
+            std::string msg = inputSharesMessage(shares, false);
+            net.sendTo(pid, msg.data(), msg.size());
+            net.sendTo(pid, &CMD_INPUT_DONE, sizeof(CMD_T));
+        }
+        CMD_T reply;
+        for (PARTY_ID_T pid = 1; pid <= numParties; ++pid) net.dealerReceive(pid, &reply, sizeof(CMD_T));
+    };
+    // Malicious jobs only take announcements; the job stops before any mask is relayed
+    ForgedInputParty unequalAnnouncements = [](LoopbackNet &net, int numParties) {
+        for (PARTY_ID_T pid = 1; pid <= numParties; ++pid) {
+            std::string msg = inputMasksMessage(pid == 1 ? 2 : 3, pid == 1 ? 2 : 3);
+            net.sendTo(pid, msg.data(), msg.size());
+        }
+    };
+    JobResult semiHonest = runJob(SecurityMode::SEMI_HONEST, 3, 10, 4, {{100, 2, {}}}, unequalShares);
+    EXPECT_EQ(semiHonest.dealerError, "Party 2 merged other inputs than Party 1");
+    EXPECT_TRUE(semiHonest.results.empty());
+    JobResult malicious = runJob(SecurityMode::MALICIOUS, 3, 10, 4, {{100, 2, {}}}, unequalAnnouncements);
+    EXPECT_EQ(malicious.dealerError, "Party 2 merged other inputs than Party 1");
+    EXPECT_TRUE(malicious.results.empty());
+}
+
+// Test 4: A malicious job takes no shares of inputs, which no MAC would protect
+TEST(InputPartiesTest, SharesAreRejectedInMaliciousJobs) {
+    ForgedInputParty rawShares = [](LoopbackNet &net, int numParties) {
+        std::vector<Share> shares;
+        shares.push_back(Share::zero());
+        std::string msg = inputSharesMessage(shares, false);
+        for (PARTY_ID_T pid = 1; pid <= numParties; ++pid) {
+            net.sendTo(pid, msg.data(), msg.size());
+            net.sendTo(pid, &CMD_INPUT_DONE, sizeof(CMD_T));
+        }
+        for (PARTY_ID_T pid = 1; pid <= numParties; ++pid) {
+            CMD_T reply;
+            net.dealerReceive(pid, &reply, sizeof(CMD_T));
+            EXPECT_EQ(reply, CMD_SHARES_REJECTED);
+        }
+    };
+    JobResult job = runJob(SecurityMode::MALICIOUS, 3, 10, 4, {{100, 2, {}}}, rawShares);
+    EXPECT_EQ(job.dealerError, "Party 1 rejected an input party's messages; every party of a job must run the same --security");
+    EXPECT_TRUE(job.results.empty());
+}
+
+// Test 5: An input party that opens x - r differently to different compute parties stops the job
+TEST(InputPartiesTest, UnequalOpeningsStopTheJob) {
+    ForgedInputParty unequalOpenings = [](LoopbackNet &net, int numParties) {
+        std::string announce = inputMasksMessage(1, 1);
+        for (PARTY_ID_T pid = 1; pid <= numParties; ++pid) net.sendTo(pid, announce.data(), announce.size());
+        // Sum the relayed shares of "r|beta|t" to learn the one mask
+        Share mask = Share::zero();
+        for (PARTY_ID_T pid = 1; pid <= numParties; ++pid) {
+            std::string relay(encodedSharesSize(3), '\0');
+            relay.resize(net.dealerReceive(pid, &relay[0], relay.size()));
+            std::vector<ShareType> raw;
+            ASSERT_EQ(decodeShares(relay.data(), relay.size(), raw), 3u);
+            std::vector<Share> parts = adoptShares(raw);
+            BN_mod_add(mask, mask, parts[0], AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+        }
+        // Party 1 sees 7 - r, the others 8 - r
+        for (PARTY_ID_T pid = 1; pid <= numParties; ++pid) {
+            Share opened = Share::zero();
+            BN_set_word(opened, pid == 1 ? 7 : 8);
+            BN_mod_sub(opened, opened, mask, AdditiveSecretSharing::getPrime(), AdditiveSecretSharing::getCtx());
+            std::string msg = inputOpenedMessage(opened);
+            net.sendTo(pid, msg.data(), msg.size());
+            net.sendTo(pid, &CMD_INPUT_DONE, sizeof(CMD_T));
+        }
+        CMD_T reply;
+        for (PARTY_ID_T pid = 1; pid <= numParties; ++pid) net.dealerReceive(pid, &reply, sizeof(CMD_T));
+    };
+    JobResult job = runJob(SecurityMode::MALICIOUS, 3, 10, 4, {{100, 2, {}}}, unequalOpenings);
+    EXPECT_EQ(job.dealerError, "Party 2 received other input openings than Party 1");
+    EXPECT_TRUE(job.results.empty());
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include "../src/PartitionGroup.h"
+#include "../src/AdditiveSecretSharing.h"
+#include "../src/NetIOMPDealerRouter.h"
+#include "../src/Share.h"
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Test 1: Every listed party gets its own host per partition, from one line or from file lines
+TEST(PartitionGroupTest, ParseHostsPerParty) {
+    auto hosts = PartitionGroup::parseHosts("1:10.0.0.1,10.0.0.2; 4:10.0.1.1,10.0.1.2", 2);
+    ASSERT_EQ(hosts.size(), 2u);
+    EXPECT_EQ(hosts.at(1), (std::vector<std::string>{"10.0.0.1", "10.0.0.2"}));
+    EXPECT_EQ(hosts.at(4), (std::vector<std::string>{"10.0.1.1", "10.0.1.2"}));
+
+    auto fromFile = PartitionGroup::parseHosts("# party:hosts\n2:a,b,c\n\n3:d,e,f\r\n", 3);
+    ASSERT_EQ(fromFile.size(), 2u);
+    EXPECT_EQ(fromFile.at(2), (std::vector<std::string>{"a", "b", "c"}));
+    EXPECT_EQ(fromFile.at(3), (std::vector<std::string>{"d", "e", "f"}));
+
+    EXPECT_TRUE(PartitionGroup::parseHosts("", 4).empty());
+}
+
+// Test 2: Malformed entries, repeated parties and wrong host counts are rejected
+TEST(PartitionGroupTest, ParseHostsRejectsBadEntries) {
+    EXPECT_THROW(PartitionGroup::parseHosts("10.0.0.1,10.0.0.2", 2), std::invalid_argument);
+    EXPECT_THROW(PartitionGroup::parseHosts("x:a,b", 2), std::invalid_argument);
+    EXPECT_THROW(PartitionGroup::parseHosts("0:a,b", 2), std::invalid_argument);
+    EXPECT_THROW(PartitionGroup::parseHosts("1:a,b;1:c,d", 2), std::invalid_argument);
+    EXPECT_THROW(PartitionGroup::parseHosts("1:a,b,c", 2), std::invalid_argument);
+}
+
+// Test 3: Data endpoints use each party's own partition host and the shifted ports
+TEST(PartitionGroupTest, PartitionInfoUsesEachPartysHosts) {
+    PartitionGroup::PartyInfo partyInfo = {{1, {"127.0.0.1", 5555}}, {2, {"127.0.0.1", 5556}}, {3, {"127.0.0.1", 5557}}};
+    auto hosts = PartitionGroup::parseHosts("1:h1a,h1b;2:h2a,h2b", 2);
+
+    auto first = PartitionGroup::partitionInfo(partyInfo, 0, hosts);
+    EXPECT_EQ(first.at(1), (std::pair<std::string, int>{"h1a", 5555}));
+    EXPECT_EQ(first.at(2), (std::pair<std::string, int>{"h2a", 5556}));
+    EXPECT_EQ(first.at(3), (std::pair<std::string, int>{"127.0.0.1", 5557}));
+
+    auto second = PartitionGroup::partitionInfo(partyInfo, 1, hosts);
+    EXPECT_EQ(second.at(1), (std::pair<std::string, int>{"h1b", 5555 + PARTITION_PORT_STRIDE}));
+    EXPECT_EQ(second.at(2), (std::pair<std::string, int>{"h2b", 5556 + PARTITION_PORT_STRIDE}));
+    EXPECT_EQ(second.at(3), (std::pair<std::string, int>{"127.0.0.1", 5557 + PARTITION_PORT_STRIDE}));
+}
+
+// Test 4: Control endpoints of a party, the dealer included, lie on that party's hosts
+TEST(PartitionGroupTest, ControlInfoUsesThePartysHosts) {
+    PartitionGroup::PartyInfo partyInfo = {{1, {"127.0.0.1", 5555}}, {2, {"127.0.0.1", 5556}}, {3, {"127.0.0.1", 5557}}};
+    auto hosts = PartitionGroup::parseHosts("2:h2a,h2b;4:d0,d1", 2);
+
+    auto party2 = PartitionGroup::controlInfo(partyInfo, 2, 2, hosts);
+    EXPECT_EQ(party2.at(1), (std::pair<std::string, int>{"h2a", 5556 + PARTITION_CONTROL_OFFSET}));
+    EXPECT_EQ(party2.at(2), (std::pair<std::string, int>{"h2b", 5556 + PARTITION_PORT_STRIDE + PARTITION_CONTROL_OFFSET}));
+
+    // The dealer is not in partyInfo and continues its port numbering
+    auto dealer = PartitionGroup::controlInfo(partyInfo, 4, 2, hosts);
+    EXPECT_EQ(dealer.at(1), (std::pair<std::string, int>{"d0", 5558 + PARTITION_CONTROL_OFFSET}));
+    EXPECT_EQ(dealer.at(2), (std::pair<std::string, int>{"d1", 5558 + PARTITION_PORT_STRIDE + PARTITION_CONTROL_OFFSET}));
+
+    auto party1 = PartitionGroup::controlInfo(partyInfo, 1, 2, hosts);
+    EXPECT_EQ(party1.at(2).first, "127.0.0.1");
+}
+
+// Test 5: Partitions on loopback sockets pass the barrier and reduce their results into partition 0
+TEST(PartitionGroupTest, LoopbackBarrierAndReduceSum) {
+    const int numPartitions = 3;
+    PartitionGroup::PartyInfo partyInfo = {{1, {"127.0.0.1", 20000 + std::rand() % 5000}}};
+    auto controlInfo = PartitionGroup::controlInfo(partyInfo, 1, numPartitions, {});
+
+    std::vector<std::unique_ptr<NetIOMPDealerRouter>> nets;
+    for (int q = 0; q < numPartitions; ++q) {
+        nets.push_back(std::make_unique<NetIOMPDealerRouter>(static_cast<PARTY_ID_T>(q + 1), controlInfo, numPartitions));
+        nets.back()->init();
+    }
+
+    // A small batch, then one large enough to grow the receive buffer
+    const std::vector<SIZE_T> batchSizes = {4, 5000};
+    std::vector<std::vector<std::vector<BN_ULONG>>> totals(numPartitions);
+    std::vector<bool> leader(numPartitions);
+    std::vector<std::thread> threads;
+    for (int q = 0; q < numPartitions; ++q) {
+        threads.emplace_back([&, q]() {
+            PartitionGroup group(nets[q].get(), q, numPartitions);
+            group.barrier();
+            for (SIZE_T batchSize : batchSizes) {
+                std::vector<Share> owned;
+                for (SIZE_T i = 0; i < batchSize; ++i) {
+                    owned.push_back(Share::zero());
+                    BN_set_word(owned.back(), (q + 1) * 1000 + i);
+                }
+                std::vector<ShareType> values = borrowShares(owned);
+                leader[q] = group.reduceSum(values);
+                std::vector<BN_ULONG> words;
+                for (auto value : values) words.push_back(BN_get_word(value));
+                totals[q].push_back(words);
+            }
+            group.barrier();
+        });
+    }
+    for (auto &thread : threads) thread.join();
+    for (auto &net : nets) net->close();
+
+    EXPECT_TRUE(leader[0]);
+    for (int q = 1; q < numPartitions; ++q) EXPECT_FALSE(leader[q]);
+    ASSERT_EQ(totals[0].size(), batchSizes.size());
+    for (SIZE_T b = 0; b < batchSizes.size(); ++b) {
+        ASSERT_EQ(totals[0][b].size(), batchSizes[b]);
+        for (SIZE_T i = 0; i < batchSizes[b]; ++i) {
+            // (1 + 2 + 3) * 1000 + 3 * i
+            ASSERT_EQ(totals[0][b][i], 6000 + 3 * i) << "batch " << b << " index " << i;
+        }
+    }
+}
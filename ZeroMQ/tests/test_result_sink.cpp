@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include "../src/ResultSink.h"
+#include "../src/ShareCodec.h"
+#include "../src/Share.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+std::string tempPath() {
+    static int counter = 0;
+    return (std::filesystem::temp_directory_path() /
+            ("test_result_sink_" + std::to_string(::getpid()) + "_" + std::to_string(counter++) + ".bin")).string();
+}
+
+// Batches of consecutive values starting at 1, one per entry of sizes
+std::vector<std::vector<Share>> makeBatches(const std::vector<SIZE_T> &sizes) {
+    std::vector<std::vector<Share>> batches;
+    BN_ULONG next = 1;
+    for (SIZE_T size : sizes) {
+        batches.emplace_back();
+        for (SIZE_T i = 0; i < size; ++i) {
+            batches.back().push_back(Share::zero());
+            BN_set_word(batches.back().back(), next++);
+        }
+    }
+    return batches;
+}
+
+// Writes the batches through a sink and checks the file decodes back to them, in order
+void expectRoundTrip(const std::vector<SIZE_T> &sizes, SIZE_T chunkBytes) {
+    std::string path = tempPath();
+    auto batches = makeBatches(sizes);
+    SIZE_T total = 0;
+    {
+        ResultSink sink(path, chunkBytes);
+        for (const auto &batch : batches) {
+            sink.write(borrowShares(batch));
+            total += batch.size();
+        }
+        EXPECT_EQ(sink.valuesWritten(), total);
+        sink.close();
+    }
+    std::ifstream in(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::filesystem::remove(path);
+    ASSERT_EQ(bytes.size(), encodedSharesBinarySize(total));
+
+    std::vector<ShareType> raw;
+    ASSERT_EQ(decodeSharesBinary(bytes.data(), bytes.size(), raw), total);
+    std::vector<Share> decoded = adoptShares(raw);
+    for (SIZE_T i = 0; i < total; ++i) {
+        ASSERT_EQ(BN_get_word(decoded[i]), i + 1) << "value " << i << " with chunks of " << chunkBytes << " bytes";
+    }
+}
+
+} // namespace
+
+// Test 1: Batches of any size read back with decodeSharesBinary, in write order
+TEST(ResultSinkTest, RoundTrip) {
+    expectRoundTrip({1}, RESULT_CHUNK_BYTES);
+    expectRoundTrip({3, 0, 7, 1000, 5000, 2}, RESULT_CHUNK_BYTES);
+    expectRoundTrip({1, 1, 1, 1, 1}, 1);
+}
+
+// Test 2: A chunk that fills exactly chunkBytes is handed off and the next one starts empty
+TEST(ResultSinkTest, HandOffAtChunkBoundary) {
+    const SIZE_T perChunk = 4;
+    expectRoundTrip({perChunk}, perChunk * SHARE_BYTES);
+    expectRoundTrip({perChunk, perChunk, 2, 2, perChunk + 1}, perChunk * SHARE_BYTES);
+
+    // RESULT_CHUNK_BYTES is no multiple of SHARE_BYTES: the largest multiple below it
+    // hits the threshold exactly, and the default threshold is crossed by one value
+    SIZE_T exactValues = RESULT_CHUNK_BYTES / SHARE_BYTES;
+    expectRoundTrip({exactValues, exactValues, 1}, exactValues * SHARE_BYTES);
+    expectRoundTrip({exactValues, 1, exactValues}, RESULT_CHUNK_BYTES);
+    expectRoundTrip({exactValues + 1, exactValues + 1}, RESULT_CHUNK_BYTES);
+}
+
+// Test 3: A sink that never got a value leaves an empty file; close may be called twice
+TEST(ResultSinkTest, EmptySink) {
+    std::string path = tempPath();
+    {
+        ResultSink sink(path);
+        sink.close();
+        sink.close();
+        EXPECT_EQ(sink.valuesWritten(), 0u);
+    }
+    EXPECT_EQ(std::filesystem::file_size(path), 0u);
+    std::filesystem::remove(path);
+}
+
+// Test 4: Writing after close and creating a file in a missing directory fail
+TEST(ResultSinkTest, UsageErrors) {
+    EXPECT_THROW(ResultSink("/nonexistent/results.bin"), std::runtime_error);
+    std::string path = tempPath();
+    ResultSink sink(path);
+    sink.close();
+    auto batches = makeBatches({1});
+    EXPECT_THROW(sink.write(borrowShares(batches[0])), std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+// Test 5: Failed writes are reported by close(), for whole chunks and for the buffered tail
+TEST(ResultSinkTest, CloseReportsWriteErrors) {
+    if (!std::filesystem::exists("/dev/full")) GTEST_SKIP() << "needs /dev/full";
+    auto batches = makeBatches({1, 2 * RESULT_CHUNK_BYTES / SHARE_BYTES});
+
+    // A few bytes stay in the stream buffer until the file is closed
+    {
+        ResultSink sink("/dev/full");
+        sink.write(borrowShares(batches[0]));
+        EXPECT_THROW(sink.close(), std::runtime_error);
+    }
+    // Whole chunks fail on the writer thread; the error surfaces on a later call
+    {
+        ResultSink sink("/dev/full", SHARE_BYTES);
+        bool reported = false;
+        try {
+            sink.write(borrowShares(batches[1]));
+            sink.write(borrowShares(batches[1]));
+            sink.close();
+        } catch (const std::runtime_error &) {
+            reported = true;
+        }
+        EXPECT_TRUE(reported);
+    }
+}
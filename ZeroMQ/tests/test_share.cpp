@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include "../src/Share.h"
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+static_assert(!std::is_copy_constructible<Share>::value, "Share must not be copyable");
+static_assert(!std::is_copy_assignable<Share>::value, "Share must not be copy-assignable");
+static_assert(std::is_nothrow_move_constructible<Share>::value, "vectors of Share must move on growth");
+static_assert(std::is_nothrow_move_assignable<Share>::value, "Share must move-assign without throwing");
+
+namespace {
+
+Share shareOf(BN_ULONG value) {
+    Share share = Share::zero();
+    BN_set_word(share, value);
+    return share;
+}
+
+} // namespace
+
+// Test 1: zero() owns a fresh BIGNUM holding zero; a default Share owns nothing
+TEST(ShareTest, ZeroAndEmpty) {
+    Share zero = Share::zero();
+    ASSERT_TRUE(zero);
+    EXPECT_TRUE(BN_is_zero(zero));
+
+    Share empty;
+    EXPECT_FALSE(empty);
+    EXPECT_EQ(empty.get(), nullptr);
+}
+
+// Test 2: Moving hands over the same BIGNUM and leaves the source empty
+TEST(ShareTest, MoveConstructTransfersOwnership) {
+    Share source = shareOf(42);
+    BIGNUM* bn = source.get();
+    Share target(std::move(source));
+    EXPECT_EQ(target.get(), bn);
+    EXPECT_EQ(BN_get_word(target), 42u);
+    EXPECT_FALSE(source);
+}
+
+// Test 3: Move assignment frees the old value, takes the new one and survives self-assignment
+TEST(ShareTest, MoveAssign) {
+    Share target = shareOf(1);
+    Share source = shareOf(2);
+    BIGNUM* bn = source.get();
+    target = std::move(source);
+    EXPECT_EQ(target.get(), bn);
+    EXPECT_EQ(BN_get_word(target), 2u);
+    EXPECT_FALSE(source);
+
+    Share &alias = target;
+    target = std::move(alias);
+    EXPECT_EQ(target.get(), bn);
+    EXPECT_EQ(BN_get_word(target), 2u);
+
+    // Assigning an empty Share releases the held value
+    target = Share();
+    EXPECT_FALSE(target);
+}
+
+// Test 4: clone is a deep copy; release gives up ownership without freeing
+TEST(ShareTest, CloneAndRelease) {
+    Share original = shareOf(7);
+    Share copy = original.clone();
+    ASSERT_TRUE(copy);
+    EXPECT_NE(copy.get(), original.get());
+    BN_set_word(copy, 8);
+    EXPECT_EQ(BN_get_word(original), 7u);
+    EXPECT_FALSE(Share().clone());
+
+    BIGNUM* raw = original.release();
+    EXPECT_FALSE(original);
+    EXPECT_EQ(BN_get_word(raw), 7u);
+    BN_free(raw);
+}
+
+// Test 5: Vectors of Share move their elements on growth, so the BIGNUMs stay where they are
+TEST(ShareTest, VectorGrowthMovesShares) {
+    std::vector<Share> shares;
+    std::vector<BIGNUM*> addresses;
+    for (BN_ULONG i = 0; i < 100; ++i) {
+        shares.push_back(shareOf(i));
+        addresses.push_back(shares.back().get());
+    }
+    for (SIZE_T i = 0; i < shares.size(); ++i) {
+        EXPECT_EQ(shares[i].get(), addresses[i]);
+        EXPECT_EQ(BN_get_word(shares[i]), i);
+    }
+    std::vector<Share> moved = std::move(shares);
+    EXPECT_EQ(moved.front().get(), addresses.front());
+}
+
+// Test 6: borrowShares only views the shares; adoptShares takes ownership of raw ones
+TEST(ShareTest, BorrowAndAdopt) {
+    std::vector<Share> owned;
+    owned.push_back(shareOf(3));
+    owned.push_back(shareOf(4));
+    std::vector<ShareType> view = borrowShares(owned);
+    ASSERT_EQ(view.size(), 2u);
+    EXPECT_EQ(view[0], owned[0].get());
+    EXPECT_EQ(view[1], owned[1].get());
+
+    std::vector<ShareType> raw = {BN_new(), BN_new()};
+    BN_set_word(raw[0], 5);
+    BN_set_word(raw[1], 6);
+    std::vector<Share> adopted = adoptShares(raw);
+    ASSERT_EQ(adopted.size(), 2u);
+    EXPECT_EQ(adopted[0].get(), raw[0]);
+    EXPECT_EQ(BN_get_word(adopted[1]), 6u);
+}
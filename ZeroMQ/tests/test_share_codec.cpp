@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include "../src/ShareCodec.h"
+#include "../src/Share.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Random shares below 2^128, plus zero and the largest value that fits SHARE_BYTES
+std::vector<Share> sampleShares(SIZE_T count) {
+    std::vector<Share> shares;
+    for (SIZE_T i = 0; i < count; ++i) {
+        shares.push_back(Share::zero());
+        if (i == 1) {
+            std::vector<unsigned char> ones(SHARE_BYTES, 0xFF);
+            BN_bin2bn(ones.data(), SHARE_BYTES, shares.back());
+        } else if (i > 1) {
+            BN_rand(shares.back(), 128, BN_RAND_TOP_ANY, BN_RAND_BOTTOM_ANY);
+        }
+    }
+    return shares;
+}
+
+void expectSameShares(const std::vector<Share> &expected, const std::vector<ShareType> &actual, SIZE_T count) {
+    ASSERT_GE(actual.size(), count);
+    for (SIZE_T i = 0; i < count; ++i) {
+        ASSERT_EQ(BN_cmp(expected[i], actual[i]), 0) << "share " << i;
+    }
+}
+
+} // namespace
+
+// Test 1: Hex batches of every size round-trip, the parallel path for large batches included
+TEST(ShareCodecTest, HexRoundTrip) {
+    for (SIZE_T count : {0, 1, 2, 3, 255, 256, 257, 3000}) {
+        std::vector<Share> shares = sampleShares(count);
+        std::string wire(encodedSharesSize(count), '\0');
+        ASSERT_EQ(encodeShares(borrowShares(shares), &wire[0]), wire.size());
+        std::vector<ShareType> raw;
+        ASSERT_EQ(decodeShares(wire.data(), wire.size(), raw), count) << "count " << count;
+        std::vector<Share> decoded = adoptShares(raw);
+        expectSameShares(shares, raw, count);
+    }
+}
+
+// Test 2: Binary batches round-trip and take SHARE_BYTES per share
+TEST(ShareCodecTest, BinaryRoundTrip) {
+    for (SIZE_T count : {0, 1, 2, 257, 3000}) {
+        std::vector<Share> shares = sampleShares(count);
+        std::string wire(encodedSharesBinarySize(count), '\0');
+        EXPECT_EQ(wire.size(), count * SHARE_BYTES);
+        ASSERT_EQ(encodeSharesBinary(borrowShares(shares), &wire[0]), wire.size());
+        std::vector<ShareType> raw;
+        ASSERT_EQ(decodeSharesBinary(wire.data(), wire.size(), raw), count) << "count " << count;
+        std::vector<Share> decoded = adoptShares(raw);
+        expectSameShares(shares, raw, count);
+    }
+}
+
+// Test 3: The hex format is fixed-width upper-case with '|' between shares; lower case decodes too
+TEST(ShareCodecTest, HexLayout) {
+    std::vector<Share> shares;
+    shares.push_back(Share::zero());
+    BN_set_word(shares.back(), 0xAB);
+    shares.push_back(Share::zero());
+    std::string wire(encodedSharesSize(2), '\0');
+    encodeShares(borrowShares(shares), &wire[0]);
+    EXPECT_EQ(wire, std::string(SHARE_HEX_DIGITS - 2, '0') + "AB|" + std::string(SHARE_HEX_DIGITS, '0'));
+
+    std::string lower = std::string(SHARE_HEX_DIGITS - 2, '0') + "ab";
+    std::vector<ShareType> raw;
+    ASSERT_EQ(decodeShares(lower.data(), lower.size(), raw), 1u);
+    std::vector<Share> decoded = adoptShares(raw);
+    EXPECT_EQ(BN_get_word(decoded[0]), 0xABu);
+}
+
+// Test 4: Decoding again into the same vector reuses its entries and never shrinks it
+TEST(ShareCodecTest, DecodeReusesEntries) {
+    std::vector<Share> shares = sampleShares(5);
+    std::string wire(encodedSharesSize(5), '\0');
+    encodeShares(borrowShares(shares), &wire[0]);
+    std::vector<ShareType> raw;
+    decodeShares(wire.data(), wire.size(), raw);
+    std::vector<ShareType> first = raw;
+
+    std::vector<Share> fewer = sampleShares(3);
+    std::string shorter(encodedSharesSize(3), '\0');
+    encodeShares(borrowShares(fewer), &shorter[0]);
+    ASSERT_EQ(decodeShares(shorter.data(), shorter.size(), raw), 3u);
+    EXPECT_EQ(raw, first);
+    std::vector<Share> decoded = adoptShares(raw);
+    expectSameShares(fewer, raw, 3);
+}
+
+// Test 5: Truncated batches, bad delimiters and bad digits are rejected
+TEST(ShareCodecTest, RejectsMalformedInput) {
+    std::vector<Share> shares = sampleShares(2);
+    std::string wire(encodedSharesSize(2), '\0');
+    encodeShares(borrowShares(shares), &wire[0]);
+    std::vector<Share> owner;
+    std::vector<ShareType> raw;
+
+    EXPECT_THROW(decodeShares(wire.data(), wire.size() - 1, raw), std::runtime_error);
+    std::string badDelimiter = wire;
+    badDelimiter[SHARE_HEX_DIGITS] = ',';
+    EXPECT_THROW(decodeShares(badDelimiter.data(), badDelimiter.size(), raw), std::runtime_error);
+    std::string badDigit = wire;
+    badDigit[3] = 'G';
+    EXPECT_THROW(decodeShares(badDigit.data(), badDigit.size(), raw), std::runtime_error);
+    EXPECT_THROW(decodeSharesBinary(wire.data(), SHARE_BYTES + 1, raw), std::runtime_error);
+    owner = adoptShares(raw);
+}
+
+// Test 6: Shares that do not fit the fixed width, negative shares and null shares are not encoded
+TEST(ShareCodecTest, RejectsUnencodableShares) {
+    char out[SHARE_FIELD_SIZE];
+    Share tooLarge = Share::zero();
+    BN_set_bit(tooLarge, 8 * SHARE_BYTES);
+    EXPECT_THROW(encodeShares({tooLarge.get()}, out), std::runtime_error);
+    EXPECT_THROW(encodeSharesBinary({tooLarge.get()}, out), std::runtime_error);
+
+    Share negative = Share::zero();
+    BN_set_word(negative, 1);
+    BN_set_negative(negative, 1);
+    EXPECT_THROW(encodeShares({negative.get()}, out), std::runtime_error);
+
+    EXPECT_THROW(encodeShares({nullptr}, out), std::runtime_error);
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include "../src/SpscQueue.h"
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+// Test 1: Capacity rounds up to a power of two and bounds what push accepts
+TEST(SpscQueueTest, FullAndEmpty) {
+    SpscQueue<int> queue(3);
+    EXPECT_EQ(queue.capacity(), 4u);
+    int value = -1;
+    EXPECT_FALSE(queue.pop(value));
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(queue.push(int(i)));
+    EXPECT_FALSE(queue.push(4));
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.pop(value));
+}
+
+// Test 2: Indices wrap around the ring in FIFO order
+TEST(SpscQueueTest, WrapsAround) {
+    SpscQueue<int> queue(4);
+    int value;
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(queue.push(int(i)));
+        ASSERT_TRUE(queue.push(int(i + 1000)));
+        ASSERT_TRUE(queue.pop(value));
+        EXPECT_EQ(value, i);
+        ASSERT_TRUE(queue.pop(value));
+        EXPECT_EQ(value, i + 1000);
+    }
+}
+
+// Test 3: Move-only items are moved in and out; a rejected push leaves the item alone
+TEST(SpscQueueTest, MoveOnlyItems) {
+    SpscQueue<std::unique_ptr<std::string>> queue(1);
+    auto first = std::make_unique<std::string>("first");
+    ASSERT_TRUE(queue.push(std::move(first)));
+    EXPECT_EQ(first, nullptr);
+    auto second = std::make_unique<std::string>("second");
+    EXPECT_FALSE(queue.push(std::move(second)));
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(*second, "second");
+    std::unique_ptr<std::string> out;
+    ASSERT_TRUE(queue.pop(out));
+    EXPECT_EQ(*out, "first");
+}
+
+// Test 4: One producer and one consumer thread see every item exactly once and in order
+TEST(SpscQueueTest, ProducerConsumerKeepOrder) {
+    const SIZE_T count = 200000;
+    SpscQueue<SIZE_T> queue(64);
+    std::thread producer([&]() {
+        for (SIZE_T i = 0; i < count; ++i) {
+            SIZE_T item = i;
+            while (!queue.push(std::move(item))) std::this_thread::yield();
+        }
+    });
+    SIZE_T expected = 0, value;
+    while (expected < count) {
+        if (queue.pop(value)) {
+            ASSERT_EQ(value, expected);
+            ++expected;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    EXPECT_FALSE(queue.pop(value));
+}
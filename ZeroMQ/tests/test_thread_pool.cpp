@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include "../src/ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Runs parallelFor and counts how often every index of [0, end) was visited
+std::vector<int> visitCounts(ThreadPool& pool, SIZE_T begin, SIZE_T end, SIZE_T grain) {
+    std::vector<std::atomic<int>> counts(end);
+    pool.parallelFor(begin, end, grain, [&](SIZE_T chunkBegin, SIZE_T chunkEnd) {
+        EXPECT_LT(chunkBegin, chunkEnd);
+        for (SIZE_T i = chunkBegin; i < chunkEnd; ++i) counts[i]++;
+    });
+    std::vector<int> result;
+    for (auto& count : counts) result.push_back(count.load());
+    return result;
+}
+
+} // namespace
+
+// Test 1: Every index is visited exactly once, whatever the pool size, range and grain
+TEST(ThreadPoolTest, ParallelForCoversRangeOnce) {
+    for (SIZE_T threads : {0, 1, 3}) {
+        ThreadPool pool(threads);
+        for (SIZE_T begin : {0, 5}) {
+            for (SIZE_T end : {6, 7, 64, 1001}) {
+                for (SIZE_T grain : {0, 1, 3, 16, 2000}) {
+                    std::vector<int> counts = visitCounts(pool, begin, end, grain);
+                    for (SIZE_T i = 0; i < end; ++i) {
+                        ASSERT_EQ(counts[i], i < begin ? 0 : 1)
+                            << "threads=" << threads << " begin=" << begin << " end=" << end << " grain=" << grain << " i=" << i;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Test 2: An empty range never calls the body
+TEST(ThreadPoolTest, EmptyRange) {
+    ThreadPool pool(2);
+    bool called = false;
+    pool.parallelFor(4, 4, 1, [&](SIZE_T, SIZE_T) { called = true; });
+    pool.parallelFor(5, 4, 1, [&](SIZE_T, SIZE_T) { called = true; });
+    EXPECT_FALSE(called);
+}
+
+// Test 3: Ranges below the grain run inline, in one call on the calling thread
+TEST(ThreadPoolTest, SmallRangeRunsInline) {
+    ThreadPool pool(3);
+    std::vector<std::pair<SIZE_T, SIZE_T>> calls;
+    std::thread::id caller = std::this_thread::get_id();
+    pool.parallelFor(10, 20, 64, [&](SIZE_T chunkBegin, SIZE_T chunkEnd) {
+        EXPECT_EQ(std::this_thread::get_id(), caller);
+        calls.emplace_back(chunkBegin, chunkEnd);
+    });
+    ASSERT_EQ(calls.size(), 1u);
+    EXPECT_EQ(calls[0], (std::pair<SIZE_T, SIZE_T>{10, 20}));
+}
+
+// Test 4: No more chunks than threads (workers plus the caller)
+TEST(ThreadPoolTest, ChunksBoundedByThreads) {
+    ThreadPool pool(3);
+    std::atomic<int> chunks{0};
+    pool.parallelFor(0, 1000, 1, [&](SIZE_T, SIZE_T) { chunks++; });
+    EXPECT_GE(chunks.load(), 1);
+    EXPECT_LE(chunks.load(), 4);
+}
+
+// Test 5: An exception in one chunk reaches the caller after every other chunk has finished
+TEST(ThreadPoolTest, ExceptionIsRethrownAfterAllChunks) {
+    ThreadPool pool(3);
+    std::atomic<SIZE_T> visited{0};
+    EXPECT_THROW(pool.parallelFor(0, 400, 1, [&](SIZE_T chunkBegin, SIZE_T chunkEnd) {
+        if (chunkBegin == 0) throw std::runtime_error("chunk failed");
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        visited += chunkEnd - chunkBegin;
+    }), std::runtime_error);
+    // Every chunk but the failing one ran to completion before parallelFor returned
+    SIZE_T afterReturn = visited.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(visited.load(), afterReturn);
+    EXPECT_LT(afterReturn, 400u);
+
+    // The pool keeps working afterwards
+    std::vector<int> counts = visitCounts(pool, 0, 100, 1);
+    for (int count : counts) EXPECT_EQ(count, 1);
+}
+
+// Test 6: Only the first of several exceptions is rethrown, inline ranges included
+TEST(ThreadPoolTest, FirstExceptionWins) {
+    ThreadPool pool(2);
+    EXPECT_THROW(pool.parallelFor(0, 300, 1, [](SIZE_T, SIZE_T) { throw std::invalid_argument("every chunk"); }),
+                 std::invalid_argument);
+    EXPECT_THROW(pool.parallelFor(0, 3, 10, [](SIZE_T, SIZE_T) { throw std::out_of_range("inline"); }),
+                 std::out_of_range);
+}
+
+// Test 7: A body may call parallelFor again; the caller works on chunks, so this cannot deadlock
+TEST(ThreadPoolTest, NestedParallelFor) {
+    ThreadPool pool(2);
+    std::atomic<SIZE_T> total{0};
+    pool.parallelFor(0, 8, 1, [&](SIZE_T outerBegin, SIZE_T outerEnd) {
+        for (SIZE_T i = outerBegin; i < outerEnd; ++i) {
+            pool.parallelFor(0, 100, 1, [&](SIZE_T innerBegin, SIZE_T innerEnd) { total += innerEnd - innerBegin; });
+        }
+    });
+    EXPECT_EQ(total.load(), 800u);
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include "../src/Topology.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// Nodes in the subtree under node, itself included
+SIZE_T subtreeSize(const KaryTree& tree, SIZE_T node) {
+    SIZE_T size = 1;
+    for (SIZE_T child : tree.children(node)) size += subtreeSize(tree, child);
+    return size;
+}
+
+// Edges from node up to the root
+SIZE_T depth(const KaryTree& tree, SIZE_T node) {
+    SIZE_T d = 0;
+    for (; node != 0; node = tree.parent(node)) ++d;
+    return d;
+}
+
+} // namespace
+
+// Test 1: Worked example with a partly filled last level
+TEST(KaryTreeTest, ChildrenOfTernaryTree) {
+    KaryTree tree(10, 3);
+    EXPECT_EQ(tree.children(0), (std::vector<SIZE_T>{1, 2, 3}));
+    EXPECT_EQ(tree.children(1), (std::vector<SIZE_T>{4, 5, 6}));
+    EXPECT_EQ(tree.children(2), (std::vector<SIZE_T>{7, 8, 9}));
+    EXPECT_TRUE(tree.children(3).empty());
+    EXPECT_TRUE(tree.children(9).empty());
+    EXPECT_EQ(tree.parent(9), 2u);
+    EXPECT_EQ(tree.parent(4), 1u);
+    EXPECT_EQ(tree.parent(1), 0u);
+}
+
+// Test 2: Arities below two would not be a tree and are raised to a binary tree
+TEST(KaryTreeTest, ArityIsAtLeastTwo) {
+    EXPECT_EQ(KaryTree(5, 0).arity, 2u);
+    EXPECT_EQ(KaryTree(5, 1).arity, 2u);
+    EXPECT_EQ(KaryTree(5, 1).children(0), (std::vector<SIZE_T>{1, 2}));
+}
+
+// Test 3: A single node is a root without children
+TEST(KaryTreeTest, SingleNode) {
+    KaryTree tree(1, 4);
+    EXPECT_TRUE(tree.children(0).empty());
+    EXPECT_EQ(subtreeSize(tree, 0), 1u);
+}
+
+// Test 4: parent and children agree, every node is reached once and the depth is logarithmic
+TEST(KaryTreeTest, ParentChildrenAndSubtreesAgree) {
+    for (SIZE_T n = 1; n <= 70; ++n) {
+        for (SIZE_T k = 2; k <= 6; ++k) {
+            KaryTree tree(n, k);
+            std::vector<int> seen(n, 0);
+            SIZE_T maxDepth = 0;
+            for (SIZE_T node = 0; node < n; ++node) {
+                std::vector<SIZE_T> kids = tree.children(node);
+                EXPECT_LE(kids.size(), k);
+                for (SIZE_T child : kids) {
+                    ASSERT_LT(child, n);
+                    EXPECT_EQ(tree.parent(child), node) << "n=" << n << " k=" << k;
+                    ++seen[child];
+                }
+                maxDepth = std::max(maxDepth, depth(tree, node));
+            }
+            EXPECT_EQ(seen[0], 0);
+            for (SIZE_T node = 1; node < n; ++node) EXPECT_EQ(seen[node], 1) << "n=" << n << " k=" << k;
+            EXPECT_EQ(subtreeSize(tree, 0), n);
+
+            // Smallest d with 1 + k + ... + k^d >= n
+            SIZE_T levels = 0, capacity = 1, width = 1;
+            while (capacity < n) {
+                width *= k;
+                capacity += width;
+                ++levels;
+            }
+            EXPECT_EQ(maxDepth, levels) << "n=" << n << " k=" << k;
+        }
+    }
+}
+
+// Test 5: Summing children's partials up the tree yields the total at the root,
+// as in a TREE-mode opening
+TEST(KaryTreeTest, ReductionReachesRoot) {
+    KaryTree tree(23, 4);
+    std::vector<SIZE_T> partial(tree.numNodes);
+    for (SIZE_T node = 0; node < tree.numNodes; ++node) partial[node] = node + 1;
+    // Children have larger ids than their parent, so a reverse sweep sees each subtree finished
+    for (SIZE_T node = tree.numNodes; node-- > 1;) partial[tree.parent(node)] += partial[node];
+    EXPECT_EQ(partial[0], tree.numNodes * (tree.numNodes + 1) / 2);
+    for (SIZE_T node = 0; node < tree.numNodes; ++node) {
+        SIZE_T expected = node + 1;
+        for (SIZE_T child : tree.children(node)) expected += partial[child];
+        EXPECT_EQ(partial[node], expected);
+    }
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "../src/ZMQMPCCommunication.h"
 #include "../src/Message.cpp"
+#include "../src/CommunicationStats.cpp"
 #include "../src/ZMQMPCCommunication.cpp"
 #include <thread>
 #include <chrono>
@@ -404,6 +405,52 @@ TEST_F(ZMQMPCCommunicationTest, QueueManagement) {
     EXPECT_EQ(zmqComm->getQueuedMessageCount(), 0u);
 }
 
+// Test 16: Statistics broken down by message type, peer and phase
+TEST_F(ZMQMPCCommunicationTest, StatisticsBreakdown) {
+    initializeAllParties();
+    
+    auto zmqComm = dynamic_cast<ZMQMPCCommunication*>(communications_[0].get());
+    ASSERT_NE(zmqComm, nullptr);
+    
+    communications_[0]->send(2, Message(Message::Type::DATA, {1, 2, 3}));
+    zmqComm->setPhase("opening");
+    communications_[0]->send(2, Message(Message::Type::SHARE, {4, 5}));
+    communications_[0]->send(3, Message(Message::Type::SHARE, {6}));
+    communications_[1]->send(1, Message(Message::Type::SYNC, {7}));
+    
+    uint32_t senderId;
+    Message msg;
+    ASSERT_TRUE(communications_[0]->receive(senderId, msg, 1000ms));
+    
+    auto stats = communications_[0]->getStatistics();
+    
+    EXPECT_TRUE(stats.find("\"messages_sent\": 3") != std::string::npos);
+    EXPECT_TRUE(stats.find("\"queue_depth_high_water\": 1") != std::string::npos);
+    EXPECT_TRUE(stats.find("\"send_blocking_ns\":") != std::string::npos);
+    // Every serialized message carries a 5-byte header
+    EXPECT_TRUE(stats.find("\"SHARE\": {\"messages_sent\": 2,\"messages_received\": 0,\"bytes_sent\": 13") != std::string::npos);
+    EXPECT_TRUE(stats.find("\"SYNC\": {\"messages_sent\": 0,\"messages_received\": 1") != std::string::npos);
+    EXPECT_TRUE(stats.find("\"2\": {\"messages_sent\": 2,\"messages_received\": 1") != std::string::npos);
+    EXPECT_TRUE(stats.find("\"untagged\": {\"messages_sent\": 1,") != std::string::npos);
+    EXPECT_TRUE(stats.find("\"opening\": {\"messages_sent\": 2,") != std::string::npos);
+    EXPECT_TRUE(stats.find("\"queue_wait_ns\": {\"count\": 1,") != std::string::npos);
+}
+
+// Test 17: Histogram buckets bound every value to within 1/8
+TEST_F(ZMQMPCCommunicationTest, LatencyHistogramBuckets) {
+    for (uint64_t value : {0ull, 1ull, 7ull, 8ull, 9ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, 1ull << 35}) {
+        size_t index = LatencyHistogram::bucketIndex(value);
+        ASSERT_LT(index, LatencyHistogram::NUM_BUCKETS);
+        uint64_t upper = LatencyHistogram::bucketUpperBound(index);
+        EXPECT_GE(upper, value);
+        EXPECT_LE(upper - value, value / 8);
+        if (index > 0) {
+            EXPECT_LT(LatencyHistogram::bucketUpperBound(index - 1), value);
+        }
+    }
+    EXPECT_EQ(LatencyHistogram::bucketIndex(~0ull), LatencyHistogram::NUM_BUCKETS - 1);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();